@@ -0,0 +1,151 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: binproto.c                                      #
+# Purpose:                                                   #
+#     Implements header encoding and the reply builder for  #
+#     the binary protocol. Replies reserve header space in  #
+#     front of the payload so each one goes out as a single #
+#     contiguous frame.                                     #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: endian(3)                            #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdlib.h>     /* malloc, realloc, free */
+#include <string.h>     /* memcpy, strlen */
+#include <endian.h>     /* htole32, le32toh */
+
+#include "binproto.h"
+
+/* ========================================================================== */
+/* ================================= Header ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Unpack a wire header and check magic/version.
+ *
+ * \return          0 if the frame is recognised, -1 otherwise.
+ */
+int bin_header_decode(const uint8_t raw[BIN_HEADER_SIZE], BinHeader *h) {
+    uint32_t len;
+
+    h->magic   = raw[0];
+    h->version = raw[1];
+    h->opcode  = raw[2];
+    h->status  = raw[3];
+    memcpy(&len, raw + 4, sizeof(len));
+    h->length  = le32toh(len);
+
+    return (h->magic == BIN_MAGIC && h->version == BIN_VERSION) ? 0 : -1;
+}
+
+/**
+ * \brief           Pack \p h into the 8-byte wire header.
+ */
+void bin_header_encode(const BinHeader *h, uint8_t raw[BIN_HEADER_SIZE]) {
+    uint32_t len = htole32(h->length);
+
+    raw[0] = h->magic;
+    raw[1] = h->version;
+    raw[2] = h->opcode;
+    raw[3] = h->status;
+    memcpy(raw + 4, &len, sizeof(len));
+}
+
+/**
+ * \brief           Decode a little-endian int32 payload field.
+ */
+int32_t bin_get_i32(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (int32_t)le32toh(v);
+}
+
+/* ========================================================================== */
+/* ============================== Reply Builder ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Reset \p rep to an empty STATUS_SUCCESS reply.
+ */
+void bin_reply_init(BinReply *rep, uint8_t opcode) {
+    rep->hdr.magic   = BIN_MAGIC;
+    rep->hdr.version = BIN_VERSION;
+    rep->hdr.opcode  = opcode;
+    rep->hdr.status  = STATUS_SUCCESS;
+    rep->hdr.length  = 0;
+    rep->frame = rep->inline_frame;
+    rep->cap   = sizeof(rep->inline_frame);
+    rep->commit_lsn = 0;
+}
+
+/**
+ * \brief           Append \p len bytes of payload.
+ *
+ * \return          0 on success, -1 if the frame could not grow.
+ */
+int bin_reply_append(BinReply *rep, const void *data, size_t len) {
+    size_t need = BIN_HEADER_SIZE + (size_t)rep->hdr.length + len;
+
+    if (need > rep->cap) {
+        size_t cap = rep->cap * 2;
+        while (cap < need) cap *= 2;
+
+        uint8_t *p;
+        if (rep->frame == rep->inline_frame) {
+            p = malloc(cap);
+            if (p) memcpy(p, rep->inline_frame, BIN_HEADER_SIZE + rep->hdr.length);
+        } else {
+            p = realloc(rep->frame, cap);
+        }
+        if (!p) return -1;
+        rep->frame = p;
+        rep->cap = cap;
+    }
+
+    memcpy(rep->frame + BIN_HEADER_SIZE + rep->hdr.length, data, len);
+    rep->hdr.length += (uint32_t)len;
+    return 0;
+}
+
+/**
+ * \brief           Discard any payload and report \p msg with \p status.
+ */
+void bin_reply_error(BinReply *rep, StatusCode status, const char *msg) {
+    rep->hdr.length = 0;
+    rep->hdr.status = (uint8_t)status;
+    bin_reply_append(rep, msg, strlen(msg));
+}
+
+/**
+ * \brief           Write the header into the reserved space.
+ *
+ * \return          Bytes to send from \p rep->frame.
+ */
+size_t bin_reply_finish(BinReply *rep) {
+    bin_header_encode(&rep->hdr, rep->frame);
+    return BIN_HEADER_SIZE + rep->hdr.length;
+}
+
+/**
+ * \brief           Free a heap frame and fall back to the inline one.
+ */
+void bin_reply_free(BinReply *rep) {
+    if (rep->frame != rep->inline_frame)
+        free(rep->frame);
+    rep->frame = rep->inline_frame;
+    rep->cap = sizeof(rep->inline_frame);
+}
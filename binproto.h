@@ -0,0 +1,171 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: binproto.h                                      #
+# Purpose:                                                   #
+#     Defines the binary, length-prefixed protocol offered  #
+#     to machine clients next to the text protocol in       #
+#     protocol.h. A client switches a connection over with  #
+#     the text command "proto binary"; from then on every   #
+#     request and reply is an 8-byte header followed by a   #
+#     raw Trainer/Pokemon record or other compact payload.  #
+#############################################################
+# Citations:                                                #
+# [1] Beej’s Guide to Network Programming, “Data Encoding,”  #
+#     https://beej.us/guide/bgnet/                          #
+# [2] Linux Man Pages: endian(3)                            #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef BINPROTO_H
+#define BINPROTO_H
+
+#include <stdint.h>     /* uint8_t, uint32_t, uint64_t */
+#include <stddef.h>     /* size_t */
+
+#include "protocol.h"
+
+/* ========================================================================== */
+/* ============================== Wire Constants ============================ */
+/* ========================================================================== */
+
+/*!< First byte of every binary frame. */
+#define BIN_MAGIC               0xB6
+
+/*!< Protocol revision carried in every frame. */
+#define BIN_VERSION             1
+
+/*!< Encoded header size in bytes. */
+#define BIN_HEADER_SIZE         8
+
+/*!< Largest request payload the server accepts. */
+#define BIN_MAX_REQUEST         4096
+
+/*!< Reply payloads up to this size are built without malloc(). */
+#define BIN_INLINE_MAX          512
+
+/*!< Most records one BIN_OP_LIST_TRAINERS reply carries; page with "after". */
+#define BIN_LIST_MAX            1024
+
+/*!< Text command that switches a connection to the binary protocol. */
+#define BIN_NEGOTIATE_CMD       "proto binary"
+
+/**
+ * \brief           Request opcodes (echoed in the reply header).
+ *
+ * \note            Integer payloads are little-endian int32; Trainer and
+ *                  Pokemon payloads use the packed layouts of trainer.h and
+ *                  pokemon.h, i.e. the same bytes as the data files.
+ */
+typedef enum {
+    BIN_OP_GET_POKEMON    = 1,   /*!< int32 id → Pokemon */
+    BIN_OP_GET_TRAINER    = 2,   /*!< int32 id → Trainer */
+    BIN_OP_LIST_TRAINERS  = 3,   /*!< (empty) or int32 after, limit → Trainer[<= BIN_LIST_MAX] */
+    BIN_OP_POST_TRAINER   = 4,   /*!< Trainer (id ignored) → int32 new id */
+    BIN_OP_PUT_TRAINER    = 5,   /*!< Trainer (id, team) → (empty) */
+    BIN_OP_DELETE_TRAINER = 6,   /*!< int32 id → (empty) */
+    BIN_OP_GET_LOG        = 7,   /*!< int32 n → log text */
+    BIN_OP_EXIT           = 8    /*!< (empty) → (empty), then close */
+} BinOpcode;
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Decoded frame header.
+ *
+ * \note            Wire layout: magic(1) version(1) opcode(1) status(1)
+ *                  length(4, little-endian). \ref status is a StatusCode in
+ *                  replies and 0 in requests; non-success replies carry a
+ *                  human-readable error text as payload.
+ */
+typedef struct {
+    uint8_t     magic;              /*!< BIN_MAGIC */
+    uint8_t     version;            /*!< BIN_VERSION */
+    uint8_t     opcode;             /*!< BinOpcode */
+    uint8_t     status;             /*!< StatusCode (replies only) */
+    uint32_t    length;             /*!< Payload bytes after the header */
+} BinHeader;
+
+/**
+ * \brief           Reply under construction: header room plus payload.
+ *
+ * \note            The header is encoded in front of the payload, so a
+ *                  finished reply is one contiguous \ref frame that needs a
+ *                  single send(). Small replies live in \ref inline_frame.
+ */
+typedef struct {
+    BinHeader   hdr;                /*!< Opcode, status and payload length */
+    uint8_t    *frame;              /*!< Header + payload bytes */
+    size_t      cap;                /*!< Allocated size of \ref frame */
+    uint64_t    commit_lsn;         /*!< Trainer WAL record to await first (0 = none) */
+    uint8_t     inline_frame[BIN_HEADER_SIZE + BIN_INLINE_MAX];
+} BinReply;
+
+/*!< Binary request handler shared by both server front ends. */
+typedef int (*bin_handler_fn)(const char *ip, int port, const BinHeader *req,
+                              const uint8_t *payload, BinReply *rep);
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Decode a header from its wire form.
+ *
+ * \return          0 if magic and version match, -1 otherwise.
+ */
+int bin_header_decode(const uint8_t raw[BIN_HEADER_SIZE], BinHeader *h);
+
+/**
+ * \brief           Encode a header into its wire form.
+ */
+void bin_header_encode(const BinHeader *h, uint8_t raw[BIN_HEADER_SIZE]);
+
+/**
+ * \brief           Start an empty successful reply for \p opcode.
+ */
+void bin_reply_init(BinReply *rep, uint8_t opcode);
+
+/**
+ * \brief           Append payload bytes, moving to the heap when needed.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+int bin_reply_append(BinReply *rep, const void *data, size_t len);
+
+/**
+ * \brief           Replace the payload with an error text and set \p status.
+ */
+void bin_reply_error(BinReply *rep, StatusCode status, const char *msg);
+
+/**
+ * \brief           Encode the header in front of the payload.
+ *
+ * \return          Total frame length (header + payload) at \p rep->frame.
+ */
+size_t bin_reply_finish(BinReply *rep);
+
+/**
+ * \brief           Release a heap payload, if one was allocated.
+ */
+void bin_reply_free(BinReply *rep);
+
+/**
+ * \brief           Read a little-endian int32 from a payload.
+ */
+int32_t bin_get_i32(const uint8_t *p);
+
+#endif /* BINPROTO_H */
@@ -1,217 +1,424 @@
-/*
-#############################################################
-# Author: Arek Gebka                                        #
-# Major: Computer Science                                   #
-# Creation Date: October 30, 2025                           #
-# Last Updated: December 2025                               #
-# Due Date: December 10, 2025                               #
-# Course: CPSC 552 — Advanced Unix Programming              #
-# Professor: Dr. Dylan Schwesinger                          #
-# Assignment: Project 6 — Threaded Server                   #
-# Filename: client.c                                        #
-# Purpose:                                                   #
-#     Implements the TCP client for Project 6. The client   #
-#     connects to the threaded server, sends user commands  #
-#     using a newline-delimited protocol, and prints        #
-#     formatted server responses using recv_line().         #
-#############################################################
-# Citations:                                                #
-# [1] Beej’s Guide to Network Programming, TCP Clients       #
-#     https://beej.us/guide/bgnet/                           #
-# [2] Linux Man Pages: socket(2), connect(2), send(2),      #
-#     recv(2), signal(2)                                    #
-#     https://man7.org/linux/man-pages/                     #
-# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
-# [4] Dr. Dylan Schwesinger, CPSC 552 Lecture Notes         #
-# [5] MaJerle C Code Style Guide                            #
-#     https://github.com/MaJerle/c-code-style               #
-#############################################################
-*/
-
-#include <stdio.h>      /* printf, fprintf, perror */
-#include <stdlib.h>     /* exit */
-#include <string.h>     /* strcmp, strncpy, strlen, snprintf */
-#include <unistd.h>     /* close */
-#include <signal.h>     /* signal, SIGPIPE */
-
-#include "common.h"
-#include "client.h"
-
-/* ========================================================================== */
-/* ============================== Usage Helper ============================== */
-/* ========================================================================== */
-
-/**
- * \brief           Print proper command-line usage for the client.
- */
-static void print_usage(void) {
-    printf("Usage: client -h <host> -p <port>\n");
-}
-
-/* ========================================================================== */
-/* ========================= Argument Parsing (Exported) ==================== */
-/* ========================================================================== */
-
-/**
- * \brief           Parse command-line arguments for the client.
- *
- * \param[in]       argc        Argument count.
- * \param[in]       argv        Argument vector.
- * \param[out]      host        Output buffer for host string.
- * \param[out]      port        Output buffer for port string.
- *
- * \return          0 on success, 1 on error.
- */
-int parse_client_arguments(int argc, char *argv[], char *host, char *port)
-{
-    int got_host = 0, got_port = 0;
-
-    for (int i = 1; i < argc; ++i) {
-        if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
-            strncpy(host, argv[++i], 255);
-            got_host = 1;
-        }
-        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
-            strncpy(port, argv[++i], 31);
-            got_port = 1;
-        }
-    }
-
-    if (!got_host || !got_port) {
-        fprintf(stderr, "Error: Missing required arguments.\n");
-        print_usage();
-        return 1;
-    }
-    return 0;
-}
-
-/* ========================================================================== */
-/* ===================== Send Command and Receive Reply ===================== */
-/* ========================================================================== */
-
-/**
- * \brief           Send a single command to the server and print its response.
- *
- * \param[in]       sockfd      Connected socket descriptor.
- * \param[in]       command     Command string to send.
- *
- * \return          0 on success, -1 on failure.
- *
- * \note            Uses recv_line() to read until the [END] marker.
- */
-int send_command(int sockfd, const char *command)
-{
-    char sendbuf[BUFFER_SIZE];
-    char recvbuf[BUFFER_SIZE];
-
-    /* Append newline for proper recv_line() termination */
-    snprintf(sendbuf, sizeof(sendbuf), "%s\n", command);
-
-    if (send_all(sockfd, sendbuf) < 0) {
-        perror("[Client] Failed to send command");
-        return -1;
-    }
-
-    /* Receive until end-of-message marker */
-    while (1) {
-        ssize_t n = recv_line(sockfd, recvbuf, sizeof(recvbuf));
-        if (n <= 0) {
-            printf("[Client] Connection closed or error.\n");
-            return -1;
-        }
-
-        /* End of message marker */
-        if (strcmp(recvbuf, "[END]\n") == 0)
-            break;
-
-        printf("%s", recvbuf);
-    }
-
-    printf("\n");
-    return 0;
-}
-
-/* ========================================================================== */
-/* =============================== REPL Loop ================================ */
-/* ========================================================================== */
-
-/**
- * \brief           Start the client-side read–eval–print loop (REPL).
- *
- * \param[in]       sockfd      Active server connection socket.
- *
- * \note            Supports interactive and batch test input.
- */
-void start_repl(int sockfd)
-{
-    char command[BUFFER_SIZE];
-
-    printf("[Client] Type 'exit' to quit.\n");
-
-    while (1) {
-        printf("> ");
-        fflush(stdout);
-
-        if (!fgets(command, sizeof(command), stdin)) {
-            printf("\n[Client] End of input.\n");
-            break;
-        }
-
-        trim_newline(command);
-
-        /* Ignore blank lines */
-        if (strlen(command) == 0)
-            continue;
-        
-        /* Ignore comment lines in batch test mode */
-        if (command[0] == '#')
-            continue;
-
-        if (strcmp(command, "exit") == 0) {
-            send_all(sockfd, "exit\n");
-            printf("[Client] Exiting.\n");
-            break;
-        }
-
-        if (send_command(sockfd, command) < 0)
-            break;
-    }
-}
-
-/* ========================================================================== */
-/* ================================= main ================================== */
-/* ========================================================================== */
-
-/**
- * \brief           Program entry point for the Project 6 client.
- *
- * \param[in]       argc        Argument count.
- * \param[in]       argv        Argument vector.
- *
- * \return          0 on normal termination, 1 on failure.
- */
-int main(int argc, char *argv[])
-{
-    char host[256] = {0};
-    char port[32] = {0};
-
-    /* Avoid termination on SIGPIPE when server closes early */
-    signal(SIGPIPE, SIG_IGN);
-
-    if (parse_client_arguments(argc, argv, host, port) != 0)
-        return 1;
-
-    int sockfd = connect_to_server(host, port);
-    if (sockfd < 0) {
-        fprintf(stderr, "[Client] Could not connect to %s:%s\n", host, port);
-        return 1;
-    }
-
-    printf("[Client] Connected to %s:%s (pid=%d)\n", host, port, getpid());
-    start_repl(sockfd);
-
-    close(sockfd);
-    printf("[Client] Connection closed.\n");
-
-    return 0;
-}
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: October 30, 2025                           #
+# Last Updated: December 2025                               #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor: Dr. Dylan Schwesinger                          #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: client.c                                        #
+# Purpose:                                                   #
+#     Implements the TCP client for Project 6. The client   #
+#     connects to the threaded server, sends user commands  #
+#     using a newline-delimited protocol, and prints        #
+#     formatted server responses via a buffered line reader. #
+#############################################################
+# Citations:                                                #
+# [1] Beej’s Guide to Network Programming, TCP Clients       #
+#     https://beej.us/guide/bgnet/                           #
+# [2] Linux Man Pages: socket(2), connect(2), send(2),      #
+#     recv(2), signal(2)                                    #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] Dr. Dylan Schwesinger, CPSC 552 Lecture Notes         #
+# [5] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf, perror */
+#include <stdlib.h>     /* exit, malloc, free */
+#include <string.h>     /* strcmp, strncpy, strlen, strcspn, strrchr */
+#include <unistd.h>     /* close */
+#include <signal.h>     /* signal, SIGPIPE */
+
+#include "common.h"
+#include "client.h"
+
+/* ========================================================================== */
+/* ============================== Usage Helper ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Print proper command-line usage for the client.
+ */
+static void print_usage(void) {
+    printf("Usage: client -h <host> -p <port> [-b <window>] "
+           "[-r <replica_host:port>]...\n");
+}
+
+/* ========================================================================== */
+/* ========================= Argument Parsing (Exported) ==================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Parse command-line arguments for the client.
+ *
+ * \param[in]       argc        Argument count.
+ * \param[in]       argv        Argument vector.
+ * \param[out]      host        Output buffer for host string.
+ * \param[out]      port        Output buffer for port string.
+ * \param[out]      window      Pipelining window (0 = interactive REPL).
+ * \param[out]      replica     Chosen -r address ("" if none was given).
+ *
+ * \return          0 on success, 1 on error.
+ */
+int parse_client_arguments(int argc, char *argv[], char *host, char *port,
+                           int *window, char *replica)
+{
+    int got_host = 0, got_port = 0;
+    const char *replicas[CLIENT_REPLICAS_MAX];
+    int nreplicas = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-h") == 0 && i + 1 < argc) {
+            strncpy(host, argv[++i], 255);
+            got_host = 1;
+        }
+        else if (strcmp(argv[i], "-p") == 0 && i + 1 < argc) {
+            strncpy(port, argv[++i], 31);
+            got_port = 1;
+        }
+        else if (strcmp(argv[i], "-b") == 0 && i + 1 < argc) {
+            *window = atoi(argv[++i]);
+            if (*window < 1) {
+                fprintf(stderr, "Error: -b window must be at least 1.\n");
+                return 1;
+            }
+        }
+        else if (strcmp(argv[i], "-r") == 0 && i + 1 < argc) {
+            if (nreplicas == CLIENT_REPLICAS_MAX) {
+                fprintf(stderr, "Error: at most %d -r replicas.\n", CLIENT_REPLICAS_MAX);
+                return 1;
+            }
+            replicas[nreplicas++] = argv[++i];
+        }
+    }
+
+    /* Spread clients over the replicas; each one reads from a single replica */
+    replica[0] = '\0';
+    if (nreplicas > 0)
+        snprintf(replica, 256, "%s", replicas[getpid() % nreplicas]);
+
+    if (!got_host || !got_port) {
+        fprintf(stderr, "Error: Missing required arguments.\n");
+        print_usage();
+        return 1;
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/* ============================= Read/Write Routing ========================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Must \p command go to the primary rather than a replica?
+ *
+ * \note            Mutations, snapshots and catalog reloads; everything else
+ *                  is a read any replica can answer.
+ */
+static int is_primary_command(const char *command)
+{
+    static const char *const verbs[] = {
+        "post", "put", "delete", "mpost", "mdelete", "snapshot", "reload"
+    };
+    size_t len = strcspn(command, " ");
+
+    for (size_t i = 0; i < sizeof(verbs) / sizeof(verbs[0]); i++)
+        if (strlen(verbs[i]) == len && strncmp(command, verbs[i], len) == 0)
+            return 1;
+    return 0;
+}
+
+/* ========================================================================== */
+/* ===================== Send Command and Receive Reply ===================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Print one framed reply, up to its [END] marker.
+ *
+ * \return          0 on success, -1 if the connection closed first.
+ */
+static int print_reply(line_reader_t *reader)
+{
+    char recvbuf[BUFFER_SIZE];
+
+    while (1) {
+        ssize_t n = line_reader_read(reader, recvbuf, sizeof(recvbuf));
+        if (n <= 0) {
+            printf("[Client] Connection closed or error.\n");
+            return -1;
+        }
+
+        /* End of message marker */
+        if (strcmp(recvbuf, END_MARKER) == 0)
+            break;
+
+        printf("%s", recvbuf);
+    }
+
+    printf("\n");
+    return 0;
+}
+
+/**
+ * \brief           Send a single command to the server and print its response.
+ *
+ * \param[in,out]   reader      Line reader attached to the server socket.
+ * \param[in]       command     Command string to send.
+ *
+ * \return          0 on success, -1 on failure.
+ *
+ * \note            Reads buffered lines until the [END] marker; bytes past
+ *                  the marker stay in \p reader for the next command.
+ */
+int send_command(line_reader_t *reader, const char *command)
+{
+    char sendbuf[BUFFER_SIZE + 2];
+
+    /* Append newline so the server sees a complete line */
+    int n = snprintf(sendbuf, sizeof(sendbuf), "%s\n", command);
+    size_t len = (n < (int)sizeof(sendbuf)) ? (size_t)n : sizeof(sendbuf) - 1;
+
+    if (send_bytes(reader->fd, sendbuf, len) < 0) {
+        perror("[Client] Failed to send command");
+        return -1;
+    }
+
+    /* Receive until end-of-message marker */
+    return print_reply(reader);
+}
+
+/* ========================================================================== */
+/* =============================== REPL Loop ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Start the client-side read–eval–print loop (REPL).
+ *
+ * \param[in]       sockfd      Active server connection socket.
+ * \param[in]       readfd      Replica for reads (\p sockfd if none).
+ *
+ * \note            Supports interactive and batch test input.
+ */
+void start_repl(int sockfd, int readfd)
+{
+    char command[BUFFER_SIZE];
+    line_reader_t reader, replica;
+
+    line_reader_init(&reader, sockfd);
+    line_reader_init(&replica, readfd);
+    printf("[Client] Type 'exit' to quit.\n");
+
+    while (1) {
+        printf("> ");
+        fflush(stdout);
+
+        if (!fgets(command, sizeof(command), stdin)) {
+            printf("\n[Client] End of input.\n");
+            break;
+        }
+
+        trim_newline(command);
+
+        /* Ignore blank lines */
+        if (strlen(command) == 0)
+            continue;
+        
+        /* Ignore comment lines in batch test mode */
+        if (command[0] == '#')
+            continue;
+
+        if (strcmp(command, "exit") == 0) {
+            send_bytes(sockfd, "exit\n", 5);
+            if (readfd != sockfd)
+                send_bytes(readfd, "exit\n", 5);
+            printf("[Client] Exiting.\n");
+            break;
+        }
+
+        if (send_command(is_primary_command(command) ? &reader : &replica, command) < 0)
+            break;
+    }
+}
+
+/* ========================================================================== */
+/* ========================== Pipelined Batch Mode ========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Read the next command from stdin, skipping blanks/comments.
+ *
+ * \return          1 if \p command holds a command, 0 at end of input.
+ */
+static int next_batch_command(char *command, size_t size)
+{
+    while (fgets(command, (int)size, stdin)) {
+        trim_newline(command);
+        if (command[0] != '\0' && command[0] != '#')
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Run stdin commands with up to \p window replies outstanding.
+ *
+ * \param[in]       sockfd      Active server connection socket.
+ * \param[in]       readfd      Replica for reads (\p sockfd if none).
+ * \param[in]       window      Maximum commands in flight.
+ *
+ * \return          0 on success, -1 on communication failure.
+ *
+ * \note            Commands are written in batches and replies are printed
+ *                  in order as they arrive, so a long script costs roughly
+ *                  one round trip per window instead of one per line. The
+ *                  window is refilled once half of it has been answered.
+ *                  With a replica, each in-flight slot remembers which
+ *                  connection owes its reply, so output keeps script order.
+ */
+int run_pipelined(int sockfd, int readfd, int window)
+{
+    char command[BUFFER_SIZE];
+    char batch[2][4 * BUFFER_SIZE];
+    line_reader_t readers[2];
+    int fds[2] = { sockfd, readfd };
+    int inflight = 0, head = 0;
+    int eof = 0, saw_exit = 0;
+    int rc = -1;
+
+    /* owner[i]: 0 = primary, 1 = replica, in send order (a ring of window slots) */
+    unsigned char *owner = malloc((size_t)window);
+    if (!owner) {
+        perror("[Client] malloc");
+        return -1;
+    }
+
+    line_reader_init(&readers[0], sockfd);
+    line_reader_init(&readers[1], readfd);
+    printf("[Client] Pipelined batch mode (window %d).\n", window);
+
+    while (!eof || inflight > 0) {
+        size_t used[2] = { 0, 0 };
+
+        /* Top up the window with as many commands as fit in one write */
+        while (!eof && inflight < window) {
+            if (!next_batch_command(command, sizeof(command))) {
+                eof = 1;
+                break;
+            }
+            if (strcmp(command, "exit") == 0) {
+                eof = saw_exit = 1;
+                break;
+            }
+
+            int to = readfd != sockfd && !is_primary_command(command);
+            size_t len = strlen(command);
+            if (used[to] + len + 2 > sizeof(batch[to])) {
+                if (send_bytes(fds[to], batch[to], used[to]) < 0) goto fail;
+                used[to] = 0;
+            }
+            memcpy(batch[to] + used[to], command, len);
+            batch[to][used[to] + len] = '\n';
+            batch[to][used[to] + len + 1] = '\0';
+            used[to] += len + 1;
+            owner[(head + inflight) % window] = (unsigned char)to;
+            inflight++;
+        }
+        for (int k = 0; k < 2; k++)
+            if (used[k] > 0 && send_bytes(fds[k], batch[k], used[k]) < 0)
+                goto fail;
+
+        /* Drain replies until the window is half empty (or all of them) */
+        int target = eof ? 0 : window / 2;
+        while (inflight > target) {
+            if (print_reply(&readers[owner[head]]) < 0)
+                goto out;
+            head = (head + 1) % window;
+            inflight--;
+        }
+    }
+
+    if (saw_exit) {
+        send_bytes(sockfd, "exit\n", 5);
+        if (readfd != sockfd)
+            send_bytes(readfd, "exit\n", 5);
+    }
+    printf("[Client] Exiting.\n");
+    rc = 0;
+    goto out;
+
+fail:
+    perror("[Client] Failed to send command");
+out:
+    free(owner);
+    return rc;
+}
+
+/* ========================================================================== */
+/* ================================= main ================================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Program entry point for the Project 6 client.
+ *
+ * \param[in]       argc        Argument count.
+ * \param[in]       argv        Argument vector.
+ *
+ * \return          0 on normal termination, 1 on failure.
+ */
+int main(int argc, char *argv[])
+{
+    char host[256] = {0};
+    char port[32] = {0};
+    char replica[256] = {0};
+    int window = 0;
+
+    /* Avoid termination on SIGPIPE when server closes early */
+    signal(SIGPIPE, SIG_IGN);
+
+    if (parse_client_arguments(argc, argv, host, port, &window, replica) != 0)
+        return 1;
+
+    int sockfd = connect_to_server(host, port);
+    if (sockfd < 0) {
+        fprintf(stderr, "[Client] Could not connect to %s:%s\n", host, port);
+        return 1;
+    }
+
+    /* Each command leaves in one write; don't hold it back for an ACK */
+    socket_set_nodelay(sockfd, 1);
+
+    printf("[Client] Connected to %s:%s (pid=%d)\n", host, port, getpid());
+
+    /* Optional read replica; writes keep going to the primary above */
+    int readfd = sockfd;
+    if (replica[0] != '\0') {
+        char *colon = strrchr(replica, ':');
+        if (colon) *colon = '\0';
+        readfd = colon ? connect_to_server(replica, colon + 1) : -1;
+        if (readfd < 0) {
+            fprintf(stderr, "[Client] Could not connect to replica %s%s%s\n",
+                    replica, colon ? ":" : "", colon ? colon + 1 : "");
+            close(sockfd);
+            return 1;
+        }
+        socket_set_nodelay(readfd, 1);
+        printf("[Client] Reads go to replica %s:%s\n", replica, colon + 1);
+    }
+
+    if (window > 0)
+        run_pipelined(sockfd, readfd, window);
+    else
+        start_repl(sockfd, readfd);
+
+    if (readfd != sockfd)
+        close(readfd);
+    close(sockfd);
+    printf("[Client] Connection closed.\n");
+
+    return 0;
+}
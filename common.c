@@ -1,345 +1,844 @@
-/*
-#############################################################
-# Author: Arek Gebka                                        #
-# Major: Computer Science                                   #
-# Creation Date: October 30, 2025                           #
-# Last Updated: December 8, 2025                            #
-# Due Date: December 10, 2025                               #
-# Course: CPSC 552 — Advanced Unix Programming              #
-# Professor Name: Dr. Dylan Schwesinger                     #
-# Assignment: Project 6 — Threaded Server                   #
-# Filename: common.c                                        #
-# Purpose:                                                   #
-#     Implements core socket setup, safe I/O utilities,     #
-#     signal handling, and TCP helper functions shared      #
-#     between the threaded client and server. Provides      #
-#     robust send/recv wrappers, TCP setup via              #
-#     getaddrinfo(), and graceful shutdown support.         #
-#############################################################
-# Citations:                                                #
-# [1] Beej’s Guide to Network Programming, Using Sockets    #
-#     https://beej.us/guide/bgnet/                           #
-# [2] Linux Man Pages: socket(2), bind(2), listen(2),       #
-#     accept(2), connect(2), send(2), recv(2),              #
-#     signal(2), write(2), read(2), getaddrinfo(3)          #
-#     https://man7.org/linux/man-pages/                     #
-# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
-# [4] Dr. Dylan Schwesinger, CPSC 552 — Project 6 Notes     #
-# [5] MaJerle C Code Style Guide                            #
-#     https://github.com/MaJerle/c-code-style               #
-#############################################################
-*/
-
-#include <stdio.h>      /* printf, fprintf */
-#include <stdlib.h>     /* exit */
-#include <string.h>     /* memset, strlen, strcspn */
-#include <unistd.h>     /* write, read, close */
-#include <errno.h>      /* errno, EINTR, EPIPE, ECONNRESET */
-#include <arpa/inet.h>  /* sockaddr_in */
-#include <sys/socket.h> /* socket, bind, listen, accept, connect */
-#include <sys/types.h>  /* ssize_t */
-#include <netinet/in.h> /* IPPROTO_TCP */
-#include <signal.h>     /* sig_atomic_t, signal */
-#include <netdb.h>      /* getaddrinfo, freeaddrinfo */
-
-#include "common.h"
-
-/* ========================================================================== */
-/* ============================== Global Flag =============================== */
-/* ========================================================================== */
-
-/**
- * \brief Global run flag toggled by SIGINT.
- *
- * Used by both client and server to terminate gracefully when
- * Ctrl+C is received. Declared volatile sig_atomic_t to ensure
- * safe access between signal handlers and main execution.
- */
-volatile sig_atomic_t keep_running = 1;
-
-/* ========================================================================== */
-/* ============================ Signal Handler ============================== */
-/* ========================================================================== */
-
-/**
- * \brief           SIGINT handler for clean shutdown.
- *
- * \param[in]       sig         Signal number (unused).
- *
- * \note            This function only sets a flag and prints a message.
- *                  Heavy cleanup is performed by the main execution flow.
- */
-void handle_sigint(int sig) {
-    (void)sig;                  /* Explicitly ignore unused parameter */
-    keep_running = 0;           /* Flip the global run flag so loops terminate cleanly */
-    /* Async-signal-safe output */
-    const char *msg = "\n[System] Caught SIGINT. Shutting down...\n";
-    write(STDOUT_FILENO, msg, strlen(msg));
-}
-
-/* ========================================================================== */
-/* =========================== Server Socket (GAI) ========================== */
-/* ========================================================================== */
-
-/**
- * \brief           Create and bind a TCP listening socket using getaddrinfo().
- *
- * \param[in]       port        Null-terminated port string.
- *
- * \return          Listening socket descriptor on success, -1 on failure.
- *
- * \note            Uses AI_PASSIVE for wildcard binding and enables
- *                  SO_REUSEADDR for fast restart during development.
- */
-int create_server_socket(const char *port) {
-    struct addrinfo hints, *res, *p;
-    int sockfd = -1;
-    int opt = 1;
-    int rv;
-
-    /* Zero out hints structure */
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family   = AF_INET;        /* IPv4 */
-    hints.ai_socktype = SOCK_STREAM;    /* TCP */
-    hints.ai_flags    = AI_PASSIVE;     /* Bind to local host */
-
-    /* Resolve local address for the given port */
-    if ((rv = getaddrinfo(NULL, port, &hints, &res)) != 0) {
-        fprintf(stderr, "[Server] getaddrinfo: %s\n", gai_strerror(rv));
-        return -1;
-    }
-
-    /* Iterate through all returned addresses and attempt to bind */
-    for (p = res; p != NULL; p = p->ai_next) {
-        
-        /* Create socket for this candidate address */
-        sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-        if (sockfd < 0)
-            continue;
-
-        /* Allow quick reuse of the same port after shutdown */
-        if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-            close(sockfd);
-            sockfd = -1;
-            continue;
-        }
-
-        /* Attempt to bind */
-        if (bind(sockfd, p->ai_addr, p->ai_addrlen) == 0)
-            break;  /* Successful bind */
-
-        close(sockfd);
-        sockfd = -1;
-    }
-
-    freeaddrinfo(res);
-
-    if (sockfd < 0)
-        return -1;
-
-    /* Begin listening for incoming connections */
-    if (listen(sockfd, BACKLOG) < 0) {
-        close(sockfd);
-        return -1;
-    }
-
-    printf("[Server] Listening on port %s...\n", port);
-    return sockfd;
-}
-
-/* ========================================================================== */
-/* ============================ Client Socket =============================== */
-/* ========================================================================== */
-
-/**
- * \brief           Connect to a TCP server using hostname and port.
- *
- * \param[in]       host        Hostname or dotted IPv4 string.
- * \param[in]       port        Port number string.
- *
- * \return          Connected socket descriptor on success, -1 on failure.
- */
-int connect_to_server(const char *host, const char *port) {
-    struct addrinfo hints, *res, *p;
-    int sockfd = -1;
-    int rv;
-
-    memset(&hints, 0, sizeof(hints));
-    hints.ai_family   = AF_INET;
-    hints.ai_socktype = SOCK_STREAM;
-
-    /* Resolve server address */
-    if ((rv = getaddrinfo(host, port, &hints, &res)) != 0) {
-        fprintf(stderr, "[Client] getaddrinfo: %s\n", gai_strerror(rv));
-        return -1;
-    }
-
-    /* Attempt to connect to one of the resolved addresses */
-    for (p = res; p != NULL; p = p->ai_next) {
-        sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
-        if (sockfd < 0)
-            continue;
-
-        if (connect(sockfd, p->ai_addr, p->ai_addrlen) == 0)
-            break;  /* Successful connection */
-
-        close(sockfd);
-        sockfd = -1;
-    }
-
-    freeaddrinfo(res);
-    return sockfd;
-}
-
-/* ========================================================================== */
-/* =============================== send_all ================================= */
-/* ========================================================================== */
-
-/**
- * \brief           Reliably send an entire buffer over a socket.
- *
- * \param[in]       sockfd      Connected socket descriptor.
- * \param[in]       buffer      Null-terminated data to send.
- *
- * \return          Number of bytes sent on success, -1 on failure.
- *
- * \note            Handles short writes caused by TCP buffering.
- */
-ssize_t send_all(int sockfd, const char *buffer) {
-    size_t len = strlen(buffer);
-    size_t total_sent = 0;
-
-    while (total_sent < len) {
-        /* Attempt to send remaining bytes */
-        ssize_t n = send(sockfd, buffer + total_sent, len - total_sent, 0);
-        if (n <= 0) {
-            /* Connection lost or fatal error */
-            if (errno == EPIPE || errno == ECONNRESET)
-                return -1;
-            return -1;
-        }
-        total_sent += (size_t)n;
-    }
-    return (ssize_t)total_sent;
-}
-
-/* ========================================================================== */
-/* =============================== recv_line ================================ */
-/* ========================================================================== */
-
-/**
- * \brief           Receive a single newline-terminated message.
- *
- * \param[in]       sockfd      Active socket descriptor.
- * \param[out]      buffer      Output buffer for received line.
- * \param[in]       maxlen      Maximum buffer size.
- *
- * \return          Number of bytes read, 0 on clean close, -1 on error.
- *
- * \note            Reads one byte at a time to preserve message boundaries.
- */
-ssize_t recv_line(int sockfd, char *buffer, size_t maxlen)
-{
-    size_t pos = 0;
-
-    while (pos < maxlen - 1) {
-        char c;
-
-        /* Receive exactly one byte */
-        ssize_t n = recv(sockfd, &c, 1, 0);
-
-        if (n == 0) {
-            /* Peer closed connection */
-            buffer[pos] = '\0';
-            return 0;
-        }
-
-        if (n < 0) {
-            if (errno == EINTR)
-                continue;  /* Retry interrupted system call */
-            return -1;
-        }
-
-        buffer[pos++] = c;
-
-        /* Stop at newline for protocol framing */
-        if (c == '\n')
-            break;
-
-        /* Prevent buffer overflow */
-        if (pos == maxlen - 1) {
-            buffer[pos] = '\0';
-            return (ssize_t)pos;
-        }
-    }
-
-    buffer[pos] = '\0';
-    return (ssize_t)pos;
-}
-
-/* ========================================================================== */
-/* ============================ Safe I/O Helpers ============================ */
-/* ========================================================================== */
-
-/**
- * \brief           Write exactly \p size bytes to a file descriptor.
- *
- * \param[in]       fd          Target file descriptor.
- * \param[in]       buf         Data buffer to write.
- * \param[in]       size        Number of bytes to write.
- *
- * \return          Number of bytes written, -1 on failure.
- */
-ssize_t safe_write(int fd, const void *buf, size_t size) {
-    size_t total = 0;
-    ssize_t n;
-    while (total < size) {
-        n = write(fd, (const char*)buf + total, size - total);
-        if (n <= 0) {
-            if (errno == EINTR) continue;
-            return -1;
-        }
-        total += (size_t)n;
-    }
-    return (ssize_t)total;
-}
-
-/**
- * \brief           Read exactly \p size bytes from a file descriptor.
- *
- * \param[in]       fd          Source file descriptor.
- * \param[out]      buf         Output buffer.
- * \param[in]       size        Number of bytes to read.
- *
- * \return          Number of bytes read, -1 on failure.
- */
-ssize_t safe_read(int fd, void *buf, size_t size) {
-    size_t total = 0;
-    ssize_t n;
-    while (total < size) {
-        n = read(fd, (char*)buf + total, size - total);
-        if (n < 0) {
-            if (errno == EINTR) continue;
-            return -1;
-        } else if (n == 0) break;
-        total += (size_t)n;
-    }
-    return (ssize_t)total;
-}
-
-/* ========================================================================== */
-/* ============================== trim_newline ============================== */
-/* ========================================================================== */
-
-/**
- * \brief           Remove trailing CR/LF characters from a string.
- *
- * \param[in,out]   str         Input string to sanitize.
- */
-void trim_newline(char *str) {
-    if (!str || *str == '\0') return;
-    
-    /* Replace first newline occurrence with null terminator */
-    str[strcspn(str, "\r\n")] = '\0';
-}
-
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: October 30, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: common.c                                        #
+# Purpose:                                                   #
+#     Implements core socket setup, safe I/O utilities,     #
+#     signal handling, and TCP helper functions shared      #
+#     between the threaded client and server. Provides      #
+#     robust send/recv wrappers, TCP setup via              #
+#     getaddrinfo(), and graceful shutdown support.         #
+#############################################################
+# Citations:                                                #
+# [1] Beej’s Guide to Network Programming, Using Sockets    #
+#     https://beej.us/guide/bgnet/                           #
+# [2] Linux Man Pages: socket(2), bind(2), listen(2),       #
+#     accept(2), connect(2), send(2), recv(2),              #
+#     signal(2), write(2), read(2), getaddrinfo(3)          #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] Dr. Dylan Schwesinger, CPSC 552 — Project 6 Notes     #
+# [5] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf */
+#include <stdlib.h>     /* exit */
+#include <string.h>     /* memset, strlen, strcspn */
+#include <unistd.h>     /* write, read, close */
+#include <errno.h>      /* errno, EINTR, EPIPE, ECONNRESET */
+#include <arpa/inet.h>  /* sockaddr_in */
+#include <sys/socket.h> /* socket, bind, listen, accept, connect, sendmsg */
+#include <sys/types.h>  /* ssize_t */
+#include <netinet/in.h> /* IPPROTO_TCP */
+#include <signal.h>     /* sig_atomic_t, signal */
+#include <netdb.h>      /* getaddrinfo, freeaddrinfo */
+#include <fcntl.h>      /* fcntl, O_NONBLOCK */
+#include <sys/uio.h>    /* struct iovec */
+#include <netinet/tcp.h> /* TCP_NODELAY, TCP_CORK */
+#include <poll.h>       /* poll, POLLERR */
+#include <linux/errqueue.h> /* sock_extended_err, SO_EE_ORIGIN_ZEROCOPY */
+
+#include "common.h"
+
+/* ========================================================================== */
+/* ============================== Global Flag =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief Global run flag toggled by SIGINT.
+ *
+ * Used by both client and server to terminate gracefully when
+ * Ctrl+C is received. Declared volatile sig_atomic_t to ensure
+ * safe access between signal handlers and main execution.
+ */
+volatile sig_atomic_t keep_running = 1;
+
+/* ========================================================================== */
+/* ============================ Signal Handler ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           SIGINT handler for clean shutdown.
+ *
+ * \param[in]       sig         Signal number (unused).
+ *
+ * \note            This function only sets a flag and prints a message.
+ *                  Heavy cleanup is performed by the main execution flow.
+ */
+void handle_sigint(int sig) {
+    (void)sig;                  /* Explicitly ignore unused parameter */
+    keep_running = 0;           /* Flip the global run flag so loops terminate cleanly */
+    /* Async-signal-safe output */
+    const char *msg = "\n[System] Caught SIGINT. Shutting down...\n";
+    write(STDOUT_FILENO, msg, strlen(msg));
+}
+
+/* ========================================================================== */
+/* =========================== Server Socket (GAI) ========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Resolve, bind and listen on a local TCP port.
+ *
+ * \param[in]       port        Null-terminated port string.
+ * \param[in]       reuseport   Non-zero to also enable SO_REUSEPORT.
+ * \param[in]       backlog     Pending connection queue length for listen().
+ *
+ * \return          Listening socket descriptor on success, -1 on failure.
+ */
+static int open_listener(const char *port, int reuseport, int backlog) {
+    struct addrinfo hints, *res, *p;
+    int sockfd = -1;
+    int opt = 1;
+    int rv;
+
+    /* Zero out hints structure */
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;        /* IPv4 */
+    hints.ai_socktype = SOCK_STREAM;    /* TCP */
+    hints.ai_flags    = AI_PASSIVE;     /* Bind to local host */
+
+    /* Resolve local address for the given port */
+    if ((rv = getaddrinfo(NULL, port, &hints, &res)) != 0) {
+        fprintf(stderr, "[Server] getaddrinfo: %s\n", gai_strerror(rv));
+        return -1;
+    }
+
+    /* Iterate through all returned addresses and attempt to bind */
+    for (p = res; p != NULL; p = p->ai_next) {
+        
+        /* Create socket for this candidate address */
+        sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if (sockfd < 0)
+            continue;
+
+        /* Allow quick reuse of the same port after shutdown */
+        if (setsockopt(sockfd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
+            close(sockfd);
+            sockfd = -1;
+            continue;
+        }
+
+        /* Let several listeners share the port (one per reactor) */
+        if (reuseport &&
+            setsockopt(sockfd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+            close(sockfd);
+            sockfd = -1;
+            continue;
+        }
+
+        /* Attempt to bind */
+        if (bind(sockfd, p->ai_addr, p->ai_addrlen) == 0)
+            break;  /* Successful bind */
+
+        close(sockfd);
+        sockfd = -1;
+    }
+
+    freeaddrinfo(res);
+
+    if (sockfd < 0)
+        return -1;
+
+    /* Begin listening for incoming connections */
+    if (listen(sockfd, backlog) < 0) {
+        close(sockfd);
+        return -1;
+    }
+
+    return sockfd;
+}
+
+/**
+ * \brief           Create and bind a TCP listening socket using getaddrinfo().
+ *
+ * \param[in]       port        Null-terminated port string.
+ *
+ * \return          Listening socket descriptor on success, -1 on failure.
+ *
+ * \note            Uses AI_PASSIVE for wildcard binding and enables
+ *                  SO_REUSEADDR for fast restart during development.
+ */
+int create_server_socket(const char *port) {
+    int sockfd = open_listener(port, 0, BACKLOG);
+    if (sockfd < 0)
+        return -1;
+
+    printf("[Server] Listening on port %s...\n", port);
+    return sockfd;
+}
+
+/**
+ * \brief           Create a SO_REUSEPORT listening socket.
+ *
+ * \param[in]       port        Null-terminated port string.
+ *
+ * \return          Listening socket descriptor on success, -1 on failure.
+ *
+ * \note            Each caller gets its own accept queue; the kernel hashes
+ *                  new connections across all listeners bound to \p port.
+ *                  The queue is sized with SOMAXCONN because reactors are
+ *                  expected to absorb large connection bursts.
+ */
+int create_reuseport_socket(const char *port) {
+    return open_listener(port, 1, SOMAXCONN);
+}
+
+/* ========================================================================== */
+/* ============================ Client Socket =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Connect to a TCP server using hostname and port.
+ *
+ * \param[in]       host        Hostname or dotted IPv4 string.
+ * \param[in]       port        Port number string.
+ *
+ * \return          Connected socket descriptor on success, -1 on failure.
+ */
+int connect_to_server(const char *host, const char *port) {
+    struct addrinfo hints, *res, *p;
+    int sockfd = -1;
+    int rv;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family   = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    /* Resolve server address */
+    if ((rv = getaddrinfo(host, port, &hints, &res)) != 0) {
+        fprintf(stderr, "[Client] getaddrinfo: %s\n", gai_strerror(rv));
+        return -1;
+    }
+
+    /* Attempt to connect to one of the resolved addresses */
+    for (p = res; p != NULL; p = p->ai_next) {
+        sockfd = socket(p->ai_family, p->ai_socktype, p->ai_protocol);
+        if (sockfd < 0)
+            continue;
+
+        if (connect(sockfd, p->ai_addr, p->ai_addrlen) == 0)
+            break;  /* Successful connection */
+
+        close(sockfd);
+        sockfd = -1;
+    }
+
+    freeaddrinfo(res);
+    return sockfd;
+}
+
+/* ========================================================================== */
+/* ============================== Socket Options ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Enable or disable Nagle's algorithm on a TCP socket.
+ *
+ * \return          0 on success, -1 on failure.
+ *
+ * \note            Replies leave in one syscall each, so there is nothing
+ *                  for Nagle to merge; it would only delay the last segment.
+ */
+int socket_set_nodelay(int sockfd, int on) {
+    return setsockopt(sockfd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+/**
+ * \brief           Cork or uncork a TCP socket.
+ *
+ * \return          0 on success, -1 on failure.
+ *
+ * \note            While corked the kernel only emits full segments; the
+ *                  partial tail goes out when the socket is uncorked.
+ */
+int socket_set_cork(int sockfd, int on) {
+    return setsockopt(sockfd, IPPROTO_TCP, TCP_CORK, &on, sizeof(on));
+}
+
+/**
+ * \brief           Allow MSG_ZEROCOPY sends on \p sockfd.
+ *
+ * \return          0 if the kernel accepted SO_ZEROCOPY, -1 otherwise.
+ */
+int socket_enable_zerocopy(int sockfd) {
+#ifdef SO_ZEROCOPY
+    int on = 1;
+    return setsockopt(sockfd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on));
+#else
+    (void)sockfd;
+    errno = ENOPROTOOPT;
+    return -1;
+#endif
+}
+
+/* ========================================================================== */
+/* ============================== Vectored Send ============================= */
+/* ========================================================================== */
+
+#ifdef SO_ZEROCOPY
+/**
+ * \brief           Wait until the kernel has released \p calls zero-copy sends.
+ *
+ * \note            Completion notices arrive on the socket error queue as
+ *                  ranges of send sequence numbers. The wait is bounded by
+ *                  ZEROCOPY_WAIT_MS so a stalled peer cannot pin a session.
+ */
+static void zerocopy_reap(int sockfd, uint32_t calls) {
+    uint32_t done = 0;
+
+    while (done < calls) {
+        struct pollfd pfd = { .fd = sockfd, .events = 0 };
+        if (poll(&pfd, 1, ZEROCOPY_WAIT_MS) <= 0 || !(pfd.revents & POLLERR))
+            return;
+
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(sockfd, &msg, MSG_ERRQUEUE) < 0)
+            return;
+
+        for (struct cmsghdr *cm = CMSG_FIRSTHDR(&msg); cm; cm = CMSG_NXTHDR(&msg, cm)) {
+            struct sock_extended_err ee;
+            memcpy(&ee, CMSG_DATA(cm), sizeof(ee));
+            if (ee.ee_errno == 0 && ee.ee_origin == SO_EE_ORIGIN_ZEROCOPY)
+                done += ee.ee_data - ee.ee_info + 1;
+        }
+    }
+}
+#endif
+
+/**
+ * \brief           sendmsg() every iovec completely, resuming after short writes.
+ *
+ * \param[in]       sockfd      Connected socket descriptor.
+ * \param[in,out]   iov         Vectors to send; advanced in place.
+ * \param[in]       cnt         Number of vectors.
+ * \param[in]       zerocopy    Use MSG_ZEROCOPY for payloads of at least
+ *                              ZEROCOPY_MIN_BYTES (socket must have passed
+ *                              socket_enable_zerocopy()).
+ *
+ * \return          Bytes sent on success, -1 on failure.
+ *
+ * \note            Returns only once the buffers may be reused, also after a
+ *                  zero-copy send. MSG_NOSIGNAL keeps a vanished peer from
+ *                  raising SIGPIPE.
+ */
+ssize_t send_iov(int sockfd, struct iovec *iov, int cnt, int zerocopy) {
+    struct msghdr msg;
+    ssize_t total = 0;
+    int flags = MSG_NOSIGNAL;
+    uint32_t zc_calls = 0;
+
+#ifdef SO_ZEROCOPY
+    if (zerocopy) {
+        size_t bytes = 0;
+        for (int i = 0; i < cnt; i++) bytes += iov[i].iov_len;
+        if (bytes >= ZEROCOPY_MIN_BYTES) flags |= MSG_ZEROCOPY;
+    }
+#else
+    (void)zerocopy;
+#endif
+
+    memset(&msg, 0, sizeof(msg));
+    while (cnt > 0) {
+        msg.msg_iov = iov;
+        msg.msg_iovlen = (size_t)cnt;
+
+        ssize_t n = sendmsg(sockfd, &msg, flags);
+        if (n < 0 && errno == EINTR)
+            continue;
+#ifdef SO_ZEROCOPY
+        if (n < 0 && errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+            flags &= ~MSG_ZEROCOPY;  /* Out of pinning budget: copy instead */
+            continue;
+        }
+#endif
+        if (n <= 0)
+            return -1;  /* Connection lost or fatal error */
+        if (flags & MSG_ZEROCOPY)
+            zc_calls++;
+        total += n;
+
+        /* Skip fully written vectors, trim the partially written one */
+        while (cnt > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            cnt--;
+        }
+        if (cnt > 0) {
+            iov->iov_base = (char *)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+
+#ifdef SO_ZEROCOPY
+    if (zc_calls > 0)
+        zerocopy_reap(sockfd, zc_calls);
+#endif
+    return total;
+}
+
+/**
+ * \brief           Reliably send \p len bytes over a socket.
+ *
+ * \return          Number of bytes sent on success, -1 on failure.
+ */
+ssize_t send_bytes(int sockfd, const void *buf, size_t len) {
+    struct iovec iov = { .iov_base = (void *)buf, .iov_len = len };
+    return send_iov(sockfd, &iov, 1, 0);
+}
+
+/**
+ * \brief           Describe a framed reply (body, newline, END_MARKER).
+ *
+ * \param[out]      iov         Receives up to RESPONSE_IOV vectors.
+ * \param[in]       body        Response body (need not be NUL-terminated).
+ * \param[in]       len         Body length in bytes.
+ *
+ * \return          Number of vectors used.
+ *
+ * \note            A newline is inserted before the marker when the body
+ *                  does not already end with one, so the marker always
+ *                  arrives on its own line.
+ */
+int response_iov(struct iovec *iov, const char *body, size_t len) {
+    static const char tail[] = "\n" END_MARKER;
+    int sep = (len == 0 || body[len - 1] != '\n');
+    int cnt = 0;
+
+    if (len > 0) {
+        iov[cnt].iov_base = (void *)body;
+        iov[cnt].iov_len = len;
+        cnt++;
+    }
+    iov[cnt].iov_base = (void *)(sep ? tail : tail + 1);
+    iov[cnt].iov_len = sizeof(tail) - 1 - (sep ? 0 : 1);
+    return cnt + 1;
+}
+
+/**
+ * \brief           Send a response body of known length plus its terminator.
+ *
+ * \return          Number of bytes sent on success, -1 on failure.
+ */
+ssize_t send_framed(int sockfd, const char *body, size_t len, int zerocopy) {
+    struct iovec iov[RESPONSE_IOV];
+    int cnt = response_iov(iov, body, len);
+    return send_iov(sockfd, iov, cnt, zerocopy);
+}
+
+/**
+ * \brief           Send a response body and its END_MARKER terminator.
+ *
+ * \param[in]       sockfd      Connected socket descriptor.
+ * \param[in]       message     Null-terminated response body.
+ *
+ * \return          Number of bytes sent on success, -1 on failure.
+ *
+ * \note            Body and marker leave in one sendmsg() without first
+ *                  being copied into a frame buffer.
+ */
+ssize_t send_response(int sockfd, const char *message) {
+    return send_framed(sockfd, message, strlen(message), 0);
+}
+
+/* ========================================================================== */
+/* =============================== recv_line ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Receive a single newline-terminated message.
+ *
+ * \param[in]       sockfd      Active socket descriptor.
+ * \param[out]      buffer      Output buffer for received line.
+ * \param[in]       maxlen      Maximum buffer size.
+ *
+ * \return          Number of bytes read, 0 on clean close, -1 on error.
+ *
+ * \note            Reads one byte at a time to preserve message boundaries.
+ */
+ssize_t recv_line(int sockfd, char *buffer, size_t maxlen)
+{
+    size_t pos = 0;
+
+    while (pos < maxlen - 1) {
+        char c;
+
+        /* Receive exactly one byte */
+        ssize_t n = recv(sockfd, &c, 1, 0);
+
+        if (n == 0) {
+            /* Peer closed connection */
+            buffer[pos] = '\0';
+            return 0;
+        }
+
+        if (n < 0) {
+            if (errno == EINTR)
+                continue;  /* Retry interrupted system call */
+            return -1;
+        }
+
+        buffer[pos++] = c;
+
+        /* Stop at newline for protocol framing */
+        if (c == '\n')
+            break;
+
+        /* Prevent buffer overflow */
+        if (pos == maxlen - 1) {
+            buffer[pos] = '\0';
+            return (ssize_t)pos;
+        }
+    }
+
+    buffer[pos] = '\0';
+    return (ssize_t)pos;
+}
+
+/**
+ * \brief           Stream a producer's chunks to the socket, then the marker.
+ *
+ * \return          Bytes sent, -1 on failure.
+ */
+ssize_t send_stream(int sockfd, stream_fill_fn fill, void *ctx, char *chunks) {
+    struct iovec iov[STREAM_CHUNKS + 1];
+    char last = '\n';
+    ssize_t total = 0;
+    int done = 0;
+
+    while (!done) {
+        int cnt = 0;
+        while (cnt < STREAM_CHUNKS) {
+            char *chunk = chunks + (size_t)cnt * STREAM_CHUNK_BYTES;
+            size_t n = fill(ctx, chunk, STREAM_CHUNK_BYTES);
+            if (n == 0) {
+                done = 1;
+                break;
+            }
+            last = chunk[n - 1];
+            iov[cnt].iov_base = chunk;
+            iov[cnt].iov_len = n;
+            cnt++;
+        }
+
+        if (done) {
+            /* Terminate the body's last line, then frame it */
+            static const char tail[] = "\n" END_MARKER;
+            iov[cnt].iov_base = (void *)(last == '\n' ? tail + 1 : tail);
+            iov[cnt].iov_len = last == '\n' ? sizeof(tail) - 2 : sizeof(tail) - 1;
+            cnt++;
+        }
+
+        ssize_t n = send_iov(sockfd, iov, cnt, 0);
+        if (n < 0)
+            return -1;
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * \brief           Write a framed response into \p dst if it fits.
+ *
+ * \return          Bytes written, 0 if \p cap is too small.
+ */
+size_t frame_response(char *dst, size_t cap, const char *message) {
+    size_t len = strlen(message);
+    size_t sep = (len > 0 && message[len - 1] == '\n') ? 0 : 1;
+    size_t mark = sizeof(END_MARKER) - 1;
+    size_t total = len + sep + mark;
+
+    if (total + 1 > cap)
+        return 0;
+
+    memcpy(dst, message, len);
+    if (sep) dst[len] = '\n';
+    memcpy(dst + len + sep, END_MARKER, mark + 1);
+    return total;
+}
+
+/* ========================================================================== */
+/* ========================== Buffered Line Reader ========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Attach an empty line reader to \p fd.
+ */
+void line_reader_init(line_reader_t *r, int fd) {
+    r->fd = fd;
+    r->start = 0;
+    r->end = 0;
+}
+
+/**
+ * \brief           Compact the buffer and append one recv() worth of data.
+ *
+ * \return          Bytes received, 0 on close, -1 on error.
+ */
+ssize_t line_reader_fill(line_reader_t *r) {
+    /* Slide unconsumed bytes to the front to maximize free space */
+    if (r->start > 0) {
+        memmove(r->buf, r->buf + r->start, r->end - r->start);
+        r->end -= r->start;
+        r->start = 0;
+    }
+
+    /* One byte stays spare so an unterminated line can be NUL-terminated */
+    size_t room = sizeof(r->buf) - 1 - r->end;
+    if (room == 0) {
+        errno = ENOBUFS;
+        return -1;
+    }
+
+    for (;;) {
+        ssize_t n = recv(r->fd, r->buf + r->end, room, 0);
+        if (n < 0 && errno == EINTR)
+            continue;  /* Retry interrupted system call */
+        if (n > 0)
+            r->end += (size_t)n;
+        return n;
+    }
+}
+
+/**
+ * \brief           Return the next buffered line in place.
+ *
+ * \return          1 if \p line / \p len were set, 0 if no full line yet.
+ */
+int line_reader_next(line_reader_t *r, char **line, size_t *len) {
+    char *p = r->buf + r->start;
+    size_t avail = r->end - r->start;
+    char *nl = memchr(p, '\n', avail);
+
+    if (nl) {
+        *nl = '\0';
+        *len = (size_t)(nl - p);
+        r->start += *len + 1;
+    } else if (r->start == 0 && r->end == sizeof(r->buf) - 1) {
+        /* Buffer full without a newline: hand it over as one line */
+        p[avail] = '\0';
+        *len = avail;
+        r->start = r->end;
+    } else {
+        return 0;
+    }
+
+    *line = p;
+    return 1;
+}
+
+/**
+ * \brief           Bytes received but not yet consumed.
+ */
+size_t line_reader_pending(const line_reader_t *r) {
+    return r->end - r->start;
+}
+
+/**
+ * \brief           Copy \p len bytes out of the buffer, receiving as needed.
+ *
+ * \return          \p len, 0 on close, -1 on error.
+ */
+ssize_t line_reader_read_exact(line_reader_t *r, void *dst, size_t len) {
+    char *out = dst;
+    size_t done = 0;
+
+    while (done < len) {
+        size_t avail = r->end - r->start;
+        if (avail == 0) {
+            ssize_t got = line_reader_fill(r);
+            if (got <= 0) return got;
+            continue;
+        }
+        size_t n = (len - done < avail) ? len - done : avail;
+        memcpy(out + done, r->buf + r->start, n);
+        r->start += n;
+        done += n;
+    }
+    return (ssize_t)len;
+}
+
+/**
+ * \brief           Skip \p len buffered bytes (clamped to what is buffered).
+ */
+void line_reader_consume(line_reader_t *r, size_t len) {
+    size_t avail = r->end - r->start;
+    r->start += (len < avail) ? len : avail;
+}
+
+/**
+ * \brief           Copy the next newline-terminated line into \p buffer.
+ *
+ * \return          Bytes copied, 0 on clean close, -1 on error.
+ *
+ * \note            Same contract as recv_line(): the newline is kept and a
+ *                  line longer than \p maxlen - 1 is returned in pieces.
+ */
+ssize_t line_reader_read(line_reader_t *r, char *buffer, size_t maxlen) {
+    for (;;) {
+        char *p = r->buf + r->start;
+        size_t avail = r->end - r->start;
+        char *nl = memchr(p, '\n', avail);
+        size_t n = nl ? (size_t)(nl - p) + 1 : avail;
+        int full = (r->start == 0 && r->end == sizeof(r->buf) - 1);
+
+        if (nl || avail >= maxlen - 1 || full) {
+            if (n > maxlen - 1) n = maxlen - 1;
+            memcpy(buffer, p, n);
+            buffer[n] = '\0';
+            r->start += n;
+            return (ssize_t)n;
+        }
+
+        ssize_t got = line_reader_fill(r);
+        if (got <= 0) {
+            buffer[0] = '\0';
+            return got;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* ============================ Safe I/O Helpers ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Write exactly \p size bytes to a file descriptor.
+ *
+ * \param[in]       fd          Target file descriptor.
+ * \param[in]       buf         Data buffer to write.
+ * \param[in]       size        Number of bytes to write.
+ *
+ * \return          Number of bytes written, -1 on failure.
+ */
+ssize_t safe_write(int fd, const void *buf, size_t size) {
+    size_t total = 0;
+    ssize_t n;
+    while (total < size) {
+        n = write(fd, (const char*)buf + total, size - total);
+        if (n <= 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        total += (size_t)n;
+    }
+    return (ssize_t)total;
+}
+
+/**
+ * \brief           Read exactly \p size bytes from a file descriptor.
+ *
+ * \param[in]       fd          Source file descriptor.
+ * \param[out]      buf         Output buffer.
+ * \param[in]       size        Number of bytes to read.
+ *
+ * \return          Number of bytes read, -1 on failure.
+ */
+ssize_t safe_read(int fd, void *buf, size_t size) {
+    size_t total = 0;
+    ssize_t n;
+    while (total < size) {
+        n = read(fd, (char*)buf + total, size - total);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        } else if (n == 0) break;
+        total += (size_t)n;
+    }
+    return (ssize_t)total;
+}
+
+/**
+ * \brief           Write exactly \p size bytes at offset \p off.
+ *
+ * \param[in]       fd          Target file descriptor.
+ * \param[in]       buf         Data buffer to write.
+ * \param[in]       size        Number of bytes to write.
+ * \param[in]       off         Absolute file offset.
+ *
+ * \return          Number of bytes written, -1 on failure.
+ */
+ssize_t safe_pwrite(int fd, const void *buf, size_t size, off_t off) {
+    size_t total = 0;
+    ssize_t n;
+    while (total < size) {
+        n = pwrite(fd, (const char*)buf + total, size - total, off + (off_t)total);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return -1;
+        }
+        total += (size_t)n;
+    }
+    return (ssize_t)total;
+}
+
+/**
+ * \brief           Read up to \p size bytes at offset \p off.
+ *
+ * \param[in]       fd          Source file descriptor.
+ * \param[out]      buf         Output buffer.
+ * \param[in]       size        Number of bytes to read.
+ * \param[in]       off         Absolute file offset.
+ *
+ * \return          Number of bytes read, -1 on failure.
+ */
+ssize_t safe_pread(int fd, void *buf, size_t size, off_t off) {
+    size_t total = 0;
+    ssize_t n;
+    while (total < size) {
+        n = pread(fd, (char*)buf + total, size - total, off + (off_t)total);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        } else if (n == 0) break;
+        total += (size_t)n;
+    }
+    return (ssize_t)total;
+}
+
+/* ========================================================================== */
+/* ============================ set_nonblocking ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Add O_NONBLOCK to a descriptor's status flags.
+ *
+ * \param[in]       fd          Descriptor to modify.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+/* ========================================================================== */
+/* ============================== trim_newline ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Remove trailing CR/LF characters from a string.
+ *
+ * \param[in,out]   str         Input string to sanitize.
+ */
+void trim_newline(char *str) {
+    if (!str || *str == '\0') return;
+    
+    /* Replace first newline occurrence with null terminator */
+    str[strcspn(str, "\r\n")] = '\0';
+}
+
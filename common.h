@@ -1,173 +1,433 @@
-/*
-#############################################################
-# Author: Arek Gebka                                        #
-# Major: Computer Science                                   #
-# Creation Date: October 30, 2025                           #
-# Last Updated: December 2025                               #
-# Due Date: December 10, 2025                               #
-# Course: CPSC 552 — Advanced Unix Programming              #
-# Professor Name: Dr. Dylan Schwesinger                     #
-# Assignment: Project 6 — Threaded Server                   #
-# Filename: common.h                                        #
-# Purpose:                                                   #
-#     Declares shared constants, global flags, and utility  #
-#     function prototypes for socket setup, communication, #
-#     and safe I/O used by both the threaded server and     #
-#     client. Provides a consistent TCP networking         #
-#     interface across Project 6.                           #
-#############################################################
-# Citations:                                                #
-# [1] Beej’s Guide to Network Programming, Using Sockets    #
-#     https://beej.us/guide/bgnet/                           #
-# [2] Linux Man Pages: socket(2), bind(2), listen(2),       #
-#     accept(2), connect(2), send(2), recv(2),              #
-#     signal(2), write(2), read(2), getaddrinfo(3)          #
-#     https://man7.org/linux/man-pages/                     #
-# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
-# [4] Dr. Dylan Schwesinger, CPSC 552 — Project 6 Notes     #
-# [5] MaJerle C Code Style Guide                            #
-#     https://github.com/MaJerle/c-code-style               #
-#############################################################
-*/
-
-#ifndef COMMON_H
-#define COMMON_H
-
-#include <stdio.h>      /* printf, fprintf */
-#include <stdlib.h>     /* exit, atoi */
-#include <string.h>     /* strlen, memset, strcspn */
-#include <unistd.h>     /* read, write, close */
-#include <errno.h>      /* errno, EINTR */
-
-#include <arpa/inet.h>  /* inet_pton, sockaddr_in */
-#include <sys/socket.h> /* socket, bind, listen, accept, connect */
-#include <sys/types.h>  /* ssize_t */
-#include <netdb.h>      /* getaddrinfo */
-#include <signal.h>     /* sig_atomic_t, SIGINT */
-
-// Compatibility placeholders
-#define safe_read read
-#define safe_write write
-
-
-/* ========================================================================== */
-/* ============================== Configuration ============================= */
-/* ========================================================================== */
-
-/*!< Maximum protocol buffer size for send/recv operations. */
-#define BUFFER_SIZE 8192
-
-/*!< Maximum pending connection backlog for the threaded server. */
-#define BACKLOG     10
-
-/* ========================================================================== */
-/* ====================== Global Signal-Controlled Flag ===================== */
-/* ========================================================================== */
-
-/**
- * \brief Global run-control flag.
- *
- * Set to 0 by the SIGINT handler to request graceful shutdown
- * of server accept loops and worker threads.
- */
-extern volatile sig_atomic_t keep_running;
-
-/* ========================================================================== */
-/* ============================== Signal Handling =========================== */
-/* ========================================================================== */
-
-/**
- * \brief           SIGINT handler for graceful termination.
- *
- * \param[in]       sig         Signal number (SIGINT).
- *
- * \note            This function should only set a flag and perform
- *                  async-signal-safe operations.
- */
-void handle_sigint(int sig);
-
-/* ========================================================================== */
-/* =========================== Socket Setup (GAI) =========================== */
-/* ========================================================================== */
-
-/**
- * \brief           Create and configure a TCP server socket bound to a port.
- *
- * \param[in]       port        Port number as a null-terminated string.
- *
- * \return          Listening socket descriptor on success, -1 on failure.
- *
- * \note            Uses getaddrinfo() for portability and enables
- *                  SO_REUSEADDR for rapid restarts.
- */
-int create_server_socket(const char *port);
-
-/**
- * \brief           Establish a TCP client connection.
- *
- * \param[in]       host        Hostname or IPv4 string.
- * \param[in]       port        Port number as a string.
- *
- * \return          Connected socket descriptor on success, -1 on failure.
- */
-int connect_to_server(const char *host, const char *port);
-
-/* ========================================================================== */
-/* ================================ I/O Utilities =========================== */
-/* ========================================================================== */
-
-/**
- * \brief           Send an entire null-terminated buffer across a socket.
- *
- * \param[in]       sockfd      Active socket descriptor.
- * \param[in]       buffer      Null-terminated message buffer.
- *
- * \return          Number of bytes transmitted, -1 on failure.
- *
- * \note            Handles short writes caused by TCP stream buffering.
- */
-ssize_t send_all(int sockfd, const char *buffer);
-
-/**
- * \brief           Receive a newline-terminated message from a socket.
- *
- * \param[in]       sockfd      Active socket descriptor.
- * \param[out]      buffer      Destination buffer.
- * \param[in]       maxlen      Maximum buffer capacity.
- *
- * \return          Number of bytes received, 0 on orderly close, -1 on error.
- *
- * \note            Reads one byte at a time to preserve protocol framing.
- */
-ssize_t recv_line(int sockfd, char *buffer, size_t maxlen);
-
-/**
- * \brief           Safely write an exact number of bytes to a descriptor.
- *
- * \param[in]       fd          Target file descriptor.
- * \param[in]       buf         Data buffer.
- * \param[in]       size        Number of bytes to write.
- *
- * \return          Number of bytes written, -1 on failure.
- */
-ssize_t safe_write(int fd, const void *buf, size_t size);
-
-/**
- * \brief           Safely read an exact number of bytes from a descriptor.
- *
- * \param[in]       fd          Source file descriptor.
- * \param[out]      buf         Destination buffer.
- * \param[in]       size        Number of bytes to read.
- *
- * \return          Number of bytes read, -1 on failure.
- */
-ssize_t safe_read(int fd, void *buf, size_t size);
-
-/**
- * \brief           Remove trailing newline and carriage return characters.
- *
- * \param[in,out]   str         Input string modified in-place.
- */
-void trim_newline(char *str);
-
-#endif // COMMON_H
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: October 30, 2025                           #
+# Last Updated: December 2025                               #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: common.h                                        #
+# Purpose:                                                   #
+#     Declares shared constants, global flags, and utility  #
+#     function prototypes for socket setup, communication, #
+#     and safe I/O used by both the threaded server and     #
+#     client. Provides a consistent TCP networking         #
+#     interface across Project 6.                           #
+#############################################################
+# Citations:                                                #
+# [1] Beej’s Guide to Network Programming, Using Sockets    #
+#     https://beej.us/guide/bgnet/                           #
+# [2] Linux Man Pages: socket(2), bind(2), listen(2),       #
+#     accept(2), connect(2), send(2), recv(2),              #
+#     signal(2), write(2), read(2), getaddrinfo(3)          #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] Dr. Dylan Schwesinger, CPSC 552 — Project 6 Notes     #
+# [5] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stdio.h>      /* printf, fprintf */
+#include <stdlib.h>     /* exit, atoi */
+#include <string.h>     /* strlen, memset, strcspn */
+#include <unistd.h>     /* read, write, close */
+#include <errno.h>      /* errno, EINTR */
+
+#include <arpa/inet.h>  /* inet_pton, sockaddr_in */
+#include <sys/socket.h> /* socket, bind, listen, accept, connect */
+#include <sys/types.h>  /* ssize_t */
+#include <sys/uio.h>    /* struct iovec */
+#include <netdb.h>      /* getaddrinfo */
+#include <signal.h>     /* sig_atomic_t, SIGINT */
+
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Maximum protocol buffer size for send/recv operations. */
+#define BUFFER_SIZE 8192
+
+/*!< Maximum pending connection backlog for the threaded server. */
+#define BACKLOG     10
+
+/*!< Line sent by the server after every response body. */
+#define END_MARKER  "[END]\n"
+
+/*!< Bytes a stream producer is asked for per call. */
+#define STREAM_CHUNK_BYTES  4096
+
+/*!< Producer chunks gathered into one sendmsg() by send_stream(). */
+#define STREAM_CHUNKS       4
+
+/*!< Vectors response_iov() may fill (body, separator + marker). */
+#define RESPONSE_IOV        2
+
+/*!< Smallest send that uses MSG_ZEROCOPY; page pinning costs more below. */
+#define ZEROCOPY_MIN_BYTES  (64 * 1024)
+
+/*!< Longest wait for the kernel to release zero-copy buffers. */
+#define ZEROCOPY_WAIT_MS    1000
+
+/* ========================================================================== */
+/* ========================== Buffered Line Reader ========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Pull-style producer for a streamed response body.
+ *
+ * \param[in,out]   ctx         Producer state (cursor etc.).
+ * \param[out]      buf         Destination for the next chunk.
+ * \param[in]       cap         Bytes available at \p buf.
+ *
+ * \return          Bytes written; 0 once the body is complete.
+ *
+ * \note            Called repeatedly until it returns 0, so a large result is
+ *                  produced and sent in bounded pieces instead of built whole.
+ */
+typedef size_t (*stream_fill_fn)(void *ctx, char *buf, size_t cap);
+
+/**
+ * \brief           Per-connection receive buffer for newline-framed input.
+ *
+ * \note            Filled with large recv() calls; lines are located with
+ *                  memchr() and any bytes past the last newline are kept for
+ *                  the next line, so a command costs far fewer syscalls than
+ *                  the byte-at-a-time recv_line().
+ */
+typedef struct {
+    int     fd;                     /*!< Socket being read */
+    size_t  start;                  /*!< First unconsumed byte in \ref buf */
+    size_t  end;                    /*!< One past the last received byte */
+    char    buf[BUFFER_SIZE];       /*!< Received bytes (last byte kept spare) */
+} line_reader_t;
+
+/* ========================================================================== */
+/* ====================== Global Signal-Controlled Flag ===================== */
+/* ========================================================================== */
+
+/**
+ * \brief Global run-control flag.
+ *
+ * Set to 0 by the SIGINT handler to request graceful shutdown
+ * of server accept loops and worker threads.
+ */
+extern volatile sig_atomic_t keep_running;
+
+/* ========================================================================== */
+/* ============================== Signal Handling =========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           SIGINT handler for graceful termination.
+ *
+ * \param[in]       sig         Signal number (SIGINT).
+ *
+ * \note            This function should only set a flag and perform
+ *                  async-signal-safe operations.
+ */
+void handle_sigint(int sig);
+
+/* ========================================================================== */
+/* =========================== Socket Setup (GAI) =========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Create and configure a TCP server socket bound to a port.
+ *
+ * \param[in]       port        Port number as a null-terminated string.
+ *
+ * \return          Listening socket descriptor on success, -1 on failure.
+ *
+ * \note            Uses getaddrinfo() for portability and enables
+ *                  SO_REUSEADDR for rapid restarts.
+ */
+int create_server_socket(const char *port);
+
+/**
+ * \brief           Create a TCP listening socket that shares its port.
+ *
+ * \param[in]       port        Port number as a null-terminated string.
+ *
+ * \return          Listening socket descriptor on success, -1 on failure.
+ *
+ * \note            Enables SO_REUSEPORT so several reactor threads can each
+ *                  own a listener on the same port and let the kernel
+ *                  balance incoming connections between them.
+ */
+int create_reuseport_socket(const char *port);
+
+/**
+ * \brief           Establish a TCP client connection.
+ *
+ * \param[in]       host        Hostname or IPv4 string.
+ * \param[in]       port        Port number as a string.
+ *
+ * \return          Connected socket descriptor on success, -1 on failure.
+ */
+int connect_to_server(const char *host, const char *port);
+
+/* ========================================================================== */
+/* ================================ I/O Utilities =========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Turn Nagle's algorithm off (\p on = 1) or back on.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int socket_set_nodelay(int sockfd, int on);
+
+/**
+ * \brief           Set or clear TCP_CORK to merge several sends into full segments.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int socket_set_cork(int sockfd, int on);
+
+/**
+ * \brief           Opt a socket in to MSG_ZEROCOPY sends (Linux 4.14+).
+ *
+ * \return          0 on success, -1 if unsupported.
+ */
+int socket_enable_zerocopy(int sockfd);
+
+/**
+ * \brief           Send a list of buffers completely with sendmsg().
+ *
+ * \param[in]       sockfd      Active socket descriptor.
+ * \param[in,out]   iov         Buffers to send; consumed in place.
+ * \param[in]       cnt         Number of buffers.
+ * \param[in]       zerocopy    Non-zero to use MSG_ZEROCOPY for large sends.
+ *
+ * \return          Number of bytes transmitted, -1 on failure.
+ *
+ * \note            Handles short writes; the buffers are reusable on return.
+ */
+ssize_t send_iov(int sockfd, struct iovec *iov, int cnt, int zerocopy);
+
+/**
+ * \brief           Send exactly \p len bytes (may contain NUL bytes).
+ *
+ * \param[in]       sockfd      Active socket descriptor.
+ * \param[in]       buf         Data to transmit.
+ * \param[in]       len         Number of bytes to transmit.
+ *
+ * \return          Number of bytes transmitted, -1 on failure.
+ */
+ssize_t send_bytes(int sockfd, const void *buf, size_t len);
+
+/**
+ * \brief           Fill \p iov with a body plus its newline and END_MARKER.
+ *
+ * \param[out]      iov         At least RESPONSE_IOV vectors.
+ * \param[in]       body        Response body.
+ * \param[in]       len         Body length in bytes.
+ *
+ * \return          Number of vectors filled.
+ */
+int response_iov(struct iovec *iov, const char *body, size_t len);
+
+/**
+ * \brief           Send a body of known length followed by END_MARKER.
+ *
+ * \param[in]       zerocopy    Passed through to send_iov().
+ *
+ * \return          Number of bytes transmitted, -1 on failure.
+ */
+ssize_t send_framed(int sockfd, const char *body, size_t len, int zerocopy);
+
+/**
+ * \brief           Send a response body followed by the END_MARKER line.
+ *
+ * \param[in]       sockfd      Active socket descriptor.
+ * \param[in]       message     Null-terminated response body.
+ *
+ * \return          Number of bytes transmitted, -1 on failure.
+ */
+ssize_t send_response(int sockfd, const char *message);
+
+/**
+ * \brief           Send a streamed response body followed by END_MARKER.
+ *
+ * \param[in]       sockfd      Active socket descriptor.
+ * \param[in]       fill        Producer called until it returns 0.
+ * \param[in,out]   ctx         Producer state.
+ * \param[out]      chunks      Scratch of STREAM_CHUNKS * STREAM_CHUNK_BYTES.
+ *
+ * \return          Number of bytes transmitted, -1 on failure.
+ *
+ * \note            Up to STREAM_CHUNKS chunks go out per sendmsg(), and the
+ *                  marker rides in the same call as the last chunk, so memory
+ *                  stays bounded no matter how large the body is. The
+ *                  caller lends \p chunks so a small thread stack suffices.
+ */
+ssize_t send_stream(int sockfd, stream_fill_fn fill, void *ctx, char *chunks);
+
+/**
+ * \brief           Append one framed response (body, newline, END_MARKER).
+ *
+ * \param[out]      dst         Destination buffer; stays NUL-terminated.
+ * \param[in]       cap         Bytes available at \p dst.
+ * \param[in]       message     Null-terminated response body.
+ *
+ * \return          Bytes written (excluding the NUL), 0 if it does not fit.
+ *
+ * \note            Lets a session coalesce several pipelined replies into
+ *                  one buffer and hand them to the kernel with one send().
+ */
+size_t frame_response(char *dst, size_t cap, const char *message);
+
+/**
+ * \brief           Receive a newline-terminated message from a socket.
+ *
+ * \param[in]       sockfd      Active socket descriptor.
+ * \param[out]      buffer      Destination buffer.
+ * \param[in]       maxlen      Maximum buffer capacity.
+ *
+ * \return          Number of bytes received, 0 on orderly close, -1 on error.
+ *
+ * \note            Reads one byte at a time to preserve protocol framing.
+ */
+ssize_t recv_line(int sockfd, char *buffer, size_t maxlen);
+
+/**
+ * \brief           Attach an empty line reader to a socket.
+ *
+ * \param[out]      r           Reader to initialize.
+ * \param[in]       fd          Connected socket descriptor.
+ */
+void line_reader_init(line_reader_t *r, int fd);
+
+/**
+ * \brief           Pull more bytes from the socket with a single recv().
+ *
+ * \param[in,out]   r           Reader to fill.
+ *
+ * \return          Bytes received, 0 on orderly close, -1 on error (errno
+ *                  set; EAGAIN on a non-blocking socket with nothing ready).
+ */
+ssize_t line_reader_fill(line_reader_t *r);
+
+/**
+ * \brief           Take the next complete line already buffered (zero-copy).
+ *
+ * \param[in,out]   r           Reader to consume from.
+ * \param[out]      line        Points into the reader's buffer; the newline
+ *                              is replaced by a terminating NUL.
+ * \param[out]      len         Line length without the newline.
+ *
+ * \return          1 if a line was returned, 0 if more input is needed.
+ *
+ * \note            A full buffer with no newline is returned as one line,
+ *                  matching recv_line()'s overflow behaviour. The pointer is
+ *                  valid until the next line_reader_fill().
+ */
+int line_reader_next(line_reader_t *r, char **line, size_t *len);
+
+/**
+ * \brief           Bytes buffered but not yet returned as lines.
+ */
+size_t line_reader_pending(const line_reader_t *r);
+
+/**
+ * \brief           Read exactly \p len raw bytes through the reader.
+ *
+ * \param[in,out]   r           Reader attached to the socket.
+ * \param[out]      dst         Destination for the bytes.
+ * \param[in]       len         Bytes wanted.
+ *
+ * \return          \p len on success, 0 if the peer closed first, -1 on error.
+ *
+ * \note            Used once a connection leaves line framing (binary mode);
+ *                  buffered bytes are consumed before the socket is read.
+ */
+ssize_t line_reader_read_exact(line_reader_t *r, void *dst, size_t len);
+
+/**
+ * \brief           Drop \p len already-buffered bytes.
+ */
+void line_reader_consume(line_reader_t *r, size_t len);
+
+/**
+ * \brief           Buffered drop-in replacement for recv_line().
+ *
+ * \param[in,out]   r           Reader attached to the socket.
+ * \param[out]      buffer      Destination buffer (line keeps its newline).
+ * \param[in]       maxlen      Maximum buffer capacity.
+ *
+ * \return          Number of bytes copied, 0 on orderly close, -1 on error.
+ */
+ssize_t line_reader_read(line_reader_t *r, char *buffer, size_t maxlen);
+
+/**
+ * \brief           Safely write an exact number of bytes to a descriptor.
+ *
+ * \param[in]       fd          Target file descriptor.
+ * \param[in]       buf         Data buffer.
+ * \param[in]       size        Number of bytes to write.
+ *
+ * \return          Number of bytes written, -1 on failure.
+ */
+ssize_t safe_write(int fd, const void *buf, size_t size);
+
+/**
+ * \brief           Safely read an exact number of bytes from a descriptor.
+ *
+ * \param[in]       fd          Source file descriptor.
+ * \param[out]      buf         Destination buffer.
+ * \param[in]       size        Number of bytes to read.
+ *
+ * \return          Number of bytes read, -1 on failure.
+ */
+ssize_t safe_read(int fd, void *buf, size_t size);
+
+/**
+ * \brief           Write exactly \p size bytes at file offset \p off.
+ *
+ * \param[in]       fd          Target file descriptor.
+ * \param[in]       buf         Data buffer.
+ * \param[in]       size        Number of bytes to write.
+ * \param[in]       off         Absolute file offset.
+ *
+ * \return          Number of bytes written, -1 on failure.
+ *
+ * \note            Uses pwrite(), so threads never share a file position.
+ */
+ssize_t safe_pwrite(int fd, const void *buf, size_t size, off_t off);
+
+/**
+ * \brief           Read up to \p size bytes at file offset \p off.
+ *
+ * \param[in]       fd          Source file descriptor.
+ * \param[out]      buf         Destination buffer.
+ * \param[in]       size        Number of bytes to read.
+ * \param[in]       off         Absolute file offset.
+ *
+ * \return          Number of bytes read (short only at EOF), -1 on failure.
+ */
+ssize_t safe_pread(int fd, void *buf, size_t size, off_t off);
+
+/**
+ * \brief           Switch a descriptor to non-blocking mode.
+ *
+ * \param[in]       fd          Descriptor to modify.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int set_nonblocking(int fd);
+
+/**
+ * \brief           Remove trailing newline and carriage return characters.
+ *
+ * \param[in,out]   str         Input string modified in-place.
+ */
+void trim_newline(char *str);
+
+#endif // COMMON_H
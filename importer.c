@@ -0,0 +1,620 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: importer.c                                      #
+# Purpose:                                                   #
+#     Converts the Pokémon CSV catalog into the headered    #
+#     pokemon.bin format of pokemon_db.h. The CSV is mapped #
+#     and tokenized in place without per-field allocation;  #
+#     records are sorted by ID and written to a temporary   #
+#     file that replaces the target with rename().          #
+#############################################################
+# Citations:                                                #
+# [1] RFC 4180, Common Format for CSV Files                 #
+# [2] Linux Man Pages: mmap(2), madvise(2), rename(2),      #
+#     fsync(2), strtof(3)                                   #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf, snprintf, rename */
+#include <stdlib.h>     /* realloc, malloc, free, qsort, strtof */
+#include <string.h>     /* memcpy, memset, strcmp, strncmp */
+#include <stddef.h>     /* offsetof */
+#include <limits.h>     /* INT_MAX, INT_MIN */
+#include <endian.h>     /* htole16, htole32 */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, fsync, unlink */
+#include <sys/stat.h>   /* fstat */
+#include <sys/mman.h>   /* mmap, madvise, munmap */
+
+#include "common.h"
+#include "pokemon_db.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Most CSV columns a row may have (extra columns are an error). */
+#define CSV_MAX_FIELDS      64
+
+/*!< Longest numeric field text accepted for strtof(). */
+#define CSV_NUMBER_MAX      32
+
+/*!< Records gathered per write() when the input was not sorted. */
+#define IMPORT_WRITE_BATCH  256
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< One field of the current row: a span of the mapped CSV. */
+typedef struct {
+    const char *p;                  /*!< First byte (after an opening quote) */
+    size_t      len;                /*!< Bytes in the span */
+    int         quoted;             /*!< Span may contain doubled quotes */
+} csv_field_t;
+
+/*!< Read position inside the mapped CSV. */
+typedef struct {
+    const char *cur;                /*!< Next unread byte */
+    const char *end;                /*!< One past the last byte */
+    size_t      line;               /*!< Line number of \ref cur (1-based) */
+} csv_cursor_t;
+
+/*!< How a column's text is stored in the Pokemon record. */
+typedef enum {
+    COL_INT,
+    COL_FLOAT,
+    COL_BOOL,
+    COL_STR
+} column_kind_t;
+
+/*!< CSV column → Pokemon field mapping. */
+typedef struct {
+    const char     *name;           /*!< Header name in the CSV */
+    column_kind_t   kind;           /*!< Conversion */
+    size_t          offset;         /*!< offsetof(Pokemon, field) */
+    size_t          size;           /*!< sizeof the field */
+} column_t;
+
+/*!< Sort key for inputs that are not already in ID order. */
+typedef struct {
+    int         id;                 /*!< Pokémon ID */
+    uint32_t    index;              /*!< Position in input order */
+} sort_key_t;
+
+#define COLUMN(n, k, f) { n, k, offsetof(Pokemon, f), sizeof(((Pokemon *)0)->f) }
+
+/*!< Every column the importer needs; the CSV may order them freely. */
+static const column_t columns[] = {
+    COLUMN("Number",           COL_INT,   id),
+    COLUMN("Name",             COL_STR,   name),
+    COLUMN("Type_1",           COL_STR,   type1),
+    COLUMN("Type_2",           COL_STR,   type2),
+    COLUMN("Total",            COL_INT,   total),
+    COLUMN("HP",               COL_INT,   hp),
+    COLUMN("Attack",           COL_INT,   attack),
+    COLUMN("Defense",          COL_INT,   defense),
+    COLUMN("Sp_Atk",           COL_INT,   sp_atk),
+    COLUMN("Sp_Def",           COL_INT,   sp_def),
+    COLUMN("Speed",            COL_INT,   speed),
+    COLUMN("Generation",       COL_INT,   generation),
+    COLUMN("isLegendary",      COL_BOOL,  legendary),
+    COLUMN("Color",            COL_STR,   color),
+    COLUMN("hasGender",        COL_BOOL,  hasGender),
+    COLUMN("Pr_Male",          COL_FLOAT, pr_male),
+    COLUMN("Egg_Group_1",      COL_STR,   egg_group1),
+    COLUMN("Egg_Group_2",      COL_STR,   egg_group2),
+    COLUMN("hasMegaEvolution", COL_BOOL,  hasMegaEvolution),
+    COLUMN("Height_m",         COL_FLOAT, height_m),
+    COLUMN("Weight_kg",        COL_FLOAT, weight_kg),
+    COLUMN("Catch_Rate",       COL_INT,   catch_rate),
+    COLUMN("Body_Style",       COL_STR,   body_style),
+};
+
+#define NCOLUMNS    (sizeof(columns) / sizeof(columns[0]))
+
+/* ========================================================================== */
+/* ================================ Tokenizer =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Read one field starting at the cursor.
+ *
+ * \param[out]      eol         Set when the field ended its row.
+ *
+ * \return          1 on success, -1 on an unterminated quoted field.
+ *
+ * \note            Fields are spans into the mapping; nothing is copied
+ *                  until a converter stores them into a record.
+ */
+static int csv_field(csv_cursor_t *c, csv_field_t *f, int *eol) {
+    const char *p = c->cur;
+
+    f->quoted = 0;
+    if (p < c->end && *p == '"') {
+        /* Quoted: runs to a quote that is not doubled */
+        const char *q = ++p;
+        for (;;) {
+            q = memchr(q, '"', (size_t)(c->end - q));
+            if (!q) return -1;
+            if (q + 1 < c->end && q[1] == '"') {
+                q += 2;
+                continue;
+            }
+            break;
+        }
+        for (const char *s = p; s < q; s++)
+            if (*s == '\n') c->line++;
+        f->p = p;
+        f->len = (size_t)(q - p);
+        f->quoted = 1;
+        p = q + 1;
+    } else {
+        const char *s = p;
+        while (s < c->end && *s != ',' && *s != '\n')
+            s++;
+        f->p = p;
+        f->len = (size_t)(s - p);
+        p = s;
+    }
+
+    /* Tolerate CRLF line endings */
+    if (!f->quoted && f->len > 0 && f->p[f->len - 1] == '\r')
+        f->len--;
+    else if (p < c->end && *p == '\r')
+        p++;
+
+    if (p >= c->end || *p == '\n') {
+        *eol = 1;
+        if (p < c->end) {
+            p++;
+            c->line++;
+        }
+    } else {
+        *eol = 0;
+        p++;    /* Skip the comma */
+    }
+    c->cur = p;
+    return 1;
+}
+
+/**
+ * \brief           Split the next non-empty row into \p fields.
+ *
+ * \return          Field count, 0 at end of input, -1 on a malformed row.
+ */
+static int csv_row(csv_cursor_t *c, csv_field_t *fields, int max) {
+    /* Skip blank lines */
+    while (c->cur < c->end && (*c->cur == '\n' || *c->cur == '\r')) {
+        if (*c->cur == '\n') c->line++;
+        c->cur++;
+    }
+    if (c->cur >= c->end)
+        return 0;
+
+    int n = 0, eol = 0;
+    while (!eol) {
+        if (n == max) return -1;
+        if (csv_field(c, &fields[n], &eol) < 0) return -1;
+        n++;
+    }
+    return n;
+}
+
+/* ========================================================================== */
+/* =============================== Converters =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Parse a whole-field decimal integer (empty → 0).
+ *
+ * \return          0 on success, -1 on stray characters or overflow.
+ */
+static int field_int(const csv_field_t *f, int *out) {
+    const char *p = f->p, *e = f->p + f->len;
+    int neg = 0;
+    long long v = 0;
+
+    if (p == e) {
+        *out = 0;
+        return 0;
+    }
+    if (*p == '-' || *p == '+') neg = (*p++ == '-');
+    if (p == e) return -1;
+
+    for (; p < e; p++) {
+        if (*p < '0' || *p > '9') return -1;
+        v = v * 10 + (*p - '0');
+        if (v > (long long)INT_MAX + 1) return -1;
+    }
+    if (neg) v = -v;
+    if (v > INT_MAX || v < INT_MIN) return -1;
+    *out = (int)v;
+    return 0;
+}
+
+/**
+ * \brief           Parse a whole-field float (empty → 0).
+ *
+ * \return          0 on success, -1 if the text is not a number.
+ */
+static int field_float(const csv_field_t *f, float *out) {
+    char buf[CSV_NUMBER_MAX];
+    char *end;
+
+    if (f->len == 0) {
+        *out = 0.0f;
+        return 0;
+    }
+    if (f->len >= sizeof(buf)) return -1;
+
+    /* strtof() needs a terminator the mapping does not have */
+    memcpy(buf, f->p, f->len);
+    buf[f->len] = '\0';
+    *out = strtof(buf, &end);
+    return (*end == '\0') ? 0 : -1;
+}
+
+/**
+ * \brief           Parse True/False (or 1/0; empty → 0).
+ *
+ * \return          0 on success, -1 on anything else.
+ */
+static int field_bool(const csv_field_t *f, int *out) {
+    if (f->len == 0 || (f->len == 1 && f->p[0] == '0') ||
+        (f->len == 5 && (strncmp(f->p, "False", 5) == 0 || strncmp(f->p, "false", 5) == 0))) {
+        *out = 0;
+        return 0;
+    }
+    if ((f->len == 1 && f->p[0] == '1') ||
+        (f->len == 4 && (strncmp(f->p, "True", 4) == 0 || strncmp(f->p, "true", 4) == 0))) {
+        *out = 1;
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * \brief           Copy a field into a fixed char array, NUL-padded.
+ *
+ * \note            Doubled quotes collapse to one; text longer than the
+ *                  field is truncated to leave room for the terminator.
+ */
+static void field_str(const csv_field_t *f, char *dst, size_t cap) {
+    size_t n = 0;
+    for (size_t i = 0; i < f->len && n + 1 < cap; i++) {
+        dst[n++] = f->p[i];
+        if (f->quoted && f->p[i] == '"')
+            i++;    /* Skip the second quote of a pair */
+    }
+    memset(dst + n, 0, cap - n);
+}
+
+/**
+ * \brief           Convert one CSV row into a Pokemon record.
+ *
+ * \param[in]       map         map[c] = CSV field index of columns[c].
+ *
+ * \return          -1 on success, otherwise the index of the bad column.
+ */
+static int convert_row(const csv_field_t *fields, const int *map, Pokemon *out) {
+    memset(out, 0, sizeof(*out));
+
+    for (size_t c = 0; c < NCOLUMNS; c++) {
+        const csv_field_t *f = &fields[map[c]];
+        char *dst = (char *)out + columns[c].offset;
+        int iv;
+        float fv;
+
+        switch (columns[c].kind) {
+        case COL_INT:
+            if (field_int(f, &iv) < 0) return (int)c;
+            memcpy(dst, &iv, sizeof(iv));
+            break;
+        case COL_FLOAT:
+            if (field_float(f, &fv) < 0) return (int)c;
+            memcpy(dst, &fv, sizeof(fv));
+            break;
+        case COL_BOOL:
+            if (field_bool(f, &iv) < 0) return (int)c;
+            memcpy(dst, &iv, sizeof(iv));
+            break;
+        case COL_STR:
+            field_str(f, dst, columns[c].size);
+            break;
+        }
+    }
+
+    if (out->id <= 0 || out->id > POKEMON_DB_MAX_ID)
+        return 0;   /* Column 0 is the ID */
+    return -1;
+}
+
+/* ========================================================================== */
+/* ================================= Import ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Order sort keys by ID, then input position.
+ */
+static int cmp_key(const void *a, const void *b) {
+    const sort_key_t *x = a, *y = b;
+    if (x->id != y->id) return (x->id < y->id) ? -1 : 1;
+    return (x->index < y->index) ? -1 : (x->index > y->index);
+}
+
+/**
+ * \brief           Resolve the header row into a column → field map.
+ *
+ * \return          0 on success, -1 if a required column is missing.
+ */
+static int map_header(const csv_field_t *fields, int n, int *map) {
+    for (size_t c = 0; c < NCOLUMNS; c++) {
+        size_t want = strlen(columns[c].name);
+        map[c] = -1;
+        for (int i = 0; i < n; i++) {
+            if (fields[i].len == want && memcmp(fields[i].p, columns[c].name, want) == 0) {
+                map[c] = i;
+                break;
+            }
+        }
+        if (map[c] < 0) {
+            fprintf(stderr, "[Importer] Missing CSV column %s\n", columns[c].name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Parse every data row of the mapped CSV.
+ *
+ * \param[out]      out         malloc'd records in input order.
+ * \param[out]      sorted      Set if the input already ascends by ID.
+ *
+ * \return          Record count, or -1 on a parse error (already reported).
+ */
+static long parse_csv(const char *path, const char *data, size_t size,
+                      Pokemon **out, int *sorted) {
+    csv_cursor_t cur = { data, data + size, 1 };
+    csv_field_t fields[CSV_MAX_FIELDS];
+    int map[NCOLUMNS];
+    Pokemon *recs = NULL;
+    size_t n = 0, cap = 0;
+
+    /* Skip a UTF-8 byte order mark */
+    if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0)
+        cur.cur += 3;
+
+    int nf = csv_row(&cur, fields, CSV_MAX_FIELDS);
+    if (nf <= 0 || map_header(fields, nf, map) < 0) {
+        if (nf <= 0)
+            fprintf(stderr, "[Importer] %s: missing header row\n", path);
+        return -1;
+    }
+
+    *sorted = 1;
+    for (;;) {
+        size_t line = cur.line;
+        nf = csv_row(&cur, fields, CSV_MAX_FIELDS);
+        if (nf == 0)
+            break;
+        if (nf < 0) {
+            fprintf(stderr, "[Importer] %s:%zu: malformed row\n", path, line);
+            goto fail;
+        }
+
+        int need = 0;
+        for (size_t c = 0; c < NCOLUMNS; c++)
+            if (map[c] >= need) need = map[c] + 1;
+        if (nf < need) {
+            fprintf(stderr, "[Importer] %s:%zu: %d field(s), expected %d\n",
+                    path, line, nf, need);
+            goto fail;
+        }
+
+        if (n == cap) {
+            size_t ncap = cap ? cap * 2 : 1024;
+            Pokemon *p = realloc(recs, ncap * sizeof(*recs));
+            if (!p) {
+                perror("[Importer] realloc()");
+                goto fail;
+            }
+            recs = p;
+            cap = ncap;
+        }
+
+        int bad = convert_row(fields, map, &recs[n]);
+        if (bad >= 0) {
+            const csv_field_t *f = &fields[map[bad]];
+            fprintf(stderr, "[Importer] %s:%zu: bad %s '%.*s'\n", path, line,
+                    columns[bad].name, (int)f->len, f->p);
+            goto fail;
+        }
+        if (n > 0 && recs[n].id <= recs[n - 1].id)
+            *sorted = 0;
+        if (++n > INT_MAX) {
+            fprintf(stderr, "[Importer] %s: too many rows\n", path);
+            goto fail;
+        }
+    }
+
+    *out = recs;
+    return (long)n;
+
+fail:
+    free(recs);
+    return -1;
+}
+
+/**
+ * \brief           Write the header and records (in ID order) to \p fd.
+ *
+ * \param[in]       keys        Sorted input positions, or NULL if \p recs
+ *                              is already in ID order.
+ *
+ * \return          0 on success, -1 on a write error.
+ */
+static int write_catalog(int fd, const Pokemon *recs, const sort_key_t *keys, size_t n) {
+    PokemonFileHeader h;
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, POKEMON_FILE_MAGIC, sizeof(h.magic));
+    h.version = htole16(POKEMON_FILE_VERSION);
+    h.header_size = htole16(sizeof(h));
+    h.record_size = htole32(sizeof(Pokemon));
+    h.count = htole32((uint32_t)n);
+    h.flags = htole32(POKEMON_FILE_SORTED);
+
+    if (safe_write(fd, &h, sizeof(h)) != (ssize_t)sizeof(h))
+        return -1;
+
+    if (!keys) {
+        size_t bytes = n * sizeof(Pokemon);
+        return (n == 0 || safe_write(fd, recs, bytes) == (ssize_t)bytes) ? 0 : -1;
+    }
+
+    /* Gather sorted records into batches so writes stay large */
+    Pokemon batch[IMPORT_WRITE_BATCH];
+    for (size_t i = 0; i < n; ) {
+        size_t k = 0;
+        while (k < IMPORT_WRITE_BATCH && i < n)
+            batch[k++] = recs[keys[i++].index];
+        if (safe_write(fd, batch, k * sizeof(Pokemon)) != (ssize_t)(k * sizeof(Pokemon)))
+            return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Import \p csv_path into \p out_path.
+ *
+ * \return          0 on success, -1 on failure (the target is untouched).
+ */
+static int import_catalog(const char *csv_path, const char *out_path) {
+    int fd = open(csv_path, O_RDONLY);
+    if (fd < 0) {
+        perror("[Importer] open()");
+        return -1;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || st.st_size == 0) {
+        fprintf(stderr, "[Importer] %s: empty or unreadable\n", csv_path);
+        close(fd);
+        return -1;
+    }
+
+    size_t size = (size_t)st.st_size;
+    char *data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        perror("[Importer] mmap()");
+        return -1;
+    }
+    madvise(data, size, MADV_SEQUENTIAL);
+
+    Pokemon *recs = NULL;
+    sort_key_t *keys = NULL;
+    int sorted = 0;
+    int rc = -1;
+    long n = parse_csv(csv_path, data, size, &recs, &sorted);
+    if (n < 0)
+        goto done;
+
+    /* Sort small keys instead of moving whole records around */
+    if (!sorted) {
+        keys = malloc((size_t)(n > 0 ? n : 1) * sizeof(*keys));
+        if (!keys) {
+            perror("[Importer] malloc()");
+            goto done;
+        }
+        for (long i = 0; i < n; i++) {
+            keys[i].id = recs[i].id;
+            keys[i].index = (uint32_t)i;
+        }
+        qsort(keys, (size_t)n, sizeof(*keys), cmp_key);
+        for (long i = 1; i < n; i++) {
+            if (keys[i].id == keys[i - 1].id) {
+                fprintf(stderr, "[Importer] %s: duplicate Pokémon ID %d\n",
+                        csv_path, keys[i].id);
+                goto done;
+            }
+        }
+    }
+
+    /* Write beside the target, then swap it in atomically */
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", out_path);
+    int out = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (out < 0) {
+        perror("[Importer] open()");
+        goto done;
+    }
+    if (write_catalog(out, recs, keys, (size_t)n) < 0 || fsync(out) < 0) {
+        perror("[Importer] write()");
+        close(out);
+        unlink(tmp_path);
+        goto done;
+    }
+    close(out);
+    if (rename(tmp_path, out_path) < 0) {
+        perror("[Importer] rename()");
+        unlink(tmp_path);
+        goto done;
+    }
+
+    printf("[Importer] Wrote %ld Pokémon to %s (%s)\n", n, out_path,
+           sorted ? "input already sorted" : "sorted by ID");
+    rc = 0;
+
+done:
+    free(keys);
+    free(recs);
+    munmap(data, size);
+    return rc;
+}
+
+/* ========================================================================== */
+/* ================================= main =================================== */
+/* ========================================================================== */
+
+/**
+ * \brief Print command-line usage instructions.
+ */
+static void print_usage(void) {
+    printf("Usage: importer -i <pokemon.csv> -o <pokemon.bin>\n");
+}
+
+int main(int argc, char *argv[]) {
+    const char *in = NULL, *out = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-i") == 0 && i + 1 < argc)
+            in = argv[++i];
+        else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+            out = argv[++i];
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+    if (!in || !out) {
+        print_usage();
+        return 1;
+    }
+
+    return import_catalog(in, out) == 0 ? 0 : 1;
+}
@@ -0,0 +1,744 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: loadgen.c                                       #
+# Purpose:                                                   #
+#     Load generator for the text protocol. Worker threads  #
+#     each drive a share of M connections from an epoll     #
+#     loop, replaying a weighted mix of get trainer, post   #
+#     trainer and get log. Closed loop keeps a fixed number #
+#     of requests in flight per connection; open loop sends #
+#     on a fixed schedule and measures latency from the     #
+#     intended send time. Reports ops/sec and percentiles   #
+#     from log-linear (HDR-style) histograms.               #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: epoll_wait(2), timerfd_create(2),    #
+#     clock_gettime(2), send(2), recv(2)                    #
+#     https://man7.org/linux/man-pages/                     #
+# [2] G. Tene, HdrHistogram and "coordinated omission"      #
+#     http://hdrhistogram.org/                              #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf, snprintf, perror */
+#include <stdlib.h>     /* atoi, atof, calloc, free, rand_r */
+#include <string.h>     /* strcmp, strstr, memmove, memcpy, strtok_r */
+#include <errno.h>      /* errno, EAGAIN, EINTR */
+#include <stdint.h>     /* uint64_t */
+#include <stdatomic.h>  /* atomic_int, atomic_compare_exchange_weak */
+#include <signal.h>     /* signal, SIGPIPE */
+#include <time.h>       /* clock_gettime */
+#include <unistd.h>     /* close, read */
+#include <pthread.h>    /* pthread_create, pthread_join */
+#include <sys/epoll.h>  /* epoll_create1, epoll_ctl, epoll_wait */
+#include <sys/socket.h> /* send, recv */
+#include <sys/timerfd.h> /* timerfd_create, timerfd_settime */
+
+#include "common.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Upper bounds on the command line settings. */
+#define LOADGEN_MAX_CONNS       4096
+#define LOADGEN_MAX_THREADS     64
+
+/*!< Requests one connection may have outstanding (open loop backlog). */
+#define LOADGEN_INFLIGHT        1024
+
+/*!< Receive buffer per connection; longer replies are skimmed. */
+#define LOADGEN_INBUF           (64 * 1024)
+
+/*!< Pending request bytes per connection. */
+#define LOADGEN_OUTBUF          (16 * 1024)
+
+/*!< Histogram: 2^HIST_SUB_BITS sub-buckets per power of two (~0.8% error). */
+#define HIST_SUB_BITS           8
+#define HIST_HALF               (1u << (HIST_SUB_BITS - 1))
+#define HIST_BUCKETS            ((64 - HIST_SUB_BITS + 2) * HIST_HALF)
+
+/*!< Reply terminator of the text protocol: the body's newline, then the marker. */
+#define LOADGEN_REPLY_END       "\n" END_MARKER
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Commands in the replayed mix. */
+typedef enum {
+    OP_GET_TRAINER = 0,             /*!< get trainer <random id> */
+    OP_POST_TRAINER,                /*!< post trainer bench<n> <three Pokémon> */
+    OP_GET_LOG,                     /*!< get log <n> */
+    OP_KINDS
+} op_kind_t;
+
+/*!< Names used by -m and in the report. */
+static const char *op_names[OP_KINDS] = { "get", "post", "log" };
+static const char *op_labels[OP_KINDS] = { "get trainer", "post trainer", "get log" };
+
+/**
+ * \brief           Log-linear latency histogram (nanoseconds).
+ *
+ * \note            Values below 2^HIST_SUB_BITS get exact buckets; above
+ *                  that every power of two is split into HIST_HALF equal
+ *                  buckets, so relative error stays constant at any scale.
+ */
+typedef struct {
+    uint64_t    counts[HIST_BUCKETS];   /*!< Samples per bucket */
+    uint64_t    total;                  /*!< All samples */
+    uint64_t    max;                    /*!< Largest sample */
+} hist_t;
+
+/*!< One benchmark connection. */
+typedef struct {
+    int         fd;                     /*!< Non-blocking socket */
+    char        in[LOADGEN_INBUF];      /*!< Unparsed reply bytes */
+    size_t      inlen;                  /*!< Valid bytes in \ref in */
+    size_t      scanned;                /*!< Bytes already searched for the end */
+    int         skimmed;                /*!< Current reply overflowed \ref in */
+    char        out[LOADGEN_OUTBUF];    /*!< Request bytes not yet sent */
+    size_t      outlen;                 /*!< Valid bytes in \ref out */
+    uint64_t    sent_at[LOADGEN_INFLIGHT]; /*!< Start time of each outstanding request */
+    uint8_t     kind[LOADGEN_INFLIGHT];    /*!< op_kind_t of each outstanding request */
+    unsigned    head;                   /*!< Oldest outstanding request */
+    unsigned    pending;                /*!< Outstanding requests */
+    uint64_t    next_due;               /*!< Open loop: next scheduled send */
+    int         want_out;               /*!< EPOLLOUT currently requested */
+} lg_conn_t;
+
+/*!< Per-thread state; merged into the report at the end. */
+typedef struct {
+    pthread_t   tid;                    /*!< Worker thread */
+    lg_conn_t  *conns;                  /*!< Connections owned by this thread */
+    int         nconns;                 /*!< Entries in \ref conns */
+    unsigned    seed;                   /*!< rand_r() state */
+    hist_t      hist[OP_KINDS];         /*!< Latencies in the measured window */
+    uint64_t    ops[OP_KINDS];          /*!< Replies in the measured window */
+    uint64_t    failed[OP_KINDS];       /*!< Negative replies in the window */
+    uint64_t    late;                   /*!< Open loop: sends behind schedule */
+    int         error;                  /*!< A connection broke */
+} lg_thread_t;
+
+/*!< Run settings from the command line. */
+static struct {
+    char        host[128];
+    char        port[32];
+    int         conns;                  /*!< -c connections */
+    int         threads;                /*!< -T worker threads */
+    double      duration;               /*!< -d measured seconds */
+    double      warmup;                 /*!< -w unmeasured seconds first */
+    double      rate;                   /*!< -r total ops/s (0 = closed loop) */
+    int         depth;                  /*!< -q closed loop requests in flight */
+    int         weights[OP_KINDS];      /*!< -m mix */
+    int         log_lines;              /*!< -n lines per get log */
+    int         preload;                /*!< -P trainers posted before the run */
+} cfg = {
+    .host = "127.0.0.1", .conns = 16, .threads = 1, .duration = 5, .warmup = 1,
+    .depth = 1, .weights = { 90, 5, 5 }, .log_lines = 10
+};
+
+/*!< Highest trainer ID get trainer picks from (raised by every post). */
+static atomic_int id_max = 1;
+
+/*!< Measured window, monotonic nanoseconds. */
+static uint64_t t_measure, t_end;
+
+/* ========================================================================== */
+/* ================================ Helpers ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Monotonic clock in nanoseconds.
+ */
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * \brief           Raise \ref id_max to at least \p id.
+ */
+static void id_max_raise(int id) {
+    int cur = atomic_load(&id_max);
+    while (id > cur && !atomic_compare_exchange_weak(&id_max, &cur, id))
+        ;
+}
+
+/**
+ * \brief           Parse a mix such as "get=90,post=5,log=5".
+ *
+ * \return          0 on success, -1 on an unknown name or an all-zero mix.
+ */
+static int parse_mix(const char *text) {
+    char buf[128], *save = NULL;
+    int total = 0;
+
+    snprintf(buf, sizeof(buf), "%s", text);
+    for (int k = 0; k < OP_KINDS; k++) cfg.weights[k] = 0;
+
+    for (char *tok = strtok_r(buf, ",", &save); tok; tok = strtok_r(NULL, ",", &save)) {
+        char *eq = strchr(tok, '=');
+        if (!eq) return -1;
+        *eq = '\0';
+        int k = 0;
+        while (k < OP_KINDS && strcmp(tok, op_names[k]) != 0) k++;
+        if (k == OP_KINDS || atoi(eq + 1) < 0) return -1;
+        cfg.weights[k] = atoi(eq + 1);
+        total += cfg.weights[k];
+    }
+    return total > 0 ? 0 : -1;
+}
+
+/* ========================================================================== */
+/* =============================== Histogram ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Bucket holding value \p v.
+ */
+static size_t hist_index(uint64_t v) {
+    if (v < 2 * HIST_HALF) return (size_t)v;
+
+    /* Keep the top HIST_SUB_BITS bits: (v >> shift) lies in [HALF, 2*HALF) */
+    unsigned shift = (unsigned)(63 - __builtin_clzll(v)) - (HIST_SUB_BITS - 1);
+    return (size_t)(shift + 1) * HIST_HALF + (size_t)((v >> shift) - HIST_HALF);
+}
+
+/**
+ * \brief           Largest value that maps to bucket \p i.
+ */
+static uint64_t hist_upper(size_t i) {
+    if (i < 2 * HIST_HALF) return (uint64_t)i;
+
+    unsigned shift = (unsigned)(i / HIST_HALF) - 1;
+    uint64_t base = (uint64_t)(i % HIST_HALF + HIST_HALF) << shift;
+    return base + ((uint64_t)1 << shift) - 1;
+}
+
+/**
+ * \brief           Record one sample.
+ */
+static void hist_record(hist_t *h, uint64_t v) {
+    h->counts[hist_index(v)]++;
+    h->total++;
+    if (v > h->max) h->max = v;
+}
+
+/**
+ * \brief           Add every sample of \p src to \p dst.
+ */
+static void hist_merge(hist_t *dst, const hist_t *src) {
+    for (size_t i = 0; i < HIST_BUCKETS; i++)
+        dst->counts[i] += src->counts[i];
+    dst->total += src->total;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+/**
+ * \brief           Value at quantile \p q (0..1), to bucket precision.
+ */
+static uint64_t hist_quantile(const hist_t *h, double q) {
+    if (h->total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(q * (double)h->total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < HIST_BUCKETS; i++) {
+        seen += h->counts[i];
+        if (seen >= rank) {
+            uint64_t v = hist_upper(i);
+            return v < h->max ? v : h->max;
+        }
+    }
+    return h->max;
+}
+
+/* ========================================================================== */
+/* ================================ Requests ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Pick a command kind according to the mix weights.
+ */
+static op_kind_t pick_kind(unsigned *seed) {
+    int total = 0;
+    for (int k = 0; k < OP_KINDS; k++) total += cfg.weights[k];
+
+    int r = rand_r(seed) % total;
+    for (int k = 0; k < OP_KINDS; k++) {
+        if (r < cfg.weights[k]) return (op_kind_t)k;
+        r -= cfg.weights[k];
+    }
+    return OP_GET_TRAINER;
+}
+
+/**
+ * \brief           Format one command line of kind \p kind.
+ *
+ * \return          Bytes written.
+ */
+static int format_request(op_kind_t kind, unsigned *seed, char *buf, size_t cap) {
+    switch (kind) {
+    case OP_GET_TRAINER:
+        return snprintf(buf, cap, "get trainer %d\n",
+                        1 + rand_r(seed) % atomic_load(&id_max));
+    case OP_POST_TRAINER:
+        return snprintf(buf, cap, "post trainer bench%u %d %d %d\n",
+                        (unsigned)rand_r(seed) % 100000, 1 + rand_r(seed) % 151,
+                        1 + rand_r(seed) % 151, 1 + rand_r(seed) % 151);
+    default:
+        return snprintf(buf, cap, "get log %d\n", cfg.log_lines);
+    }
+}
+
+/**
+ * \brief           Did the server accept the request? Learns new trainer IDs.
+ */
+static int reply_ok(op_kind_t kind, const char *reply, int skimmed) {
+    const char *id;
+
+    switch (kind) {
+    case OP_GET_TRAINER:
+        return skimmed || !strstr(reply, "not found");
+    case OP_POST_TRAINER:
+        if ((id = strstr(reply, "ID=")) == NULL) return 0;
+        id_max_raise(atoi(id + 3));
+        return 1;
+    default:
+        return 1;
+    }
+}
+
+/**
+ * \brief           Queue a request started (or scheduled) at \p start.
+ *
+ * \return          0 on success, -1 if the connection's buffers are full.
+ */
+static int conn_enqueue(lg_thread_t *t, lg_conn_t *c, uint64_t start) {
+    if (c->pending == LOADGEN_INFLIGHT || LOADGEN_OUTBUF - c->outlen < 128)
+        return -1;
+
+    op_kind_t kind = pick_kind(&t->seed);
+    c->outlen += (size_t)format_request(kind, &t->seed, c->out + c->outlen,
+                                        LOADGEN_OUTBUF - c->outlen);
+    unsigned slot = (c->head + c->pending++) % LOADGEN_INFLIGHT;
+    c->sent_at[slot] = start;
+    c->kind[slot] = (uint8_t)kind;
+    return 0;
+}
+
+/* ========================================================================== */
+/* =============================== Connection =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Send as much queued output as the socket takes.
+ *
+ * \return          0 on success, -1 if the connection broke.
+ */
+static int conn_flush(int epfd, lg_conn_t *c) {
+    size_t off = 0;
+
+    while (off < c->outlen) {
+        ssize_t n = send(c->fd, c->out + off, c->outlen - off, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+            return -1;
+        }
+        off += (size_t)n;
+    }
+    memmove(c->out, c->out + off, c->outlen - off);
+    c->outlen -= off;
+
+    /* Only ask for EPOLLOUT while the socket is backed up */
+    int want = c->outlen > 0;
+    if (want != c->want_out) {
+        struct epoll_event ev = { .events = EPOLLIN | (want ? EPOLLOUT : 0), .data.ptr = c };
+        epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+        c->want_out = want;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Read replies and retire the oldest outstanding requests.
+ *
+ * \return          Replies completed, or -1 if the connection broke.
+ */
+static int conn_read(lg_thread_t *t, lg_conn_t *c) {
+    static const size_t end_len = sizeof(LOADGEN_REPLY_END) - 1;
+    int done = 0;
+
+    for (;;) {
+        ssize_t n = recv(c->fd, c->in + c->inlen, LOADGEN_INBUF - 1 - c->inlen, 0);
+        if (n == 0) return -1;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return done;
+            return -1;
+        }
+        c->inlen += (size_t)n;
+        c->in[c->inlen] = '\0';
+
+        /* Replies arrive in request order, one END marker each */
+        size_t start = 0;
+        for (;;) {
+            char *end = strstr(c->in + c->scanned, LOADGEN_REPLY_END);
+            if (!end) break;
+            if (c->pending == 0) return -1;
+
+            uint64_t now = now_ns();
+            unsigned slot = c->head;
+            op_kind_t kind = (op_kind_t)c->kind[slot];
+            *end = '\0';        /* Classify this reply alone */
+            int ok = reply_ok(kind, c->in + start, c->skimmed);
+            *end = '\n';
+            c->head = (c->head + 1) % LOADGEN_INFLIGHT;
+            c->pending--;
+            done++;
+
+            if (c->sent_at[slot] >= t_measure && now <= t_end) {
+                hist_record(&t->hist[kind], now - c->sent_at[slot]);
+                t->ops[kind]++;
+                if (!ok) t->failed[kind]++;
+            }
+
+            start = (size_t)(end - c->in) + end_len;
+            c->scanned = start;
+            c->skimmed = 0;
+        }
+
+        /* Keep the unfinished reply; skim it once it outgrows the buffer */
+        memmove(c->in, c->in + start, c->inlen - start + 1);
+        c->inlen -= start;
+        c->scanned = c->inlen > end_len ? c->inlen - end_len : 0;
+        if (c->inlen >= LOADGEN_INBUF - 1) {
+            memmove(c->in, c->in + c->inlen - end_len, end_len + 1);
+            c->inlen = end_len;
+            c->scanned = 0;
+            c->skimmed = 1;
+        }
+    }
+}
+
+/* ========================================================================== */
+/* ============================== Worker Thread ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Arm \p tfd to fire at monotonic time \p when.
+ */
+static void timer_arm(int tfd, uint64_t when) {
+    struct itimerspec its = {0};
+    its.it_value.tv_sec = (time_t)(when / 1000000000ull);
+    its.it_value.tv_nsec = (long)(when % 1000000000ull);
+    timerfd_settime(tfd, TFD_TIMER_ABSTIME, &its, NULL);
+}
+
+/**
+ * \brief           Top every connection up to the closed loop depth, or send
+ *                  everything the open loop schedule has made due.
+ *
+ * \return          Earliest future send time (open loop), else 0.
+ */
+static uint64_t issue_requests(lg_thread_t *t, int epfd, uint64_t interval) {
+    uint64_t now = now_ns(), next = 0;
+
+    for (int i = 0; i < t->nconns; i++) {
+        lg_conn_t *c = &t->conns[i];
+        int queued = 0;
+
+        if (interval == 0) {
+            while (c->pending < (unsigned)cfg.depth && conn_enqueue(t, c, now) == 0)
+                queued = 1;
+        } else {
+            /* Latency counts from the scheduled time, so a stalled server
+             * cannot hide its backlog (no coordinated omission) */
+            while (c->next_due <= now && c->next_due < t_end) {
+                if (conn_enqueue(t, c, c->next_due) < 0) break;
+                if (now - c->next_due > interval) t->late++;
+                c->next_due += interval;
+                queued = 1;
+            }
+            if (c->next_due < t_end && (next == 0 || c->next_due < next))
+                next = c->next_due;
+        }
+        if (queued && conn_flush(epfd, c) < 0) {
+            t->error = 1;
+            return 0;
+        }
+    }
+    return next;
+}
+
+/**
+ * \brief           Drive this thread's connections until the run ends.
+ */
+static void *worker_thread(void *arg) {
+    lg_thread_t *t = arg;
+    struct epoll_event events[64];
+    uint64_t interval = 0;
+
+    int epfd = epoll_create1(0);
+    int tfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+    if (epfd < 0 || tfd < 0) {
+        perror("[Loadgen] epoll/timerfd");
+        t->error = 1;
+        return NULL;
+    }
+    struct epoll_event tev = { .events = EPOLLIN, .data.ptr = NULL };
+    epoll_ctl(epfd, EPOLL_CTL_ADD, tfd, &tev);
+
+    /* Spread each connection's schedule over one interval */
+    if (cfg.rate > 0)
+        interval = (uint64_t)(1e9 * cfg.conns / cfg.rate);
+    uint64_t begin = now_ns();
+    for (int i = 0; i < t->nconns; i++) {
+        lg_conn_t *c = &t->conns[i];
+        struct epoll_event ev = { .events = EPOLLIN, .data.ptr = c };
+        epoll_ctl(epfd, EPOLL_CTL_ADD, c->fd, &ev);
+        if (interval)
+            c->next_due = begin + (uint64_t)rand_r(&t->seed) % interval;
+    }
+
+    while (!t->error && now_ns() < t_end) {
+        uint64_t next = issue_requests(t, epfd, interval);
+        timer_arm(tfd, next ? next : t_end);
+
+        int n = epoll_wait(epfd, events, 64, 100);
+        if (n < 0 && errno != EINTR) break;
+        for (int i = 0; i < n; i++) {
+            lg_conn_t *c = events[i].data.ptr;
+            if (!c) {
+                /* Timer: just drain it; the loop re-issues due requests */
+                uint64_t expirations;
+                ssize_t r = read(tfd, &expirations, sizeof(expirations));
+                (void)r;
+                continue;
+            }
+            if (((events[i].events & EPOLLOUT) && conn_flush(epfd, c) < 0) ||
+                ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && conn_read(t, c) < 0)) {
+                fprintf(stderr, "[Loadgen] Connection closed by server.\n");
+                t->error = 1;
+                break;
+            }
+        }
+    }
+
+    close(tfd);
+    close(epfd);
+    return NULL;
+}
+
+/* ========================================================================== */
+/* ================================= Preload ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Post \p count trainers over \p fd so gets have targets.
+ *
+ * \return          0 on success, -1 on failure.
+ *
+ * \note            Pipelined 64 at a time, so write-ahead log commits are
+ *                  shared and the preload does not dominate the run time.
+ */
+static int preload_trainers(int fd, int count) {
+    unsigned seed = 12345;
+    line_reader_t reader;
+    line_reader_init(&reader, fd);
+
+    for (int done = 0; done < count; ) {
+        char batch[64 * 64];
+        size_t len = 0;
+        int n = count - done < 64 ? count - done : 64;
+
+        for (int i = 0; i < n; i++)
+            len += (size_t)format_request(OP_POST_TRAINER, &seed, batch + len, sizeof(batch) - len);
+        if (send_bytes(fd, batch, len) < 0) return -1;
+
+        /* Each reply is one line plus the END marker line */
+        for (int got = 0; got < n; ) {
+            char *line;
+            size_t llen;
+            if (!line_reader_next(&reader, &line, &llen)) {
+                if (line_reader_fill(&reader) <= 0) return -1;
+                continue;
+            }
+            if (strcmp(line, "[END]") == 0)
+                got++;
+            else
+                reply_ok(OP_POST_TRAINER, line, 0);
+        }
+        done += n;
+    }
+    return 0;
+}
+
+/* ========================================================================== */
+/* ================================= Report ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Print one row of the latency table (microseconds).
+ */
+static void report_row(const char *label, const hist_t *h, uint64_t ops,
+                       uint64_t failed, double secs) {
+    printf("%-13s %9llu %10.1f %8llu %8.1f %8.1f %8.1f %9.1f %9.1f\n",
+           label, (unsigned long long)ops, (double)ops / secs,
+           (unsigned long long)failed,
+           hist_quantile(h, 0.50) / 1e3, hist_quantile(h, 0.90) / 1e3,
+           hist_quantile(h, 0.99) / 1e3, hist_quantile(h, 0.999) / 1e3,
+           h->max / 1e3);
+}
+
+/* ========================================================================== */
+/* ================================== main ================================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Print command-line usage.
+ */
+static void print_usage(void) {
+    printf("Usage: loadgen -p <port> [-h <host>] [-c <connections>] [-T <threads>] "
+           "[-d <seconds>] [-w <warmup_s>] [-r <ops_per_s> | -q <depth>] "
+           "[-m get=90,post=5,log=5] [-n <log_lines>] [-P <preload>]\n");
+}
+
+int main(int argc, char *argv[]) {
+    signal(SIGPIPE, SIG_IGN);
+
+    int got_p = 0;
+    for (int i = 1; i < argc; i++) {
+        const char *opt = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : NULL;
+        if (!val) {
+            print_usage();
+            return 1;
+        }
+        i++;
+        if (strcmp(opt, "-h") == 0)      snprintf(cfg.host, sizeof(cfg.host), "%s", val);
+        else if (strcmp(opt, "-p") == 0) { snprintf(cfg.port, sizeof(cfg.port), "%s", val); got_p = 1; }
+        else if (strcmp(opt, "-c") == 0) cfg.conns = atoi(val);
+        else if (strcmp(opt, "-T") == 0) cfg.threads = atoi(val);
+        else if (strcmp(opt, "-d") == 0) cfg.duration = atof(val);
+        else if (strcmp(opt, "-w") == 0) cfg.warmup = atof(val);
+        else if (strcmp(opt, "-r") == 0) cfg.rate = atof(val);
+        else if (strcmp(opt, "-q") == 0) cfg.depth = atoi(val);
+        else if (strcmp(opt, "-n") == 0) cfg.log_lines = atoi(val);
+        else if (strcmp(opt, "-P") == 0) cfg.preload = atoi(val);
+        else if (strcmp(opt, "-m") == 0 && parse_mix(val) == 0) continue;
+        else {
+            print_usage();
+            return 1;
+        }
+    }
+
+    if (!got_p || cfg.conns < 1 || cfg.conns > LOADGEN_MAX_CONNS ||
+        cfg.threads < 1 || cfg.threads > LOADGEN_MAX_THREADS || cfg.duration <= 0 ||
+        cfg.warmup < 0 || cfg.rate < 0 || cfg.depth < 1 || cfg.depth > LOADGEN_INFLIGHT) {
+        print_usage();
+        return 1;
+    }
+    if (cfg.threads > cfg.conns) cfg.threads = cfg.conns;
+
+    lg_conn_t *conns = calloc((size_t)cfg.conns, sizeof(*conns));
+    lg_thread_t *threads = calloc((size_t)cfg.threads, sizeof(*threads));
+    if (!conns || !threads) {
+        perror("[Loadgen] calloc");
+        return 1;
+    }
+
+    for (int i = 0; i < cfg.conns; i++) {
+        conns[i].fd = connect_to_server(cfg.host, cfg.port);
+        if (conns[i].fd < 0) {
+            fprintf(stderr, "[Loadgen] Could not connect to %s:%s\n", cfg.host, cfg.port);
+            return 1;
+        }
+        socket_set_nodelay(conns[i].fd, 1);
+    }
+
+    if (cfg.preload > 0 && preload_trainers(conns[0].fd, cfg.preload) < 0) {
+        fprintf(stderr, "[Loadgen] Preload failed.\n");
+        return 1;
+    }
+    for (int i = 0; i < cfg.conns; i++)
+        set_nonblocking(conns[i].fd);
+
+    printf("[Loadgen] %d connection(s), %d thread(s), %s, %.1f s (+%.1f s warmup)\n",
+           cfg.conns, cfg.threads, cfg.rate > 0 ? "open loop" : "closed loop",
+           cfg.duration, cfg.warmup);
+    if (cfg.rate > 0)
+        printf("[Loadgen] Target rate %.0f ops/s\n", cfg.rate);
+    else
+        printf("[Loadgen] Depth %d request(s) in flight per connection\n", cfg.depth);
+    printf("[Loadgen] Mix: get trainer %d, post trainer %d, get log %d (trainer IDs 1..%d)\n",
+           cfg.weights[OP_GET_TRAINER], cfg.weights[OP_POST_TRAINER],
+           cfg.weights[OP_GET_LOG], atomic_load(&id_max));
+
+    uint64_t start = now_ns();
+    t_measure = start + (uint64_t)(cfg.warmup * 1e9);
+    t_end = t_measure + (uint64_t)(cfg.duration * 1e9);
+
+    /* Deal connections out to threads in contiguous blocks */
+    int base = 0;
+    for (int k = 0; k < cfg.threads; k++) {
+        lg_thread_t *t = &threads[k];
+        t->nconns = cfg.conns / cfg.threads + (k < cfg.conns % cfg.threads);
+        t->conns = conns + base;
+        t->seed = 0x9E3779B9u * (unsigned)(k + 1);
+        base += t->nconns;
+        if (pthread_create(&t->tid, NULL, worker_thread, t) != 0) {
+            perror("[Loadgen] pthread_create");
+            return 1;
+        }
+    }
+
+    hist_t *all = calloc(OP_KINDS + 1, sizeof(hist_t));
+    uint64_t ops[OP_KINDS + 1] = {0}, failed[OP_KINDS + 1] = {0}, late = 0;
+    int error = 0;
+    for (int k = 0; k < cfg.threads; k++) {
+        lg_thread_t *t = &threads[k];
+        pthread_join(t->tid, NULL);
+        error |= t->error;
+        late += t->late;
+        for (int j = 0; j < OP_KINDS; j++) {
+            hist_merge(&all[j], &t->hist[j]);
+            hist_merge(&all[OP_KINDS], &t->hist[j]);
+            ops[j] += t->ops[j];
+            failed[j] += t->failed[j];
+            ops[OP_KINDS] += t->ops[j];
+            failed[OP_KINDS] += t->failed[j];
+        }
+    }
+
+    printf("\n%-13s %9s %10s %8s %8s %8s %8s %9s %9s\n", "op", "count", "ops/s",
+           "failed", "p50 us", "p90 us", "p99 us", "p99.9 us", "max us");
+    for (int j = 0; j < OP_KINDS; j++)
+        if (ops[j] > 0)
+            report_row(op_labels[j], &all[j], ops[j], failed[j], cfg.duration);
+    report_row("all", &all[OP_KINDS], ops[OP_KINDS], failed[OP_KINDS], cfg.duration);
+    if (cfg.rate > 0)
+        printf("\n[Loadgen] %llu send(s) fell more than one interval behind schedule\n",
+               (unsigned long long)late);
+
+    for (int i = 0; i < cfg.conns; i++)
+        close(conns[i].fd);
+    free(all);
+    free(threads);
+    free(conns);
+    return error ? 1 : 0;
+}
@@ -0,0 +1,626 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: logger.c                                        #
+# Purpose:                                                   #
+#     Implements the asynchronous request logger. Records   #
+#     flow through two bounded MPMC queues (free → ready →  #
+#     free); the writer thread drains them in batches, so   #
+#     the log file is opened once and written with a few    #
+#     large write() calls instead of fopen/fclose per line. #
+#     Each written line is also copied into a fixed-slot    #
+#     tail ring, primed from the file's end at startup.     #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: write(2), pread(2), fdatasync(2),    #
+#     sem_timedwait(3), localtime_r(3), strftime(3)         #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard), <stdatomic.h>       #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* snprintf, perror, printf */
+#include <stdlib.h>     /* calloc, malloc, free */
+#include <string.h>     /* strcmp, strlen, memcpy */
+#include <errno.h>      /* errno, EINTR, ETIMEDOUT */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, dup, fdatasync */
+#include <sched.h>      /* sched_yield */
+#include <sys/stat.h>   /* fstat */
+
+#include "common.h"
+#include "logger.h"
+#include "metrics.h"
+
+/* ========================================================================== */
+/* ================================ Tail Ring =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Store one line in the next tail slot (caller holds tail_mutex).
+ */
+static void tail_push(logger_t *lg, const char *line, size_t len) {
+    char *slot = lg->tail + lg->tail_head * LOG_TAIL_LINE;
+
+    if (len > LOG_TAIL_LINE) {
+        /* Only lines from an older file can be this long: keep the head */
+        len = LOG_TAIL_LINE;
+        memcpy(slot, line, len - 1);
+        slot[len - 1] = '\n';
+    } else {
+        memcpy(slot, line, len);
+    }
+    lg->tail_len[lg->tail_head] = (uint16_t)len;
+    lg->tail_head = (lg->tail_head + 1) % LOG_TAIL_LINES;
+
+    if (lg->tail_count < LOG_TAIL_LINES)
+        lg->tail_count++;
+    else
+        lg->tail_whole = 0;  /* Oldest line evicted */
+}
+
+/**
+ * \brief           Seed the ring with the last lines already in the file.
+ *
+ * \note            Reads at most one ring's worth of bytes from the end, so
+ *                  startup cost does not grow with the log.
+ */
+static void tail_prime(logger_t *lg) {
+    struct stat st;
+    lg->tail_whole = 1;
+    if (fstat(lg->fd, &st) < 0 || st.st_size == 0)
+        return;
+
+    off_t want  = (off_t)LOG_TAIL_LINES * LOG_TAIL_LINE;
+    off_t start = st.st_size > want ? st.st_size - want : 0;
+    size_t size = (size_t)(st.st_size - start);
+
+    char *buf = malloc(size);
+    if (!buf || safe_pread(lg->fd, buf, size, start) != (ssize_t)size) {
+        free(buf);
+        lg->tail_whole = 0;  /* Unknown contents: always defer to the file */
+        return;
+    }
+
+    char *p = buf, *end = buf + size;
+    if (start > 0) {
+        /* First line was cut by the window: drop it */
+        char *nl = memchr(p, '\n', size);
+        p = nl ? nl + 1 : end;
+        lg->tail_whole = 0;
+    }
+    while (p < end) {
+        char *nl = memchr(p, '\n', (size_t)(end - p));
+        size_t len = nl ? (size_t)(nl - p) + 1 : (size_t)(end - p);
+        tail_push(lg, p, len);
+        p += len;
+    }
+    free(buf);
+}
+
+/*!< Read cursor over a range of the log file (see logger_tail_open()). */
+struct logger_stream {
+    int     fd;                     /*!< dup() of the log descriptor */
+    off_t   pos;                    /*!< Next byte to hand out */
+    off_t   end;                    /*!< End of the last whole line at open time */
+};
+
+/**
+ * \brief           Offset just past the last newline before \p size.
+ *
+ * \return          File offset (0 if there is none), or -1 on a read error.
+ *
+ * \note            Drops a line the writer is still appending.
+ */
+static off_t tail_end(int fd, off_t size) {
+    char block[512];
+    off_t pos = size;
+
+    while (pos > 0) {
+        size_t chunk = pos > (off_t)sizeof(block) ? sizeof(block) : (size_t)pos;
+        pos -= (off_t)chunk;
+        if (safe_pread(fd, block, chunk, pos) != (ssize_t)chunk)
+            return -1;
+        for (size_t i = chunk; i-- > 0;)
+            if (block[i] == '\n')
+                return pos + (off_t)i + 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Find where the last \p n lines before \p size start.
+ *
+ * \return          File offset, or -1 on a read error.
+ *
+ * \note            Scans backwards block by block, so the cost follows the
+ *                  bytes returned rather than the file size. Nothing before
+ *                  \p floor is read; when the window cuts a line, that line
+ *                  is dropped.
+ */
+static off_t tail_begin(int fd, off_t size, off_t floor, int n) {
+    off_t pos = size, begin = 0, first_nl = -1;
+    char block[8192];
+    int seen = 0;
+
+    while (pos > floor && seen < n) {
+        size_t chunk = pos - floor > (off_t)sizeof(block) ? sizeof(block) : (size_t)(pos - floor);
+        pos -= (off_t)chunk;
+        if (safe_pread(fd, block, chunk, pos) != (ssize_t)chunk)
+            return -1;
+
+        for (size_t i = chunk; i-- > 0;) {
+            /* The newline ending the final line does not start a line */
+            if (block[i] != '\n' || pos + (off_t)i == size - 1)
+                continue;
+            if (++seen == n) {
+                begin = pos + (off_t)i + 1;
+                break;
+            }
+            first_nl = pos + (off_t)i;
+        }
+    }
+    if (seen < n && floor > 0)
+        begin = first_nl >= 0 ? first_nl + 1 : size;
+    return begin;
+}
+
+/**
+ * \brief           Read the last \p n lines straight from the file \p fd.
+ *
+ * \return          malloc'd text, or NULL on failure.
+ *
+ * \note            Runs without tail_mutex on a dup() of the log descriptor,
+ *                  while the writer keeps appending. Only whole lines up to
+ *                  the size seen at the start are returned. It reads at most
+ *                  one ring's worth of bytes, like tail_prime().
+ */
+static char *tail_from_file(int fd, int n) {
+    struct stat st;
+    if (fstat(fd, &st) < 0) return NULL;
+
+    off_t limit = (off_t)LOG_TAIL_LINES * LOG_TAIL_LINE;
+    off_t size = st.st_size;
+    off_t begin = tail_begin(fd, size, size > limit ? size - limit : 0, n);
+    if (begin < 0) return NULL;
+
+    size_t len = (size_t)(size - begin);
+    char *out = malloc(len + 1);
+    if (!out) return NULL;
+    if (safe_pread(fd, out, len, begin) != (ssize_t)len) {
+        free(out);
+        return NULL;
+    }
+    while (len > 0 && out[len - 1] != '\n')
+        len--;                          /* A batch still being appended */
+    out[len] = '\0';
+    return out;
+}
+
+/* ========================================================================== */
+/* ============================== Writer Thread ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Switch to a freshly opened file at \ref logger_t.path.
+ *
+ * \note            Writer thread only, after a drain, so every earlier line
+ *                  is already in the old file. The swap happens under
+ *                  tail_mutex; a logger_tail() file scan works on its own
+ *                  dup() of the old descriptor, so closing it here is safe.
+ *                  On failure the old descriptor is kept.
+ */
+static void logger_rotate(logger_t *lg) {
+    int fd = open(lg->path, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (fd < 0) {
+        perror("[Server] reopen(log)");
+        return;
+    }
+    if (lg->fsync_policy != LOG_FSYNC_NONE)
+        fdatasync(lg->fd);
+
+    pthread_mutex_lock(&lg->tail_mutex);
+    close(lg->fd);
+    lg->fd = fd;
+    lg->tail_head = 0;
+    lg->tail_count = 0;
+    tail_prime(lg);
+    pthread_mutex_unlock(&lg->tail_mutex);
+    printf("[Server] Reopened log file %s\n", lg->path);
+}
+
+/**
+ * \brief           Milliseconds on the monotonic clock.
+ */
+static long long logger_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * \brief           Write out and empty the batch buffer.
+ */
+static void logger_write_batch(logger_t *lg) {
+    if (lg->batch_len == 0) return;
+    if (safe_write(lg->fd, lg->batch, lg->batch_len) < 0)
+        perror("[Server] log write()");
+    lg->batch_len = 0;
+}
+
+/**
+ * \brief           Format one record into the batch buffer.
+ *
+ * \note            localtime_r()/strftime() only run when the second changes;
+ *                  every other line reuses the cached text.
+ */
+static void logger_format(logger_t *lg, const log_record_t *rec) {
+    if (rec->when != lg->ts_cached) {
+        struct tm tm_info;
+        localtime_r(&rec->when, &tm_info);
+        strftime(lg->ts_text, sizeof(lg->ts_text), "%Y-%m-%d %H:%M:%S", &tm_info);
+        lg->ts_cached = rec->when;
+    }
+
+    /* Worst case: timestamp + address + command + fixed text */
+    if (LOG_BATCH_BYTES - lg->batch_len < sizeof(*rec) + sizeof(lg->ts_text) + 64)
+        logger_write_batch(lg);
+
+    char *line = lg->batch + lg->batch_len;
+    int n = snprintf(line, LOG_BATCH_BYTES - lg->batch_len,
+                     "[%s] Client %s:%d issued command: %s\n",
+                     lg->ts_text, rec->ip, rec->port, rec->cmd);
+    if (n <= 0) return;
+    lg->batch_len += (size_t)n;
+
+    pthread_mutex_lock(&lg->tail_mutex);
+    tail_push(lg, line, (size_t)n);
+    pthread_mutex_unlock(&lg->tail_mutex);
+}
+
+/**
+ * \brief           Move every ready record into the batch, then recycle it.
+ *
+ * \return          Number of records drained.
+ */
+static unsigned long logger_drain(logger_t *lg) {
+    unsigned long count = 0;
+    void *item;
+
+    while (mpmc_pop(&lg->ready_q, &item) == 0) {
+        logger_format(lg, item);
+        mpmc_push(&lg->free_q, item);
+        count++;
+    }
+    logger_write_batch(lg);
+    return count;
+}
+
+/**
+ * \brief           Writer loop: sleep up to flush_ms, drain, sync, repeat.
+ */
+static void *logger_writer(void *arg) {
+    logger_t *lg = arg;
+    long long last_sync = logger_now_ms();
+    int dirty = 0;
+
+    for (;;) {
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec  += lg->flush_ms / 1000;
+        deadline.tv_nsec += (long)(lg->flush_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+        while (sem_timedwait(&lg->wake, &deadline) < 0 && errno == EINTR)
+            ;
+
+        int stopping = lg->stop;
+        unsigned long n = logger_drain(lg);
+        if (n > 0) dirty = 1;
+
+        if (atomic_exchange(&lg->reopen, 0)) {
+            logger_rotate(lg);
+            dirty = 0;
+        }
+
+        /* Apply the durability policy before acknowledging the records */
+        if (dirty) {
+            long long now = logger_now_ms();
+            if (lg->fsync_policy == LOG_FSYNC_ALWAYS ||
+                (lg->fsync_policy == LOG_FSYNC_INTERVAL &&
+                 (stopping || now - last_sync >= LOG_FSYNC_PERIOD_MS))) {
+                fdatasync(lg->fd);
+                last_sync = now;
+                dirty = 0;
+            } else if (lg->fsync_policy == LOG_FSYNC_NONE) {
+                dirty = 0;
+            }
+        }
+
+        pthread_mutex_lock(&lg->sync_mutex);
+        lg->written += n;
+        pthread_cond_broadcast(&lg->sync_cond);
+        pthread_mutex_unlock(&lg->sync_mutex);
+
+        if (stopping && n == 0)
+            break;
+    }
+    return NULL;
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Open \p path for append and launch the writer thread.
+ *
+ * \return          Logger handle, or NULL on failure.
+ */
+logger_t *logger_open(const char *path, int flush_ms, log_fsync_t policy) {
+    logger_t *lg = calloc(1, sizeof(*lg));
+    if (!lg) return NULL;
+
+    /* Readable too: tail_prime() and tail_from_file() pread() from it */
+    snprintf(lg->path, sizeof(lg->path), "%s", path);
+    lg->fd = open(path, O_RDWR | O_APPEND | O_CREAT, 0644);
+    if (lg->fd < 0) {
+        perror("[Server] open(log)");
+        free(lg);
+        return NULL;
+    }
+    lg->flush_ms = flush_ms > 0 ? flush_ms : LOG_FLUSH_MS_DEFAULT;
+    lg->fsync_policy = policy;
+    lg->ts_cached = (time_t)-1;
+    atomic_init(&lg->enqueued, 0);
+    atomic_init(&lg->reopen, 0);
+
+    lg->records = calloc(LOG_RING_DEPTH, sizeof(*lg->records));
+    lg->batch = malloc(LOG_BATCH_BYTES);
+    lg->tail = malloc((size_t)LOG_TAIL_LINES * LOG_TAIL_LINE);
+    lg->tail_len = calloc(LOG_TAIL_LINES, sizeof(*lg->tail_len));
+    if (!lg->records || !lg->batch || !lg->tail || !lg->tail_len ||
+        mpmc_init(&lg->free_q, LOG_RING_DEPTH) < 0)
+        goto fail_alloc;
+    if (mpmc_init(&lg->ready_q, LOG_RING_DEPTH) < 0)
+        goto fail_free_q;
+
+    /* Every record starts out available to producers */
+    for (size_t i = 0; i < LOG_RING_DEPTH; i++)
+        mpmc_push(&lg->free_q, &lg->records[i]);
+
+    tail_prime(lg);
+
+    sem_init(&lg->wake, 0, 0);
+    pthread_mutex_init(&lg->sync_mutex, NULL);
+    pthread_cond_init(&lg->sync_cond, NULL);
+    pthread_mutex_init(&lg->tail_mutex, NULL);
+
+    if (pthread_create(&lg->writer, NULL, logger_writer, lg) != 0) {
+        perror("[Server] pthread_create(logger)");
+        sem_destroy(&lg->wake);
+        pthread_mutex_destroy(&lg->sync_mutex);
+        pthread_cond_destroy(&lg->sync_cond);
+        pthread_mutex_destroy(&lg->tail_mutex);
+        mpmc_destroy(&lg->ready_q);
+        goto fail_free_q;
+    }
+    return lg;
+
+fail_free_q:
+    mpmc_destroy(&lg->free_q);
+fail_alloc:
+    free(lg->tail_len);
+    free(lg->tail);
+    free(lg->batch);
+    free(lg->records);
+    close(lg->fd);
+    free(lg);
+    return NULL;
+}
+
+/**
+ * \brief           Copy the request into a free record and publish it.
+ *
+ * \return          0 if queued, -1 if the logger is stopping.
+ */
+int logger_log(logger_t *lg, const char *ip, int port, const char *cmd) {
+    void *item;
+
+    /* Ring exhausted: nudge the writer and retry instead of dropping lines */
+    if (mpmc_pop(&lg->free_q, &item) < 0) {
+        uint64_t start = metrics_now();
+        while (mpmc_pop(&lg->free_q, &item) < 0) {
+            if (lg->stop) return -1;
+            sem_post(&lg->wake);
+            sched_yield();
+        }
+        metrics_wait(MWAIT_LOG_RING, metrics_now() - start);
+    }
+
+    log_record_t *rec = item;
+    rec->when = time(NULL);
+    rec->port = port;
+    snprintf(rec->ip, sizeof(rec->ip), "%s", ip);
+    snprintf(rec->cmd, sizeof(rec->cmd), "%s", cmd);
+
+    mpmc_push(&lg->ready_q, rec);
+    atomic_fetch_add_explicit(&lg->enqueued, 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * \brief           Wait for the writer to persist everything queued so far.
+ *
+ * \note            The wake-up is posted under sync_mutex, so the writer's
+ *                  broadcast cannot slip in before this thread waits.
+ */
+void logger_sync(logger_t *lg) {
+    unsigned long target = atomic_load_explicit(&lg->enqueued, memory_order_acquire);
+
+    pthread_mutex_lock(&lg->sync_mutex);
+    while (lg->written < target) {
+        sem_post(&lg->wake);
+        pthread_cond_wait(&lg->sync_cond, &lg->sync_mutex);
+    }
+    pthread_mutex_unlock(&lg->sync_mutex);
+}
+
+/**
+ * \brief           Copy the newest \p n lines out of the tail ring.
+ *
+ * \return          malloc'd text (possibly ""), or NULL on failure.
+ *
+ * \note            \p n is clamped to LOG_TAIL_LINES, so the reply never
+ *                  exceeds one ring's worth of bytes.
+ */
+char *logger_tail(logger_t *lg, int n) {
+    if (n < 1) n = 1;
+    if (n > LOG_TAIL_LINES) n = LOG_TAIL_LINES;
+    logger_sync(lg);
+
+    pthread_mutex_lock(&lg->tail_mutex);
+    if ((size_t)n > lg->tail_count && !lg->tail_whole) {
+        /* Older lines were evicted: only the file still has them. Scan a
+         * duplicate of the current fd, so neither tail_store() nor a
+         * rotation waits for the read */
+        int fd = dup(lg->fd);
+        pthread_mutex_unlock(&lg->tail_mutex);
+        if (fd < 0) return NULL;
+        char *text = tail_from_file(fd, n);
+        close(fd);
+        return text;
+    }
+
+    size_t k = (size_t)n < lg->tail_count ? (size_t)n : lg->tail_count;
+    size_t first = (lg->tail_head + LOG_TAIL_LINES - k) % LOG_TAIL_LINES;
+    size_t total = 0;
+    for (size_t i = 0; i < k; i++)
+        total += lg->tail_len[(first + i) % LOG_TAIL_LINES];
+
+    char *out = malloc(total + 1);
+    if (out) {
+        char *p = out;
+        for (size_t i = 0; i < k; i++) {
+            size_t slot = (first + i) % LOG_TAIL_LINES;
+            memcpy(p, lg->tail + slot * LOG_TAIL_LINE, lg->tail_len[slot]);
+            p += lg->tail_len[slot];
+        }
+        *p = '\0';
+    }
+    pthread_mutex_unlock(&lg->tail_mutex);
+    return out;
+}
+
+/**
+ * \brief           Open a cursor over the newest \p n lines of the log file.
+ *
+ * \return          Cursor for logger_tail_fill(), or NULL on failure.
+ */
+logger_stream_t *logger_tail_open(logger_t *lg, int n, size_t *bytes) {
+    if (n < 1) n = 1;
+    logger_sync(lg);
+
+    /* A private descriptor keeps reading the same file across a rotation */
+    pthread_mutex_lock(&lg->tail_mutex);
+    int fd = dup(lg->fd);
+    pthread_mutex_unlock(&lg->tail_mutex);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    logger_stream_t *ls = malloc(sizeof(*ls));
+    off_t end = -1, begin = -1;
+    if (ls && fstat(fd, &st) == 0 && (end = tail_end(fd, st.st_size)) >= 0)
+        begin = tail_begin(fd, end, 0, n);
+    if (begin < 0) {
+        free(ls);
+        close(fd);
+        return NULL;
+    }
+
+    ls->fd = fd;
+    ls->pos = begin;
+    ls->end = end;
+    *bytes = (size_t)(end - begin);
+    return ls;
+}
+
+/**
+ * \brief           Copy the next bytes of the cursor (stream_fill_fn).
+ */
+size_t logger_tail_fill(void *ctx, char *buf, size_t cap) {
+    logger_stream_t *ls = ctx;
+    size_t want = ls->end - ls->pos < (off_t)cap ? (size_t)(ls->end - ls->pos) : cap;
+    if (want == 0 || safe_pread(ls->fd, buf, want, ls->pos) != (ssize_t)want)
+        return 0;   /* Done, or the file shrank: end the reply here */
+    ls->pos += (off_t)want;
+    return want;
+}
+
+/**
+ * \brief           Close a cursor from logger_tail_open(); NULL is ignored.
+ */
+void logger_tail_close(void *ctx) {
+    logger_stream_t *ls = ctx;
+    if (!ls) return;
+    close(ls->fd);
+    free(ls);
+}
+
+/**
+ * \brief           Flag a reopen and wake the writer.
+ *
+ * \note            Only an atomic store and sem_post(), both async-signal-safe.
+ */
+void logger_reopen(logger_t *lg) {
+    atomic_store(&lg->reopen, 1);
+    sem_post(&lg->wake);
+}
+
+/**
+ * \brief           Flush, stop and join the writer, then release everything.
+ */
+void logger_close(logger_t *lg) {
+    if (!lg) return;
+
+    lg->stop = 1;
+    sem_post(&lg->wake);
+    pthread_join(lg->writer, NULL);
+
+    close(lg->fd);
+    sem_destroy(&lg->wake);
+    pthread_mutex_destroy(&lg->sync_mutex);
+    pthread_cond_destroy(&lg->sync_cond);
+    pthread_mutex_destroy(&lg->tail_mutex);
+    mpmc_destroy(&lg->ready_q);
+    mpmc_destroy(&lg->free_q);
+    free(lg->tail_len);
+    free(lg->tail);
+    free(lg->batch);
+    free(lg->records);
+    free(lg);
+}
+
+/**
+ * \brief           Map a policy name from the command line to log_fsync_t.
+ *
+ * \return          0 on success, -1 for an unknown name.
+ */
+int logger_parse_fsync(const char *name, log_fsync_t *out) {
+    if (strcmp(name, "none") == 0)          *out = LOG_FSYNC_NONE;
+    else if (strcmp(name, "interval") == 0) *out = LOG_FSYNC_INTERVAL;
+    else if (strcmp(name, "always") == 0)   *out = LOG_FSYNC_ALWAYS;
+    else return -1;
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: logger.h                                        #
+# Purpose:                                                   #
+#     Declares the asynchronous request logger. Session     #
+#     threads publish fixed-size records into a lock-free   #
+#     ring; one writer thread keeps the log file open,      #
+#     formats records in batches and applies the chosen     #
+#     fsync policy, so no request ever waits on file I/O.   #
+#     The writer also keeps the most recent lines in a      #
+#     tail ring that answers "get log <n>" without a scan.  #
+#     logger_reopen() lets log rotation swap the file.      #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: write(2), fdatasync(2),              #
+#     sem_timedwait(3), localtime_r(3), strftime(3)         #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard), <stdatomic.h>       #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <stdint.h>     /* uint16_t */
+#include <time.h>       /* time_t */
+#include <pthread.h>    /* pthread_t, pthread_mutex_t, pthread_cond_t */
+#include <semaphore.h>  /* sem_t */
+#include <stdatomic.h>  /* atomic_ulong, atomic_int */
+
+#include "pool.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Records that can be waiting for the writer at once. */
+#define LOG_RING_DEPTH          4096
+
+/*!< Longest command text kept per record (longer ones are truncated). */
+#define LOG_RECORD_CMD          256
+
+/*!< Formatted bytes the writer gathers before one write(). */
+#define LOG_BATCH_BYTES         (64 * 1024)
+
+/*!< Default writer wake-up period in milliseconds. */
+#define LOG_FLUSH_MS_DEFAULT    100
+
+/*!< Minimum spacing of fdatasync() calls under LOG_FSYNC_INTERVAL. */
+#define LOG_FSYNC_PERIOD_MS     1000
+
+/*!< Most recent log lines kept in memory for "get log <n>". */
+#define LOG_TAIL_LINES          8192
+
+/*!< Bytes per tail slot; fits the longest line logger_format() emits. */
+#define LOG_TAIL_LINE           384
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< When the writer forces logged lines to stable storage. */
+typedef enum {
+    LOG_FSYNC_NONE = 0,             /*!< Leave it to the kernel */
+    LOG_FSYNC_INTERVAL,             /*!< At most once per LOG_FSYNC_PERIOD_MS */
+    LOG_FSYNC_ALWAYS                /*!< After every batch written */
+} log_fsync_t;
+
+/*!< One queued request, formatted later by the writer thread. */
+typedef struct {
+    time_t  when;                   /*!< Time the command was received */
+    int     port;                   /*!< Client port */
+    char    ip[64];                 /*!< Client address */
+    char    cmd[LOG_RECORD_CMD];    /*!< Command text */
+} log_record_t;
+
+/**
+ * \brief           Asynchronous logger state.
+ *
+ * \note            Records cycle between \ref free_q and \ref ready_q, so
+ *                  producers never allocate or lock. Only the writer thread
+ *                  touches the file, the batch buffer and the timestamp cache.
+ */
+typedef struct {
+    int             fd;             /*!< Log file, kept open for append */
+    char            path[256];      /*!< Log path (reopened on rotation) */
+    atomic_int      reopen;         /*!< Set by logger_reopen() */
+    log_record_t   *records;        /*!< Preallocated record storage */
+    mpmc_queue_t    free_q;         /*!< Records available to producers */
+    mpmc_queue_t    ready_q;        /*!< Records waiting for the writer */
+    sem_t           wake;           /*!< Wakes the writer before its timeout */
+    pthread_t       writer;         /*!< Writer thread */
+    int             flush_ms;       /*!< Writer wake-up period */
+    log_fsync_t     fsync_policy;   /*!< Durability policy */
+    volatile int    stop;           /*!< Set by logger_close() */
+    atomic_ulong    enqueued;       /*!< Records published so far */
+    unsigned long   written;        /*!< Records written (guarded by sync_mutex) */
+    pthread_mutex_t sync_mutex;     /*!< Guards \ref written for logger_sync() */
+    pthread_cond_t  sync_cond;      /*!< Signalled after every writer pass */
+    time_t          ts_cached;      /*!< Second \ref ts_text was built for */
+    char            ts_text[32];    /*!< Cached "YYYY-MM-DD HH:MM:SS" */
+    char           *batch;          /*!< Writer's output buffer */
+    size_t          batch_len;      /*!< Valid bytes in \ref batch */
+    char           *tail;           /*!< LOG_TAIL_LINES slots of LOG_TAIL_LINE */
+    uint16_t       *tail_len;       /*!< Length of each tail slot */
+    size_t          tail_head;      /*!< Slot the next line overwrites */
+    size_t          tail_count;     /*!< Valid slots (<= LOG_TAIL_LINES) */
+    int             tail_whole;     /*!< Ring still holds the entire file */
+    pthread_mutex_t tail_mutex;     /*!< Guards the tail ring and fd swaps */
+} logger_t;
+
+/*!< Opaque cursor over a range of the log file (logger_tail_open()). */
+typedef struct logger_stream logger_stream_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Open the log file and start the writer thread.
+ *
+ * \param[in]       path        Log file (created if missing, appended to).
+ * \param[in]       flush_ms    Writer wake-up period (<= 0 → default).
+ * \param[in]       policy      fsync policy.
+ *
+ * \return          Running logger, or NULL on failure.
+ */
+logger_t *logger_open(const char *path, int flush_ms, log_fsync_t policy);
+
+/**
+ * \brief           Queue one "Client ip:port issued command" line.
+ *
+ * \return          0 if queued, -1 if the logger is shutting down.
+ *
+ * \note            Lock-free; only waits (yielding) if the ring is full.
+ */
+int logger_log(logger_t *lg, const char *ip, int port, const char *cmd);
+
+/**
+ * \brief           Block until every record queued so far is in the file.
+ */
+void logger_sync(logger_t *lg);
+
+/**
+ * \brief           Return the last \p n lines of the log, oldest first.
+ *
+ * \param[in]       n           Number of lines wanted (at most LOG_TAIL_LINES).
+ *
+ * \return          malloc'd NUL-terminated text ("" if the log is empty),
+ *                  or NULL on failure. The caller frees it.
+ *
+ * \note            O(n): served from the in-memory tail ring, falling back
+ *                  to a reverse scan of the file only when \p n exceeds what
+ *                  the ring holds. Includes every line queued before the call.
+ *                  A larger \p n is clamped, and the file scan reads at most
+ *                  LOG_TAIL_LINES * LOG_TAIL_LINE bytes, so the reply is
+ *                  bounded however long the log grows. Use it where the
+ *                  text must fit in memory (a binary frame); otherwise
+ *                  stream it with logger_tail_open().
+ */
+char *logger_tail(logger_t *lg, int n);
+
+/**
+ * \brief           Open a cursor over the last \p n lines of the log file.
+ *
+ * \param[in]       n           Number of lines wanted (no upper limit).
+ * \param[out]      bytes       Bytes the cursor will produce (0 if empty).
+ *
+ * \return          Cursor for logger_tail_fill(), or NULL on failure.
+ *
+ * \note            Includes every line queued before the call, like
+ *                  logger_tail(). The cursor reads a dup() of the log
+ *                  descriptor, so a rotation does not cut it short, and
+ *                  holds no lock between fills. Lines appended later are
+ *                  not included.
+ */
+logger_stream_t *logger_tail_open(logger_t *lg, int n, size_t *bytes);
+
+/**
+ * \brief           Copy the cursor's next bytes into \p buf (a stream_fill_fn).
+ *
+ * \return          Bytes copied, 0 once the range is done.
+ */
+size_t logger_tail_fill(void *ctx, char *buf, size_t cap);
+
+/**
+ * \brief           Release a cursor from logger_tail_open(); NULL is ignored.
+ */
+void logger_tail_close(void *ctx);
+
+/**
+ * \brief           Ask the writer to reopen the log path (for log rotation).
+ *
+ * \note            Async-signal-safe, so a SIGHUP handler may call it. Lines
+ *                  queued before the call still go to the old file; the
+ *                  writer then opens the path afresh and reseeds the tail
+ *                  ring from it, so "get log" follows the new file.
+ */
+void logger_reopen(logger_t *lg);
+
+/**
+ * \brief           Drain outstanding records, stop the writer and free.
+ */
+void logger_close(logger_t *lg);
+
+/**
+ * \brief           Parse an fsync policy name ("none", "interval", "always").
+ *
+ * \return          0 on success, -1 if \p name is unknown.
+ */
+int logger_parse_fsync(const char *name, log_fsync_t *out);
+
+#endif /* LOGGER_H */
@@ -0,0 +1,533 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: metrics.c                                       #
+# Purpose:                                                   #
+#     Implements sharded metrics. A thread's first sample   #
+#     claims a shard (recycled from exited threads when     #
+#     possible); afterwards recording is a few relaxed,     #
+#     unlocked stores into memory no other thread writes.   #
+#     Reports walk the shard list and sum it.               #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: clock_gettime(2),                    #
+#     pthread_key_create(3), accept(2), mmap(2)             #
+#     https://man7.org/linux/man-pages/                     #
+# [2] Prometheus text exposition format                     #
+#     https://prometheus.io/docs/instrumenting/exposition_formats/ #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* vsnprintf, perror */
+#include <stdlib.h>     /* malloc, realloc, free */
+#include <string.h>     /* memset, strncmp */
+#include <stdarg.h>     /* va_list */
+#include <time.h>       /* clock_gettime */
+#include <unistd.h>     /* close */
+#include <pthread.h>    /* pthread_key_*, pthread_mutex_*, pthread_create */
+#include <sys/socket.h> /* accept, recv, setsockopt */
+#include <sys/time.h>   /* struct timeval */
+#include <sys/mman.h>   /* mmap */
+
+#include "common.h"
+#include "metrics.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Sub-buckets per power of two: half of 2^METRICS_SUB_BITS. */
+#define METRICS_HALF    (1u << (METRICS_SUB_BITS - 1))
+
+/*!< Upper bounds (seconds) of the Prometheus histogram buckets. */
+static const double prom_bounds[] = {
+    10e-6, 50e-6, 100e-6, 250e-6, 500e-6, 1e-3, 2.5e-3, 5e-3,
+    10e-3, 25e-3, 50e-3, 100e-3, 250e-3, 1.0
+};
+#define PROM_BOUNDS     (sizeof(prom_bounds) / sizeof(prom_bounds[0]))
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Counters of one recording thread.
+ *
+ * \note            Aligned to a cache line so neighbouring shards never
+ *                  share one. Only the owning thread writes; readers may see
+ *                  a sample half counted (count bumped, histogram not yet),
+ *                  which is fine for monitoring.
+ */
+typedef struct metrics_shard {
+    uint64_t    cmd_count[MCMD_COUNT];          /*!< Commands handled */
+    uint64_t    cmd_ns[MCMD_COUNT];             /*!< Total handling time */
+    uint64_t    cmd_hist[MCMD_COUNT][METRICS_BUCKETS]; /*!< Latency histogram */
+    uint64_t    wait_count[MWAIT_COUNT];        /*!< Blocking waits */
+    uint64_t    wait_ns[MWAIT_COUNT];           /*!< Time spent blocked */
+    uint64_t    conns_opened;                   /*!< Connections accepted */
+    uint64_t    conns_closed;                   /*!< Connections closed */
+    struct metrics_shard *next;                 /*!< Registry of all shards */
+    struct metrics_shard *next_free;            /*!< Free list of released shards */
+} __attribute__((aligned(64))) metrics_shard_t;
+
+/*!< Summed view built for a report. */
+typedef struct {
+    uint64_t    cmd_count[MCMD_COUNT];
+    uint64_t    cmd_ns[MCMD_COUNT];
+    uint64_t    cmd_hist[MCMD_COUNT][METRICS_BUCKETS];
+    uint64_t    wait_count[MWAIT_COUNT];
+    uint64_t    wait_ns[MWAIT_COUNT];
+    uint64_t    conns_opened;
+    uint64_t    conns_closed;
+} metrics_sum_t;
+
+/*!< Growable report text. */
+typedef struct {
+    char       *buf;                /*!< NUL-terminated text */
+    size_t      len;                /*!< Bytes used */
+    size_t      cap;                /*!< Bytes allocated */
+    int         oom;                /*!< An allocation failed */
+} report_t;
+
+/*!< Names used in reports (snake_case doubles as the Prometheus label). */
+static const char *cmd_names[MCMD_COUNT] = {
+    "get_pokemon", "query_pokemon", "stats", "get_trainer", "list_trainers",
+    "post_trainer", "put_trainer", "delete_trainer", "mget_trainer",
+    "mpost_trainer", "mdelete_trainer", "get_log", "snapshot",
+    "reload_pokemon", "get_replication", "get_stats", "other"
+};
+static const char *wait_names[MWAIT_COUNT] = {
+    "trainer_index_shared", "trainer_index_exclusive", "trainer_stripe",
+    "wal_commit", "log_ring_full"
+};
+
+/* ========================================================================== */
+/* ================================ Registry ================================ */
+/* ========================================================================== */
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static metrics_shard_t *registry;       /*!< Every shard ever created */
+static metrics_shard_t *free_shards;    /*!< Shards of exited threads */
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t shard_key;
+static uint64_t start_ns;               /*!< metrics_now() at first use */
+
+static __thread metrics_shard_t *my_shard;
+
+/**
+ * \brief           Thread-exit destructor: hand the shard to the next thread.
+ *
+ * \note            Counts stay in the shard, so totals never go backwards.
+ */
+static void shard_release(void *arg) {
+    metrics_shard_t *s = arg;
+    pthread_mutex_lock(&registry_mutex);
+    s->next_free = free_shards;
+    free_shards = s;
+    pthread_mutex_unlock(&registry_mutex);
+}
+
+/**
+ * \brief           One-time setup of the thread-exit hook and the uptime base.
+ */
+static void key_init(void) {
+    pthread_key_create(&shard_key, shard_release);
+    start_ns = metrics_now();
+}
+
+/**
+ * \brief           The calling thread's shard, claimed on first use.
+ *
+ * \return          Shard, or NULL if none could be allocated.
+ */
+static metrics_shard_t *shard_get(void) {
+    if (my_shard) return my_shard;
+
+    pthread_once(&key_once, key_init);
+    pthread_mutex_lock(&registry_mutex);
+    metrics_shard_t *s = free_shards;
+    if (s) {
+        free_shards = s->next_free;
+    } else {
+        /* Fresh anonymous pages are zero and cost nothing until written, so
+         * a session thread only pays for the histogram rows it touches */
+        s = mmap(NULL, sizeof(*s), PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (s == MAP_FAILED) {
+            s = NULL;
+        } else {
+            s->next = registry;
+            registry = s;
+        }
+    }
+    pthread_mutex_unlock(&registry_mutex);
+
+    if (s) pthread_setspecific(shard_key, s);
+    my_shard = s;
+    return s;
+}
+
+/**
+ * \brief           Add \p v to a counter only the calling thread writes.
+ *
+ * \note            Relaxed load + store: no lock prefix, but readers never
+ *                  see a torn value.
+ */
+static inline void bump(uint64_t *p, uint64_t v) {
+    __atomic_store_n(p, __atomic_load_n(p, __ATOMIC_RELAXED) + v, __ATOMIC_RELAXED);
+}
+
+/* ========================================================================== */
+/* =============================== Histogram ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Bucket of a latency in nanoseconds.
+ */
+static size_t hist_index(uint64_t ns) {
+    if (ns >= ((uint64_t)1 << METRICS_MAX_BITS))
+        ns = ((uint64_t)1 << METRICS_MAX_BITS) - 1;
+    if (ns < 2 * METRICS_HALF) return (size_t)ns;
+
+    unsigned shift = (unsigned)(63 - __builtin_clzll(ns)) - (METRICS_SUB_BITS - 1);
+    return (size_t)(shift + 1) * METRICS_HALF + (size_t)((ns >> shift) - METRICS_HALF);
+}
+
+/**
+ * \brief           Largest latency mapping to bucket \p i.
+ */
+static uint64_t hist_upper(size_t i) {
+    if (i < 2 * METRICS_HALF) return (uint64_t)i;
+
+    unsigned shift = (unsigned)(i / METRICS_HALF) - 1;
+    uint64_t base = (uint64_t)(i % METRICS_HALF + METRICS_HALF) << shift;
+    return base + ((uint64_t)1 << shift) - 1;
+}
+
+/**
+ * \brief           Latency at quantile \p q of \p hist (bucket precision).
+ */
+static uint64_t hist_quantile(const uint64_t *hist, uint64_t total, double q) {
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(q * (double)total + 0.5);
+    if (rank < 1) rank = 1;
+    uint64_t seen = 0;
+    for (size_t i = 0; i < METRICS_BUCKETS; i++) {
+        seen += hist[i];
+        if (seen >= rank) return hist_upper(i);
+    }
+    return hist_upper(METRICS_BUCKETS - 1);
+}
+
+/* ========================================================================== */
+/* ================================ Recording =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Read CLOCK_MONOTONIC in nanoseconds.
+ */
+uint64_t metrics_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+/**
+ * \brief           Count a command and its latency in this thread's shard.
+ */
+void metrics_command(metric_cmd_t cmd, uint64_t ns) {
+    metrics_shard_t *s = shard_get();
+    if (!s || cmd >= MCMD_COUNT) return;
+
+    bump(&s->cmd_count[cmd], 1);
+    bump(&s->cmd_ns[cmd], ns);
+    bump(&s->cmd_hist[cmd][hist_index(ns)], 1);
+}
+
+/**
+ * \brief           Count a blocking wait in this thread's shard.
+ */
+void metrics_wait(metric_wait_t where, uint64_t ns) {
+    metrics_shard_t *s = shard_get();
+    if (!s || where >= MWAIT_COUNT) return;
+
+    bump(&s->wait_count[where], 1);
+    bump(&s->wait_ns[where], ns);
+}
+
+/**
+ * \brief           Count an accepted connection.
+ */
+void metrics_conn_open(void) {
+    metrics_shard_t *s = shard_get();
+    if (s) bump(&s->conns_opened, 1);
+}
+
+/**
+ * \brief           Count a closed connection.
+ *
+ * \note            May run on another thread than the matching open: the
+ *                  active gauge is the difference of the sums.
+ */
+void metrics_conn_close(void) {
+    metrics_shard_t *s = shard_get();
+    if (s) bump(&s->conns_closed, 1);
+}
+
+/* ========================================================================== */
+/* ================================= Reports ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Sum every shard into \p out.
+ */
+static void metrics_collect(metrics_sum_t *out) {
+    memset(out, 0, sizeof(*out));
+    pthread_once(&key_once, key_init);
+
+    pthread_mutex_lock(&registry_mutex);
+    for (metrics_shard_t *s = registry; s; s = s->next) {
+        for (int c = 0; c < MCMD_COUNT; c++) {
+            out->cmd_count[c] += __atomic_load_n(&s->cmd_count[c], __ATOMIC_RELAXED);
+            out->cmd_ns[c] += __atomic_load_n(&s->cmd_ns[c], __ATOMIC_RELAXED);
+            for (size_t b = 0; b < METRICS_BUCKETS; b++)
+                out->cmd_hist[c][b] += __atomic_load_n(&s->cmd_hist[c][b], __ATOMIC_RELAXED);
+        }
+        for (int w = 0; w < MWAIT_COUNT; w++) {
+            out->wait_count[w] += __atomic_load_n(&s->wait_count[w], __ATOMIC_RELAXED);
+            out->wait_ns[w] += __atomic_load_n(&s->wait_ns[w], __ATOMIC_RELAXED);
+        }
+        out->conns_opened += __atomic_load_n(&s->conns_opened, __ATOMIC_RELAXED);
+        out->conns_closed += __atomic_load_n(&s->conns_closed, __ATOMIC_RELAXED);
+    }
+    pthread_mutex_unlock(&registry_mutex);
+}
+
+/**
+ * \brief           Append formatted text to a report.
+ */
+__attribute__((format(printf, 2, 3)))
+static void report_printf(report_t *r, const char *fmt, ...) {
+    for (;;) {
+        va_list ap;
+        size_t room = r->cap - r->len;
+        va_start(ap, fmt);
+        int n = r->buf ? vsnprintf(r->buf + r->len, room, fmt, ap) : -1;
+        va_end(ap);
+
+        if (n >= 0 && (size_t)n < room) {
+            r->len += (size_t)n;
+            return;
+        }
+
+        size_t cap = r->cap ? r->cap * 2 : 4096;
+        while (n >= 0 && cap - r->len <= (size_t)n) cap *= 2;
+        char *p = realloc(r->buf, cap);
+        if (!p) {
+            r->oom = 1;
+            return;
+        }
+        r->buf = p;
+        r->cap = cap;
+    }
+}
+
+/**
+ * \brief           Hand the report text to the caller, or NULL if it failed.
+ */
+static char *report_finish(report_t *r) {
+    if (r->oom || !r->buf) {
+        free(r->buf);
+        return NULL;
+    }
+    return r->buf;
+}
+
+/**
+ * \brief           Build the "get stats" text.
+ */
+char *metrics_report_text(void) {
+    metrics_sum_t *m = malloc(sizeof(*m));
+    if (!m) return NULL;
+    metrics_collect(m);
+
+    report_t r = {0};
+    report_printf(&r, "Uptime: %.0f s\n", (double)(metrics_now() - start_ns) / 1e9);
+    report_printf(&r, "Connections: %llu active, %llu total\n",
+                  (unsigned long long)(m->conns_opened - m->conns_closed),
+                  (unsigned long long)m->conns_opened);
+
+    report_printf(&r, "\n%-16s %10s %10s %10s %10s %10s\n",
+                  "Command", "count", "p50 us", "p90 us", "p99 us", "mean us");
+    for (int c = 0; c < MCMD_COUNT; c++) {
+        uint64_t n = m->cmd_count[c];
+        if (n == 0) continue;
+        report_printf(&r, "%-16s %10llu %10.1f %10.1f %10.1f %10.1f\n", cmd_names[c],
+                      (unsigned long long)n,
+                      hist_quantile(m->cmd_hist[c], n, 0.50) / 1e3,
+                      hist_quantile(m->cmd_hist[c], n, 0.90) / 1e3,
+                      hist_quantile(m->cmd_hist[c], n, 0.99) / 1e3,
+                      (double)m->cmd_ns[c] / (double)n / 1e3);
+    }
+
+    report_printf(&r, "\n%-24s %10s %12s\n", "Wait", "blocked", "total ms");
+    for (int w = 0; w < MWAIT_COUNT; w++)
+        report_printf(&r, "%-24s %10llu %12.3f\n", wait_names[w],
+                      (unsigned long long)m->wait_count[w], (double)m->wait_ns[w] / 1e6);
+
+    /* The framer appends its own newline */
+    if (!r.oom && r.len > 0 && r.buf[r.len - 1] == '\n')
+        r.buf[--r.len] = '\0';
+    free(m);
+    return report_finish(&r);
+}
+
+/**
+ * \brief           Build the Prometheus exposition text.
+ *
+ * \note            Histogram buckets are cumulative, as the format requires;
+ *                  a fine bucket is counted under the first bound at or above
+ *                  its upper edge, so bounds are exact to histogram precision.
+ */
+char *metrics_report_prometheus(void) {
+    metrics_sum_t *m = malloc(sizeof(*m));
+    if (!m) return NULL;
+    metrics_collect(m);
+
+    report_t r = {0};
+    report_printf(&r, "# HELP pokeserver_uptime_seconds Seconds since the server started.\n"
+                      "# TYPE pokeserver_uptime_seconds gauge\n"
+                      "pokeserver_uptime_seconds %.3f\n",
+                  (double)(metrics_now() - start_ns) / 1e9);
+    report_printf(&r, "# HELP pokeserver_connections_active Open client connections.\n"
+                      "# TYPE pokeserver_connections_active gauge\n"
+                      "pokeserver_connections_active %llu\n"
+                      "# HELP pokeserver_connections_total Client connections accepted.\n"
+                      "# TYPE pokeserver_connections_total counter\n"
+                      "pokeserver_connections_total %llu\n",
+                  (unsigned long long)(m->conns_opened - m->conns_closed),
+                  (unsigned long long)m->conns_opened);
+
+    report_printf(&r, "# HELP pokeserver_command_duration_seconds Command handling time.\n"
+                      "# TYPE pokeserver_command_duration_seconds histogram\n");
+    for (int c = 0; c < MCMD_COUNT; c++) {
+        uint64_t cum = 0;
+        size_t b = 0;
+        for (size_t k = 0; k < PROM_BOUNDS; k++) {
+            uint64_t bound_ns = (uint64_t)(prom_bounds[k] * 1e9);
+            for (; b < METRICS_BUCKETS && hist_upper(b) <= bound_ns; b++)
+                cum += m->cmd_hist[c][b];
+            report_printf(&r, "pokeserver_command_duration_seconds_bucket"
+                              "{command=\"%s\",le=\"%g\"} %llu\n",
+                          cmd_names[c], prom_bounds[k], (unsigned long long)cum);
+        }
+        report_printf(&r, "pokeserver_command_duration_seconds_bucket"
+                          "{command=\"%s\",le=\"+Inf\"} %llu\n"
+                          "pokeserver_command_duration_seconds_sum{command=\"%s\"} %.9f\n"
+                          "pokeserver_command_duration_seconds_count{command=\"%s\"} %llu\n",
+                      cmd_names[c], (unsigned long long)m->cmd_count[c],
+                      cmd_names[c], (double)m->cmd_ns[c] / 1e9,
+                      cmd_names[c], (unsigned long long)m->cmd_count[c]);
+    }
+
+    report_printf(&r, "# HELP pokeserver_wait_total Waits that blocked on another thread.\n"
+                      "# TYPE pokeserver_wait_total counter\n");
+    for (int w = 0; w < MWAIT_COUNT; w++)
+        report_printf(&r, "pokeserver_wait_total{wait=\"%s\"} %llu\n",
+                      wait_names[w], (unsigned long long)m->wait_count[w]);
+    report_printf(&r, "# HELP pokeserver_wait_seconds_total Time spent blocked.\n"
+                      "# TYPE pokeserver_wait_seconds_total counter\n");
+    for (int w = 0; w < MWAIT_COUNT; w++)
+        report_printf(&r, "pokeserver_wait_seconds_total{wait=\"%s\"} %.9f\n",
+                      wait_names[w], (double)m->wait_ns[w] / 1e9);
+
+    free(m);
+    return report_finish(&r);
+}
+
+/* ========================================================================== */
+/* ============================== HTTP Endpoint ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Answer one scrape on \p fd, then close it.
+ */
+static void http_serve(int fd) {
+    char req[1024];
+    size_t len = 0;
+
+    /* A slow or silent client must not wedge the only listener thread */
+    struct timeval tv = { .tv_sec = 2, .tv_usec = 0 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    while (len < sizeof(req) - 1) {
+        ssize_t n = recv(fd, req + len, sizeof(req) - 1 - len, 0);
+        if (n <= 0) break;
+        len += (size_t)n;
+        req[len] = '\0';
+        if (strstr(req, "\r\n\r\n") || strstr(req, "\n\n")) break;
+    }
+    req[len] = '\0';
+
+    char *body = NULL;
+    const char *status = "404 Not Found";
+    if (strncmp(req, "GET /metrics", 12) == 0 || strncmp(req, "GET / ", 6) == 0) {
+        body = metrics_report_prometheus();
+        status = body ? "200 OK" : "500 Internal Server Error";
+    }
+
+    char head[256];
+    size_t blen = body ? strlen(body) : 0;
+    int hlen = snprintf(head, sizeof(head),
+                        "HTTP/1.0 %s\r\n"
+                        "Content-Type: text/plain; version=0.0.4\r\n"
+                        "Content-Length: %zu\r\n"
+                        "Connection: close\r\n\r\n", status, blen);
+    if (send_bytes(fd, head, (size_t)hlen) >= 0 && body)
+        send_bytes(fd, body, blen);
+    free(body);
+    close(fd);
+}
+
+/**
+ * \brief           Accept loop of the metrics listener.
+ */
+static void *http_thread(void *arg) {
+    int lfd = (int)(intptr_t)arg;
+
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) continue;
+        http_serve(fd);
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Bind \p port and start the detached listener thread.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int metrics_start_http(const char *port) {
+    int lfd = create_server_socket(port);
+    if (lfd < 0) return -1;
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, http_thread, (void *)(intptr_t)lfd) != 0) {
+        close(lfd);
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
@@ -0,0 +1,140 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: metrics.h                                       #
+# Purpose:                                                   #
+#     Declares the server's built-in metrics: per-command   #
+#     counters and latency histograms, lock and commit wait #
+#     times, and connection counts. Every thread records    #
+#     into its own cache-line-aligned shard with plain      #
+#     stores; shards are only summed when a report is       #
+#     requested ("get stats" or the Prometheus endpoint).   #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: clock_gettime(2),                    #
+#     pthread_key_create(3)                                 #
+#     https://man7.org/linux/man-pages/                     #
+# [2] Prometheus text exposition format                     #
+#     https://prometheus.io/docs/instrumenting/exposition_formats/ #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>     /* uint64_t */
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Histogram precision: 2^METRICS_SUB_BITS sub-buckets per power of two. */
+#define METRICS_SUB_BITS        4
+
+/*!< Largest latency tracked exactly (2^36 ns ≈ 69 s); longer ones clamp. */
+#define METRICS_MAX_BITS        36
+
+/*!< Buckets per latency histogram. */
+#define METRICS_BUCKETS \
+    ((METRICS_MAX_BITS - METRICS_SUB_BITS + 2) * (1u << (METRICS_SUB_BITS - 1)))
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Command classes with their own counter and latency histogram. */
+typedef enum {
+    MCMD_GET_POKEMON = 0,           /*!< get pokemon <id> */
+    MCMD_QUERY_POKEMON,             /*!< get pokemon <filters> */
+    MCMD_STATS,                     /*!< stats ... */
+    MCMD_GET_TRAINER,               /*!< get trainer <id> */
+    MCMD_LIST_TRAINERS,             /*!< get trainer [after|limit] */
+    MCMD_POST_TRAINER,              /*!< post trainer */
+    MCMD_PUT_TRAINER,               /*!< put trainer */
+    MCMD_DELETE_TRAINER,            /*!< delete trainer */
+    MCMD_MGET_TRAINER,              /*!< mget trainer <ids> */
+    MCMD_MPOST_TRAINER,             /*!< mpost trainer <records> */
+    MCMD_MDELETE_TRAINER,           /*!< mdelete trainer <ids> */
+    MCMD_GET_LOG,                   /*!< get log <n> */
+    MCMD_SNAPSHOT,                  /*!< snapshot */
+    MCMD_RELOAD_POKEMON,            /*!< reload pokemon */
+    MCMD_GET_REPLICATION,           /*!< get replication */
+    MCMD_GET_STATS,                 /*!< get stats */
+    MCMD_OTHER,                     /*!< exit, proto, invalid commands */
+    MCMD_COUNT
+} metric_cmd_t;
+
+/*!< Places where a request can wait on another thread. */
+typedef enum {
+    MWAIT_TRAINER_SHARED = 0,       /*!< Trainer index lock, shared */
+    MWAIT_TRAINER_EXCL,             /*!< Trainer index lock, exclusive */
+    MWAIT_TRAINER_STRIPE,           /*!< Trainer record stripe locks */
+    MWAIT_WAL_COMMIT,               /*!< Blocking trainer WAL commit */
+    MWAIT_LOG_RING,                 /*!< Full logger ring */
+    MWAIT_COUNT
+} metric_wait_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Monotonic clock in nanoseconds.
+ */
+uint64_t metrics_now(void);
+
+/**
+ * \brief           Count one command of class \p cmd that took \p ns.
+ */
+void metrics_command(metric_cmd_t cmd, uint64_t ns);
+
+/**
+ * \brief           Count one wait of \p ns at \p where.
+ *
+ * \note            Callers only time waits that actually blocked (a failed
+ *                  try-lock), so uncontended paths pay nothing.
+ */
+void metrics_wait(metric_wait_t where, uint64_t ns);
+
+/**
+ * \brief           Count an accepted / a closed client connection.
+ */
+void metrics_conn_open(void);
+void metrics_conn_close(void);
+
+/**
+ * \brief           Sum all shards into a human-readable report.
+ *
+ * \return          malloc'd text, or NULL on allocation failure.
+ */
+char *metrics_report_text(void);
+
+/**
+ * \brief           Sum all shards in Prometheus text exposition format.
+ *
+ * \return          malloc'd text, or NULL on allocation failure.
+ */
+char *metrics_report_prometheus(void);
+
+/**
+ * \brief           Serve metrics_report_prometheus() over HTTP on \p port.
+ *
+ * \return          0 once the listener thread runs, -1 on failure.
+ *
+ * \note            Answers "GET /metrics" (and "GET /") on a detached thread,
+ *                  one short-lived connection at a time, like a scrape
+ *                  target expects.
+ */
+int metrics_start_http(const char *port);
+
+#endif /* METRICS_H */
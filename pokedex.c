@@ -0,0 +1,286 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokedex.c                                       #
+# Purpose:                                                   #
+#     Implements catalog publication. Every thread owns a   #
+#     cache-line sized hazard slot naming the version it    #
+#     reads; a reload swaps the published pointer, then     #
+#     waits until no slot names the old version and no pin  #
+#     holds it before unmapping it.                         #
+#############################################################
+# Citations:                                                #
+# [1] McKenney, P. E. "What is RCU, Fundamentally?" (LWN    #
+#     2007)                                                 #
+# [2] Michael, M. M. "Hazard Pointers: Safe Memory          #
+#     Reclamation for Lock-Free Objects" (IEEE TPDS 2004)   #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf, snprintf */
+#include <stdlib.h>     /* malloc, aligned_alloc, free */
+#include <unistd.h>     /* usleep */
+#include <pthread.h>    /* pthread_create, pthread_key_*, pthread_mutex_* */
+#include <stdatomic.h>  /* atomic_* */
+
+#include "pokedex.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Pause between checks for readers of a replaced catalog. */
+#define POKEDEX_GRACE_POLL_US   1000
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< One published catalog. */
+struct pokedex_version {
+    PokemonDB      *db;                 /*!< Records and indexes */
+    unsigned long   number;             /*!< 1 for the startup catalog */
+    atomic_long     pins;               /*!< pokedex_pin() holders */
+};
+
+/*!< One thread's hazard pointer; written only by its owner. */
+typedef struct reader_slot {
+    _Atomic(struct pokedex_version *) hazard;   /*!< Version being read, or NULL */
+    struct reader_slot *next;           /*!< Every slot ever created */
+    struct reader_slot *next_free;      /*!< Slots of exited threads */
+} __attribute__((aligned(64))) reader_slot_t;
+
+/* ========================================================================== */
+/* ================================== State ================================= */
+/* ========================================================================== */
+
+static _Atomic(struct pokedex_version *) current;   /*!< Published catalog */
+static char catalog_path[256];                      /*!< File reloads read */
+static atomic_ulong published;                      /*!< Number of \ref current */
+static atomic_int reloading;                        /*!< A reload thread runs */
+static pokedex_retired_fn reload_retired;           /*!< Hook of that reload */
+
+static pthread_mutex_t registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+static reader_slot_t *slots;            /*!< Scanned by the reclaimer */
+static reader_slot_t *free_slots;
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t slot_key;
+
+static __thread reader_slot_t *my_slot;
+static __thread struct pokedex_version *my_version;    /*!< Version of the open section */
+static __thread int my_fallback;        /*!< Section holds a pin instead of a slot */
+
+/* ========================================================================== */
+/* ================================ Registry ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Thread-exit destructor: hand the slot to the next thread.
+ */
+static void slot_release(void *arg) {
+    reader_slot_t *s = arg;
+    pthread_mutex_lock(&registry_mutex);
+    s->next_free = free_slots;
+    free_slots = s;
+    pthread_mutex_unlock(&registry_mutex);
+}
+
+/**
+ * \brief           One-time setup of the thread-exit hook.
+ */
+static void key_init(void) {
+    pthread_key_create(&slot_key, slot_release);
+}
+
+/**
+ * \brief           The calling thread's slot, claimed on first use.
+ *
+ * \return          Slot, or NULL if none could be allocated.
+ *
+ * \note            The registry mutex is taken once per thread, never per
+ *                  request.
+ */
+static reader_slot_t *slot_get(void) {
+    if (my_slot) return my_slot;
+
+    pthread_once(&key_once, key_init);
+    pthread_mutex_lock(&registry_mutex);
+    reader_slot_t *s = free_slots;
+    if (s) {
+        free_slots = s->next_free;
+    } else if ((s = aligned_alloc(64, sizeof(*s))) != NULL) {
+        atomic_init(&s->hazard, NULL);
+        s->next = slots;
+        slots = s;
+    }
+    pthread_mutex_unlock(&registry_mutex);
+
+    if (s) pthread_setspecific(slot_key, s);
+    my_slot = s;
+    return s;
+}
+
+/**
+ * \brief           Block until no request can still read \p old.
+ *
+ * \note            Runs after the new version is published. A reader that
+ *                  loaded \p old either already shows it in its slot or sees
+ *                  the new pointer on its re-check and retries, so an empty
+ *                  scan proves the old catalog is unreachable.
+ */
+static void wait_for_readers(struct pokedex_version *old) {
+    for (;;) {
+        pthread_mutex_lock(&registry_mutex);
+        int busy = atomic_load(&old->pins) > 0;
+        for (reader_slot_t *s = slots; s && !busy; s = s->next)
+            busy = atomic_load(&s->hazard) == old;
+        pthread_mutex_unlock(&registry_mutex);
+        if (!busy) return;
+        usleep(POKEDEX_GRACE_POLL_US);
+    }
+}
+
+/* ========================================================================== */
+/* ================================== Reload ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Build, publish and retire: one background reload.
+ */
+static void *reload_thread(void *arg) {
+    (void)arg;
+    struct pokedex_version *old = atomic_load(&current);
+    PokemonDB *db = pokemon_db_open(catalog_path);
+    struct pokedex_version *v = db ? malloc(sizeof(*v)) : NULL;
+
+    if (!v) {
+        if (db) pokemon_db_close(db);
+        fprintf(stderr, "[Server] Reload of %s failed; keeping catalog version %lu\n",
+                catalog_path, old->number);
+    } else {
+        v->db = db;
+        v->number = old->number + 1;
+        atomic_init(&v->pins, 0);
+        atomic_store(&current, v);
+        atomic_store(&published, v->number);
+
+        wait_for_readers(old);
+        if (reload_retired) reload_retired();
+        pokemon_db_close(old->db);
+        free(old);
+        printf("[Server] Reloaded %d Pokémon from %s (catalog version %lu)\n",
+               db->count, catalog_path, v->number);
+    }
+
+    atomic_store(&reloading, 0);
+    return NULL;
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Load \p path as catalog version 1.
+ */
+const PokemonDB *pokedex_open(const char *path) {
+    PokemonDB *db = pokemon_db_open(path);
+    struct pokedex_version *v = db ? malloc(sizeof(*v)) : NULL;
+    if (!v) {
+        if (db) pokemon_db_close(db);
+        return NULL;
+    }
+    v->db = db;
+    v->number = 1;
+    atomic_init(&v->pins, 0);
+    snprintf(catalog_path, sizeof(catalog_path), "%s", path);
+    atomic_store(&current, v);
+    atomic_store(&published, 1);
+    return db;
+}
+
+/**
+ * \brief           Start reading the current catalog.
+ */
+const PokemonDB *pokedex_enter(void) {
+    reader_slot_t *s = slot_get();
+    struct pokedex_version *v;
+
+    if (s) {
+        /* Publish, then confirm the version is still current */
+        do {
+            v = atomic_load(&current);
+            atomic_store(&s->hazard, v);
+        } while (atomic_load(&current) != v);
+    } else {
+        /* No slot: pin under the mutex the reclaimer scans with */
+        pthread_mutex_lock(&registry_mutex);
+        v = atomic_load(&current);
+        atomic_fetch_add(&v->pins, 1);
+        pthread_mutex_unlock(&registry_mutex);
+        my_fallback = 1;
+    }
+    my_version = v;
+    return v->db;
+}
+
+/**
+ * \brief           End the read section begun by pokedex_enter().
+ */
+void pokedex_exit(void) {
+    if (my_fallback) {
+        atomic_fetch_sub(&my_version->pins, 1);
+        my_fallback = 0;
+    } else if (my_slot) {
+        atomic_store_explicit(&my_slot->hazard, NULL, memory_order_release);
+    }
+    my_version = NULL;
+}
+
+/**
+ * \brief           Keep the catalog of the current read section alive.
+ */
+pokedex_pin_t *pokedex_pin(void) {
+    if (my_version) atomic_fetch_add(&my_version->pins, 1);
+    return my_version;
+}
+
+/**
+ * \brief           Release a pin from pokedex_pin(); NULL is ignored.
+ */
+void pokedex_unpin(pokedex_pin_t *pin) {
+    if (pin) atomic_fetch_sub_explicit(&pin->pins, 1, memory_order_release);
+}
+
+/**
+ * \brief           Reload the catalog file in a background thread.
+ */
+int pokedex_reload(pokedex_retired_fn retired) {
+    if (atomic_exchange(&reloading, 1)) return 1;
+
+    reload_retired = retired;
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, reload_thread, NULL) != 0) {
+        atomic_store(&reloading, 0);
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
+
+/**
+ * \brief           Number of the catalog version new requests will see.
+ */
+unsigned long pokedex_version(void) {
+    return atomic_load(&published);
+}
@@ -0,0 +1,110 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokedex.h                                       #
+# Purpose:                                                   #
+#     Declares the published Pokémon catalog. Requests read #
+#     the current PokemonDB through a per-thread hazard     #
+#     slot instead of a lock; "reload pokemon" builds a     #
+#     replacement in the background, swaps the pointer and  #
+#     frees the old catalog once no request can still see   #
+#     it (an RCU-style grace period).                       #
+#############################################################
+# Citations:                                                #
+# [1] McKenney, P. E. "What is RCU, Fundamentally?" (LWN    #
+#     2007)                                                 #
+# [2] Michael, M. M. "Hazard Pointers: Safe Memory          #
+#     Reclamation for Lock-Free Objects" (IEEE TPDS 2004)   #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef POKEDEX_H
+#define POKEDEX_H
+
+#include "pokemon_db.h"
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< A catalog version kept alive past pokedex_exit() (streamed replies). */
+typedef struct pokedex_version pokedex_pin_t;
+
+/*!< Called once a replaced catalog can no longer be read. */
+typedef void (*pokedex_retired_fn)(void);
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Load \p path as catalog version 1.
+ *
+ * \return          The catalog, or NULL if it could not be loaded.
+ *
+ * \note            \p path is remembered for pokedex_reload().
+ */
+const PokemonDB *pokedex_open(const char *path);
+
+/**
+ * \brief           Start reading the current catalog.
+ *
+ * \return          Catalog that stays valid until pokedex_exit().
+ *
+ * \note            Lock-free: the pointer is published in the calling
+ *                  thread's hazard slot and re-checked. Sections do not
+ *                  nest; each thread holds at most one at a time.
+ */
+const PokemonDB *pokedex_enter(void);
+
+/**
+ * \brief           End the read section begun by pokedex_enter().
+ */
+void pokedex_exit(void);
+
+/**
+ * \brief           Keep the catalog of the current read section alive.
+ *
+ * \return          Pin to pass to pokedex_unpin(); never NULL inside a section.
+ *
+ * \note            For replies produced after the section ends, such as a
+ *                  streamed listing. Pins are counted per version, so only
+ *                  requests that outlive their dispatch pay for an atomic.
+ */
+pokedex_pin_t *pokedex_pin(void);
+
+/**
+ * \brief           Release a pin from pokedex_pin(); NULL is ignored.
+ */
+void pokedex_unpin(pokedex_pin_t *pin);
+
+/**
+ * \brief           Reload the catalog file in a background thread.
+ *
+ * \param[in]       retired     Called after the old catalog's grace period,
+ *                              before it is freed (may be NULL).
+ *
+ * \return          0 if a reload started, 1 if one is already running,
+ *                  -1 if the thread could not be created.
+ *
+ * \note            The new catalog and its indexes are built off the request
+ *                  path; readers switch to it on their next pokedex_enter().
+ *                  A file that fails to load leaves the old catalog in place.
+ */
+int pokedex_reload(pokedex_retired_fn retired);
+
+/**
+ * \brief           Number of the catalog version new requests will see.
+ */
+unsigned long pokedex_version(void);
+
+#endif /* POKEDEX_H */
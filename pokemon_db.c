@@ -0,0 +1,267 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokemon_db.c                                    #
+# Purpose:                                                   #
+#     Implements the Pokémon catalog. pokemon.bin is mapped #
+#     read-only and validated against its header; records  #
+#     are served by pointer into the mapping. Sorted files  #
+#     are searched in place, while unsorted and legacy      #
+#     files get a dense pointer table indexed by ID.        #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: open(2), mmap(2), fstat(2)           #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* fprintf, perror */
+#include <stdlib.h>     /* calloc, free */
+#include <string.h>     /* memcmp, memcpy */
+#include <limits.h>     /* INT_MAX */
+#include <endian.h>     /* le16toh, le32toh */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close */
+#include <sys/stat.h>   /* fstat */
+#include <sys/mman.h>   /* mmap, munmap */
+
+#include "common.h"
+#include "pokemon_db.h"
+
+/* ========================================================================== */
+/* ================================ Loading ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Build the by_id table from the loaded records.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int pokemon_db_index(PokemonDB *db) {
+    db->max_id = 0;
+    for (int i = 0; i < db->count; i++) {
+        int id = db->records[i].id;
+        if (id > db->max_id && id <= POKEMON_DB_MAX_ID)
+            db->max_id = id;
+    }
+
+    db->by_id = calloc((size_t)db->max_id + 1, sizeof(*db->by_id));
+    if (!db->by_id) return -1;
+
+    for (int i = 0; i < db->count; i++) {
+        int id = db->records[i].id;
+        if (id <= 0 || id > POKEMON_DB_MAX_ID) {
+            fprintf(stderr, "[Server] Skipping Pokémon with bad ID %d\n", id);
+            continue;
+        }
+        /* First record wins if the file has duplicates */
+        if (!db->by_id[id])
+            db->by_id[id] = &db->records[i];
+    }
+    return 0;
+}
+
+/**
+ * \brief           Check that the record IDs strictly ascend.
+ *
+ * \return          1 if they do, 0 otherwise.
+ *
+ * \note            O(n), once at load: pokemon_db_get() binary-searches a
+ *                  sorted file, so a wrong POKEMON_FILE_SORTED flag would
+ *                  silently hide records.
+ */
+static int pokemon_db_ascending(const PokemonDB *db) {
+    for (int i = 1; i < db->count; i++) {
+        if (db->records[i].id <= db->records[i - 1].id)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Locate the record array inside the mapped file.
+ *
+ * \return          0 on success, -1 if the file is malformed.
+ *
+ * \note            A legacy file cannot be mistaken for a headered one: the
+ *                  magic read as a record ID exceeds POKEMON_DB_MAX_ID.
+ */
+static int pokemon_db_layout(PokemonDB *db, const char *path) {
+    const uint8_t *base = db->map;
+    size_t size = db->map_len;
+    PokemonFileHeader h;
+
+    if (size < sizeof(h) || memcmp(base, POKEMON_FILE_MAGIC, sizeof(h.magic)) != 0) {
+        /* Legacy layout: a bare array of records */
+        if (size % sizeof(Pokemon) != 0)
+            fprintf(stderr, "[Server] %s: ignoring %zu trailing byte(s)\n",
+                    path, size % sizeof(Pokemon));
+        if (size / sizeof(Pokemon) > INT_MAX) {
+            fprintf(stderr, "[Server] %s: too many records\n", path);
+            return -1;
+        }
+        db->records = (const Pokemon *)base;
+        db->count = (int)(size / sizeof(Pokemon));
+        return 0;
+    }
+
+    memcpy(&h, base, sizeof(h));
+    uint16_t version = le16toh(h.version);
+    uint16_t header_size = le16toh(h.header_size);
+    uint32_t record_size = le32toh(h.record_size);
+    uint32_t count = le32toh(h.count);
+
+    if (version != POKEMON_FILE_VERSION) {
+        fprintf(stderr, "[Server] %s: unsupported format version %u\n", path, version);
+        return -1;
+    }
+    if (header_size < sizeof(h) || record_size != sizeof(Pokemon)) {
+        fprintf(stderr, "[Server] %s: record size %u, expected %zu\n",
+                path, record_size, sizeof(Pokemon));
+        return -1;
+    }
+    if (count > INT_MAX || (size - header_size) / record_size < count) {
+        fprintf(stderr, "[Server] %s: truncated (%u records declared)\n", path, count);
+        return -1;
+    }
+
+    db->records = (const Pokemon *)(base + header_size);
+    db->count = (int)count;
+    db->sorted = (le32toh(h.flags) & POKEMON_FILE_SORTED) != 0;
+    if (db->sorted && !pokemon_db_ascending(db)) {
+        fprintf(stderr, "[Server] %s: marked sorted but IDs do not ascend; indexing\n", path);
+        db->sorted = 0;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Map the Pokémon file read-only and prepare lookups.
+ *
+ * \param[in]       path        Path to the Pokémon binary file.
+ *
+ * \return          Loaded catalog, or NULL on failure.
+ *
+ * \note            Nothing is copied: pages fault in from the shared page
+ *                  cache on first use, and a sorted file needs no index.
+ */
+PokemonDB *pokemon_db_open(const char *path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("[Server] open()");
+        return NULL;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) < 0) {
+        perror("[Server] fstat()");
+        close(fd);
+        return NULL;
+    }
+
+    PokemonDB *db = calloc(1, sizeof(*db));
+    if (!db) {
+        close(fd);
+        return NULL;
+    }
+
+    /* mmap() rejects empty files; an empty catalog simply has no records */
+    if (st.st_size > 0) {
+        void *map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            perror("[Server] mmap()");
+            close(fd);
+            free(db);
+            return NULL;
+        }
+        db->map = map;
+        db->map_len = (size_t)st.st_size;
+    }
+    close(fd);  /* The mapping stays valid without the descriptor */
+
+    if (pokemon_db_layout(db, path) < 0) {
+        pokemon_db_close(db);
+        return NULL;
+    }
+
+    if (db->sorted) {
+        db->max_id = db->count > 0 ? db->records[db->count - 1].id : 0;
+    } else if (pokemon_db_index(db) < 0) {
+        pokemon_db_close(db);
+        return NULL;
+    }
+
+    /* Filter queries never scan: build their indexes up front */
+    db->index = pokemon_index_build(db->records, db->count);
+    if (!db->index) {
+        pokemon_db_close(db);
+        return NULL;
+    }
+    return db;
+}
+
+/**
+ * \brief           Unmap the file and free the index and catalog header.
+ */
+void pokemon_db_close(PokemonDB *db) {
+    if (!db) return;
+    pokemon_index_free(db->index);
+    free(db->by_id);
+    if (db->map)
+        munmap(db->map, db->map_len);
+    free(db);
+}
+
+/* ========================================================================== */
+/* ================================ Queries ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Return the record for \p id, or NULL if it does not exist.
+ */
+const Pokemon *pokemon_db_get(const PokemonDB *db, int id) {
+    if (!db || id <= 0 || id > db->max_id)
+        return NULL;
+    if (!db->sorted)
+        return db->by_id[id];
+
+    /* Dense catalogs keep ID first+k at index k: try that slot first */
+    size_t guess = (size_t)(id - db->records[0].id);
+    if (id >= db->records[0].id && guess < (size_t)db->count &&
+        db->records[guess].id == id)
+        return &db->records[guess];
+
+    /* Sparse IDs: lower-bound binary search over the mapped records */
+    size_t lo = 0, hi = (size_t)db->count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (db->records[mid].id < id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return (lo < (size_t)db->count && db->records[lo].id == id) ? &db->records[lo] : NULL;
+}
+
+/**
+ * \brief           Validate that every Pokémon ID in \p ids exists.
+ *
+ * \return          1 if all IDs are present, 0 otherwise.
+ */
+int pokemon_db_validate(const PokemonDB *db, const int *ids, int count) {
+    for (int i = 0; i < count; i++) {
+        if (!pokemon_db_get(db, ids[i]))
+            return 0;
+    }
+    return 1;
+}
@@ -0,0 +1,134 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokemon_db.h                                    #
+# Purpose:                                                   #
+#     Declares the Pokémon catalog and its on-disk format.  #
+#     pokemon.bin starts with a versioned header and is     #
+#     mapped read-only, so every thread reads records       #
+#     straight from the shared page cache. Headerless       #
+#     legacy files are still accepted. Secondary indexes    #
+#     for filter queries are built once at open.            #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: open(2), mmap(2), fstat(2)           #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef POKEMON_DB_H
+#define POKEMON_DB_H
+
+#include <stdint.h>     /* uint16_t, uint32_t */
+#include <stddef.h>     /* size_t */
+
+#include "pokemon.h"
+#include "pokemon_index.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Largest Pokémon ID accepted into the dense index. */
+#define POKEMON_DB_MAX_ID   1000000
+
+/*!< First four bytes of a headered pokemon.bin. */
+#define POKEMON_FILE_MAGIC      "PKDB"
+
+/*!< Current header revision. */
+#define POKEMON_FILE_VERSION    1
+
+/*!< Header flag: records are stored in ascending ID order. */
+#define POKEMON_FILE_SORTED     0x1u
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Header at the start of a pokemon.bin file.
+ *
+ * \note            Little-endian, packed. Records start at \ref header_size
+ *                  so later revisions can grow the header without moving
+ *                  old readers off the record array.
+ */
+#pragma pack(push, 1)
+typedef struct {
+    char        magic[4];           /*!< POKEMON_FILE_MAGIC */
+    uint16_t    version;            /*!< POKEMON_FILE_VERSION */
+    uint16_t    header_size;        /*!< Bytes before the first record */
+    uint32_t    record_size;        /*!< sizeof(Pokemon) the file was built for */
+    uint32_t    count;              /*!< Records that follow the header */
+    uint32_t    flags;              /*!< POKEMON_FILE_* flags */
+    uint8_t     reserved[12];       /*!< Zero */
+} PokemonFileHeader;
+#pragma pack(pop)
+
+/**
+ * \brief           Read-only Pokémon catalog shared by all threads.
+ *
+ * \note            \ref records points into a read-only mapping of the file,
+ *                  so lookups hand out pointers without copying. Never
+ *                  modified after pokemon_db_open() returns, so concurrent
+ *                  readers need no locking.
+ */
+typedef struct {
+    const Pokemon   *records;       /*!< All records, in file order */
+    int              count;         /*!< Number of records */
+    const Pokemon  **by_id;         /*!< by_id[id] → record (NULL if sorted) */
+    int              max_id;        /*!< Highest indexed ID */
+    int              sorted;        /*!< Records ascend by ID: no by_id table */
+    void            *map;           /*!< mmap() of the whole file */
+    size_t           map_len;       /*!< Length of \ref map */
+    PokemonIndex    *index;         /*!< Type/generation/stat indexes */
+} PokemonDB;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Map a binary Pokémon database read-only.
+ *
+ * \param[in]       path        Path to the Pokémon binary file.
+ *
+ * \return          Newly allocated catalog, or NULL on failure.
+ *
+ * \note            A headered file is validated against its header; a
+ *                  headerless legacy file is treated as a bare record array.
+ */
+PokemonDB *pokemon_db_open(const char *path);
+
+/**
+ * \brief           Release a catalog returned by pokemon_db_open().
+ */
+void pokemon_db_close(PokemonDB *db);
+
+/**
+ * \brief           Look up a Pokémon by ID.
+ *
+ * \return          Pointer to the record, or NULL if the ID is unknown.
+ *
+ * \note            O(1) for dense sorted files and through \ref by_id,
+ *                  O(log n) binary search for sparse sorted files.
+ */
+const Pokemon *pokemon_db_get(const PokemonDB *db, int id);
+
+/**
+ * \brief           Check that every ID in a team exists in the catalog.
+ *
+ * \return          1 if all IDs are valid, 0 otherwise.
+ */
+int pokemon_db_validate(const PokemonDB *db, const int *ids, int count);
+
+#endif /* POKEMON_DB_H */
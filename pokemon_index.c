@@ -0,0 +1,358 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokemon_index.c                                 #
+# Purpose:                                                   #
+#     Builds and queries the Pokémon secondary indexes. One #
+#     pass over the catalog fills the type, generation and  #
+#     legendary bitmaps; each stat gets a record array      #
+#     sorted by value so a range becomes two binary         #
+#     searches. The numeric fields are also copied into    #
+#     aligned columns for the SIMD kernels.                 #
+#############################################################
+# Citations:                                                #
+# [1] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [2] GCC Manual: __builtin_popcountll                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* fprintf */
+#include <stdlib.h>     /* calloc, malloc, realloc, aligned_alloc, free, qsort */
+#include <string.h>     /* memset, strncpy, strcmp, strnlen */
+#include <strings.h>    /* strcasecmp */
+
+#include "pokemon_index.h"
+#include "pokemon_simd.h"
+
+/*!< Ranges covering more than 1/N of the records are scanned, not probed. */
+#define RANGE_SCAN_FRACTION     8
+
+/* ========================================================================== */
+/* ================================ Helpers ================================= */
+/* ========================================================================== */
+
+/*!< (value, record) pair used while sorting one stat. */
+typedef struct {
+    int32_t     val;
+    uint32_t    rec;
+} stat_pair_t;
+
+/*!< Column names, in pokemon_stat_t order followed by the extra columns. */
+static const char *const column_names[POKEMON_COLUMNS] = {
+    "total", "hp", "attack", "defense", "spatk", "spdef", "speed",
+    "generation", "legendary"
+};
+
+/**
+ * \brief           Order stat pairs by value, then record position.
+ */
+static int cmp_pair(const void *a, const void *b) {
+    const stat_pair_t *x = a, *y = b;
+    if (x->val != y->val) return (x->val < y->val) ? -1 : 1;
+    return (x->rec < y->rec) ? -1 : (x->rec > y->rec);
+}
+
+/**
+ * \brief           Set bit \p i of \p bits.
+ */
+static inline void bit_set(uint64_t *bits, size_t i) {
+    bits[i >> 6] |= (uint64_t)1 << (i & 63);
+}
+
+/**
+ * \brief           Find (or add) the bitmap for type \p name.
+ *
+ * \return          Bitmap, or NULL on allocation failure.
+ */
+static uint64_t *type_bits(PokemonIndex *idx, const char *name) {
+    for (int i = 0; i < idx->ntypes; i++)
+        if (strcmp(idx->types[i].name, name) == 0)
+            return idx->types[i].bits;
+
+    pokemon_type_bits_t *t = realloc(idx->types, (size_t)(idx->ntypes + 1) * sizeof(*t));
+    if (!t) return NULL;
+    idx->types = t;
+
+    t = &idx->types[idx->ntypes];
+    t->bits = calloc(idx->words, sizeof(uint64_t));
+    if (!t->bits) return NULL;
+    strncpy(t->name, name, sizeof(t->name) - 1);
+    t->name[sizeof(t->name) - 1] = '\0';
+    idx->ntypes++;
+    return t->bits;
+}
+
+/**
+ * \brief           Index one type field (ignored when empty).
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int index_type(PokemonIndex *idx, const char *field, size_t field_len, size_t rec) {
+    char name[sizeof(((pokemon_type_bits_t *)0)->name)];
+    size_t n = strnlen(field, field_len);
+    if (n >= sizeof(name)) n = sizeof(name) - 1;
+    if (n == 0) return 0;
+
+    memcpy(name, field, n);
+    name[n] = '\0';
+    uint64_t *bits = type_bits(idx, name);
+    if (!bits) return -1;
+    bit_set(bits, rec);
+    return 0;
+}
+
+/**
+ * \brief           First position in a sorted stat whose value is >= \p v.
+ */
+static size_t stat_lower_bound(const int32_t *vals, size_t n, int v) {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (vals[mid] < v)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/* ========================================================================== */
+/* ================================ Building ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Build type/generation/legendary bitmaps and stat orders.
+ *
+ * \return          New index, or NULL on allocation failure.
+ */
+PokemonIndex *pokemon_index_build(const Pokemon *records, int count) {
+    PokemonIndex *idx = calloc(1, sizeof(*idx));
+    if (!idx) return NULL;
+
+    idx->count = count;
+    idx->words = ((size_t)count + 63) / 64;
+    if (idx->words == 0) idx->words = 1;
+
+    idx->legendary = calloc(idx->words, sizeof(uint64_t));
+    if (!idx->legendary) goto fail;
+
+    /* Bitmaps: one pass over the records */
+    for (int i = 0; i < count; i++) {
+        const Pokemon *p = &records[i];
+
+        if (index_type(idx, p->type1, sizeof(p->type1), (size_t)i) < 0 ||
+            index_type(idx, p->type2, sizeof(p->type2), (size_t)i) < 0)
+            goto fail;
+
+        int g = p->generation;
+        if (g >= 1 && g <= POKEMON_GEN_MAX) {
+            if (!idx->gens[g] && !(idx->gens[g] = calloc(idx->words, sizeof(uint64_t))))
+                goto fail;
+            bit_set(idx->gens[g], (size_t)i);
+        }
+
+        if (p->legendary)
+            bit_set(idx->legendary, (size_t)i);
+    }
+
+    /* Stat orders: sort (value, record) pairs, then split into two arrays */
+    stat_pair_t *pairs = malloc((size_t)(count > 0 ? count : 1) * sizeof(*pairs));
+    if (!pairs) goto fail;
+
+    for (int s = 0; s < STAT_COUNT; s++) {
+        idx->by_stat[s] = malloc((size_t)(count > 0 ? count : 1) * sizeof(uint32_t));
+        idx->stat_vals[s] = malloc((size_t)(count > 0 ? count : 1) * sizeof(int32_t));
+        if (!idx->by_stat[s] || !idx->stat_vals[s]) {
+            free(pairs);
+            goto fail;
+        }
+
+        for (int i = 0; i < count; i++) {
+            pairs[i].val = pokemon_stat_value(&records[i], (pokemon_stat_t)s);
+            pairs[i].rec = (uint32_t)i;
+        }
+        qsort(pairs, (size_t)count, sizeof(*pairs), cmp_pair);
+        for (int i = 0; i < count; i++) {
+            idx->stat_vals[s][i] = pairs[i].val;
+            idx->by_stat[s][i] = pairs[i].rec;
+        }
+    }
+    free(pairs);
+
+    /* Columns: aligned, zero-padded to whole SIMD granules */
+    size_t col_bytes = ((size_t)count * sizeof(int32_t) + SIMD_COLUMN_ALIGN - 1)
+                       / SIMD_COLUMN_ALIGN * SIMD_COLUMN_ALIGN;
+    if (col_bytes == 0) col_bytes = SIMD_COLUMN_ALIGN;
+    for (int c = 0; c < POKEMON_COLUMNS; c++) {
+        idx->cols[c] = aligned_alloc(SIMD_COLUMN_ALIGN, col_bytes);
+        if (!idx->cols[c]) goto fail;
+        memset(idx->cols[c], 0, col_bytes);
+    }
+    for (int i = 0; i < count; i++) {
+        const Pokemon *p = &records[i];
+        for (int st = 0; st < STAT_COUNT; st++)
+            idx->cols[st][i] = pokemon_stat_value(p, (pokemon_stat_t)st);
+        idx->cols[COL_GENERATION][i] = p->generation;
+        idx->cols[COL_LEGENDARY][i] = p->legendary ? 1 : 0;
+    }
+    return idx;
+
+fail:
+    fprintf(stderr, "[Server] Out of memory building Pokémon indexes\n");
+    pokemon_index_free(idx);
+    return NULL;
+}
+
+/**
+ * \brief           Release every bitmap and stat array.
+ */
+void pokemon_index_free(PokemonIndex *idx) {
+    if (!idx) return;
+    for (int i = 0; i < idx->ntypes; i++)
+        free(idx->types[i].bits);
+    free(idx->types);
+    for (int g = 0; g <= POKEMON_GEN_MAX; g++)
+        free(idx->gens[g]);
+    free(idx->legendary);
+    for (int s = 0; s < STAT_COUNT; s++) {
+        free(idx->by_stat[s]);
+        free(idx->stat_vals[s]);
+    }
+    for (int c = 0; c < POKEMON_COLUMNS; c++)
+        free(idx->cols[c]);
+    free(idx);
+}
+
+/* ========================================================================== */
+/* ================================= Queries ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Clear every criterion of \p f.
+ */
+void pokemon_filter_init(PokemonFilter *f) {
+    memset(f, 0, sizeof(*f));
+    f->legendary = -1;
+}
+
+/**
+ * \brief           Look up a stat by its command name.
+ */
+int pokemon_stat_parse(const char *name) {
+    for (int s = 0; s < STAT_COUNT; s++)
+        if (strcasecmp(name, column_names[s]) == 0)
+            return s;
+    return -1;
+}
+
+/**
+ * \brief           Look up a column by its command name.
+ */
+int pokemon_column_parse(const char *name) {
+    for (int c = 0; c < POKEMON_COLUMNS; c++)
+        if (strcasecmp(name, column_names[c]) == 0)
+            return c;
+    return -1;
+}
+
+/**
+ * \brief           Return the command name of column \p col.
+ */
+const char *pokemon_column_name(int col) {
+    return (col >= 0 && col < POKEMON_COLUMNS) ? column_names[col] : "?";
+}
+
+/**
+ * \brief           Return \p p's value for \p stat.
+ */
+int pokemon_stat_value(const Pokemon *p, pokemon_stat_t stat) {
+    switch (stat) {
+    case STAT_TOTAL:   return p->total;
+    case STAT_HP:      return p->hp;
+    case STAT_ATTACK:  return p->attack;
+    case STAT_DEFENSE: return p->defense;
+    case STAT_SP_ATK:  return p->sp_atk;
+    case STAT_SP_DEF:  return p->sp_def;
+    case STAT_SPEED:   return p->speed;
+    default:           return 0;
+    }
+}
+
+/**
+ * \brief           Intersect every criterion of \p f into \p out.
+ *
+ * \return          Matching records (0 also if scratch space ran out).
+ */
+size_t pokemon_index_query(const PokemonIndex *idx, const PokemonFilter *f, uint64_t *out) {
+    size_t words = idx->words;
+    uint64_t *scratch = NULL;
+
+    /* Start from "all records", tail bits cleared */
+    memset(out, 0xff, words * sizeof(uint64_t));
+    if (idx->count % 64)
+        out[words - 1] = ((uint64_t)1 << (idx->count % 64)) - 1;
+    if (idx->count == 0)
+        out[0] = 0;
+
+    if (f->type) {
+        const uint64_t *bits = NULL;
+        for (int i = 0; i < idx->ntypes && !bits; i++)
+            if (strcasecmp(idx->types[i].name, f->type) == 0)
+                bits = idx->types[i].bits;
+        if (!bits) goto none;
+        for (size_t w = 0; w < words; w++) out[w] &= bits[w];
+    }
+
+    if (f->gen) {
+        if (f->gen < 1 || f->gen > POKEMON_GEN_MAX || !idx->gens[f->gen]) goto none;
+        for (size_t w = 0; w < words; w++) out[w] &= idx->gens[f->gen][w];
+    }
+
+    if (f->legendary == 1)
+        for (size_t w = 0; w < words; w++) out[w] &= idx->legendary[w];
+    else if (f->legendary == 0)
+        for (size_t w = 0; w < words; w++) out[w] &= ~idx->legendary[w];
+
+    for (int s = 0; s < STAT_COUNT; s++) {
+        if (!f->has_range[s]) continue;
+        if (f->lo[s] > f->hi[s]) goto none;
+
+        /* Records with lo <= stat <= hi are one contiguous run */
+        size_t n = (size_t)idx->count;
+        size_t a = stat_lower_bound(idx->stat_vals[s], n, f->lo[s]);
+        size_t b = (f->hi[s] == INT32_MAX) ? n
+                 : stat_lower_bound(idx->stat_vals[s], n, f->hi[s] + 1);
+
+        /* Wide range: one vectorised pass over the column is cheaper */
+        if ((b - a) * RANGE_SCAN_FRACTION > n) {
+            simd_filter_range(idx->cols[s], n, f->lo[s], f->hi[s], out);
+            continue;
+        }
+
+        if (!scratch && !(scratch = malloc(words * sizeof(uint64_t)))) goto none;
+        memset(scratch, 0, words * sizeof(uint64_t));
+        for (size_t i = a; i < b; i++)
+            bit_set(scratch, idx->by_stat[s][i]);
+        for (size_t w = 0; w < words; w++) out[w] &= scratch[w];
+    }
+    free(scratch);
+
+    size_t matches = 0;
+    for (size_t w = 0; w < words; w++)
+        matches += (size_t)__builtin_popcountll(out[w]);
+    return matches;
+
+none:
+    free(scratch);
+    memset(out, 0, words * sizeof(uint64_t));
+    return 0;
+}
@@ -0,0 +1,162 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokemon_index.h                                 #
+# Purpose:                                                   #
+#     Declares the immutable secondary indexes built over   #
+#     the Pokémon catalog at load time: one bitmap per type #
+#     and per generation, a legendary bitmap, and arrays of #
+#     records sorted by each base stat. Filter queries are  #
+#     answered by bitmap intersection and binary search. A  #
+#     columnar copy of the numeric fields feeds the SIMD    #
+#     aggregate kernels of pokemon_simd.h.                  #
+#############################################################
+# Citations:                                                #
+# [1] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [2] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef POKEMON_INDEX_H
+#define POKEMON_INDEX_H
+
+#include <stdint.h>     /* uint32_t, uint64_t, int32_t */
+#include <stddef.h>     /* size_t */
+
+#include "pokemon.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Highest generation number given its own bitmap. */
+#define POKEMON_GEN_MAX     64
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Base stats that support range filters. */
+typedef enum {
+    STAT_TOTAL = 0,
+    STAT_HP,
+    STAT_ATTACK,
+    STAT_DEFENSE,
+    STAT_SP_ATK,
+    STAT_SP_DEF,
+    STAT_SPEED,
+    STAT_COUNT
+} pokemon_stat_t;
+
+/*!< Columnar projection: the base stats, then generation and legendary. */
+#define COL_GENERATION      STAT_COUNT
+#define COL_LEGENDARY       (STAT_COUNT + 1)
+#define POKEMON_COLUMNS     (STAT_COUNT + 2)
+
+/*!< Records having one type (as type1 or type2). */
+typedef struct {
+    char        name[20];           /*!< Type name as stored in the catalog */
+    uint64_t   *bits;               /*!< Bit i set → record i has this type */
+} pokemon_type_bits_t;
+
+/**
+ * \brief           Secondary indexes over a catalog's record array.
+ *
+ * \note            Bit i / entry i refers to record i of the catalog, so
+ *                  matches come out in file order (ID order for sorted
+ *                  files). Immutable once built; readers need no locks.
+ */
+typedef struct {
+    int                  count;     /*!< Records covered */
+    size_t               words;     /*!< uint64_t words per bitmap */
+    pokemon_type_bits_t *types;     /*!< One bitmap per distinct type */
+    int                  ntypes;    /*!< Entries in \ref types */
+    uint64_t            *gens[POKEMON_GEN_MAX + 1]; /*!< Per generation, or NULL */
+    uint64_t            *legendary; /*!< Legendary records */
+    uint32_t            *by_stat[STAT_COUNT];   /*!< Record indexes by stat */
+    int32_t             *stat_vals[STAT_COUNT]; /*!< Stat values in that order */
+    int32_t             *cols[POKEMON_COLUMNS]; /*!< cols[c][i] = field c of record i */
+} PokemonIndex;
+
+/**
+ * \brief           Conjunctive filter; unset criteria match everything.
+ */
+typedef struct {
+    const char *type;               /*!< Type name (case-insensitive) or NULL */
+    int         gen;                /*!< Generation, 0 = any */
+    int         legendary;          /*!< 1 = only, 0 = exclude, -1 = any */
+    int         has_range[STAT_COUNT]; /*!< Range set for this stat */
+    int         lo[STAT_COUNT];     /*!< Inclusive lower bound */
+    int         hi[STAT_COUNT];     /*!< Inclusive upper bound */
+} PokemonFilter;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Build every index over \p records.
+ *
+ * \return          New index, or NULL on allocation failure.
+ */
+PokemonIndex *pokemon_index_build(const Pokemon *records, int count);
+
+/**
+ * \brief           Free an index returned by pokemon_index_build().
+ */
+void pokemon_index_free(PokemonIndex *idx);
+
+/**
+ * \brief           Reset \p f to match every record.
+ */
+void pokemon_filter_init(PokemonFilter *f);
+
+/**
+ * \brief           Map a stat name ("total", "hp", "attack", "defense",
+ *                  "spatk", "spdef", "speed") to its enum value.
+ *
+ * \return          Stat, or -1 if \p name is unknown.
+ */
+int pokemon_stat_parse(const char *name);
+
+/**
+ * \brief           Map a column name (a stat name, "generation" or
+ *                  "legendary") to its column number.
+ *
+ * \return          Column, or -1 if \p name is unknown.
+ */
+int pokemon_column_parse(const char *name);
+
+/**
+ * \brief           Command name of column \p col.
+ */
+const char *pokemon_column_name(int col);
+
+/**
+ * \brief           Read one base stat of a record.
+ */
+int pokemon_stat_value(const Pokemon *p, pokemon_stat_t stat);
+
+/**
+ * \brief           Evaluate \p f into a result bitmap.
+ *
+ * \param[out]      out         \ref PokemonIndex.words words; bit i set for
+ *                              every matching record i.
+ *
+ * \return          Number of matching records.
+ *
+ * \note            Each criterion costs one bitmap AND. A narrow stat range
+ *                  is a binary search plus one bit per record inside it; a
+ *                  wide one is a SIMD scan of the stat's column instead.
+ */
+size_t pokemon_index_query(const PokemonIndex *idx, const PokemonFilter *f, uint64_t *out);
+
+#endif /* POKEMON_INDEX_H */
@@ -0,0 +1,283 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokemon_simd.c                                  #
+# Purpose:                                                   #
+#     Implements the column scan kernels. The SSE2 paths    #
+#     handle four int32 lanes per instruction and skip      #
+#     64-row blocks whose selection word is empty; a scalar #
+#     loop handles the tail and non-SSE2 builds.            #
+#############################################################
+# Citations:                                                #
+# [1] Intel Intrinsics Guide (SSE2)                         #
+#     https://www.intel.com/content/www/us/en/docs/intrinsics-guide/ #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <string.h>     /* memcpy */
+
+#ifdef __SSE2__
+#include <emmintrin.h>  /* _mm_* SSE2 intrinsics */
+#endif
+
+#include "pokemon_simd.h"
+
+/* ========================================================================== */
+/* ================================ Helpers ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Test bit \p i of \p bits.
+ */
+static inline int bit_test(const uint64_t *bits, size_t i) {
+    return (int)((bits[i >> 6] >> (i & 63)) & 1);
+}
+
+#ifdef __SSE2__
+/*!< Lane masks for every 4-bit selection nibble (bit j → lane j). */
+static const int32_t lane_masks[16][4] __attribute__((aligned(16))) = {
+    { 0,  0,  0,  0}, {-1,  0,  0,  0}, { 0, -1,  0,  0}, {-1, -1,  0,  0},
+    { 0,  0, -1,  0}, {-1,  0, -1,  0}, { 0, -1, -1,  0}, {-1, -1, -1,  0},
+    { 0,  0,  0, -1}, {-1,  0,  0, -1}, { 0, -1,  0, -1}, {-1, -1,  0, -1},
+    { 0,  0, -1, -1}, {-1,  0, -1, -1}, { 0, -1, -1, -1}, {-1, -1, -1, -1},
+};
+
+/**
+ * \brief           Lane-wise select: \p m ? \p a : \p b.
+ */
+static inline __m128i blend(__m128i m, __m128i a, __m128i b) {
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+}
+
+/**
+ * \brief           Reduce four lanes with min (\p want_max = 0) or max.
+ */
+static inline int32_t reduce_lanes(__m128i v, int want_max) {
+    int32_t l[4];
+    memcpy(l, &v, sizeof(l));
+    int32_t r = l[0];
+    for (int i = 1; i < 4; i++)
+        if (want_max ? l[i] > r : l[i] < r) r = l[i];
+    return r;
+}
+#endif
+
+/* ========================================================================== */
+/* ================================= Filter ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           AND \p bits with (lo <= col[i] <= hi).
+ */
+void simd_filter_range(const int32_t *col, size_t n, int32_t lo, int32_t hi, uint64_t *bits) {
+    size_t i = 0;
+
+#ifdef __SSE2__
+    const __m128i vlo = _mm_set1_epi32(lo);
+    const __m128i vhi = _mm_set1_epi32(hi);
+
+    /* One 64-row selection word per outer iteration */
+    for (; i + 64 <= n; i += 64) {
+        uint64_t *w = &bits[i >> 6];
+        if (!*w) continue;
+
+        uint64_t keep = 0;
+        for (size_t j = 0; j < 64; j += 4) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(col + i + j));
+            __m128i out = _mm_or_si128(_mm_cmpgt_epi32(vlo, v), _mm_cmpgt_epi32(v, vhi));
+            uint64_t in = (uint64_t)(~_mm_movemask_ps(_mm_castsi128_ps(out)) & 0xF);
+            keep |= in << j;
+        }
+        *w &= keep;
+    }
+#endif
+
+    /* Scalar tail (and the whole column without SSE2) */
+    for (; i < n; i++)
+        if (col[i] < lo || col[i] > hi)
+            bits[i >> 6] &= ~((uint64_t)1 << (i & 63));
+}
+
+/* ========================================================================== */
+/* =============================== Aggregates =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Count/sum/min/max over the rows selected by \p bits.
+ *
+ * \note            Sums are widened to 64-bit lanes, so they are exact for
+ *                  any column length.
+ */
+void simd_aggregate(const int32_t *col, size_t n, const uint64_t *bits, simd_agg_t *out) {
+    size_t i = 0;
+
+    out->count = 0;
+    out->sum = 0;
+    out->min = INT32_MAX;
+    out->max = INT32_MIN;
+
+#ifdef __SSE2__
+    __m128i sum_lo = _mm_setzero_si128();       /* Lanes 0,1 as int64 */
+    __m128i sum_hi = _mm_setzero_si128();       /* Lanes 2,3 as int64 */
+    __m128i vmin = _mm_set1_epi32(INT32_MAX);
+    __m128i vmax = _mm_set1_epi32(INT32_MIN);
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = bits[i >> 6];
+        if (!w) continue;
+        out->count += (size_t)__builtin_popcountll(w);
+
+        for (size_t j = 0; j < 64; j += 4, w >>= 4) {
+            unsigned nib = (unsigned)(w & 0xF);
+            if (!nib) continue;
+
+            __m128i m = _mm_load_si128((const __m128i *)lane_masks[nib]);
+            __m128i v = _mm_loadu_si128((const __m128i *)(col + i + j));
+            __m128i sel = _mm_and_si128(m, v);
+
+            /* Sign-extend to 64 bits before accumulating */
+            __m128i sign = _mm_cmpgt_epi32(zero, sel);
+            sum_lo = _mm_add_epi64(sum_lo, _mm_unpacklo_epi32(sel, sign));
+            sum_hi = _mm_add_epi64(sum_hi, _mm_unpackhi_epi32(sel, sign));
+
+            /* SSE2 has no pminsd/pmaxsd: compare and blend instead */
+            __m128i lo_cand = blend(m, v, vmin);
+            __m128i hi_cand = blend(m, v, vmax);
+            vmin = blend(_mm_cmpgt_epi32(vmin, lo_cand), lo_cand, vmin);
+            vmax = blend(_mm_cmpgt_epi32(hi_cand, vmax), hi_cand, vmax);
+        }
+    }
+
+    int64_t parts[4];
+    memcpy(parts, &sum_lo, 2 * sizeof(int64_t));
+    memcpy(parts + 2, &sum_hi, 2 * sizeof(int64_t));
+    out->sum = parts[0] + parts[1] + parts[2] + parts[3];
+    out->min = reduce_lanes(vmin, 0);
+    out->max = reduce_lanes(vmax, 1);
+#endif
+
+    for (; i < n; i++) {
+        if (!bit_test(bits, i)) continue;
+        out->count++;
+        out->sum += col[i];
+        if (col[i] < out->min) out->min = col[i];
+        if (col[i] > out->max) out->max = col[i];
+    }
+}
+
+/* ========================================================================== */
+/* ================================== Top-k ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Does (\p va, \p ra) rank below (\p vb, \p rb)?
+ */
+static inline int ranks_below(int32_t va, uint32_t ra, int32_t vb, uint32_t rb) {
+    return va < vb || (va == vb && ra > rb);
+}
+
+/**
+ * \brief           Restore the min-heap property downward from \p i.
+ */
+static void heap_sift_down(const int32_t *col, uint32_t *heap, size_t len, size_t i) {
+    for (;;) {
+        size_t l = 2 * i + 1, r = l + 1, m = i;
+        if (l < len && ranks_below(col[heap[l]], heap[l], col[heap[m]], heap[m])) m = l;
+        if (r < len && ranks_below(col[heap[r]], heap[r], col[heap[m]], heap[m])) m = r;
+        if (m == i) return;
+        uint32_t t = heap[i]; heap[i] = heap[m]; heap[m] = t;
+        i = m;
+    }
+}
+
+/**
+ * \brief           Offer row \p row to a bounded min-heap of the best rows.
+ */
+static void heap_offer(const int32_t *col, uint32_t *heap, size_t *len, size_t k, uint32_t row) {
+    if (*len < k) {
+        /* Sift up */
+        size_t i = (*len)++;
+        heap[i] = row;
+        while (i > 0) {
+            size_t p = (i - 1) / 2;
+            if (!ranks_below(col[heap[i]], heap[i], col[heap[p]], heap[p])) break;
+            uint32_t t = heap[i]; heap[i] = heap[p]; heap[p] = t;
+            i = p;
+        }
+    } else if (ranks_below(col[heap[0]], heap[0], col[row], row)) {
+        heap[0] = row;
+        heap_sift_down(col, heap, *len, 0);
+    }
+}
+
+/**
+ * \brief           Largest-k selection with a vectorised threshold test.
+ *
+ * \note            Rows are visited in order, so a later row only enters a
+ *                  full heap with a strictly larger value; once the heap is
+ *                  full, four rows at a time are rejected against its minimum.
+ */
+size_t simd_top_k(const int32_t *col, size_t n, const uint64_t *bits,
+                  size_t k, uint32_t *rows) {
+    size_t len = 0;
+    size_t i = 0;
+
+    if (k == 0) return 0;
+
+#ifdef __SSE2__
+    for (; i + 64 <= n; i += 64) {
+        uint64_t w = bits[i >> 6];
+        if (!w) continue;
+
+        for (size_t j = 0; j < 64; j += 4, w >>= 4) {
+            unsigned nib = (unsigned)(w & 0xF);
+            if (!nib) continue;
+
+            if (len == k) {
+                __m128i thr = _mm_set1_epi32(col[rows[0]]);
+                __m128i v = _mm_loadu_si128((const __m128i *)(col + i + j));
+                __m128i m = _mm_load_si128((const __m128i *)lane_masks[nib]);
+                __m128i gt = _mm_and_si128(m, _mm_cmpgt_epi32(v, thr));
+                nib = (unsigned)_mm_movemask_ps(_mm_castsi128_ps(gt));
+                if (!nib) continue;
+            }
+            for (unsigned b = 0; b < 4; b++)
+                if (nib & (1u << b))
+                    heap_offer(col, rows, &len, k, (uint32_t)(i + j + b));
+        }
+    }
+#endif
+
+    for (; i < n; i++)
+        if (bit_test(bits, i))
+            heap_offer(col, rows, &len, k, (uint32_t)i);
+
+    /* Heap-sort in place: repeatedly move the minimum to the end */
+    for (size_t end = len; end > 1; end--) {
+        uint32_t t = rows[0]; rows[0] = rows[end - 1]; rows[end - 1] = t;
+        heap_sift_down(col, rows, end - 1, 0);
+    }
+    return len;
+}
+
+/**
+ * \brief           Report which kernels were compiled in.
+ */
+const char *simd_backend(void) {
+#ifdef __SSE2__
+    return "sse2";
+#else
+    return "scalar";
+#endif
+}
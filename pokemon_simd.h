@@ -0,0 +1,86 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pokemon_simd.h                                  #
+# Purpose:                                                   #
+#     Declares the scan kernels used over the columnar      #
+#     projection of the Pokémon catalog: range filters into #
+#     bitmaps, masked aggregates and top-k selection. Each  #
+#     kernel has an SSE2 path and a scalar fallback chosen  #
+#     at compile time.                                      #
+#############################################################
+# Citations:                                                #
+# [1] Intel Intrinsics Guide (SSE2)                         #
+#     https://www.intel.com/content/www/us/en/docs/intrinsics-guide/ #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef POKEMON_SIMD_H
+#define POKEMON_SIMD_H
+
+#include <stdint.h>     /* int32_t, int64_t, uint32_t, uint64_t */
+#include <stddef.h>     /* size_t */
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Column storage alignment and length granule (elements). */
+#define SIMD_COLUMN_ALIGN   64
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Result of simd_aggregate() over the selected rows. */
+typedef struct {
+    size_t      count;              /*!< Rows selected */
+    int64_t     sum;                /*!< Sum of selected values */
+    int32_t     min;                /*!< Smallest selected value (if count) */
+    int32_t     max;                /*!< Largest selected value (if count) */
+} simd_agg_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Clear bits of rows whose value lies outside [lo, hi].
+ *
+ * \param[in]       col         Column of \p n values.
+ * \param[in,out]   bits        Selection bitmap, ANDed in place.
+ */
+void simd_filter_range(const int32_t *col, size_t n, int32_t lo, int32_t hi, uint64_t *bits);
+
+/**
+ * \brief           Count, sum, min and max of the selected rows.
+ */
+void simd_aggregate(const int32_t *col, size_t n, const uint64_t *bits, simd_agg_t *out);
+
+/**
+ * \brief           Select the \p k largest selected values.
+ *
+ * \param[out]      rows        Receives up to \p k row numbers, largest
+ *                              value first (ties: lower row first).
+ *
+ * \return          Rows stored (less than \p k if fewer are selected).
+ */
+size_t simd_top_k(const int32_t *col, size_t n, const uint64_t *bits,
+                  size_t k, uint32_t *rows);
+
+/**
+ * \brief           Name of the kernel implementation compiled in.
+ */
+const char *simd_backend(void);
+
+#endif /* POKEMON_SIMD_H */
@@ -0,0 +1,227 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pool.c                                          #
+# Purpose:                                                   #
+#     Implements the bounded lock-free MPMC queue and the   #
+#     fixed worker pool built on top of it. Producers never #
+#     block: a full queue is reported back to the caller so #
+#     it can shed load instead of spawning more threads.    #
+#############################################################
+# Citations:                                                #
+# [1] Dmitry Vyukov, "Bounded MPMC queue"                   #
+#     https://www.1024cores.net/                            #
+# [2] Linux Man Pages: sem_init(3), sem_wait(3),            #
+#     pthread_create(3), pthread_detach(3)                  #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard), <stdatomic.h>       #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* perror */
+#include <stdlib.h>     /* calloc, free */
+#include <errno.h>      /* errno, EINTR */
+#include <pthread.h>    /* pthread_create, pthread_detach */
+#include <semaphore.h>  /* sem_* */
+#include <stdatomic.h>  /* atomic_* */
+#include <stdint.h>     /* intptr_t */
+
+#include "pool.h"
+
+/* ========================================================================== */
+/* ============================ Bounded MPMC Queue ========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Allocate a power-of-two ring of at least \p capacity slots.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+int mpmc_init(mpmc_queue_t *q, size_t capacity) {
+    size_t cap = 2;
+    while (cap < capacity) cap <<= 1;
+
+    q->cells = calloc(cap, sizeof(*q->cells));
+    if (!q->cells) return -1;
+    q->mask = cap - 1;
+
+    /* Slot i is free for the producer holding position i */
+    for (size_t i = 0; i < cap; i++)
+        atomic_store_explicit(&q->cells[i].seq, i, memory_order_relaxed);
+    atomic_store_explicit(&q->head, 0, memory_order_relaxed);
+    atomic_store_explicit(&q->tail, 0, memory_order_relaxed);
+    return 0;
+}
+
+/**
+ * \brief           Free the ring allocated by mpmc_init().
+ */
+void mpmc_destroy(mpmc_queue_t *q) {
+    free(q->cells);
+    q->cells = NULL;
+}
+
+/**
+ * \brief           Claim the next free slot and publish \p item into it.
+ *
+ * \return          0 on success, -1 if every slot is occupied.
+ */
+int mpmc_push(mpmc_queue_t *q, void *item) {
+    size_t pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+    mpmc_cell_t *cell;
+
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+        if (dif == 0) {
+            /* Slot is free for this position: try to claim it */
+            if (atomic_compare_exchange_weak_explicit(&q->head, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return -1;  /* Consumer has not freed this slot yet: full */
+        } else {
+            pos = atomic_load_explicit(&q->head, memory_order_relaxed);
+        }
+    }
+
+    cell->item = item;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+    return 0;
+}
+
+/**
+ * \brief           Take the oldest published item, if any.
+ *
+ * \return          0 on success, -1 if the queue is empty.
+ */
+int mpmc_pop(mpmc_queue_t *q, void **item) {
+    size_t pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+    mpmc_cell_t *cell;
+
+    for (;;) {
+        cell = &q->cells[pos & q->mask];
+        size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        intptr_t dif = (intptr_t)seq - (intptr_t)(pos + 1);
+
+        if (dif == 0) {
+            if (atomic_compare_exchange_weak_explicit(&q->tail, &pos, pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (dif < 0) {
+            return -1;  /* Producer has not published here yet: empty */
+        } else {
+            pos = atomic_load_explicit(&q->tail, memory_order_relaxed);
+        }
+    }
+
+    *item = cell->item;
+
+    /* Hand the slot to the producer one lap ahead */
+    atomic_store_explicit(&cell->seq, pos + q->mask + 1, memory_order_release);
+    return 0;
+}
+
+/* ========================================================================== */
+/* =============================== Worker Pool ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Worker loop: sleep on the semaphore, run one item, repeat.
+ */
+static void *pool_worker(void *arg) {
+    worker_pool_t *pool = arg;
+
+    for (;;) {
+        if (sem_wait(&pool->ready) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+
+        void *item;
+        if (mpmc_pop(&pool->queue, &item) == 0) {
+            atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+            pool->task(item);
+            continue;
+        }
+
+        /* Woken without an item: only pool_shutdown() does that */
+        if (atomic_load(&pool->stop))
+            break;
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Build the queue and start the detached worker threads.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int pool_init(worker_pool_t *pool, int nthreads, size_t depth, pool_task_fn task,
+              const pthread_attr_t *attr) {
+    if (nthreads < 1 || depth < 1) return -1;
+
+    if (mpmc_init(&pool->queue, depth) < 0) return -1;
+    if (sem_init(&pool->ready, 0, 0) < 0) {
+        mpmc_destroy(&pool->queue);
+        return -1;
+    }
+    pool->task = task;
+    pool->depth = depth;
+    atomic_init(&pool->queued, 0);
+    atomic_init(&pool->stop, 0);
+    pool->nthreads = 0;
+
+    for (int i = 0; i < nthreads; i++) {
+        pthread_t tid;
+        if (pthread_create(&tid, attr, pool_worker, pool) != 0) {
+            perror("[Server] pthread_create()");
+            break;
+        }
+        pthread_detach(tid);
+        pool->nthreads++;
+    }
+    return pool->nthreads > 0 ? 0 : -1;
+}
+
+/**
+ * \brief           Queue one item and wake a worker.
+ *
+ * \return          0 if queued, -1 if \ref worker_pool_t.depth items are
+ *                  already waiting.
+ *
+ * \note            The ring may be larger than the configured depth, so the
+ *                  limit is checked against \ref worker_pool_t.queued rather
+ *                  than left to a full ring.
+ */
+int pool_submit(worker_pool_t *pool, void *item) {
+    size_t prev = atomic_fetch_add_explicit(&pool->queued, 1, memory_order_relaxed);
+    if (prev >= pool->depth || mpmc_push(&pool->queue, item) < 0) {
+        atomic_fetch_sub_explicit(&pool->queued, 1, memory_order_relaxed);
+        return -1;
+    }
+    sem_post(&pool->ready);
+    return 0;
+}
+
+/**
+ * \brief           Wake every worker so idle ones observe the stop flag.
+ */
+void pool_shutdown(worker_pool_t *pool) {
+    atomic_store(&pool->stop, 1);
+    for (int i = 0; i < pool->nthreads; i++)
+        sem_post(&pool->ready);
+}
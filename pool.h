@@ -0,0 +1,138 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: pool.h                                          #
+# Purpose:                                                   #
+#     Declares a fixed-size worker thread pool fed by a     #
+#     bounded lock-free multi-producer/multi-consumer       #
+#     queue. Used by the threaded server to cap the number  #
+#     of session threads and reject work under overload.    #
+#############################################################
+# Citations:                                                #
+# [1] Dmitry Vyukov, "Bounded MPMC queue"                   #
+#     https://www.1024cores.net/                            #
+# [2] Linux Man Pages: sem_init(3), sem_wait(3),            #
+#     pthread_create(3)                                     #
+#     https://man7.org/linux/man-pages/                     #
+# [3] ISO/IEC 9899:2018 (C11 Standard), <stdatomic.h>       #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>     /* size_t */
+#include <stdatomic.h>  /* atomic_size_t, atomic_int */
+#include <semaphore.h>  /* sem_t */
+#include <pthread.h>    /* pthread_attr_t */
+
+/* ========================================================================== */
+/* ============================ Bounded MPMC Queue ========================== */
+/* ========================================================================== */
+
+/*!< One queue slot; \ref seq tells producers and consumers whose turn it is. */
+typedef struct {
+    atomic_size_t   seq;            /*!< Slot sequence number */
+    void           *item;           /*!< Stored element */
+} mpmc_cell_t;
+
+/**
+ * \brief           Bounded lock-free queue safe for any number of threads.
+ *
+ * \note            Producer and consumer cursors live on separate cache
+ *                  lines so enqueue and dequeue do not false-share.
+ */
+typedef struct {
+    mpmc_cell_t            *cells;  /*!< Ring of capacity slots */
+    size_t                  mask;   /*!< capacity - 1 (capacity is 2^k) */
+    _Alignas(64) atomic_size_t head;   /*!< Next enqueue position */
+    _Alignas(64) atomic_size_t tail;   /*!< Next dequeue position */
+} mpmc_queue_t;
+
+/**
+ * \brief           Initialize a queue holding at least \p capacity items.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+int mpmc_init(mpmc_queue_t *q, size_t capacity);
+
+/**
+ * \brief           Release the queue's slot array.
+ */
+void mpmc_destroy(mpmc_queue_t *q);
+
+/**
+ * \brief           Enqueue an item without blocking.
+ *
+ * \return          0 on success, -1 if the queue is full.
+ */
+int mpmc_push(mpmc_queue_t *q, void *item);
+
+/**
+ * \brief           Dequeue an item without blocking.
+ *
+ * \return          0 on success, -1 if the queue is empty.
+ */
+int mpmc_pop(mpmc_queue_t *q, void **item);
+
+/* ========================================================================== */
+/* =============================== Worker Pool ============================== */
+/* ========================================================================== */
+
+/*!< Task executed by a worker for each dequeued item. */
+typedef void (*pool_task_fn)(void *item);
+
+/*!< Pre-created worker threads draining a shared bounded queue. */
+typedef struct {
+    mpmc_queue_t    queue;          /*!< Pending work items */
+    sem_t           ready;          /*!< Counts queued items (and wakeups) */
+    pool_task_fn    task;           /*!< Work routine for every item */
+    size_t          depth;          /*!< Configured queue limit */
+    atomic_size_t   queued;         /*!< Items submitted but not yet taken */
+    int             nthreads;       /*!< Number of workers started */
+    atomic_int      stop;           /*!< Set by pool_shutdown() */
+} worker_pool_t;
+
+/**
+ * \brief           Create the queue and start \p nthreads detached workers.
+ *
+ * \param[out]      pool        Pool to initialize.
+ * \param[in]       nthreads    Worker thread count (>= 1).
+ * \param[in]       depth       Maximum queued items before submit fails.
+ *                              The ring is rounded up to a power of two,
+ *                              but the limit is enforced exactly.
+ * \param[in]       task        Routine run by a worker for each item.
+ * \param[in]       attr        Worker thread attributes (stack size), or NULL.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int pool_init(worker_pool_t *pool, int nthreads, size_t depth, pool_task_fn task,
+              const pthread_attr_t *attr);
+
+/**
+ * \brief           Hand one item to the pool.
+ *
+ * \return          0 if queued, -1 if the queue is full (caller must shed
+ *                  the work — this is the pool's back-pressure signal).
+ */
+int pool_submit(worker_pool_t *pool, void *item);
+
+/**
+ * \brief           Ask idle workers to exit once the queue drains.
+ *
+ * \note            Workers busy inside a task finish it first; like the
+ *                  detached session threads, they are not joined. The
+ *                  server waits for the sessions themselves (sessions_drain()).
+ */
+void pool_shutdown(worker_pool_t *pool);
+
+#endif /* POOL_H */
@@ -0,0 +1,730 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: reactor.c                                       #
+# Purpose:                                                   #
+#     Implements the epoll server mode. Every reactor       #
+#     thread owns a SO_REUSEPORT listener plus an epoll     #
+#     set of non-blocking client sockets, splits incoming   #
+#     bytes into newline-framed commands, and queues the    #
+#     framed replies until the socket is writable.          #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: epoll(7), epoll_ctl(2),              #
+#     epoll_wait(2), accept4(2), recv(2), send(2)           #
+#     https://man7.org/linux/man-pages/                     #
+# [2] Beej’s Guide to Network Programming, select()/poll()  #
+#     https://beej.us/guide/bgnet/                          #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#define _GNU_SOURCE     /* accept4, SOCK_NONBLOCK */
+
+#include <stdio.h>      /* printf, perror */
+#include <stdlib.h>     /* malloc, realloc, free */
+#include <string.h>     /* memchr, memmove, memcpy */
+#include <unistd.h>     /* close, sysconf */
+#include <errno.h>      /* errno, EAGAIN, EINTR */
+#include <time.h>       /* clock_gettime */
+#include <pthread.h>    /* pthread_create, pthread_join */
+#include <arpa/inet.h>  /* inet_ntop, ntohs */
+#include <sys/epoll.h>  /* epoll_* */
+#include <sys/socket.h> /* accept4, recv, send */
+
+#include "common.h"
+#include "protocol.h"
+#include "reactor.h"
+#include "metrics.h"
+#include "slab.h"
+#include "storage_ring.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Maximum events handled per epoll_wait() call. */
+#define REACTOR_MAX_EVENTS  256
+
+/*!< epoll_wait() timeout so reactors notice the run flag clearing. */
+#define REACTOR_TICK_MS     500
+
+/*!< Pending output above which a connection stops being read. */
+#define REACTOR_OUT_HIGH    (4 * BUFFER_SIZE)
+
+/*!< epoll_wait() timeout while replies are waiting for a WAL commit. */
+#define REACTOR_COMMIT_POLL_MS  1
+
+/*!< Longest a stopping reactor keeps sending replies it already produced. */
+#define REACTOR_DRAIN_MS        2000
+
+/*!< Objects carved per slab chunk: connections, readers, reply buffers. */
+#define REACTOR_SLAB_CONNS      256
+#define REACTOR_SLAB_BUFFERS    16
+
+/* ========================================================================== */
+/* ============================== Data Types ================================ */
+/* ========================================================================== */
+
+/*!< State kept for each multiplexed client connection. */
+typedef struct conn {
+    struct reactor *owner;          /*!< Reactor whose slabs hold this state */
+    int     fd;                     /*!< Non-blocking client socket */
+    int     port;                   /*!< Peer port for logging */
+    char    ip[INET_ADDRSTRLEN];    /*!< Peer address for logging */
+    line_reader_t *in;              /*!< Unframed input, borrowed only while bytes are buffered */
+    char   *out;                    /*!< Framed replies awaiting send() (BUFFER_SIZE ones pooled) */
+    size_t  outlen;                 /*!< Valid bytes in \ref out */
+    size_t  outoff;                 /*!< Bytes of \ref out already sent */
+    size_t  outcap;                 /*!< Allocated size of \ref out */
+    int     closing;                /*!< Close once \ref out drains */
+    int     binary;                 /*!< Negotiated binproto.h framing */
+    stream_fill_fn stream;          /*!< Reply still being produced, or NULL */
+    void   *stream_ctx;             /*!< Producer state (freed when done) */
+    void  (*stream_free)(void *);   /*!< Destructor for \ref stream_ctx (NULL → free()) */
+    char    stream_last;            /*!< Last byte the producer emitted */
+    uint32_t events;                /*!< Event mask currently registered */
+    uint64_t commit_lsn;            /*!< WAL record queued output waits for */
+    int     held;                   /*!< Buffered input waits for \ref commit_lsn */
+    struct conn  *wait_next;        /*!< Next connection awaiting a commit */
+    struct conn **wait_pprev;       /*!< Link pointing here, NULL if not waiting */
+    struct conn  *live_next;        /*!< Next open connection of the reactor */
+    struct conn **live_pprev;       /*!< Link pointing here */
+} conn_t;
+
+/*!< Arguments and state for one reactor thread. */
+typedef struct reactor {
+    int                 index;      /*!< Reactor number for log output */
+    const char         *port;       /*!< Port shared by all listeners */
+    reactor_handler_fn  handler;    /*!< Per-line command handler */
+    bin_handler_fn      bin_handler; /*!< Binary frame handler */
+    reactor_commit_fn   commit;     /*!< Polls deferred commits */
+    conn_t             *waiting;    /*!< Connections holding output for a commit */
+    conn_t             *live;       /*!< Every open connection, drained at shutdown */
+    volatile int       *running;    /*!< Global run flag */
+    int                 started;    /*!< Set once the listener is bound */
+    slab_t              conns;      /*!< conn_t objects */
+    slab_t              readers;    /*!< line_reader_t lent to connections mid-line */
+    slab_t              buffers;    /*!< BUFFER_SIZE output buffers */
+} reactor_t;
+
+/* ========================================================================== */
+/* =========================== Connection Helpers =========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Make room for \p len more bytes of pending output.
+ *
+ * \return          0 on success, -1 if the buffer could not grow.
+ */
+static int conn_reserve(conn_t *c, size_t len) {
+    size_t need = c->outlen + len;
+    if (need <= c->outcap) return 0;
+
+    /* Typical replies fit a pooled buffer; only larger ones reach malloc() */
+    if (c->outcap == 0 && need <= BUFFER_SIZE) {
+        c->out = slab_alloc(&c->owner->buffers);
+        if (!c->out) return -1;
+        c->outcap = BUFFER_SIZE;
+        return 0;
+    }
+
+    size_t cap = c->outcap ? c->outcap * 2 : 2 * BUFFER_SIZE;
+    while (cap < need) cap *= 2;
+    char *p;
+    if (c->outcap == BUFFER_SIZE) {
+        /* Outgrew the pooled buffer: move to the heap and hand it back */
+        if (!(p = malloc(cap))) return -1;
+        memcpy(p, c->out, c->outlen);
+        slab_free(&c->owner->buffers, c->out);
+    } else if (!(p = realloc(c->out, cap))) {
+        return -1;
+    }
+    c->out = p;
+    c->outcap = cap;
+    return 0;
+}
+
+/**
+ * \brief           Give up the output buffer (pooled or heap).
+ */
+static void conn_release_out(conn_t *c) {
+    if (c->outcap == BUFFER_SIZE)
+        slab_free(&c->owner->buffers, c->out);
+    else
+        free(c->out);
+    c->out = NULL;
+    c->outlen = c->outoff = c->outcap = 0;
+}
+
+/**
+ * \brief           Borrow an input reader for \p c if it has none.
+ *
+ * \return          The reader, or NULL if none could be allocated.
+ */
+static line_reader_t *conn_reader(conn_t *c) {
+    if (!c->in && (c->in = slab_alloc(&c->owner->readers)) != NULL)
+        line_reader_init(c->in, c->fd);
+    return c->in;
+}
+
+/**
+ * \brief           Hand the reader back once no partial input is buffered.
+ *
+ * \note            Idle connections then cost only their conn_t.
+ */
+static void conn_release_reader(conn_t *c) {
+    if (c->in && line_reader_pending(c->in) == 0) {
+        slab_free(&c->owner->readers, c->in);
+        c->in = NULL;
+    }
+}
+
+/**
+ * \brief           Append bytes to a connection's pending output.
+ *
+ * \return          0 on success, -1 if the buffer could not grow.
+ */
+static int conn_append(conn_t *c, const char *data, size_t len) {
+    if (conn_reserve(c, len) < 0) return -1;
+    memcpy(c->out + c->outlen, data, len);
+    c->outlen += len;
+    return 0;
+}
+
+/**
+ * \brief           Queue a response body plus its END_MARKER line.
+ */
+static int conn_queue_response(conn_t *c, const char *message) {
+    size_t len = strlen(message);
+    if (conn_append(c, message, len) < 0) return -1;
+    if ((len == 0 || message[len - 1] != '\n') && conn_append(c, "\n", 1) < 0)
+        return -1;
+    return conn_append(c, END_MARKER, strlen(END_MARKER));
+}
+
+/**
+ * \brief           Send as much pending output as the socket accepts.
+ *
+ * \return          1 if output remains, 0 if drained, -1 on socket error.
+ */
+static int conn_flush(conn_t *c) {
+    while (c->outoff < c->outlen) {
+        ssize_t n = send(c->fd, c->out + c->outoff, c->outlen - c->outoff,
+                         MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return 1;
+            return -1;
+        }
+        c->outoff += (size_t)n;
+    }
+
+    /* Release the buffer so idle connections stay small */
+    conn_release_out(c);
+    return 0;
+}
+
+/**
+ * \brief           Put \p c on the reactor's commit wait list.
+ */
+static void conn_wait(reactor_t *r, conn_t *c) {
+    if (c->wait_pprev) return;
+    c->wait_next = r->waiting;
+    if (r->waiting) r->waiting->wait_pprev = &c->wait_next;
+    r->waiting = c;
+    c->wait_pprev = &r->waiting;
+}
+
+/**
+ * \brief           Take \p c off the commit wait list, if it is on it.
+ */
+static void conn_unwait(conn_t *c) {
+    if (!c->wait_pprev) return;
+    *c->wait_pprev = c->wait_next;
+    if (c->wait_next) c->wait_next->wait_pprev = c->wait_pprev;
+    c->wait_next = NULL;
+    c->wait_pprev = NULL;
+}
+
+/**
+ * \brief           May the queued output be sent yet?
+ *
+ * \return          1 if nothing waits for a commit (or it is durable), 0 if
+ *                  it is still pending, -1 if it failed.
+ */
+static int conn_commit_ready(reactor_t *r, conn_t *c) {
+    if (c->commit_lsn == 0) return 1;
+
+    int st = r->commit(c->commit_lsn);
+    if (st == 1)
+        c->commit_lsn = 0;
+    else if (st == 0)
+        conn_wait(r, c);
+    return st;
+}
+
+/**
+ * \brief           Release a finished or abandoned stream producer.
+ */
+static void conn_free_stream(conn_t *c) {
+    if (c->stream_free) c->stream_free(c->stream_ctx);
+    else free(c->stream_ctx);
+    c->stream = NULL;
+    c->stream_ctx = NULL;
+    c->stream_free = NULL;
+}
+
+/**
+ * \brief           Close a connection and release its state.
+ */
+static void conn_close(int epfd, conn_t *c) {
+    printf("[Server] Client disconnected: %s:%d\n", c->ip, c->port);
+    metrics_conn_close();
+    conn_unwait(c);
+    *c->live_pprev = c->live_next;
+    if (c->live_next) c->live_next->live_pprev = c->live_pprev;
+    epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+    conn_release_out(c);
+    if (c->in)
+        slab_free(&c->owner->readers, c->in);
+    conn_free_stream(c);
+    slab_free(&c->owner->conns, c);
+}
+
+/**
+ * \brief           Dispatch every complete binary frame in the input buffer.
+ *
+ * \note            A frame is handled only once header and payload are both
+ *                  buffered; the reader's buffer bounds BIN_MAX_REQUEST.
+ */
+static void conn_process_frames(reactor_t *r, conn_t *c) {
+    BinHeader req;
+    BinReply rep;
+
+    while (!c->closing && c->commit_lsn == 0 && c->in &&
+           line_reader_pending(c->in) >= BIN_HEADER_SIZE) {
+        const uint8_t *raw = (const uint8_t *)c->in->buf + c->in->start;
+        int bad = bin_header_decode(raw, &req) < 0 || req.length > BIN_MAX_REQUEST;
+
+        if (!bad && line_reader_pending(c->in) < BIN_HEADER_SIZE + req.length)
+            break;  /* Wait for the rest of the payload */
+
+        bin_reply_init(&rep, req.opcode);
+        if (bad) {
+            /* Framing is lost: report it and close after the reply */
+            bin_reply_error(&rep, STATUS_INVALID, "Bad frame header.");
+            c->closing = 1;
+        } else if (r->bin_handler(c->ip, c->port, &req, raw + BIN_HEADER_SIZE, &rep)
+                   == SESSION_CLOSE) {
+            c->closing = 1;
+        }
+        if (!bad)
+            line_reader_consume(c->in, BIN_HEADER_SIZE + req.length);
+        if (rep.commit_lsn > c->commit_lsn)
+            c->commit_lsn = rep.commit_lsn;
+
+        size_t n = bin_reply_finish(&rep);
+        if (conn_append(c, (const char *)rep.frame, n) < 0)
+            c->closing = 1;
+        bin_reply_free(&rep);
+    }
+}
+
+/**
+ * \brief           Frame and dispatch every complete line in the input buffer.
+ */
+static void conn_process_input(reactor_t *r, conn_t *c) {
+    char *line;
+    size_t len;
+    Response res;
+
+    /* Partial lines stay buffered in the reader for the next recv();
+     * a streamed reply holds back later lines until it has been framed,
+     * and a pending commit until it is durable, so they see its write */
+    while (!c->closing && !c->binary && !c->stream && c->commit_lsn == 0 &&
+           c->in && line_reader_next(c->in, &line, &len)) {
+        trim_newline(line);
+
+        memset(&res, 0, sizeof(res));
+        int action = r->handler(c->ip, c->port, line, &res);
+        if (action == SESSION_CLOSE)
+            c->closing = 1;
+        else if (action == SESSION_BINARY)
+            c->binary = 1;
+        if (res.commit_lsn > c->commit_lsn)
+            c->commit_lsn = res.commit_lsn;
+        if (res.stream) {
+            c->stream = res.stream;
+            c->stream_ctx = res.stream_ctx;
+            c->stream_free = res.stream_free;
+            c->stream_last = '\n';
+            continue;
+        }
+        if (conn_queue_response(c, res.body ? res.body : res.message) < 0)
+            c->closing = 1;
+        free(res.body);
+    }
+
+    if (c->binary)
+        conn_process_frames(r, c);
+    c->held = c->commit_lsn != 0 && c->in && line_reader_pending(c->in) > 0;
+    conn_release_reader(c);
+}
+
+/**
+ * \brief           Produce streamed reply chunks until output reaches the mark.
+ *
+ * \return          1 if the stream finished, 0 if it is still pending.
+ *
+ * \note            Chunks are generated straight into the output buffer, so
+ *                  a large listing never needs more than REACTOR_OUT_HIGH
+ *                  plus one chunk of memory per connection.
+ */
+static int conn_pump(conn_t *c) {
+    while (c->stream && c->outlen - c->outoff < REACTOR_OUT_HIGH) {
+        if (conn_reserve(c, STREAM_CHUNK_BYTES) < 0) {
+            c->closing = 1;
+            break;
+        }
+
+        size_t n = c->stream(c->stream_ctx, c->out + c->outlen, STREAM_CHUNK_BYTES);
+        if (n > 0) {
+            c->outlen += n;
+            c->stream_last = c->out[c->outlen - 1];
+            continue;
+        }
+
+        /* Producer exhausted: terminate the last line and frame the reply */
+        if ((c->stream_last != '\n' && conn_append(c, "\n", 1) < 0) ||
+            conn_append(c, END_MARKER, strlen(END_MARKER)) < 0)
+            c->closing = 1;
+        conn_free_stream(c);
+        return 1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Update which events a connection waits for.
+ *
+ * \note            While output is pending only EPOLLOUT is requested, which
+ *                  stops a slow reader from making the server queue replies
+ *                  without bound. Output held for a commit asks for neither
+ *                  event; the commit poll in reactor_thread() resumes it.
+ */
+static void conn_rearm(int epfd, conn_t *c) {
+    size_t pending = c->outlen - c->outoff;
+    struct epoll_event ev;
+
+    ev.events = 0;
+    if (pending > 0 && c->commit_lsn == 0)
+        ev.events |= EPOLLOUT;
+    if (!c->closing && !c->stream && c->commit_lsn == 0 && pending < REACTOR_OUT_HIGH)
+        ev.events |= EPOLLIN;
+
+    /* Skip the syscall when the interest set is unchanged */
+    if (ev.events == c->events)
+        return;
+    ev.data.ptr = c;
+    epoll_ctl(epfd, EPOLL_CTL_MOD, c->fd, &ev);
+    c->events = ev.events;
+}
+
+/* ========================================================================== */
+/* ============================== Event Handlers ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Accept every pending connection on a reactor listener.
+ */
+static void reactor_accept(reactor_t *r, int epfd, int lfd) {
+    while (1) {
+        struct sockaddr_in addr;
+        socklen_t len = sizeof(addr);
+        int fd = accept4(lfd, (struct sockaddr *)&addr, &len,
+                         SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                perror("[Server] accept4()");
+            return;
+        }
+
+        conn_t *c = slab_alloc(&r->conns);
+        if (!c) {
+            close(fd);
+            continue;
+        }
+        memset(c, 0, sizeof(*c));
+        c->owner = r;
+        c->fd = fd;
+        socket_set_nodelay(fd, 1);  /* Replies are already coalesced per pass */
+        inet_ntop(AF_INET, &addr.sin_addr, c->ip, sizeof(c->ip));
+        c->port = ntohs(addr.sin_port);
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = c;
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+            close(fd);
+            slab_free(&r->conns, c);
+            continue;
+        }
+        c->events = ev.events;
+        c->live_next = r->live;
+        if (r->live) r->live->live_pprev = &c->live_next;
+        r->live = c;
+        c->live_pprev = &r->live;
+        metrics_conn_open();
+
+        printf("[Server] Client connected: %s:%d (reactor %d)\n",
+               c->ip, c->port, r->index);
+    }
+}
+
+/**
+ * \brief           Service readiness on one client connection.
+ */
+static void reactor_conn_event(reactor_t *r, int epfd, conn_t *c, uint32_t events) {
+    if (events & EPOLLIN) {
+        ssize_t n = conn_reader(c) ? line_reader_fill(c->in) : -1;
+        if (n == 0 || (n < 0 && errno != EAGAIN)) {
+            conn_close(epfd, c);
+            return;
+        }
+        if (n > 0)
+            conn_process_input(r, c);
+        else
+            conn_release_reader(c);     /* Spurious wake-up */
+    } else if (events & (EPOLLHUP | EPOLLERR)) {
+        conn_close(epfd, c);
+        return;
+    }
+
+    /* Alternate producing and sending until the socket pushes back */
+    for (;;) {
+        if (conn_pump(c))
+            conn_process_input(r, c);   /* Lines held back by the stream */
+
+        /* Nothing is sent ahead of an acknowledgement that is not durable */
+        int ready = conn_commit_ready(r, c);
+        if (ready < 0) {
+            conn_close(epfd, c);
+            return;
+        }
+        if (ready == 0)
+            break;
+
+        int pending = conn_flush(c);
+        if (pending < 0 || (pending == 0 && c->closing)) {
+            conn_close(epfd, c);
+            return;
+        }
+        if (c->held) {
+            c->held = 0;
+            conn_process_input(r, c);   /* Lines held back by the commit */
+            continue;
+        }
+        if (pending > 0 || !c->stream)
+            break;
+    }
+    conn_rearm(epfd, c);
+}
+
+/* ========================================================================== */
+/* ============================== Reactor Thread ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Milliseconds on the monotonic clock.
+ */
+static long long reactor_now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * \brief           Dispatch one epoll_wait() batch of connection events.
+ */
+static void reactor_dispatch(reactor_t *r, int epfd, int lfd,
+                             const struct epoll_event *events, int n) {
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.ptr == NULL)
+            reactor_accept(r, epfd, lfd);
+        else
+            reactor_conn_event(r, epfd, events[i].data.ptr, events[i].events);
+    }
+
+    /* Resume connections whose commit may have completed (re-queued if not) */
+    conn_t *c = r->waiting;
+    while (c) {
+        conn_t *next = c->wait_next;
+        conn_unwait(c);
+        reactor_conn_event(r, epfd, c, 0);
+        c = next;
+    }
+}
+
+/**
+ * \brief           Finish every connection of a stopping reactor.
+ *
+ * \note            No further input is read, and unfinished listings are
+ *                  cut short. Replies already produced still wait for their
+ *                  commit and are sent for up to REACTOR_DRAIN_MS; then
+ *                  every connection is closed, so no session outlives the
+ *                  reactor into the shutdown checkpoint.
+ */
+static void reactor_drain(reactor_t *r, int epfd) {
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    for (conn_t *c = r->live, *next; c; c = next) {
+        next = c->live_next;
+        c->closing = 1;
+        conn_free_stream(c);
+        conn_unwait(c);
+        reactor_conn_event(r, epfd, c, 0);     /* Closes c once it has drained */
+    }
+
+    long long deadline = reactor_now_ms() + REACTOR_DRAIN_MS;
+    while (r->live && reactor_now_ms() < deadline) {
+        int n = epoll_wait(epfd, events, REACTOR_MAX_EVENTS, REACTOR_COMMIT_POLL_MS);
+        if (n < 0 && errno != EINTR)
+            break;
+        reactor_dispatch(r, epfd, -1, events, n > 0 ? n : 0);
+    }
+    while (r->live)
+        conn_close(epfd, r->live);
+}
+
+/**
+ * \brief           Event loop executed by each reactor thread.
+ */
+static void *reactor_thread(void *arg) {
+    reactor_t *r = arg;
+
+    int lfd = create_reuseport_socket(r->port);
+    if (lfd < 0 || set_nonblocking(lfd) < 0) {
+        perror("[Server] reactor listener");
+        if (lfd >= 0) close(lfd);
+        return NULL;
+    }
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("[Server] epoll_create1()");
+        close(lfd);
+        return NULL;
+    }
+
+    /* A NULL data pointer marks the listener */
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = NULL;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev);
+
+    /* Batched trainer reads from this thread go through its own io_uring */
+    storage_ring_t *ring = storage_ring_create();
+    storage_ring_bind(ring);
+    r->started = 1;
+
+    struct epoll_event events[REACTOR_MAX_EVENTS];
+
+    while (*r->running) {
+        int timeout = r->waiting ? REACTOR_COMMIT_POLL_MS : REACTOR_TICK_MS;
+        int n = epoll_wait(epfd, events, REACTOR_MAX_EVENTS, timeout);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            perror("[Server] epoll_wait()");
+            break;
+        }
+
+        reactor_dispatch(r, epfd, lfd, events, n);
+    }
+
+    /* Stop accepting, then let open connections finish before returning */
+    epoll_ctl(epfd, EPOLL_CTL_DEL, lfd, NULL);
+    close(lfd);
+    reactor_drain(r, epfd);
+
+    storage_ring_bind(NULL);
+    storage_ring_destroy(ring);
+    close(epfd);
+    return NULL;
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Start the reactor threads and wait for them to finish.
+ *
+ * \param[in]       port        Port number string.
+ * \param[in]       nthreads    Reactor count (<= 0 selects one per core).
+ * \param[in]       handler     Per-line command handler.
+ * \param[in]       bin_handler Binary frame handler.
+ * \param[in]       commit      Deferred-commit poll.
+ * \param[in]       running     Run flag cleared by the SIGINT handler.
+ *
+ * \return          0 on clean shutdown, -1 if no reactor could start.
+ */
+int reactor_run(const char *port, int nthreads, reactor_handler_fn handler,
+                bin_handler_fn bin_handler, reactor_commit_fn commit,
+                volatile int *running) {
+    if (nthreads <= 0) {
+        long cores = sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (cores > 0) ? (int)cores : 1;
+    }
+
+    reactor_t *reactors = calloc((size_t)nthreads, sizeof(*reactors));
+    pthread_t *tids = calloc((size_t)nthreads, sizeof(*tids));
+    if (!reactors || !tids) {
+        free(reactors);
+        free(tids);
+        return -1;
+    }
+
+    int spawned = 0;
+    for (int i = 0; i < nthreads; i++) {
+        reactors[i].index = i;
+        reactors[i].port = port;
+        reactors[i].handler = handler;
+        reactors[i].bin_handler = bin_handler;
+        reactors[i].commit = commit;
+        reactors[i].running = running;
+        slab_init(&reactors[i].conns, sizeof(conn_t), REACTOR_SLAB_CONNS);
+        slab_init(&reactors[i].readers, sizeof(line_reader_t), REACTOR_SLAB_BUFFERS);
+        slab_init(&reactors[i].buffers, BUFFER_SIZE, REACTOR_SLAB_BUFFERS);
+        if (pthread_create(&tids[spawned], NULL, reactor_thread, &reactors[i]) == 0)
+            spawned++;
+    }
+
+    printf("[Server] epoll mode: %d reactor thread(s) on port %s\n", spawned, port);
+
+    for (int i = 0; i < spawned; i++)
+        pthread_join(tids[i], NULL);
+
+    int ok = 0;
+    for (int i = 0; i < nthreads; i++) {
+        ok |= reactors[i].started;
+        slab_destroy(&reactors[i].conns);
+        slab_destroy(&reactors[i].readers);
+        slab_destroy(&reactors[i].buffers);
+    }
+
+    free(reactors);
+    free(tids);
+    return (spawned > 0 && ok) ? 0 : -1;
+}
@@ -0,0 +1,89 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: reactor.h                                       #
+# Purpose:                                                   #
+#     Declares the event-driven (epoll) server front end.   #
+#     A fixed set of reactor threads multiplexes many       #
+#     non-blocking client sockets and hands every complete  #
+#     command line to the shared server command handler.   #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: epoll(7), epoll_wait(2), socket(7)   #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef REACTOR_H
+#define REACTOR_H
+
+#include "common.h"
+#include "protocol.h"
+#include "binproto.h"
+
+/* ========================================================================== */
+/* ============================== Handler Type ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Command handler invoked once per received line.
+ *
+ * \param[in]       ip          Client IP address string.
+ * \param[in]       port        Client port number.
+ * \param[in]       line        Command text with the newline removed.
+ * \param[out]      res         Response to be framed and sent back.
+ *
+ * \return          SessionAction for the connection.
+ */
+typedef int (*reactor_handler_fn)(const char *ip, int port,
+                                  const char *line, Response *res);
+
+/**
+ * \brief           Durability check for a reply's commit_lsn.
+ *
+ * \return          1 once the record is durable, 0 while it is pending, -1 if
+ *                  it never will be (the connection is then closed unanswered).
+ */
+typedef int (*reactor_commit_fn)(uint64_t lsn);
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Run the epoll front end until the run flag clears.
+ *
+ * \param[in]       port        Port number string to listen on.
+ * \param[in]       nthreads    Number of reactor threads (<= 0 → one per core).
+ * \param[in]       handler     Command handler for each parsed line.
+ * \param[in]       bin_handler Handler for frames once a connection has
+ *                              negotiated the binary protocol.
+ * \param[in]       commit      Polls the commit_lsn of deferred replies.
+ * \param[in]       running     Run flag polled by every reactor thread.
+ *
+ * \return          0 on clean shutdown, -1 if no reactor could start.
+ *
+ * \note            Each reactor owns a SO_REUSEPORT listener and an epoll
+ *                  instance, so connections never migrate between threads
+ *                  and no locking is needed on connection state. Output
+ *                  that follows a reply with a commit_lsn is held until the
+ *                  record is durable, while the reactor serves other clients.
+ *                  Once the flag clears, each reactor stops reading, sends
+ *                  the replies it has produced (bounded in time) and closes
+ *                  every connection, so no session runs after the return.
+ */
+int reactor_run(const char *port, int nthreads, reactor_handler_fn handler,
+                bin_handler_fn bin_handler, reactor_commit_fn commit,
+                volatile int *running);
+
+#endif /* REACTOR_H */
@@ -0,0 +1,490 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: replication.c                                   #
+# Purpose:                                                   #
+#     Implements log shipping. Every shard's WAL committer  #
+#     copies each durable batch into one in-memory feed;    #
+#     one sender thread per replica ships a snapshot image  #
+#     and then the feed. The replica's follower thread      #
+#     applies both through trainer_store_apply().           #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: socket(2), accept(2), recv(2),       #
+#     setsockopt(2), pthread_cond_timedwait(3)              #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf, snprintf */
+#include <stdlib.h>     /* malloc, free, qsort, bsearch */
+#include <string.h>     /* memset, memmove, strrchr, strcmp */
+#include <errno.h>      /* errno, EINTR, EBUSY, ETIMEDOUT */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, unlink, sleep, usleep */
+#include <time.h>       /* clock_gettime */
+#include <stdint.h>     /* intptr_t, uint64_t */
+#include <pthread.h>    /* pthread_create, pthread_mutex_*, pthread_cond_* */
+#include <stdatomic.h>  /* atomic_* */
+#include <sys/socket.h> /* accept, recv, setsockopt */
+#include <sys/time.h>   /* struct timeval */
+
+#include "common.h"
+#include "replication.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Line a replica sends to start a session. */
+#define REPL_HELLO              "replicate\n"
+
+/*!< Bytes per read while sending a snapshot image. */
+#define REPL_IMAGE_CHUNK        (64 * 1024)
+
+/*!< Pause before a replica retries its primary, and a busy snapshot. */
+#define REPL_RETRY_S            1
+#define REPL_SNAPSHOT_RETRY_US  100000
+
+/* ========================================================================== */
+/* ================================== State ================================= */
+/* ========================================================================== */
+
+/*!< Server role. */
+enum { ROLE_NONE = 0, ROLE_PRIMARY, ROLE_REPLICA };
+
+/*!< Committed records, in the order the shard committers delivered them. */
+static struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t  more;           /*!< Signalled when \ref head advances */
+    wal_record_t   *ring;           /*!< REPL_BACKLOG slots */
+    uint64_t        head;           /*!< Records ever published */
+    int             replicas;       /*!< Connected senders */
+} feed = { .mutex = PTHREAD_MUTEX_INITIALIZER };
+
+static atomic_int role;
+static TrainerStore *repl_store;
+static char repl_port[32];          /*!< Primary: listener port */
+static char image_prefix[512];      /*!< Primary: snapshot image prefix */
+static atomic_ulong image_seq;      /*!< Primary: unique image names */
+
+static char primary_host[256];      /*!< Replica: primary address */
+static char primary_port[32];
+static repl_changed_fn on_change;
+static atomic_int following;        /*!< Replica: stream is live */
+static atomic_ulong syncs;          /*!< Replica: images loaded */
+static atomic_ullong applied;       /*!< Replica: stream records applied */
+static atomic_ullong applied_lsn;   /*!< Replica: LSN of the newest one */
+
+/* ========================================================================== */
+/* ================================ Helpers ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Absolute CLOCK_MONOTONIC time \p s seconds from now.
+ */
+static struct timespec deadline_after_s(int s) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += s;
+    return ts;
+}
+
+/**
+ * \brief           Bound blocking send()/recv() on \p fd to REPL_TIMEOUT_S.
+ */
+static void set_link_timeouts(int fd) {
+    struct timeval tv = { .tv_sec = REPL_TIMEOUT_S };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+/**
+ * \brief           qsort()/bsearch() order of trainer IDs.
+ */
+static int cmp_int(const void *a, const void *b) {
+    int x = *(const int *)a, y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+/* ========================================================================== */
+/* ================================= Primary ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           WAL tap: append a durable batch to the feed.
+ *
+ * \note            Runs on a shard's committer. Every trainer's records come
+ *                  from one committer in log order, so the feed orders each
+ *                  trainer's changes correctly even when shards interleave.
+ */
+static void feed_publish(const wal_record_t *recs, size_t n, void *ctx) {
+    (void)ctx;
+    pthread_mutex_lock(&feed.mutex);
+    for (size_t i = 0; i < n; i++)
+        feed.ring[(feed.head + i) % REPL_BACKLOG] = recs[i];
+    feed.head += n;
+    pthread_cond_broadcast(&feed.more);
+    pthread_mutex_unlock(&feed.mutex);
+}
+
+/**
+ * \brief           Send a fresh snapshot image of the store over \p fd.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+static int send_image(int fd) {
+    char path[600];
+    snprintf(path, sizeof(path), "%s.repl-%lu.snap", image_prefix,
+             atomic_fetch_add(&image_seq, 1));
+
+    /* A client "snapshot" may be running; the image waits for it */
+    TrainerSnapshotHeader info;
+    while (trainer_store_snapshot(repl_store, path, &info) < 0) {
+        if (errno != EBUSY) return -1;
+        usleep(REPL_SNAPSHOT_RETRY_US);
+    }
+
+    int in = open(path, O_RDONLY);
+    unlink(path);
+    if (in < 0) return -1;
+
+    char *chunk = malloc(REPL_IMAGE_CHUNK);
+    int rc = chunk ? 0 : -1;
+    while (rc == 0) {
+        ssize_t n = safe_read(in, chunk, REPL_IMAGE_CHUNK);
+        if (n < 0 || (n > 0 && send_bytes(fd, chunk, (size_t)n) < 0))
+            rc = -1;
+        if (n <= 0) break;
+    }
+    free(chunk);
+    close(in);
+    return rc;
+}
+
+/**
+ * \brief           One replica session: image, then the feed until it fails.
+ */
+static void *sender_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char hello[32];
+    set_link_timeouts(fd);
+
+    if (recv_line(fd, hello, sizeof(hello)) <= 0 || strcmp(hello, REPL_HELLO) != 0) {
+        close(fd);
+        return NULL;
+    }
+
+    /* Take the feed position first: whatever the image misses comes after it */
+    pthread_mutex_lock(&feed.mutex);
+    uint64_t pos = feed.head;
+    feed.replicas++;
+    pthread_mutex_unlock(&feed.mutex);
+
+    wal_record_t batch[REPL_BATCH];
+    int ok = send_image(fd) == 0;
+    if (ok) printf("[Server] Replica attached (fd %d)\n", fd);
+
+    while (ok) {
+        size_t n = 0;
+        struct timespec until = deadline_after_s(REPL_HEARTBEAT_S);
+
+        pthread_mutex_lock(&feed.mutex);
+        while (pos == feed.head &&
+               pthread_cond_timedwait(&feed.more, &feed.mutex, &until) != ETIMEDOUT)
+            ;
+        if (feed.head - pos > REPL_BACKLOG) {
+            ok = 0;     /* Overwritten: the replica must start over */
+        } else {
+            while (pos < feed.head && n < REPL_BATCH)
+                batch[n++] = feed.ring[pos++ % REPL_BACKLOG];
+        }
+        pthread_mutex_unlock(&feed.mutex);
+
+        if (!ok) {
+            fprintf(stderr, "[Server] Replica (fd %d) fell more than %d records behind; "
+                    "dropping it\n", fd, REPL_BACKLOG);
+            break;
+        }
+
+        /* An idle stream carries heartbeats (LSN 0) so both ends see a dead link */
+        if (n == 0) {
+            memset(&batch[0], 0, sizeof(batch[0]));
+            batch[0].magic = TRAINER_WAL_MAGIC;
+            n = 1;
+        }
+        if (send_bytes(fd, batch, n * sizeof(batch[0])) < 0)
+            ok = 0;
+    }
+
+    pthread_mutex_lock(&feed.mutex);
+    feed.replicas--;
+    pthread_mutex_unlock(&feed.mutex);
+    printf("[Server] Replica detached (fd %d)\n", fd);
+    close(fd);
+    return NULL;
+}
+
+/**
+ * \brief           Accept replicas and give each a sender thread.
+ */
+static void *listener_thread(void *arg) {
+    int lfd = (int)(intptr_t)arg;
+    for (;;) {
+        int fd = accept(lfd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            perror("[Server] accept(replica)");
+            sleep(REPL_RETRY_S);
+            continue;
+        }
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, sender_thread, (void *)(intptr_t)fd) != 0) {
+            close(fd);
+            continue;
+        }
+        pthread_detach(tid);
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Serve replicas of \p store on \p port.
+ */
+int repl_primary_start(const char *port, TrainerStore *store, const char *trainer_path) {
+    feed.ring = malloc(REPL_BACKLOG * sizeof(*feed.ring));
+    if (!feed.ring) return -1;
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&feed.more, &attr);
+    pthread_condattr_destroy(&attr);
+
+    int lfd = create_server_socket(port);
+    if (lfd < 0) return -1;
+
+    repl_store = store;
+    snprintf(repl_port, sizeof(repl_port), "%s", port);
+    snprintf(image_prefix, sizeof(image_prefix), "%s", trainer_path);
+    trainer_store_set_tap(store, feed_publish, NULL);
+
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, listener_thread, (void *)(intptr_t)lfd) != 0) {
+        trainer_store_set_tap(store, NULL, NULL);
+        close(lfd);
+        return -1;
+    }
+    pthread_detach(tid);
+    atomic_store(&role, ROLE_PRIMARY);
+    return 0;
+}
+
+/* ========================================================================== */
+/* ================================= Replica ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Replace the store's contents with the image on \p fd.
+ *
+ * \return          0 on success, -1 on a bad image or a failed apply.
+ *
+ * \note            Every image record is applied as a put, then trainers the
+ *                  image lacks are deleted, so reads keep being served from
+ *                  the old contents while the new ones load.
+ */
+static int replica_load_image(int fd) {
+    TrainerSnapshotHeader hdr;
+    if (safe_read(fd, &hdr, sizeof(hdr)) != (ssize_t)sizeof(hdr) ||
+        hdr.magic != TRAINER_SNAPSHOT_MAGIC || hdr.version != TRAINER_SNAPSHOT_VERSION ||
+        hdr.record_size != sizeof(Trainer))
+        return -1;
+
+    int *ids = malloc(((size_t)hdr.count + 1) * sizeof(*ids));
+    if (!ids) return -1;
+
+    Trainer recs[REPL_BATCH];
+    wal_record_t batch[REPL_BATCH];
+    int rc = 0;
+    for (uint32_t done = 0; done < hdr.count && rc == 0; ) {
+        size_t want = hdr.count - done;
+        if (want > REPL_BATCH) want = REPL_BATCH;
+        if (safe_read(fd, recs, want * sizeof(Trainer)) != (ssize_t)(want * sizeof(Trainer))) {
+            rc = -1;
+            break;
+        }
+        for (size_t i = 0; i < want; i++) {
+            batch[i] = (wal_record_t){ .op = WAL_OP_PUT, .rec = recs[i] };
+            ids[done + i] = recs[i].id;
+        }
+        if (trainer_store_apply(repl_store, batch, want) < 0)
+            rc = -1;
+        done += (uint32_t)want;
+    }
+
+    /* Trainers deleted on the primary since this replica last synced */
+    qsort(ids, hdr.count, sizeof(*ids), cmp_int);
+    Trainer page[TRAINER_PAGE_MAX];
+    for (int after = 0, n; rc == 0 &&
+         (n = trainer_store_page(repl_store, after, page, TRAINER_PAGE_MAX)) > 0; ) {
+        size_t gone = 0;
+        for (int i = 0; i < n; i++)
+            if (!bsearch(&page[i].id, ids, hdr.count, sizeof(*ids), cmp_int))
+                batch[gone++] = (wal_record_t){ .op = WAL_OP_DELETE, .rec = { .id = page[i].id } };
+        if (gone > 0 && trainer_store_apply(repl_store, batch, gone) < 0)
+            rc = -1;
+        after = page[n - 1].id;
+    }
+    free(ids);
+    if (on_change) on_change(0);
+    if (rc < 0) return -1;
+
+    atomic_fetch_add(&syncs, 1);
+    atomic_store(&applied_lsn, hdr.lsn);
+    printf("[Server] Replica loaded %u trainer(s) from primary %s:%s (lsn %llu)\n",
+           hdr.count, primary_host, primary_port, (unsigned long long)hdr.lsn);
+    return 0;
+}
+
+/**
+ * \brief           Apply the committed-record stream until the link fails.
+ */
+static void replica_follow(int fd) {
+    wal_record_t buf[REPL_BATCH];
+    size_t have = 0;
+
+    for (;;) {
+        ssize_t got = recv(fd, (char *)buf + have, sizeof(buf) - have, 0);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return;       /* Closed, failed or silent past the timeout */
+        have += (size_t)got;
+
+        /* Keep whole mutation records; drop heartbeats */
+        size_t whole = have / sizeof(buf[0]), n = 0;
+        for (size_t i = 0; i < whole; i++) {
+            if (buf[i].magic == TRAINER_WAL_MAGIC && buf[i].lsn == 0)
+                continue;
+            if (!trainer_wal_record_valid(&buf[i])) {
+                fprintf(stderr, "[Server] Replica received a corrupt record; resyncing\n");
+                return;
+            }
+            buf[n++] = buf[i];
+        }
+
+        if (n > 0) {
+            if (trainer_store_apply(repl_store, buf, n) < 0) {
+                fprintf(stderr, "[Server] Replica could not apply the stream; resyncing\n");
+                return;
+            }
+            for (size_t i = 0; on_change && i < n; i++)
+                on_change(buf[i].rec.id);
+            atomic_fetch_add(&applied, n);
+            atomic_store(&applied_lsn, buf[n - 1].lsn);
+        }
+
+        size_t rest = have - whole * sizeof(buf[0]);
+        memmove(buf, (char *)buf + whole * sizeof(buf[0]), rest);
+        have = rest;
+    }
+}
+
+/**
+ * \brief           Connect, load an image, follow; repeat whenever the link drops.
+ */
+static void *follower_thread(void *arg) {
+    (void)arg;
+    for (;;) {
+        int fd = connect_to_server(primary_host, primary_port);
+        if (fd >= 0) {
+            set_link_timeouts(fd);
+            if (send_bytes(fd, REPL_HELLO, strlen(REPL_HELLO)) >= 0 &&
+                replica_load_image(fd) == 0) {
+                atomic_store(&following, 1);
+                replica_follow(fd);
+                atomic_store(&following, 0);
+                printf("[Server] Lost primary %s:%s; reconnecting\n", primary_host, primary_port);
+            }
+            close(fd);
+        }
+        sleep(REPL_RETRY_S);
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Follow the primary at \p primary ("host:port") into \p store.
+ */
+int repl_replica_start(const char *primary, TrainerStore *store, repl_changed_fn changed) {
+    const char *colon = strrchr(primary, ':');
+    if (!colon || colon == primary || colon[1] == '\0' ||
+        (size_t)(colon - primary) >= sizeof(primary_host))
+        return -1;
+
+    snprintf(primary_host, sizeof(primary_host), "%.*s", (int)(colon - primary), primary);
+    snprintf(primary_port, sizeof(primary_port), "%s", colon + 1);
+    repl_store = store;
+    on_change = changed;
+
+    atomic_store(&role, ROLE_REPLICA);
+    pthread_t tid;
+    if (pthread_create(&tid, NULL, follower_thread, NULL) != 0) {
+        atomic_store(&role, ROLE_NONE);
+        return -1;
+    }
+    pthread_detach(tid);
+    return 0;
+}
+
+/* ========================================================================== */
+/* ================================= Status ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Does this server follow a primary (and so refuse writes)?
+ */
+int repl_is_replica(void) {
+    return atomic_load(&role) == ROLE_REPLICA;
+}
+
+/**
+ * \brief           Describe this server's replication role and progress.
+ */
+int repl_status(char *buf, size_t cap) {
+    switch (atomic_load(&role)) {
+    case ROLE_PRIMARY: {
+        pthread_mutex_lock(&feed.mutex);
+        uint64_t head = feed.head;
+        int replicas = feed.replicas;
+        pthread_mutex_unlock(&feed.mutex);
+        return snprintf(buf, cap,
+                        "Role: primary (replicas connect to port %s)\n"
+                        "Replicas connected: %d\n"
+                        "Records shipped: %llu\n",
+                        repl_port, replicas, (unsigned long long)head);
+    }
+    case ROLE_REPLICA:
+        return snprintf(buf, cap,
+                        "Role: read-only replica of %s:%s\n"
+                        "State: %s\n"
+                        "Images loaded: %lu\n"
+                        "Records applied: %llu\n"
+                        "Last applied LSN: %llu\n",
+                        primary_host, primary_port,
+                        atomic_load(&following) ? "streaming" : "connecting",
+                        atomic_load(&syncs),
+                        (unsigned long long)atomic_load(&applied),
+                        (unsigned long long)atomic_load(&applied_lsn));
+    default:
+        return snprintf(buf, cap, "Role: standalone (no replication)\n");
+    }
+}
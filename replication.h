@@ -0,0 +1,107 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: replication.h                                   #
+# Purpose:                                                   #
+#     Declares primary/replica replication of the trainer   #
+#     store. A primary ships every durable WAL batch to     #
+#     its replicas over TCP; a replica starts from a        #
+#     snapshot image of the primary, applies the stream in  #
+#     log order and serves reads while refusing writes.     #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: socket(2), accept(2), recv(2),       #
+#     setsockopt(2), pthread_cond_timedwait(3)              #
+#     https://man7.org/linux/man-pages/                     #
+# [2] Gray, J. and Reuter, A. "Transaction Processing:      #
+#     Concepts and Techniques" (log shipping), 1992         #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <stddef.h>     /* size_t */
+
+#include "trainer_store.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Committed records the primary keeps for replicas that fall behind. */
+#define REPL_BACKLOG            16384
+
+/*!< Records per send or apply batch. */
+#define REPL_BATCH              256
+
+/*!< Seconds between heartbeats on an idle stream. */
+#define REPL_HEARTBEAT_S        1
+
+/*!< Seconds without data before either side drops the link. */
+#define REPL_TIMEOUT_S          5
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Replica hook: trainer \p id changed, or 0 if any trainer may have. */
+typedef void (*repl_changed_fn)(int id);
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Serve replicas of \p store on \p port.
+ *
+ * \param[in]       port        Replication listener port ("server -R").
+ * \param[in]       store       Store with its WAL enabled.
+ * \param[in]       trainer_path Prefix for the snapshot images sent to
+ *                              joining replicas.
+ *
+ * \return          0 once listening, -1 on failure.
+ *
+ * \note            A joining replica first receives a snapshot image, then
+ *                  every batch committed after its position was taken. A
+ *                  replica more than REPL_BACKLOG records behind is
+ *                  dropped; it reconnects and starts from a new image.
+ */
+int repl_primary_start(const char *port, TrainerStore *store, const char *trainer_path);
+
+/**
+ * \brief           Follow the primary at \p primary ("host:port") into \p store.
+ *
+ * \param[in]       changed     Called after changes are applied, so cached
+ *                              replies can be dropped (may be NULL).
+ *
+ * \return          0 once the follower thread runs, -1 on a bad address.
+ *
+ * \note            The follower reconnects and resynchronizes with a fresh
+ *                  image whenever the link drops, so a restarted primary
+ *                  or replica converges without manual steps.
+ */
+int repl_replica_start(const char *primary, TrainerStore *store, repl_changed_fn changed);
+
+/**
+ * \brief           Does this server follow a primary (and so refuse writes)?
+ */
+int repl_is_replica(void);
+
+/**
+ * \brief           Describe this server's replication role and progress.
+ *
+ * \return          Characters written (as snprintf()).
+ */
+int repl_status(char *buf, size_t cap);
+
+#endif /* REPLICATION_H */
@@ -1,613 +1,2182 @@
-/*
-#############################################################
-# Author: Arek Gebka                                        #
-# Major: Computer Science                                   #
-# Creation Date: October 30, 2025                           #
-# Last Updated: December 8, 2025                            #
-# Due Date: December 10, 2025                               #
-# Course: CPSC 552 — Advanced Unix Programming              #
-# Professor Name: Dr. Dylan Schwesinger                     #
-# Assignment: Project 6 — Threaded Server with Logging      #
-# Filename: server.c                                        #
-# Purpose:                                                   #
-#     Implements a multithreaded TCP server that manages    #
-#     Pokémon and Trainer records using binary files.       #
-#     Supports concurrent CRUD operations via pthreads,    #
-#     validates all Pokémon IDs, logs every client request  #
-#     with timestamp and addressing metadata, and performs  #
-#     graceful shutdown using SIGINT.                       #
-#############################################################
-# Citations:                                                #
-# [1] Beej’s Guide to Network Programming, Concurrent I/O   #
-#     https://beej.us/guide/bgnet/                          #
-# [2] Linux Man Pages: socket(2), bind(2), listen(2),       #
-#     accept(2), pthread_create(3), pthread_mutex_lock(3), #
-#     signal(2), open(2), read(2), write(2), close(2)       #
-#     https://man7.org/linux/man-pages/                     #
-# [3] POSIX Threads Programming Guide                       #
-#     https://man7.org/linux/man-pages/man7/pthreads.7.html#
-# [4] ISO/IEC 9899:2018 (C11 Standard)                      #
-# [5] Dr. Dylan Schwesinger, CPSC 552 — Project 6 Notes     #
-# [6] MaJerle C Code Style Guide                            #
-#     https://github.com/MaJerle/c-code-style               #
-#############################################################
-*/
-
-#include <stdio.h>      /* printf, fprintf */
-#include <stdlib.h>     /* malloc, free, atoi */
-#include <string.h>     /* strcmp, strncpy, memset, strtok */
-#include <unistd.h>     /* close */
-#include <signal.h>     /* signal, SIGINT, SIGPIPE */
-#include <errno.h>      /* errno, EINTR */
-#include <pthread.h>   /* pthread_* */
-#include <fcntl.h>     /* open flags */
-#include <time.h>      /* time, localtime, strftime */
-#include <arpa/inet.h> /* inet_ntop */
-#include <sys/socket.h>
-#include <sys/types.h>
-
-#include "common.h"
-#include "protocol.h"
-#include "pokemon.h"
-#include "trainer.h"
-
-/* ========================================================================== */
-/* =============================== Global State ============================= */
-/* ========================================================================== */
-
-/*!< Server run flag (cleared by SIGINT handler). */
-static volatile int running = 1;
-
-/*!< Listening socket descriptor (closed to unblock accept()). */
-static int listenfd = -1;
-
-/*!< Mutex protecting trainer database file access. */
-static pthread_mutex_t trainer_mutex = PTHREAD_MUTEX_INITIALIZER;
-
-/*!< Mutex protecting log file access. */
-static pthread_mutex_t log_mutex     = PTHREAD_MUTEX_INITIALIZER;
-
-/*!< Runtime file paths passed via command line. */
-static char pokemon_path[256];
-static char trainer_path[256];
-static char log_path[256];
-
-/* ========================================================================== */
-/* ============================== Signal Handling =========================== */
-/* ========================================================================== */
-
-/**
- * \brief           Handle SIGINT for graceful server shutdown.
- *
- * \param[in]       sig     Signal number (SIGINT).
- *
- * \note            Clears the global run flag and closes the listening socket
- *                  to safely unblock accept().
- */
-static void server_sigint_handler(int sig) {
-    (void)sig;
-    running = 0;
-    
-    /* Closing the listening socket unblocks accept() */
-    if (listenfd >= 0)
-        close(listenfd);   /* Unblocks accept() */
-    printf("\n[Server] SIGINT received. Shutting down...\n");
-}
-
-/* ========================================================================== */
-/* ============================ Utility Helpers ============================= */
-/* ========================================================================== */
-
-/**
- * \brief Print command-line usage instructions.
- */
-static void print_usage(void) {
-    printf("Usage: server -p <port> -m <pokemon_file> "
-           "-t <trainer_file> -l <logfile>\n");
-}
-
-/**
- * \brief Open a binary file with standard permissions and error reporting.
- */
-static int open_binary_file(const char *path, int flags) {
-    int fd = open(path, flags, 0644);
-    if (fd < 0) perror("[Server] open()");
-    return fd;
-}
-
-/* ========================================================================== */
-/* ==================== Pokémon / Trainer Helper Functions ================== */
-/* ========================================================================== */
-
-/**
- * \brief Locate a Pokémon record by ID.
- */
-static int get_pokemon_by_id(int fd, int id, Pokemon *r) {
-    Pokemon p;
-    /* Always seek to file beginning before scanning */
-    lseek(fd, 0, SEEK_SET);
-    while (safe_read(fd, &p, sizeof(Pokemon)) == sizeof(Pokemon)) {
-        if (p.id == id) { *r = p; return 1; }
-    }
-    return 0;
-}
-
-/**
- * \brief Locate a Trainer record by ID.
- */
-static int get_trainer_by_id(int fd, int id, Trainer *r) {
-    Trainer t;
-    lseek(fd, 0, SEEK_SET);
-    while (safe_read(fd, &t, sizeof(Trainer)) == sizeof(Trainer)) {
-        if (t.id == id) { *r = t; return 1; }
-    }
-    return 0;
-}
-
-/**
- * \brief Validate that all Pokémon IDs exist in the Pokémon database.
- */
-static int validate_pokemon_ids(const char *pokemon_file, int *ids, int count) {
-    int fd = open(pokemon_file, O_RDONLY);
-    if (fd < 0) {
-        perror("[Server] Failed to open Pokémon file");
-        return 0;
-    }
-
-    Pokemon p;
-    for (int i = 0; i < count; i++) {
-        if (!get_pokemon_by_id(fd, ids[i], &p)) {
-            close(fd);
-            return 0;
-        }
-    }
-    close(fd);
-    return 1;
-}
-
-/**
- * \brief Add a new trainer after validating Pokémon IDs.
- */
-static int add_trainer_with_validation(const char *pokemon_file, int trainer_fd,
-                                       const char *name, int *ids, int count) {
-    if (count <= 0 || count > MAX_POKEMON) return -1;
-    if (!validate_pokemon_ids(pokemon_file, ids, count)) return -1;
-
-    Trainer t, tmp;
-    int max_id = 0;
-
-    lseek(trainer_fd, 0, SEEK_SET);
-    
-    /* Determine next available trainer ID */
-    while (safe_read(trainer_fd, &tmp, sizeof(Trainer)) == sizeof(Trainer)) {
-        if (tmp.id > max_id) max_id = tmp.id;
-    }
-
-    memset(&t, 0, sizeof(t));
-    t.id = max_id + 1;
-    strncpy(t.name, name, sizeof(t.name) - 1);
-    for (int i = 0; i < count; i++) t.pokemon_ids[i] = ids[i];
-    t.count = count;
-
-    if (safe_write(trainer_fd, &t, sizeof(t)) != sizeof(t)) return -1;
-    return t.id;
-}
-
-/**
- * \brief Update an existing trainer record with validation.
- */
-static int update_trainer_with_validation(const char *pokemon_file, int trainer_fd,
-                                          int id, int *ids, int count) {
-    if (count <= 0 || count > MAX_POKEMON) return 0;
-    if (!validate_pokemon_ids(pokemon_file, ids, count)) return 0;
-
-    Trainer t;
-    off_t pos = 0;
-
-    lseek(trainer_fd, 0, SEEK_SET);
-    while (safe_read(trainer_fd, &t, sizeof(t)) == sizeof(t)) {
-        if (t.id == id) {
-            for (int i = 0; i < count; i++) t.pokemon_ids[i] = ids[i];
-            t.count = count;
-            lseek(trainer_fd, pos, SEEK_SET);
-            if (safe_write(trainer_fd, &t, sizeof(t)) != sizeof(t)) return 0;
-            return 1;
-        }
-        pos += sizeof(t);
-    }
-    return 0;
-}
-
-/**
- * \brief Delete a trainer record by rewriting the database file.
- */
-static int delete_trainer(const char *path, int id) {
-    int src = open(path, O_RDONLY);
-    int tmp = open("trainers.tmp", O_WRONLY|O_CREAT|O_TRUNC, 0644);
-    if (src < 0 || tmp < 0) return 0;
-
-    Trainer t;
-    int found = 0;
-
-    while (safe_read(src, &t, sizeof(t)) == sizeof(t)) {
-        if (t.id != id)
-            safe_write(tmp, &t, sizeof(t));
-        else
-            found = 1;
-    }
-
-    close(src);
-    close(tmp);
-    rename("trainers.tmp", path);
-    return found;
-}
-
-/* ========================================================================== */
-/* ================================ Logging ================================= */
-/* ========================================================================== */
-
-/**
- * \brief Log a client request with timestamp and address.
- *
- * Thread-safe via log_mutex.
- */
-static void log_request(const char *ip, int port, const char *cmd) {
-    pthread_mutex_lock(&log_mutex);
-
-    FILE *fp = fopen(log_path, "a");
-    if (!fp) {
-        pthread_mutex_unlock(&log_mutex);
-        return;
-    }
-
-    time_t now = time(NULL);
-    struct tm *tm_info = localtime(&now);
-    char tbuf[64];
-    strftime(tbuf, sizeof(tbuf), "%Y-%m-%d %H:%M:%S", tm_info);
-
-    fprintf(fp, "[%s] Client %s:%d issued command: %s\n",
-            tbuf, ip, port, cmd);
-
-    fclose(fp);
-    pthread_mutex_unlock(&log_mutex);
-}
-
-/**
- * \brief Return the last N lines from the server log.
- */
-static int read_last_n_lines(char *outbuf, size_t outsz, int n) {
-    pthread_mutex_lock(&log_mutex);
-
-    FILE *fp = fopen(log_path, "r");
-    if (!fp) {
-        pthread_mutex_unlock(&log_mutex);
-        snprintf(outbuf, outsz, "No log file or cannot open log.");
-        return 0;
-    }
-
-    int lines = 0;
-    char buf[1024];
-    
-    /* Count total log lines */
-    while (fgets(buf, sizeof(buf), fp))
-        lines++;
-
-    if (lines == 0) {
-        fclose(fp);
-        pthread_mutex_unlock(&log_mutex);
-        snprintf(outbuf, outsz, "Log file is empty.");
-        return 0;
-    }
-
-    int skip = (lines > n) ? (lines - n) : 0;
-    rewind(fp);
-    while (skip-- > 0 && fgets(buf, sizeof(buf), fp));
-
-    outbuf[0] = '\0';
-    while (fgets(buf, sizeof(buf), fp)) {
-        strncat(outbuf, buf, outsz - strlen(outbuf) - 1);
-    }
-
-    fclose(fp);
-    pthread_mutex_unlock(&log_mutex);
-    return 1;
-}
-
-/* ========================================================================== */
-/* ============================ Client Thread =============================== */
-/* ========================================================================== */
-
-/*!< Struct passed to each client-handling thread. */
-typedef struct {
-    int connfd;                     /*!< Connected client socket */
-    struct sockaddr_in addr;       /*!< Client address info */
-} client_args_t;
-
-/**
- * \brief Thread routine servicing a single connected client.
- */
-static void *client_thread(void *arg) {
-    client_args_t *c = arg;
-    int connfd = c->connfd;
-    struct sockaddr_in client_addr = c->addr;
-    free(c);
-
-    char ip[64];
-    inet_ntop(AF_INET, &client_addr.sin_addr, ip, sizeof(ip));
-    int port = ntohs(client_addr.sin_port);
-
-    printf("[Server] Client connected: %s:%d (thread %lu)\n",
-           ip, port, pthread_self());
-
-    char buffer[BUFFER_SIZE];
-
-    while (running) {
-        
-        /* Read one full line from the client */
-        ssize_t r = recv_line(connfd, buffer, sizeof(buffer));
-        if (r <= 0)
-            break;
-
-        trim_newline(buffer);
-        
-        /* Log command before processing */
-        log_request(ip, port, buffer);
-
-        Request req = {0};
-        Response res = {0};
-        snprintf(req.command, sizeof(req.command), "%s", buffer);
-
-        /* Tokenize command into argument array */
-        char *args[20];
-        int argc = 0;
-        char *tok = strtok(req.command, " ");
-        while (tok && argc < 20) {
-            args[argc++] = tok;
-            tok = strtok(NULL, " ");
-        }
-
-        if (argc == 0) {
-            snprintf(res.message, sizeof(res.message), "Empty command.");
-        }
-
-        /* ========================== EXIT ========================== */
-        else if (strcmp(args[0], "exit") == 0) {
-            snprintf(res.message, sizeof(res.message), "Goodbye from server.");
-            send_all(connfd, res.message);
-            break;
-        }
-
-        /* ========================== GET LOG ======================== */
-        else if (argc == 3 && strcmp(args[0], "get") == 0 &&
-                 strcmp(args[1], "log") == 0) {
-            int n = atoi(args[2]);
-            if (n <= 0) n = 10;
-            char out[4096];
-            if (!read_last_n_lines(out, sizeof(out), n))
-                snprintf(res.message, sizeof(res.message), "Could not read log file.");
-            else
-                snprintf(res.message, sizeof(res.message), "%s", out);
-        }
-
-        /* ========================== GET TRAINER ==================== */
-        else if (argc >= 2 && strcmp(args[0], "get") == 0 &&
-                 strcmp(args[1], "trainer") == 0) {
-            pthread_mutex_lock(&trainer_mutex);
-            int fd = open_binary_file(trainer_path, O_RDONLY);
-            if (fd < 0) {
-                snprintf(res.message, sizeof(res.message), "Cannot open trainer DB.");
-                pthread_mutex_unlock(&trainer_mutex);
-                send_all(connfd, res.message);
-                continue;
-            }
-
-            if (argc == 3) {
-                int id = atoi(args[2]);
-                Trainer t;
-                if (get_trainer_by_id(fd, id, &t)) {
-                    int pfd = open_binary_file(pokemon_path, O_RDONLY);
-                    if (pfd < 0) {
-                        snprintf(res.message, sizeof(res.message), "Cannot open Pokémon DB.");
-                    } else {
-                        char team[512] = "";
-                        for (int i = 0; i < t.count; i++) {
-                            Pokemon p;
-                            if (get_pokemon_by_id(pfd, t.pokemon_ids[i], &p)) {
-                                char entry[128];
-                                snprintf(entry, sizeof(entry),
-                                         "  - [%d] %s (%s/%s)\n",
-                                         p.id, p.name, p.type1,
-                                         (strlen(p.type2)?p.type2:"—"));
-                                strncat(team, entry, sizeof(team)-strlen(team)-1);
-                            }
-                        }
-                        snprintf(res.message, sizeof(res.message),
-                                 "Trainer #%d: %s\nPokémon count: %d\nPokémon Team:\n%s",
-                                 t.id, t.name, t.count, team);
-                        close(pfd);
-                    }
-                } else {
-                    snprintf(res.message, sizeof(res.message), "Trainer %d not found.", id);
-                }
-            } else {
-                Trainer t;
-                char out[1024] = "All Trainers:\n";
-                while (safe_read(fd, &t, sizeof(t)) == sizeof(t)) {
-                    char line[128];
-                    snprintf(line, sizeof(line),
-                             "  #%d %s (%d Pokémon)\n",
-                             t.id, t.name, t.count);
-                    strncat(out, line, sizeof(out)-strlen(out)-1);
-                }
-                snprintf(res.message, sizeof(res.message), "%s", out);
-            }
-
-            close(fd);
-            pthread_mutex_unlock(&trainer_mutex);
-        }
-
-        /* ========================== POST TRAINER =================== */
-        else if (argc >= 4 && strcmp(args[0], "post") == 0 &&
-                 strcmp(args[1], "trainer") == 0) {
-            int ids[MAX_POKEMON];
-            int count = argc - 3;
-            if (count > MAX_POKEMON) {
-                snprintf(res.message, sizeof(res.message),
-                         "Invalid command: Trainer cannot have more than %d Pokémon.", MAX_POKEMON);
-            } else {
-                for (int i = 0; i < count; i++) ids[i] = atoi(args[i+3]);
-                pthread_mutex_lock(&trainer_mutex);
-                int fd = open_binary_file(trainer_path, O_RDWR);
-                int new_id = add_trainer_with_validation(pokemon_path, fd, args[2], ids, count);
-                close(fd);
-                pthread_mutex_unlock(&trainer_mutex);
-
-                if (new_id < 0)
-                    snprintf(res.message, sizeof(res.message),
-                             "Invalid command: Failed validation (check Pokémon IDs).");
-                else
-                    snprintf(res.message, sizeof(res.message),
-                             "Trainer added successfully. ID=%d", new_id);
-            }
-        }
-
-        /* ========================== PUT TRAINER ==================== */
-        else if (argc >= 4 && strcmp(args[0], "put") == 0 &&
-                 strcmp(args[1], "trainer") == 0) {
-            int id = atoi(args[2]);
-            int ids[MAX_POKEMON];
-            int count = argc - 3;
-            if (count > MAX_POKEMON)
-                snprintf(res.message, sizeof(res.message),
-                         "Invalid command: Max Pokémon = %d.", MAX_POKEMON);
-            else {
-                for (int i = 0; i < count; i++) ids[i] = atoi(args[i+3]);
-                pthread_mutex_lock(&trainer_mutex);
-                int fd = open_binary_file(trainer_path, O_RDWR);
-                int ok = update_trainer_with_validation(pokemon_path, fd, id, ids, count);
-                close(fd);
-                pthread_mutex_unlock(&trainer_mutex);
-
-                if (!ok)
-                    snprintf(res.message, sizeof(res.message), "Trainer %d not updated.", id);
-                else
-                    snprintf(res.message, sizeof(res.message), "Trainer %d updated.", id);
-            }
-        }
-
-        /* ========================== DELETE TRAINER ================= */
-        else if (argc == 3 && strcmp(args[0], "delete") == 0 &&
-                 strcmp(args[1], "trainer") == 0) {
-            int id = atoi(args[2]);
-            pthread_mutex_lock(&trainer_mutex);
-            int ok = delete_trainer(trainer_path, id);
-            pthread_mutex_unlock(&trainer_mutex);
-
-            if (!ok)
-                snprintf(res.message, sizeof(res.message), "Trainer %d not found.", id);
-            else
-                snprintf(res.message, sizeof(res.message), "Trainer %d deleted.", id);
-        }
-
-        /* ========================== INVALID COMMAND ================= */
-        else {
-            snprintf(res.message, sizeof(res.message), "Invalid command.");
-        }
-
-        /* Send response back to the client */
-        send_all(connfd, res.message);
-    }
-
-    printf("[Server] Client disconnected: %s:%d\n", ip, port);
-    close(connfd);
-    return NULL;
-}
-
-/* ========================================================================== */
-/* ================================= main ================================== */
-/* ========================================================================== */
-
-int main(int argc, char *argv[]) {
-    signal(SIGPIPE, SIG_IGN);               /* Prevent abrupt termination when client disconnects */
-    signal(SIGINT, server_sigint_handler);  /* Install graceful shutdown handler */
-
-    char port[32] = {0};
-    char logname[128] = {0};
-    int got_p=0, got_m=0, got_t=0, got_l=0;
-
-    /* Parse command-line arguments (order-independent) */
-    for (int i=1; i<argc; i++) {
-        if (strcmp(argv[i], "-p") == 0 && i+1 < argc) {
-            strncpy(port, argv[++i], 31);
-            got_p=1;
-        } else if (strcmp(argv[i], "-m") == 0 && i+1 < argc) {
-            strncpy(pokemon_path, argv[++i], 255);
-            got_m=1;
-        } else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
-            strncpy(trainer_path, argv[++i], 255);
-            got_t=1;
-        } else if (strcmp(argv[i], "-l") == 0 && i+1 < argc) {
-            strncpy(logname, argv[++i], 127);
-            got_l=1;
-        }
-    }
-
-    if (!got_p || !got_m || !got_t || !got_l) {
-        print_usage();
-        return 1;
-    }
-
-    /* Normalize trainer file name */
-    if (strcmp(trainer_path, "trainer.bin") == 0)
-        strcpy(trainer_path, "trainers.bin");
-
-    /* Resolve log file output path */
-    if (strchr(logname, '/'))
-        snprintf(log_path, sizeof(log_path), "%s", logname);
-    else
-        snprintf(log_path, sizeof(log_path), "data/%s", logname);
-
-    /* Validate Pokémon database file */
-    int fd = open_binary_file(pokemon_path, O_RDONLY);
-    if (fd < 0) return 1;
-    close(fd);
-
-    /* Ensure trainer database exists */
-    fd = open_binary_file(trainer_path, O_RDWR | O_CREAT);
-    if (fd < 0) return 1;
-    close(fd);
-
-    /* Create and bind the listening socket */
-    listenfd = create_server_socket(port);
-    if (listenfd < 0) return 1;
-
-    printf("[Server] Listening on port %s ...\n", port);
-
-    /* ====================== Accept Loop ====================== */
-    while (running) {
-        struct sockaddr_in client_addr;
-        socklen_t len = sizeof(client_addr);
-        int connfd = accept(listenfd, (struct sockaddr*)&client_addr, &len);
-
-        if (connfd < 0) {
-            if (!running) break;
-            if (errno == EINTR) continue;
-            perror("accept");
-            continue;
-        }
-
-        /* Allocate argument block for thread */
-        client_args_t *args = malloc(sizeof(client_args_t));
-        args->connfd = connfd;
-        args->addr = client_addr;
-
-        pthread_t tid;
-        pthread_create(&tid, NULL, client_thread, args);
-        
-        /* Detached thread cleans itself up */
-        pthread_detach(tid);
-    }
-
-    printf("[Server] Shutdown complete.\n");
-    return 0;
-}
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: October 30, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server with Logging      #
+# Filename: server.c                                        #
+# Purpose:                                                   #
+#     Implements a multithreaded TCP server that manages    #
+#     Pokémon and Trainer records using binary files.       #
+#     Supports concurrent CRUD operations via pthreads,    #
+#     validates all Pokémon IDs, logs every client request  #
+#     with timestamp and addressing metadata, and performs  #
+#     graceful shutdown using SIGINT.                       #
+#############################################################
+# Citations:                                                #
+# [1] Beej’s Guide to Network Programming, Concurrent I/O   #
+#     https://beej.us/guide/bgnet/                          #
+# [2] Linux Man Pages: socket(2), bind(2), listen(2),       #
+#     accept(2), pthread_create(3), pthread_mutex_lock(3), #
+#     signal(2), open(2), read(2), write(2), close(2)       #
+#     https://man7.org/linux/man-pages/                     #
+# [3] POSIX Threads Programming Guide                       #
+#     https://man7.org/linux/man-pages/man7/pthreads.7.html#
+# [4] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [5] Dr. Dylan Schwesinger, CPSC 552 — Project 6 Notes     #
+# [6] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* printf, fprintf */
+#include <stdlib.h>     /* malloc, free, atoi, strtol */
+#include <string.h>     /* strcmp, strncpy, memset, strtok_r */
+#include <ctype.h>      /* isspace */
+#include <unistd.h>     /* close */
+#include <signal.h>     /* signal, SIGINT, SIGPIPE */
+#include <errno.h>      /* errno, EINTR, EBUSY, ETIMEDOUT */
+#include <stdint.h>     /* INT32_MIN, INT32_MAX */
+#include <stdarg.h>     /* va_list, va_start, va_end */
+#include <pthread.h>   /* pthread_* */
+#include <limits.h>    /* PTHREAD_STACK_MIN */
+#include <fcntl.h>     /* open flags */
+#include <time.h>      /* time, localtime, strftime, clock_gettime */
+#include <endian.h>    /* htole32 */
+#include <arpa/inet.h> /* inet_ntop */
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/uio.h>    /* struct iovec */
+
+#include "common.h"
+#include "protocol.h"
+#include "pokemon.h"
+#include "trainer.h"
+#include "reactor.h"
+#include "pool.h"
+#include "pokemon_db.h"
+#include "pokedex.h"
+#include "pokemon_simd.h"
+#include "trainer_store.h"
+#include "trainer_cache.h"
+#include "logger.h"
+#include "binproto.h"
+#include "textproto.h"
+#include "metrics.h"
+#include "slab.h"
+#include "storage_ring.h"
+#include "replication.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Reply bytes a threaded session coalesces before one send(). */
+#define SESSION_BATCH_BYTES     (2 * BUFFER_SIZE)
+
+/*!< Default stack of a session thread (-k); see docs/design.md. */
+#define SESSION_STACK_KB_DEFAULT    128
+
+/*!< Smallest -k accepted: the deepest request path plus libc headroom. */
+#define SESSION_STACK_KB_MIN        64
+
+/*!< Time shutdown gives threaded sessions to send their last replies. */
+#define SESSION_DRAIN_MS            2000
+
+/* The batch buffer doubles as send_stream() scratch and a binary payload */
+#if SESSION_BATCH_BYTES < STREAM_CHUNKS * STREAM_CHUNK_BYTES || \
+    SESSION_BATCH_BYTES < BIN_MAX_REQUEST
+#error "SESSION_BATCH_BYTES must hold the stream chunks and a binary payload"
+#endif
+
+/*!< Objects carved per slab chunk for session state and reply batches. */
+#define SESSION_SLAB_CHUNK      16
+
+/*!< Upper bound of one rendered "get trainer <id>" reply. */
+#define TRAINER_RENDER_MAX      1024
+
+/*!< Largest k accepted by "stats top". */
+#define STATS_TOP_MAX           50
+
+/*!< Longest type, stat or column name a command may give, plus the NUL. */
+#define POKEMON_WORD_MAX        32
+
+/* ========================================================================== */
+/* =============================== Global State ============================= */
+/* ========================================================================== */
+
+/*!< Server run flag (cleared by SIGINT handler). */
+static volatile int running = 1;
+
+/*!< Listening socket descriptor (closed to unblock accept()). */
+static int listenfd = -1;
+
+/*!< Trainer shards opened at startup (each internally rwlock/stripe locked). */
+static TrainerStore *trainers = NULL;
+
+/*!< Rendered "get trainer <id>" replies (NULL when -C 0). */
+static trainer_cache_t *trainer_replies = NULL;
+
+/*!< Asynchronous request logger (owns the log file while running). */
+static logger_t *logger = NULL;
+
+/*!< Pokémon catalog of the request being dispatched on this thread.
+ *   Set by pokedex_enter() for the duration of one dispatch; replies
+ *   produced later pin their version instead (see pokedex.h). */
+static __thread const PokemonDB *pokedex = NULL;
+
+/*!< Send large replies with MSG_ZEROCOPY (-z, threaded front end). */
+static int zerocopy_replies = 0;
+
+/*!< Per-session input readers (threaded front end). */
+static slab_t session_slab;
+
+/*!< Per-session Response, reused for every command of the session. */
+static slab_t response_slab;
+
+/*!< Reply batch buffers, borrowed only while a batch is being built. */
+static slab_t batch_slab;
+
+/*!< Runtime file paths passed via command line. */
+static char pokemon_path[256];
+static char trainer_path[256];
+static char log_path[256];
+
+/* ========================================================================== */
+/* ============================== Signal Handling =========================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Handle SIGINT for graceful server shutdown.
+ *
+ * \param[in]       sig     Signal number (SIGINT).
+ *
+ * \note            Clears the global run flag and closes the listening socket
+ *                  to safely unblock accept().
+ */
+static void server_sigint_handler(int sig) {
+    (void)sig;
+    running = 0;
+    
+    /* Closing the listening socket unblocks accept() */
+    if (listenfd >= 0)
+        close(listenfd);   /* Unblocks accept() */
+    printf("\n[Server] SIGINT received. Shutting down...\n");
+}
+
+/**
+ * \brief           Handle SIGHUP by reopening the log file.
+ *
+ * \param[in]       sig     Signal number (SIGHUP).
+ *
+ * \note            For log rotation: after the old file is renamed, new
+ *                  lines go to a fresh file at the same path. The logger's
+ *                  writer thread does the reopen; the handler only flags it.
+ */
+static void server_sighup_handler(int sig) {
+    (void)sig;
+    if (logger)
+        logger_reopen(logger);
+}
+
+/* ========================================================================== */
+/* ============================ Utility Helpers ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief Print command-line usage instructions.
+ */
+static void print_usage(void) {
+    printf("Usage: server -p <port> -m <pokemon_file> "
+           "-t <trainer_file> -l <logfile> "
+           "[-e threads|epoll] [-r <reactors>] "
+           "[-w <workers> [-q <queue_depth>]] [-c <dead_ratio>] "
+           "[-f <log_flush_ms>] [-y none|interval|always] [-g <commit_ms>] "
+           "[-s <snapshot>] [-M <metrics_port>] [-C <cached_replies>] "
+           "[-k <stack_kb (min 64)>] [-u] [-z] [-S <shards>] "
+           "[-R <replication_port> | -P <primary_host:port>]\n");
+}
+
+/* ========================================================================== */
+/* ==================== Pokémon / Trainer Helper Functions ================== */
+/* ========================================================================== */
+
+/**
+ * \brief Validate that all Pokémon IDs exist in the in-memory catalog.
+ */
+static int validate_pokemon_ids(const int *ids, int count) {
+    return pokemon_db_validate(pokedex, ids, count);
+}
+
+/**
+ * \brief Drop cached trainer replies rendered from a retired catalog.
+ *
+ * \note  Runs after the grace period, so every later render already uses
+ *        the new catalog and the clear cannot be undone by a stale put.
+ */
+static void retire_rendered_replies(void) {
+    if (trainer_replies) trainer_cache_clear(trainer_replies);
+}
+
+/**
+ * \brief Drop cached replies for trainers a replication batch changed.
+ *
+ * \note  \p id 0 means the replica reloaded its whole store.
+ */
+static void replicated_change(int id) {
+    if (!trainer_replies) return;
+    if (id == 0)
+        trainer_cache_clear(trainer_replies);
+    else
+        trainer_cache_invalidate(trainer_replies, id);
+}
+
+/**
+ * \brief Add a new trainer after validating Pokémon IDs.
+ */
+static int add_trainer_with_validation(const char *name, int *ids, int count) {
+    if (count <= 0 || count > MAX_POKEMON) return -1;
+    if (!validate_pokemon_ids(ids, count)) return -1;
+
+    Trainer t;
+    memset(&t, 0, sizeof(t));
+    strncpy(t.name, name, sizeof(t.name) - 1);
+    for (int i = 0; i < count; i++) t.pokemon_ids[i] = ids[i];
+    t.count = count;
+
+    /* The store assigns the next ID from its cached counter */
+    int id = trainer_store_add(trainers, &t);
+    if (id >= 0 && trainer_replies)
+        trainer_cache_invalidate(trainer_replies, id);
+    return id;
+}
+
+/**
+ * \brief Update an existing trainer record with validation.
+ */
+static int update_trainer_with_validation(int id, int *ids, int count) {
+    if (count <= 0 || count > MAX_POKEMON) return 0;
+    if (!validate_pokemon_ids(ids, count)) return 0;
+
+    int ok = trainer_store_set_team(trainers, id, ids, count);
+    if (trainer_replies)
+        trainer_cache_invalidate(trainer_replies, id);
+    return ok;
+}
+
+/**
+ * \brief Delete a trainer and drop its cached reply.
+ */
+static int delete_trainer(int id) {
+    int ok = trainer_store_delete(trainers, id);
+    if (trainer_replies)
+        trainer_cache_invalidate(trainer_replies, id);
+    return ok;
+}
+
+/**
+ * \brief Render the "get trainer <id>" reply for \p t into \p buf.
+ *
+ * \return Length the reply needs (as snprintf()); >= \p cap means truncated.
+ */
+static int render_trainer(const Trainer *t, char *buf, size_t cap) {
+    char team[512] = "";
+    for (int i = 0; i < t->count; i++) {
+        const Pokemon *p = pokemon_db_get(pokedex, t->pokemon_ids[i]);
+        if (p) {
+            char entry[128];
+            snprintf(entry, sizeof(entry),
+                     "  - [%d] %s (%s/%s)\n",
+                     p->id, p->name, p->type1,
+                     (strlen(p->type2)?p->type2:"—"));
+            strncat(team, entry, sizeof(team)-strlen(team)-1);
+        }
+    }
+    return snprintf(buf, cap,
+                    "Trainer #%d: %s\nPokémon count: %d\nPokémon Team:\n%s",
+                    t->id, t->name, t->count, team);
+}
+
+/**
+ * \brief Parse whitespace-separated trainer IDs (strictly positive integers).
+ *
+ * \return Number parsed, or -1 on a malformed ID or more than \p max.
+ */
+static int parse_id_list(const char *text, int *ids, int max) {
+    int n = 0;
+    for (;;) {
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0') return n;
+
+        char *end;
+        errno = 0;
+        long v = strtol(text, &end, 10);
+        if (end == text || (*end != '\0' && !isspace((unsigned char)*end)) || errno == ERANGE ||
+            v <= 0 || v > INT32_MAX || n == max)
+            return -1;
+        ids[n++] = (int)v;
+        text = end;
+    }
+}
+
+/**
+ * \brief Resolve a client-chosen snapshot name next to the trainer file.
+ *
+ * \return 0 on success, -1 if \p name could escape that directory.
+ *
+ * \note  No name means \<trainer_file\>.snap. Names are plain file names
+ *        only, so the command cannot overwrite files elsewhere.
+ */
+static int snapshot_path(const char *name, char *out, size_t cap) {
+    if (!name) {
+        snprintf(out, cap, "%s.snap", trainer_path);
+        return 0;
+    }
+    if (name[0] == '\0' || name[0] == '.' || strchr(name, '/'))
+        return -1;
+
+    const char *slash = strrchr(trainer_path, '/');
+    int dir = slash ? (int)(slash - trainer_path + 1) : 0;
+    snprintf(out, cap, "%.*s%s", dir, trainer_path, name);
+    return 0;
+}
+
+/*!< Cursor state for a streamed trainer listing (Response.stream_ctx). */
+typedef struct {
+    int after;                      /*!< Last trainer ID already emitted */
+    int remaining;                  /*!< Rows still allowed (-1 = unlimited) */
+    int limit;                      /*!< Requested page size (0 = none) */
+    int started;                    /*!< Header line written */
+    int finished;                   /*!< Footer written; next call ends it */
+} trainer_list_t;
+
+/*!< Upper bound on one formatted listing line. */
+#define TRAINER_LINE_MAX    128
+
+/*!< Most rows one listing chunk can hold, so one fetch's worth. */
+#define TRAINER_LIST_ROWS   (STREAM_CHUNK_BYTES / TRAINER_LINE_MAX)
+
+/**
+ * \brief Produce the next chunk of a trainer listing (stream_fill_fn).
+ *
+ * \note  Rows are fetched a page at a time in ID order and the cursor is
+ *        carried in \p ctx, so no lock is held between chunks and memory
+ *        stays at one chunk regardless of table size.
+ */
+static size_t trainer_list_fill(void *ctx, char *buf, size_t cap) {
+    trainer_list_t *ls = ctx;
+    Trainer page[TRAINER_LIST_ROWS];
+    size_t len = 0;
+
+    if (ls->finished)
+        return 0;
+
+    if (!ls->started) {
+        if (ls->after > 0)
+            len += (size_t)snprintf(buf, cap, "Trainers after #%d:\n", ls->after);
+        else
+            len += (size_t)snprintf(buf, cap, "All Trainers:\n");
+        ls->started = 1;
+    }
+
+    while (ls->remaining != 0 && cap - len >= TRAINER_LINE_MAX) {
+        int want = (int)((cap - len) / TRAINER_LINE_MAX);
+        if (want > TRAINER_LIST_ROWS) want = TRAINER_LIST_ROWS;
+        if (ls->remaining > 0 && want > ls->remaining) want = ls->remaining;
+
+        int n = trainer_store_page(trainers, ls->after, page, want);
+        if (n <= 0) {
+            ls->remaining = 0;      /* End of table (or read error) */
+            ls->limit = 0;
+            break;
+        }
+        for (int i = 0; i < n; i++)
+            len += (size_t)snprintf(buf + len, cap - len,
+                                    "  #%d %s (%d Pokémon)\n",
+                                    page[i].id, page[i].name, page[i].count);
+        ls->after = page[n - 1].id;
+        if (ls->remaining > 0) ls->remaining -= n;
+        if (n < want) {
+            ls->remaining = 0;
+            ls->limit = 0;
+        }
+    }
+
+    if (ls->remaining == 0 && cap - len >= TRAINER_LINE_MAX) {
+        /* Page limit reached: tell the client where to resume */
+        if (ls->limit > 0 && trainer_store_page(trainers, ls->after, page, 1) > 0)
+            len += (size_t)snprintf(buf + len, cap - len,
+                                    "Next page: get trainer after %d limit %d\n",
+                                    ls->after, ls->limit);
+        ls->finished = 1;
+    }
+    return len;
+}
+
+/**
+ * \brief Parse "[after <id>] [limit <n>]" listing options.
+ *
+ * \return 1 on success, 0 on a malformed option list.
+ */
+static int parse_list_options(const cmd_token_t *args, int argc, trainer_list_t *ls) {
+    memset(ls, 0, sizeof(*ls));
+    ls->remaining = -1;
+
+    for (int i = 0; i < argc; i += 2) {
+        if (i + 1 >= argc) return 0;
+        if (cmd_tok_eq(&args[i], "after")) {
+            if (!cmd_tok_int(&args[i + 1], 0, INT32_MAX, &ls->after)) return 0;
+        } else if (cmd_tok_eq(&args[i], "limit")) {
+            if (!cmd_tok_int(&args[i + 1], 1, INT32_MAX, &ls->limit)) return 0;
+            ls->remaining = ls->limit;
+        } else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/*!< Cursor state for a streamed Pokémon filter result (Response.stream_ctx). */
+typedef struct {
+    const PokemonDB *db;            /*!< Catalog the query ran against */
+    pokedex_pin_t *pin;             /*!< Keeps \ref db alive until freed */
+    size_t      pos;                /*!< Next record index to examine */
+    size_t      matches;            /*!< Records in \ref bits */
+    int         remaining;          /*!< Rows still allowed (-1 = unlimited) */
+    int         started;            /*!< Header line written */
+    size_t      words;              /*!< Words in \ref bits */
+    uint64_t    bits[];             /*!< Query result bitmap */
+} pokemon_list_t;
+
+/*!< Upper bound on one formatted Pokémon listing line. */
+#define POKEMON_LINE_MAX    192
+
+/**
+ * \brief Produce the next chunk of a Pokémon filter result (stream_fill_fn).
+ */
+static size_t pokemon_list_fill(void *ctx, char *buf, size_t cap) {
+    pokemon_list_t *ls = ctx;
+    size_t len = 0;
+
+    if (!ls->started) {
+        len += (size_t)snprintf(buf, cap, "Matches: %zu Pokémon%s\n", ls->matches,
+                                ls->remaining >= 0 && (size_t)ls->remaining < ls->matches
+                                    ? " (limited)" : "");
+        ls->started = 1;
+    }
+
+    /* Walk set bits from the cursor, one word at a time */
+    while (ls->remaining != 0 && cap - len >= POKEMON_LINE_MAX) {
+        size_t w = ls->pos >> 6;
+        if (w >= ls->words)
+            break;
+        uint64_t word = ls->bits[w] & (~(uint64_t)0 << (ls->pos & 63));
+        if (!word) {
+            ls->pos = (w + 1) << 6;
+            continue;
+        }
+
+        size_t i = (w << 6) + (size_t)__builtin_ctzll(word);
+        const Pokemon *p = &ls->db->records[i];
+        len += (size_t)snprintf(buf + len, cap - len,
+                                "  #%d %s (%s/%s) Gen %d, Total %d%s\n",
+                                p->id, p->name, p->type1,
+                                (strlen(p->type2) ? p->type2 : "—"),
+                                p->generation, p->total,
+                                p->legendary ? ", Legendary" : "");
+        ls->pos = i + 1;
+        if (ls->remaining > 0) ls->remaining--;
+    }
+    return len;
+}
+
+/**
+ * \brief Release a Pokémon filter stream and its catalog pin (Response.stream_free).
+ */
+static void pokemon_list_free(void *ctx) {
+    pokemon_list_t *ls = ctx;
+    pokedex_unpin(ls->pin);
+    free(ls);
+}
+
+/**
+ * \brief Parse a stat range: "lo-hi", "lo-", "-hi" or a single value.
+ *
+ * \return 1 on success, 0 on malformed input.
+ */
+static int parse_stat_range(const cmd_token_t *t, int *lo, int *hi) {
+    const char *dash = memchr(t->s, '-', t->len);
+
+    if (!dash) {
+        if (!cmd_tok_int(t, 0, INT32_MAX, lo)) return 0;
+        *hi = *lo;
+        return 1;
+    }
+
+    size_t head = (size_t)(dash - t->s), tail = t->len - head - 1;
+    *lo = INT32_MIN;
+    *hi = INT32_MAX;
+    if (head > 0 && !cmd_parse_int(t->s, head, 0, INT32_MAX, lo)) return 0;
+    if (tail > 0 && !cmd_parse_int(dash + 1, tail, 0, INT32_MAX, hi)) return 0;
+    return 1;
+}
+
+/**
+ * \brief Resolve a column (or, with \p stat_only, a base stat) token.
+ *
+ * \return Column index, or -1 if \p t names none.
+ */
+static int parse_column(const cmd_token_t *t, int stat_only) {
+    char word[POKEMON_WORD_MAX];
+    if (!cmd_tok_cstr(t, word, sizeof(word))) return -1;
+    return stat_only ? pokemon_stat_parse(word) : pokemon_column_parse(word);
+}
+
+/**
+ * \brief Parse "get pokemon" filter criteria into \p f.
+ *
+ * \return 1 on success, 0 on an unknown or malformed criterion.
+ *
+ * \note  A type name is copied into \p type, which \p f then points at.
+ */
+static int parse_pokemon_filter(const cmd_token_t *args, int argc, PokemonFilter *f,
+                                int *limit, char type[POKEMON_WORD_MAX]) {
+    pokemon_filter_init(f);
+    *limit = -1;
+
+    for (int i = 0; i < argc; i++) {
+        int stat;
+        if (cmd_tok_eq(&args[i], "legendary")) {
+            f->legendary = 1;
+        } else if (cmd_tok_eq(&args[i], "nonlegendary")) {
+            f->legendary = 0;
+        } else if (i + 1 >= argc) {
+            return 0;
+        } else if (cmd_tok_eq(&args[i], "type")) {
+            if (!cmd_tok_cstr(&args[++i], type, POKEMON_WORD_MAX)) return 0;
+            f->type = type;
+        } else if (cmd_tok_eq(&args[i], "gen")) {
+            if (!cmd_tok_int(&args[++i], 1, INT32_MAX, &f->gen)) return 0;
+        } else if (cmd_tok_eq(&args[i], "limit")) {
+            if (!cmd_tok_int(&args[++i], 1, INT32_MAX, limit)) return 0;
+        } else if ((stat = parse_column(&args[i], 1)) >= 0) {
+            if (!parse_stat_range(&args[++i], &f->lo[stat], &f->hi[stat])) return 0;
+            f->has_range[stat] = 1;
+        } else {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* ========================================================================== */
+/* ============================== Stat Queries ============================== */
+/* ========================================================================== */
+
+/*!< Aggregate selected by the first "stats" argument. */
+typedef enum {
+    STATS_AVG = 0,
+    STATS_SUM,
+    STATS_MIN,
+    STATS_MAX,
+    STATS_COUNT
+} stats_op_t;
+
+/*!< Operation names, in stats_op_t order. */
+static const char *const stats_op_names[] = { "avg", "sum", "min", "max", "count" };
+
+/*!< Output cursor over a fixed reply buffer. */
+typedef struct {
+    char       *buf;
+    size_t      cap;
+    size_t      len;
+} stats_out_t;
+
+/**
+ * \brief Append formatted text to \p o; output past the buffer is dropped.
+ */
+static void __attribute__((format(printf, 2, 3)))
+stats_printf(stats_out_t *o, const char *fmt, ...) {
+    if (o->len + 1 >= o->cap) return;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(o->buf + o->len, o->cap - o->len, fmt, ap);
+    va_end(ap);
+    if (n > 0) o->len = (o->len + (size_t)n < o->cap) ? o->len + (size_t)n : o->cap - 1;
+}
+
+/**
+ * \brief Append one aggregate value of \p a (without a trailing newline).
+ */
+static void stats_print_value(stats_out_t *o, stats_op_t op, const simd_agg_t *a) {
+    switch (op) {
+        case STATS_AVG:   stats_printf(o, "%.2f", (double)a->sum / (double)a->count); break;
+        case STATS_SUM:   stats_printf(o, "%lld", (long long)a->sum); break;
+        case STATS_MIN:   stats_printf(o, "%d", a->min); break;
+        case STATS_MAX:   stats_printf(o, "%d", a->max); break;
+        case STATS_COUNT: stats_printf(o, "%zu", a->count); break;
+    }
+}
+
+/**
+ * \brief Aggregate one group: \p sel AND \p group (or AND NOT, if \p invert).
+ */
+static void stats_print_group(stats_out_t *o, stats_op_t op, const int32_t *col,
+                              const uint64_t *sel, const uint64_t *group, int invert,
+                              uint64_t *scratch, const char *label) {
+    const PokemonIndex *idx = pokedex->index;
+    simd_agg_t a;
+
+    for (size_t w = 0; w < idx->words; w++)
+        scratch[w] = sel[w] & (invert ? ~group[w] : group[w]);
+    simd_aggregate(col, (size_t)idx->count, scratch, &a);
+    if (a.count == 0) return;
+
+    stats_printf(o, "\n  %s: ", label);
+    stats_print_value(o, op, &a);
+    if (op != STATS_COUNT) stats_printf(o, " (%zu)", a.count);
+}
+
+/**
+ * \brief Order type bitmaps by name (qsort callback).
+ */
+static int cmp_type_name(const void *a, const void *b) {
+    const pokemon_type_bits_t *const *x = a, *const *y = b;
+    return strcmp((*x)->name, (*y)->name);
+}
+
+/**
+ * \brief Run "stats top <k> <column> [filters...]".
+ */
+static void stats_top(stats_out_t *o, const cmd_token_t *args, int argc) {
+    const PokemonIndex *idx = pokedex->index;
+    PokemonFilter filter;
+    char type[POKEMON_WORD_MAX];
+    uint32_t rows[STATS_TOP_MAX];
+    int limit, k, col;
+    uint64_t *sel;
+
+    if (argc < 3 || !cmd_tok_int(&args[1], 1, STATS_TOP_MAX, &k) ||
+        (col = parse_column(&args[2], 0)) < 0 ||
+        !parse_pokemon_filter(args + 3, argc - 3, &filter, &limit, type)) {
+        stats_printf(o, "Invalid command: use stats top <1-%d> <column> [filters].",
+                     STATS_TOP_MAX);
+        return;
+    }
+    if (!(sel = malloc(idx->words * sizeof(uint64_t)))) {
+        stats_printf(o, "Out of memory.");
+        return;
+    }
+
+    size_t matches = pokemon_index_query(idx, &filter, sel);
+    size_t n = simd_top_k(idx->cols[col], (size_t)idx->count, sel, (size_t)k, rows);
+    stats_printf(o, "Top %zu by %s (%zu Pokémon matched):", n, pokemon_column_name(col), matches);
+    for (size_t i = 0; i < n; i++) {
+        const Pokemon *p = &pokedex->records[rows[i]];
+        stats_printf(o, "\n  %zu. #%d %s — %s %d", i + 1, p->id, p->name,
+                     pokemon_column_name(col), idx->cols[col][rows[i]]);
+    }
+    free(sel);
+}
+
+/**
+ * \brief Run a "stats" command against the catalog's columnar projection.
+ *
+ * Syntax (filters as for "get pokemon"):
+ *   stats <avg|sum|min|max> <column> [by type|gen|legendary] [filters...]
+ *   stats count [by type|gen|legendary] [filters...]
+ *   stats top <k> <column> [filters...]
+ *
+ * \param[in]       args        Arguments after "stats".
+ */
+static void stats_command(const cmd_token_t *args, int argc, char *msg, size_t cap) {
+    const PokemonIndex *idx = pokedex->index;
+    stats_out_t o = { msg, cap, 0 };
+    PokemonFilter filter;
+    char type[POKEMON_WORD_MAX];
+    const char *by = NULL;
+    int op = -1, col = COL_GENERATION, limit, i = 1;
+    uint64_t *sel, *scratch;
+
+    msg[0] = '\0';
+    if (argc >= 1 && cmd_tok_eq(&args[0], "top")) {
+        stats_top(&o, args, argc);
+        return;
+    }
+
+    for (int j = 0; argc >= 1 && j < (int)(sizeof(stats_op_names) / sizeof(stats_op_names[0])); j++)
+        if (cmd_tok_eq(&args[0], stats_op_names[j])) op = j;
+    if (op >= 0 && op != STATS_COUNT && (argc < 2 || (col = parse_column(&args[i++], 0)) < 0))
+        op = -1;
+    if (op >= 0 && i + 1 < argc && cmd_tok_eq(&args[i], "by")) {
+        static const char *const groups[] = { "type", "gen", "legendary" };
+        for (size_t g = 0; g < sizeof(groups) / sizeof(groups[0]); g++)
+            if (cmd_tok_eq(&args[i + 1], groups[g])) by = groups[g];
+        if (!by)
+            op = -1;
+        i += 2;
+    }
+    if (op < 0 || !parse_pokemon_filter(args + i, argc - i, &filter, &limit, type)) {
+        stats_printf(&o, "Invalid command: use stats <avg|sum|min|max> <column> "
+                         "[by type|gen|legendary] [filters], stats count [by ...] "
+                         "[filters] or stats top <k> <column> [filters].");
+        return;
+    }
+
+    sel = malloc(idx->words * sizeof(uint64_t));
+    scratch = malloc(idx->words * sizeof(uint64_t));
+    if (!sel || !scratch) {
+        stats_printf(&o, "Out of memory.");
+        free(sel);
+        free(scratch);
+        return;
+    }
+
+    size_t matches = pokemon_index_query(idx, &filter, sel);
+    const int32_t *values = idx->cols[col];
+
+    if (!by) {
+        simd_agg_t a;
+        simd_aggregate(values, (size_t)idx->count, sel, &a);
+        if (op == STATS_COUNT) {
+            stats_printf(&o, "count: %zu Pokémon", a.count);
+        } else if (a.count == 0) {
+            stats_printf(&o, "No Pokémon match.");
+        } else {
+            stats_printf(&o, "%s %s: ", stats_op_names[op], pokemon_column_name(col));
+            stats_print_value(&o, (stats_op_t)op, &a);
+            stats_printf(&o, " over %zu Pokémon", a.count);
+        }
+    } else {
+        if (op == STATS_COUNT)
+            stats_printf(&o, "count by %s (%zu Pokémon):", by, matches);
+        else
+            stats_printf(&o, "%s %s by %s (%zu Pokémon):", stats_op_names[op],
+                         pokemon_column_name(col), by, matches);
+
+        if (strcmp(by, "type") == 0) {
+            const pokemon_type_bits_t *order[idx->ntypes > 0 ? idx->ntypes : 1];
+            for (int t = 0; t < idx->ntypes; t++) order[t] = &idx->types[t];
+            qsort(order, (size_t)idx->ntypes, sizeof(order[0]), cmp_type_name);
+            for (int t = 0; t < idx->ntypes; t++)
+                stats_print_group(&o, (stats_op_t)op, values, sel, order[t]->bits, 0,
+                                  scratch, order[t]->name);
+        } else if (strcmp(by, "gen") == 0) {
+            for (int g = 0; g <= POKEMON_GEN_MAX; g++) {
+                char label[16];
+                if (!idx->gens[g]) continue;
+                snprintf(label, sizeof(label), "Gen %d", g);
+                stats_print_group(&o, (stats_op_t)op, values, sel, idx->gens[g], 0,
+                                  scratch, label);
+            }
+        } else {
+            stats_print_group(&o, (stats_op_t)op, values, sel, idx->legendary, 0,
+                              scratch, "Legendary");
+            stats_print_group(&o, (stats_op_t)op, values, sel, idx->legendary, 1,
+                              scratch, "Non-legendary");
+        }
+    }
+
+    free(sel);
+    free(scratch);
+}
+
+/* ========================================================================== */
+/* ================================ Logging ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief Log a client request with timestamp and address.
+ *
+ * Lock-free: the line is queued for the logger's writer thread.
+ */
+static void log_request(const char *ip, int port, const char *cmd) {
+    logger_log(logger, ip, port, cmd);
+}
+
+/* ========================================================================== */
+/* ========================= Batch Trainer Commands ========================= */
+/* ========================================================================== */
+
+/**
+ * \brief "mget trainer <id>...": every requested trainer in one reply.
+ *
+ * \note  One shared lock acquisition for the whole batch; entries follow
+ *        the request order and are separated by a blank line.
+ */
+static void mget_command(const char *text, Response *res) {
+    int ids[TRAINER_BATCH_MAX];
+    uint8_t found[TRAINER_BATCH_MAX];
+    int n = parse_id_list(text, ids, TRAINER_BATCH_MAX);
+    if (n <= 0) {
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: use mget trainer <id> [<id> ...] (at most %d).",
+                 TRAINER_BATCH_MAX);
+        return;
+    }
+
+    Trainer *recs = malloc((size_t)n * sizeof(*recs));
+    char *body = malloc((size_t)n * (TRAINER_RENDER_MAX + 1));
+    if (!recs || !body) {
+        free(recs);
+        free(body);
+        snprintf(res->message, sizeof(res->message), "Out of memory.");
+        return;
+    }
+
+    trainer_store_get_many(trainers, ids, (size_t)n, recs, found);
+    size_t len = 0;
+    for (int k = 0; k < n; k++) {
+        if (k > 0) body[len++] = '\n';
+        int m = found[k] ? render_trainer(&recs[k], body + len, TRAINER_RENDER_MAX)
+                         : snprintf(body + len, TRAINER_RENDER_MAX,
+                                    "Trainer %d not found.\n", ids[k]);
+        if (m >= TRAINER_RENDER_MAX) m = TRAINER_RENDER_MAX - 1;
+        if (m > 0) len += (size_t)m;
+    }
+    body[len] = '\0';
+    free(recs);
+    res->body = body;   /* Sent and freed by the caller */
+}
+
+/**
+ * \brief Parse one "<name> <p1> [<p2> ...]" record of an mpost body.
+ *
+ * \return 1 if \p rec is a valid trainer (copied into \p t), 0 otherwise.
+ */
+static int parse_batch_record(char *rec, Trainer *t) {
+    while (isspace((unsigned char)*rec)) rec++;
+    char *name = rec;
+    while (*rec && !isspace((unsigned char)*rec)) rec++;
+    if (rec == name) return 0;
+    if (*rec) *rec++ = '\0';
+
+    int ids[MAX_POKEMON];
+    int count = parse_id_list(rec, ids, MAX_POKEMON);
+    if (count <= 0 || !validate_pokemon_ids(ids, count)) return 0;
+
+    memset(t, 0, sizeof(*t));
+    strncpy(t->name, name, sizeof(t->name) - 1);
+    for (int i = 0; i < count; i++) t->pokemon_ids[i] = ids[i];
+    t->count = count;
+    return 1;
+}
+
+/**
+ * \brief Append the IDs of \p ts[0..n) to the reply text at \p buf + \p len.
+ *
+ * \note  Consecutive IDs print as "a-b". With -S > 1 one shard takes the
+ *        batch and its IDs step by the shard count, so they are listed
+ *        ("3,7,11") rather than as a range that would hide the gaps.
+ *        TRAINER_BATCH_MAX IDs always fit in the message.
+ */
+static void append_batch_ids(char *buf, size_t cap, size_t len, const Trainer *ts, size_t n) {
+    if (n > 1 && ts[n - 1].id - ts[0].id == (int)n - 1) {
+        snprintf(buf + len, cap - len, "%d-%d", ts[0].id, ts[n - 1].id);
+        return;
+    }
+    for (size_t k = 0; k < n && len < cap; k++)
+        len += (size_t)snprintf(buf + len, cap - len, k ? ",%d" : "%d", ts[k].id);
+}
+
+/**
+ * \brief "mpost trainer <name> <p>... [; <name> <p>...]...": add a batch.
+ *
+ * \note  Every record is validated before any is stored, so a bad record
+ *        rejects the whole batch; the valid batch is then written under
+ *        one exclusive lock and acknowledged after one WAL commit.
+ */
+static void mpost_command(const char *text, Response *res) {
+    char *copy = strdup(text);
+    Trainer *ts = malloc(TRAINER_BATCH_MAX * sizeof(*ts));
+    if (!copy || !ts) {
+        free(copy);
+        free(ts);
+        snprintf(res->message, sizeof(res->message), "Out of memory.");
+        return;
+    }
+
+    size_t n = 0;
+    int bad = 0;
+    char *save = NULL;
+    for (char *rec = strtok_r(copy, ";", &save); rec && !bad;
+         rec = strtok_r(NULL, ";", &save)) {
+        if (rec[strspn(rec, " \t\n\v\f\r")] == '\0')
+            continue;   /* Tolerate a trailing or doubled ';' */
+        if (n == TRAINER_BATCH_MAX || !parse_batch_record(rec, &ts[n]))
+            bad = 1;
+        else
+            n++;
+    }
+    free(copy);
+
+    if (bad || n == 0) {
+        if (bad && n == TRAINER_BATCH_MAX)
+            snprintf(res->message, sizeof(res->message),
+                     "Invalid command: at most %d trainers per mpost.", TRAINER_BATCH_MAX);
+        else if (bad)
+            snprintf(res->message, sizeof(res->message),
+                     "Invalid command: record %zu failed validation (check Pokémon IDs); "
+                     "nothing was added.", n + 1);
+        else
+            snprintf(res->message, sizeof(res->message),
+                     "Invalid command: use mpost trainer <name> <p1> [<p2> ...] "
+                     "[; <name> <p1> ...]...");
+        free(ts);
+        return;
+    }
+
+    /* A failed commit still leaves the batch indexed (ids set), so every
+     * stored ID is invalidated whatever the outcome */
+    long added = trainer_store_add_many(trainers, ts, n);
+    for (size_t k = 0; k < n && trainer_replies; k++) {
+        if (ts[k].id > 0)
+            trainer_cache_invalidate(trainer_replies, ts[k].id);
+    }
+
+    if (added < 0)
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: Failed to store the batch; nothing was acknowledged.");
+    else {
+        int len = snprintf(res->message, sizeof(res->message), "Added %zu trainer(s). IDs=", n);
+        append_batch_ids(res->message, sizeof(res->message), (size_t)len, ts, n);
+    }
+    free(ts);
+}
+
+/**
+ * \brief "mdelete trainer <id>...": remove a batch in one transaction.
+ */
+static void mdelete_command(const char *text, Response *res) {
+    int ids[TRAINER_BATCH_MAX];
+    uint8_t deleted[TRAINER_BATCH_MAX];
+    int n = parse_id_list(text, ids, TRAINER_BATCH_MAX);
+    if (n <= 0) {
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: use mdelete trainer <id> [<id> ...] (at most %d).",
+                 TRAINER_BATCH_MAX);
+        return;
+    }
+
+    long removed = trainer_store_delete_many(trainers, ids, (size_t)n, deleted);
+    for (int k = 0; k < n && trainer_replies; k++)
+        if (deleted[k])
+            trainer_cache_invalidate(trainer_replies, ids[k]);
+    if (removed < 0) {
+        snprintf(res->message, sizeof(res->message), "Trainers not deleted.");
+        return;
+    }
+
+    int len = snprintf(res->message, sizeof(res->message),
+                       "Deleted %ld of %d trainer(s).", removed, n);
+    if (removed < n)
+        len += snprintf(res->message + len, sizeof(res->message) - (size_t)len, " Not found:");
+    for (int k = 0; k < n && (size_t)len < sizeof(res->message); k++)
+        if (!deleted[k])
+            len += snprintf(res->message + len, sizeof(res->message) - (size_t)len,
+                            " %d", ids[k]);
+}
+
+/* ========================================================================== */
+/* =========================== Command Processing =========================== */
+/* ========================================================================== */
+
+/**
+ * \brief Reply "Invalid command: <usage>." for a malformed command.
+ */
+static int cmd_usage(cmd_ctx_t *c, const char *usage) {
+    snprintf(c->res->message, sizeof(c->res->message), "Invalid command: use %s.", usage);
+    return SESSION_CONTINUE;
+}
+
+/**
+ * \brief Raw text after the key words, for commands that outgrow the tokens.
+ */
+static const char *cmd_rest(const cmd_ctx_t *c) {
+    return c->nargs > 0 ? c->args[0].s : c->line + strlen(c->line);
+}
+
+/**
+ * \brief Parse Pokémon ID arguments strictly into \p ids.
+ *
+ * \return 1 if every token is an ID, 0 otherwise.
+ */
+static int parse_team(const cmd_token_t *args, int count, int *ids) {
+    for (int i = 0; i < count; i++)
+        if (!cmd_tok_int(&args[i], 1, INT32_MAX, &ids[i])) return 0;
+    return 1;
+}
+
+/* ========================== EXIT ========================== */
+static int cmd_exit(cmd_ctx_t *c) {
+    snprintf(c->res->message, sizeof(c->res->message), "Goodbye from server.");
+    return SESSION_CLOSE;
+}
+
+/* ========================== PROTO BINARY =================== */
+static int cmd_proto_binary(cmd_ctx_t *c) {
+    snprintf(c->res->message, sizeof(c->res->message), "Switching to binary protocol.");
+    return SESSION_BINARY;
+}
+
+/* ========================== GET STATS ====================== */
+static int cmd_get_stats(cmd_ctx_t *c) {
+    int prometheus = c->nargs == 1;
+    if (prometheus && !cmd_tok_eq(&c->args[0], "prometheus"))
+        return cmd_usage(c, "get stats [prometheus]");
+
+    char *text = prometheus ? metrics_report_prometheus() : metrics_report_text();
+    if (!text)
+        snprintf(c->res->message, sizeof(c->res->message), "Out of memory.");
+    else
+        c->res->body = text;    /* Sent and freed by caller */
+    return SESSION_CONTINUE;
+}
+
+/* ========================== GET LOG ======================== */
+static int cmd_get_log(cmd_ctx_t *c) {
+    Response *res = c->res;
+    int n;
+    if (!cmd_tok_int(&c->args[0], 1, INT32_MAX, &n))
+        return cmd_usage(c, "get log <n>");
+
+    /* Within the tail ring: copy it. Beyond it: stream from the file */
+    if (n <= LOG_TAIL_LINES) {
+        char *text = logger_tail(logger, n);
+        if (!text) {
+            snprintf(res->message, sizeof(res->message), "Could not read log file.");
+        } else if (text[0] == '\0') {
+            snprintf(res->message, sizeof(res->message), "Log file is empty.");
+            free(text);
+        } else if (strlen(text) < sizeof(res->message)) {
+            snprintf(res->message, sizeof(res->message), "%s", text);
+            free(text);
+        } else {
+            res->body = text;   /* Too big for message: sent and freed by caller */
+        }
+        return SESSION_CONTINUE;
+    }
+
+    size_t bytes = 0;
+    logger_stream_t *ls = logger_tail_open(logger, n, &bytes);
+    if (!ls) {
+        snprintf(res->message, sizeof(res->message), "Could not read log file.");
+    } else if (bytes == 0) {
+        snprintf(res->message, sizeof(res->message), "Log file is empty.");
+        logger_tail_close(ls);
+    } else {
+        res->stream = logger_tail_fill;     /* Sent and closed by the front end */
+        res->stream_ctx = ls;
+        res->stream_free = logger_tail_close;
+    }
+    return SESSION_CONTINUE;
+}
+
+/* ========================== GET REPLICATION ================ */
+static int cmd_get_replication(cmd_ctx_t *c) {
+    repl_status(c->res->message, sizeof(c->res->message));
+    return SESSION_CONTINUE;
+}
+
+/* ========================== GET POKEMON ==================== */
+static int cmd_get_pokemon(cmd_ctx_t *c) {
+    Response *res = c->res;
+    int id;
+
+    /* One integer looks up that Pokémon; anything else is a filter query */
+    if (c->nargs == 1 && cmd_tok_int(&c->args[0], 0, INT32_MAX, &id)) {
+        const Pokemon *p = pokemon_db_get(pokedex, id);
+        if (!p)
+            snprintf(res->message, sizeof(res->message), "Pokémon %d not found.", id);
+        else
+            snprintf(res->message, sizeof(res->message),
+                     "Pokémon #%d: %s\n"
+                     "Type: %s/%s\n"
+                     "Generation: %d  Legendary: %s\n"
+                     "Stats: Total %d | HP %d | Atk %d | Def %d | "
+                     "SpA %d | SpD %d | Spe %d",
+                     p->id, p->name, p->type1,
+                     (strlen(p->type2)?p->type2:"—"),
+                     p->generation, p->legendary ? "Yes" : "No",
+                     p->total, p->hp, p->attack, p->defense,
+                     p->sp_atk, p->sp_def, p->speed);
+        return SESSION_CONTINUE;
+    }
+
+    c->kind = MCMD_QUERY_POKEMON;
+    PokemonFilter filter;
+    char type[POKEMON_WORD_MAX];
+    int limit;
+    const PokemonIndex *idx = pokedex->index;
+    pokemon_list_t *ls;
+
+    if (!parse_pokemon_filter(c->args, c->nargs, &filter, &limit, type))
+        return cmd_usage(c, "get pokemon [type <t>] [gen <n>] "
+                            "[legendary|nonlegendary] [<stat> <lo>-<hi>] [limit <n>]");
+    if (!(ls = malloc(sizeof(*ls) + idx->words * sizeof(uint64_t)))) {
+        snprintf(res->message, sizeof(res->message), "Out of memory.");
+        return SESSION_CONTINUE;
+    }
+    memset(ls, 0, sizeof(*ls));
+    ls->db = pokedex;
+    ls->pin = pokedex_pin();    /* Chunks are produced after dispatch */
+    ls->words = idx->words;
+    ls->remaining = limit;
+    ls->matches = pokemon_index_query(idx, &filter, ls->bits);
+    res->stream = pokemon_list_fill;
+    res->stream_free = pokemon_list_free;
+    res->stream_ctx = ls;
+    return SESSION_CONTINUE;
+}
+
+/* ========================== GET TRAINER ==================== */
+static int cmd_get_trainer(cmd_ctx_t *c) {
+    Response *res = c->res;
+
+    if (c->nargs == 1 && !cmd_tok_eq(&c->args[0], "after") &&
+        !cmd_tok_eq(&c->args[0], "limit")) {
+        int id;
+        uint32_t epoch = 0;
+        Trainer t;
+
+        if (!cmd_tok_int(&c->args[0], 1, INT32_MAX, &id))
+            return cmd_usage(c, "get trainer <id>");
+
+        /* Hot trainers: copy the reply rendered by an earlier request */
+        int cached = trainer_replies &&
+                     trainer_cache_get(trainer_replies, id, res->message,
+                                       sizeof(res->message), &epoch) > 0;
+        if (cached) {
+            /* res->message already holds the reply */
+        } else if (trainer_store_get(trainers, id, &t)) {
+            int n = render_trainer(&t, res->message, sizeof(res->message));
+            if (trainer_replies && n > 0 && (size_t)n < sizeof(res->message))
+                trainer_cache_put(trainer_replies, id, epoch, res->message, (size_t)n);
+        } else {
+            snprintf(res->message, sizeof(res->message), "Trainer %d not found.", id);
+        }
+        return SESSION_CONTINUE;
+    }
+
+    /* Listing, optionally paged: streamed by the front end */
+    c->kind = MCMD_LIST_TRAINERS;
+    trainer_list_t opts;
+    trainer_list_t *ls;
+    if (!parse_list_options(c->args, c->nargs, &opts))
+        return cmd_usage(c, "get trainer [after <id>] [limit <n>]");
+    if (!(ls = malloc(sizeof(*ls)))) {
+        snprintf(res->message, sizeof(res->message), "Out of memory.");
+        return SESSION_CONTINUE;
+    }
+    *ls = opts;
+    res->stream = trainer_list_fill;
+    res->stream_ctx = ls;
+    return SESSION_CONTINUE;
+}
+
+/* ========================== POST TRAINER =================== */
+static int cmd_post_trainer(cmd_ctx_t *c) {
+    Response *res = c->res;
+    char name[sizeof(((Trainer *)0)->name)];
+    int ids[MAX_POKEMON];
+    int count = c->nargs - 1;
+
+    if (count > MAX_POKEMON) {
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: Trainer cannot have more than %d Pokémon.", MAX_POKEMON);
+        return SESSION_CONTINUE;
+    }
+
+    /* Long names are cut to the record's field, as before */
+    snprintf(name, sizeof(name), "%.*s", (int)c->args[0].len, c->args[0].s);
+    int new_id = parse_team(c->args + 1, count, ids) ?
+                 add_trainer_with_validation(name, ids, count) : -1;
+
+    if (new_id < 0)
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: Failed validation (check Pokémon IDs).");
+    else
+        snprintf(res->message, sizeof(res->message),
+                 "Trainer added successfully. ID=%d", new_id);
+    return SESSION_CONTINUE;
+}
+
+/* ========================== PUT TRAINER ==================== */
+static int cmd_put_trainer(cmd_ctx_t *c) {
+    Response *res = c->res;
+    int id;
+    int ids[MAX_POKEMON];
+    int count = c->nargs - 1;
+
+    if (!cmd_tok_int(&c->args[0], 1, INT32_MAX, &id))
+        return cmd_usage(c, "put trainer <id> <p1> [<p2> ...]");
+    if (count > MAX_POKEMON) {
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: Max Pokémon = %d.", MAX_POKEMON);
+        return SESSION_CONTINUE;
+    }
+
+    int ok = parse_team(c->args + 1, count, ids) &&
+             update_trainer_with_validation(id, ids, count);
+    if (!ok)
+        snprintf(res->message, sizeof(res->message), "Trainer %d not updated.", id);
+    else
+        snprintf(res->message, sizeof(res->message), "Trainer %d updated.", id);
+    return SESSION_CONTINUE;
+}
+
+/* ========================== DELETE TRAINER ================= */
+static int cmd_delete_trainer(cmd_ctx_t *c) {
+    int id;
+    if (!cmd_tok_int(&c->args[0], 1, INT32_MAX, &id))
+        return cmd_usage(c, "delete trainer <id>");
+
+    if (!delete_trainer(id))
+        snprintf(c->res->message, sizeof(c->res->message), "Trainer %d not found.", id);
+    else
+        snprintf(c->res->message, sizeof(c->res->message), "Trainer %d deleted.", id);
+    return SESSION_CONTINUE;
+}
+
+/* ==================== MGET / MPOST / MDELETE =============== */
+/* Batches exceed the tokenizer's limit, so they parse the raw rest */
+static int cmd_mget_trainer(cmd_ctx_t *c) {
+    mget_command(cmd_rest(c), c->res);
+    return SESSION_CONTINUE;
+}
+
+static int cmd_mpost_trainer(cmd_ctx_t *c) {
+    mpost_command(cmd_rest(c), c->res);
+    return SESSION_CONTINUE;
+}
+
+static int cmd_mdelete_trainer(cmd_ctx_t *c) {
+    mdelete_command(cmd_rest(c), c->res);
+    return SESSION_CONTINUE;
+}
+
+/* ========================== SNAPSHOT ======================= */
+static int cmd_snapshot(cmd_ctx_t *c) {
+    Response *res = c->res;
+    char name[256], path[512];
+    TrainerSnapshotHeader info;
+
+    if ((c->nargs == 1 && !cmd_tok_cstr(&c->args[0], name, sizeof(name))) ||
+        snapshot_path(c->nargs == 1 ? name : NULL, path, sizeof(path)) < 0)
+        snprintf(res->message, sizeof(res->message),
+                 "Snapshot name must be a plain file name.");
+    else if (trainer_store_snapshot(trainers, path, &info) < 0)
+        snprintf(res->message, sizeof(res->message), errno == EBUSY ?
+                 "A snapshot or compaction is already running." : "Snapshot failed.");
+    else
+        snprintf(res->message, sizeof(res->message),
+                 "Snapshot saved: %u trainer(s) to %s (lsn %llu).",
+                 info.count, path, (unsigned long long)info.lsn);
+    return SESSION_CONTINUE;
+}
+
+/* ======================= RELOAD POKEMON ==================== */
+static int cmd_reload_pokemon(cmd_ctx_t *c) {
+    Response *res = c->res;
+    int rc = pokedex_reload(retire_rendered_replies);
+    if (rc == 0)
+        snprintf(res->message, sizeof(res->message),
+                 "Reloading the Pokémon catalog in the background "
+                 "(serving version %lu, %d Pokémon).", pokedex_version(), pokedex->count);
+    else
+        snprintf(res->message, sizeof(res->message), rc > 0 ?
+                 "A Pokémon reload is already running." : "Reload failed to start.");
+    return SESSION_CONTINUE;
+}
+
+/* ========================== STATS ========================== */
+static int cmd_stats(cmd_ctx_t *c) {
+    stats_command(c->args, c->nargs, c->res->message, sizeof(c->res->message));
+    return SESSION_CONTINUE;
+}
+
+/*!< Text commands, each in the slot CMD_HASH() gives its verb and noun. */
+static const cmd_entry_t commands[CMD_TABLE_SIZE] = {
+    CMD_ENTRY("exit",     'e', "",            0,  0, CMD_ARGS_ANY, 0,
+              MCMD_OTHER,           cmd_exit),
+    CMD_ENTRY("proto",    'p', "binary",      'b', 0, 0,          0,
+              MCMD_OTHER,           cmd_proto_binary),
+    CMD_ENTRY("get",      'g', "stats",       's', 0, 1,          0,
+              MCMD_GET_STATS,       cmd_get_stats),
+    CMD_ENTRY("get",      'g', "log",         'l', 1, 1,          0,
+              MCMD_GET_LOG,         cmd_get_log),
+    CMD_ENTRY("get",      'g', "replication", 'r', 0, 0,          0,
+              MCMD_GET_REPLICATION, cmd_get_replication),
+    CMD_ENTRY("get",      'g', "pokemon",     'p', 1, CMD_ARGS_ANY, 0,
+              MCMD_GET_POKEMON,     cmd_get_pokemon),
+    CMD_ENTRY("get",      'g', "trainer",     't', 0, CMD_ARGS_ANY, 0,
+              MCMD_GET_TRAINER,     cmd_get_trainer),
+    CMD_ENTRY("post",     'p', "trainer",     't', 2, CMD_ARGS_ANY, CMD_WRITE,
+              MCMD_POST_TRAINER,    cmd_post_trainer),
+    CMD_ENTRY("put",      'p', "trainer",     't', 2, CMD_ARGS_ANY, CMD_WRITE,
+              MCMD_PUT_TRAINER,     cmd_put_trainer),
+    CMD_ENTRY("delete",   'd', "trainer",     't', 1, 1,          CMD_WRITE,
+              MCMD_DELETE_TRAINER,  cmd_delete_trainer),
+    CMD_ENTRY("mget",     'm', "trainer",     't', 0, CMD_ARGS_ANY, CMD_RAW,
+              MCMD_MGET_TRAINER,    cmd_mget_trainer),
+    CMD_ENTRY("mpost",    'm', "trainer",     't', 0, CMD_ARGS_ANY, CMD_WRITE | CMD_RAW,
+              MCMD_MPOST_TRAINER,   cmd_mpost_trainer),
+    CMD_ENTRY("mdelete",  'm', "trainer",     't', 0, CMD_ARGS_ANY, CMD_WRITE | CMD_RAW,
+              MCMD_MDELETE_TRAINER, cmd_mdelete_trainer),
+    CMD_ENTRY("snapshot", 's', "",            0,  0, 1,          0,
+              MCMD_SNAPSHOT,        cmd_snapshot),
+    CMD_ENTRY("reload",   'r', "pokemon",     'p', 0, 0,          0,
+              MCMD_RELOAD_POKEMON,  cmd_reload_pokemon),
+    CMD_ENTRY("stats",    's', "",            0,  0, CMD_ARGS_ANY, 0,
+              MCMD_STATS,           cmd_stats),
+};
+
+/**
+ * \brief           Log \p line, look it up in \ref commands and run its handler.
+ *
+ * \param[in]       ip          Client IP address (for logging).
+ * \param[in]       port        Client port (for logging).
+ * \param[in]       line        Command text with the newline removed.
+ * \param[out]      res         Receives the handler's reply, or the error.
+ * \param[out]      kind        Metrics class of the matched entry as the
+ *                              handler left it; MCMD_OTHER if none matched.
+ *
+ * \return          The handler's SessionAction, or SESSION_CONTINUE when
+ *                  the line is refused.
+ *
+ * \note            The words are tokenized once. cmd_lookup() finds the
+ *                  entry with one perfect-hash probe on verb and noun, or
+ *                  a second on the verb alone for one-word commands. A
+ *                  blank line gets "Empty command.", and a line with no
+ *                  entry, or with fewer or more arguments than the entry
+ *                  allows, gets "Invalid command."; on a replica
+ *                  an entry flagged CMD_WRITE is refused before its handler
+ *                  runs.
+ */
+static int dispatch_command(const char *ip, int port, const char *line, Response *res,
+                            metric_cmd_t *kind) {
+    /* Log command before processing */
+    log_request(ip, port, line);
+
+    cmd_tokens_t words;
+    int argi = 0;
+    const cmd_entry_t *cmd = NULL;
+
+    *kind = MCMD_OTHER;
+    if (cmd_tokenize(line, &words) == 0) {
+        snprintf(res->message, sizeof(res->message), "Empty command.");
+        return SESSION_CONTINUE;
+    }
+
+    cmd = cmd_lookup(commands, &words, &argi);
+    int nargs = words.n - argi;
+    if (cmd && words.more && !(cmd->flags & CMD_RAW)) {
+        res->status = STATUS_INVALID;
+        snprintf(res->message, sizeof(res->message),
+                 "Invalid command: too many arguments (at most %d words).", CMD_TOKENS_MAX);
+        return SESSION_CONTINUE;
+    }
+    if (!cmd || nargs < cmd->min_args || nargs > cmd->max_args) {
+        snprintf(res->message, sizeof(res->message), "Invalid command.");
+        return SESSION_CONTINUE;
+    }
+    if ((cmd->flags & CMD_WRITE) && repl_is_replica()) {
+        snprintf(res->message, sizeof(res->message),
+                 "Read-only replica: send writes to the primary.");
+        return SESSION_CONTINUE;
+    }
+
+    cmd_ctx_t c = {
+        .line = line, .words = &words, .args = &words.tok[argi], .nargs = nargs,
+        .res = res, .kind = cmd->kind
+    };
+    int action = cmd->fn(&c);
+    *kind = (metric_cmd_t)c.kind;
+    return action;
+}
+
+/**
+ * \brief           Execute one client command and build its reply.
+ *
+ * \param[in]       ip          Client IP address (for logging).
+ * \param[in]       port        Client port (for logging).
+ * \param[in]       line        Command text with the newline removed.
+ * \param[out]      res         Response whose message receives the reply.
+ *
+ * \return          SessionAction telling the front end how to continue.
+ *
+ * \note            Shared by the thread-per-connection and epoll front ends;
+ *                  the caller frames and sends \p res. The handling time is
+ *                  recorded per command class; for streamed replies it covers
+ *                  the setup only, not the chunks sent afterwards.
+ */
+static int process_command(const char *ip, int port, const char *line, Response *res) {
+    metric_cmd_t kind;
+    uint64_t start = metrics_now();
+    pokedex = pokedex_enter();
+    int action = dispatch_command(ip, port, line, res, &kind);
+    pokedex_exit();
+    pokedex = NULL;
+    metrics_command(kind, metrics_now() - start);
+    return action;
+}
+
+/* ========================================================================== */
+/* ======================= Binary Command Processing ======================== */
+/* ========================================================================== */
+
+/**
+ * \brief Append trainers after \p after (up to \p limit) to \p rep.
+ *
+ * \return 0 on success, -1 on read or allocation failure.
+ *
+ * \note   \p limit is clamped to BIN_LIST_MAX (0 means BIN_LIST_MAX), so
+ *         one frame stays small whatever the table size; a full reply tells
+ *         the client to ask again after the last ID it received.
+ */
+static int append_trainer_records(BinReply *rep, int after, int limit) {
+    Trainer *page = malloc(TRAINER_PAGE_MAX * sizeof(*page));   /* Off the session stack */
+    int rc = page ? 0 : -1;
+
+    if (limit <= 0 || limit > BIN_LIST_MAX) limit = BIN_LIST_MAX;
+    while (rc == 0) {
+        int want = limit < TRAINER_PAGE_MAX ? limit : TRAINER_PAGE_MAX;
+
+        int n = trainer_store_page(trainers, after, page, want);
+        if (n <= 0 || bin_reply_append(rep, page, (size_t)n * sizeof(Trainer)) < 0) {
+            rc = n == 0 ? 0 : -1;
+            break;
+        }
+
+        after = page[n - 1].id;
+        if ((limit -= n) == 0 || n < want) break;
+    }
+    free(page);
+    return rc;
+}
+
+/**
+ * \brief Copy a Trainer payload and check its team size and name.
+ *
+ * \return 1 if usable, 0 otherwise (an error is set on \p rep).
+ */
+static int decode_trainer_payload(const BinHeader *req, const uint8_t *payload,
+                                  Trainer *t, BinReply *rep) {
+    if (req->length != sizeof(*t)) {
+        bin_reply_error(rep, STATUS_INVALID, "Payload must be one Trainer record.");
+        return 0;
+    }
+    memcpy(t, payload, sizeof(*t));
+    t->name[sizeof(t->name) - 1] = '\0';
+    if (t->count <= 0 || t->count > MAX_POKEMON) {
+        bin_reply_error(rep, STATUS_INVALID, "Trainer must have 1 to 6 Pokémon.");
+        return 0;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Execute one binary request and build its reply.
+ *
+ * \param[in]       ip          Client IP address (for logging).
+ * \param[in]       port        Client port (for logging).
+ * \param[in]       req         Decoded request header.
+ * \param[in]       payload     \p req->length payload bytes.
+ * \param[out]      rep         Reply initialized by the caller for \p req.
+ *
+ * \return          SESSION_CLOSE after BIN_OP_EXIT, SESSION_CONTINUE otherwise.
+ *
+ * \note            Same stores and validation as dispatch_command(), without
+ *                  tokenizing or formatting text.
+ */
+static int dispatch_binary(const char *ip, int port, const BinHeader *req,
+                           const uint8_t *payload, BinReply *rep) {
+    int32_t arg = (req->length >= 4) ? bin_get_i32(payload) : 0;
+    char note[64];
+    Trainer t;
+
+    snprintf(note, sizeof(note), "[binary] op=%u len=%u arg=%d",
+             req->opcode, req->length, arg);
+    log_request(ip, port, note);
+
+    if (repl_is_replica() && (req->opcode == BIN_OP_POST_TRAINER ||
+                              req->opcode == BIN_OP_PUT_TRAINER ||
+                              req->opcode == BIN_OP_DELETE_TRAINER)) {
+        bin_reply_error(rep, STATUS_UNSUPPORTED, "Read-only replica: send writes to the primary.");
+        return SESSION_CONTINUE;
+    }
+
+    switch (req->opcode) {
+    case BIN_OP_GET_POKEMON: {
+        const Pokemon *p = pokemon_db_get(pokedex, arg);
+        if (req->length != 4)
+            bin_reply_error(rep, STATUS_INVALID, "Payload must be an int32 ID.");
+        else if (!p)
+            bin_reply_error(rep, STATUS_NOT_FOUND, "Pokémon not found.");
+        else
+            bin_reply_append(rep, p, sizeof(*p));
+        break;
+    }
+
+    case BIN_OP_GET_TRAINER:
+        if (req->length != 4)
+            bin_reply_error(rep, STATUS_INVALID, "Payload must be an int32 ID.");
+        else if (!trainer_store_get(trainers, arg, &t))
+            bin_reply_error(rep, STATUS_NOT_FOUND, "Trainer not found.");
+        else
+            bin_reply_append(rep, &t, sizeof(t));
+        break;
+
+    case BIN_OP_LIST_TRAINERS:
+        /* Optional payload: int32 after, int32 limit (ID-ordered paging) */
+        if (req->length != 0 && req->length != 8)
+            bin_reply_error(rep, STATUS_INVALID, "Payload must be empty or after+limit.");
+        else if (append_trainer_records(rep, arg,
+                                        req->length == 8 ? bin_get_i32(payload + 4) : 0) < 0)
+            bin_reply_error(rep, STATUS_FAILURE, "Could not read trainer DB.");
+        break;
+
+    case BIN_OP_POST_TRAINER: {
+        if (!decode_trainer_payload(req, payload, &t, rep))
+            break;
+        int32_t new_id = add_trainer_with_validation(t.name, t.pokemon_ids, t.count);
+        if (new_id < 0) {
+            bin_reply_error(rep, STATUS_INVALID, "Failed validation (check Pokémon IDs).");
+        } else {
+            uint32_t wire = htole32((uint32_t)new_id);
+            bin_reply_append(rep, &wire, sizeof(wire));
+        }
+        break;
+    }
+
+    case BIN_OP_PUT_TRAINER:
+        if (!decode_trainer_payload(req, payload, &t, rep))
+            break;
+        if (!update_trainer_with_validation(t.id, t.pokemon_ids, t.count))
+            bin_reply_error(rep, STATUS_NOT_FOUND, "Trainer not updated.");
+        break;
+
+    case BIN_OP_DELETE_TRAINER:
+        if (req->length != 4)
+            bin_reply_error(rep, STATUS_INVALID, "Payload must be an int32 ID.");
+        else if (!delete_trainer(arg))
+            bin_reply_error(rep, STATUS_NOT_FOUND, "Trainer not found.");
+        break;
+
+    case BIN_OP_GET_LOG: {
+        char *text = logger_tail(logger, arg > 0 ? arg : 10);
+        if (!text) {
+            bin_reply_error(rep, STATUS_FAILURE, "Could not read log file.");
+        } else {
+            bin_reply_append(rep, text, strlen(text));
+            free(text);
+        }
+        break;
+    }
+
+    case BIN_OP_EXIT:
+        return SESSION_CLOSE;
+
+    default:
+        bin_reply_error(rep, STATUS_UNSUPPORTED, "Unknown opcode.");
+        break;
+    }
+    return SESSION_CONTINUE;
+}
+
+/**
+ * \brief Execute one binary request, counted under its text command's class.
+ *
+ * \return SessionAction from dispatch_binary().
+ */
+static int process_binary(const char *ip, int port, const BinHeader *req,
+                          const uint8_t *payload, BinReply *rep) {
+    metric_cmd_t kind;
+    switch (req->opcode) {
+    case BIN_OP_GET_POKEMON:    kind = MCMD_GET_POKEMON;     break;
+    case BIN_OP_GET_TRAINER:    kind = MCMD_GET_TRAINER;     break;
+    case BIN_OP_LIST_TRAINERS:  kind = MCMD_LIST_TRAINERS;   break;
+    case BIN_OP_POST_TRAINER:   kind = MCMD_POST_TRAINER;    break;
+    case BIN_OP_PUT_TRAINER:    kind = MCMD_PUT_TRAINER;     break;
+    case BIN_OP_DELETE_TRAINER: kind = MCMD_DELETE_TRAINER;  break;
+    case BIN_OP_GET_LOG:        kind = MCMD_GET_LOG;         break;
+    default:                    kind = MCMD_OTHER;           break;
+    }
+
+    uint64_t start = metrics_now();
+    pokedex = pokedex_enter();
+    int action = dispatch_binary(ip, port, req, payload, rep);
+    pokedex_exit();
+    pokedex = NULL;
+    metrics_command(kind, metrics_now() - start);
+    return action;
+}
+
+/* ========================================================================== */
+/* ========================== Reactor Entry Points ========================== */
+/* ========================================================================== */
+
+/**
+ * \brief Text handler for the epoll front end: defer the WAL commit.
+ *
+ * A reactor must not sleep in fdatasync(), so mutations return once logged
+ * and the reply carries the LSN the reactor holds it back for.
+ */
+static int reactor_command(const char *ip, int port, const char *line, Response *res) {
+    trainer_db_defer_commits(1);
+    int action = process_command(ip, port, line, res);
+    res->commit_lsn = trainer_db_take_commit();
+    return action;
+}
+
+/**
+ * \brief Binary handler for the epoll front end (see reactor_command()).
+ */
+static int reactor_binary(const char *ip, int port, const BinHeader *req,
+                          const uint8_t *payload, BinReply *rep) {
+    trainer_db_defer_commits(1);
+    int action = process_binary(ip, port, req, payload, rep);
+    rep->commit_lsn = trainer_db_take_commit();
+    return action;
+}
+
+/**
+ * \brief Poll a deferred trainer commit (reactor_commit_fn).
+ */
+static int reactor_commit(uint64_t lsn) {
+    return trainer_store_commit_status(trainers, lsn);
+}
+
+/* ========================================================================== */
+/* ============================ Client Thread =============================== */
+/* ========================================================================== */
+
+/*!< Struct passed to each client-handling thread; it lives as long as the session. */
+typedef struct client_args {
+    int connfd;                     /*!< Connected client socket */
+    struct sockaddr_in addr;       /*!< Client address info */
+    struct client_args  *next;      /*!< Next live session */
+    struct client_args **pprev;     /*!< Link pointing here */
+} client_args_t;
+
+/*!< Sessions accepted and not yet finished (queued ones included). */
+static client_args_t *sessions = NULL;
+static pthread_mutex_t sessions_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t sessions_done = PTHREAD_COND_INITIALIZER;
+
+/**
+ * \brief Record an accepted session before it is handed to a thread.
+ */
+static void session_register(client_args_t *c) {
+    pthread_mutex_lock(&sessions_mutex);
+    c->next = sessions;
+    if (sessions) sessions->pprev = &c->next;
+    sessions = c;
+    c->pprev = &sessions;
+    pthread_mutex_unlock(&sessions_mutex);
+}
+
+/**
+ * \brief Drop a finished session; call before closing its socket.
+ */
+static void session_unregister(client_args_t *c) {
+    pthread_mutex_lock(&sessions_mutex);
+    *c->pprev = c->next;
+    if (c->next) c->next->pprev = c->pprev;
+    if (!sessions)
+        pthread_cond_broadcast(&sessions_done);
+    pthread_mutex_unlock(&sessions_mutex);
+}
+
+/**
+ * \brief Shut every session down and wait until all have finished.
+ *
+ * \note  Reads are shut first, so a session finishes the replies it is
+ *        sending and then sees end-of-input. After SESSION_DRAIN_MS the
+ *        sockets are shut both ways, which fails any send still blocked on
+ *        a client that stopped reading.
+ */
+static void sessions_drain(void) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += SESSION_DRAIN_MS / 1000;
+    deadline.tv_nsec += (long)(SESSION_DRAIN_MS % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&sessions_mutex);
+    for (client_args_t *c = sessions; c; c = c->next)
+        shutdown(c->connfd, SHUT_RD);
+    while (sessions &&
+           pthread_cond_timedwait(&sessions_done, &sessions_mutex, &deadline) != ETIMEDOUT)
+        ;
+    for (client_args_t *c = sessions; c; c = c->next)
+        shutdown(c->connfd, SHUT_RDWR);
+    while (sessions)
+        pthread_cond_wait(&sessions_done, &sessions_mutex);
+    pthread_mutex_unlock(&sessions_mutex);
+}
+
+/**
+ * \brief Serve a connection that negotiated the binary protocol.
+ *
+ * \param[out] payload  Scratch of BIN_MAX_REQUEST bytes (a batch buffer).
+ *
+ * \note  Bytes the client pipelined after "proto binary" are already in
+ *        \p reader and are consumed first.
+ */
+static void binary_session(const char *ip, int port, line_reader_t *reader, int zc,
+                           uint8_t *payload) {
+    uint8_t raw[BIN_HEADER_SIZE];
+    BinHeader req;
+    BinReply rep;
+
+    while (running) {
+        if (line_reader_read_exact(reader, raw, sizeof(raw)) <= 0)
+            return;
+
+        int bad = bin_header_decode(raw, &req) < 0 || req.length > BIN_MAX_REQUEST;
+        if (!bad && req.length > 0 &&
+            line_reader_read_exact(reader, payload, req.length) <= 0)
+            return;
+
+        bin_reply_init(&rep, req.opcode);
+        int action = SESSION_CLOSE;
+        if (bad)
+            bin_reply_error(&rep, STATUS_INVALID, "Bad frame header.");
+        else
+            action = process_binary(ip, port, &req, payload, &rep);
+
+        struct iovec iov = { .iov_base = rep.frame, .iov_len = bin_reply_finish(&rep) };
+        ssize_t sent = send_iov(reader->fd, &iov, 1, zc);
+        bin_reply_free(&rep);
+
+        /* A bad header loses framing, so the connection cannot continue */
+        if (sent < 0 || action == SESSION_CLOSE)
+            return;
+    }
+}
+
+/**
+ * \brief Thread routine servicing a single connected client.
+ */
+static void *client_thread(void *arg) {
+    client_args_t *c = arg;
+    int connfd = c->connfd;
+    struct sockaddr_in client_addr = c->addr;
+
+    char ip[64];
+    inet_ntop(AF_INET, &client_addr.sin_addr, ip, sizeof(ip));
+    int port = ntohs(client_addr.sin_port);
+
+    printf("[Server] Client connected: %s:%d (thread %lu)\n",
+           ip, port, pthread_self());
+    metrics_conn_open();
+
+    /* Every reply leaves in one sendmsg(), so Nagle would only add delay */
+    socket_set_nodelay(connfd, 1);
+    int zc = zerocopy_replies && socket_enable_zerocopy(connfd) == 0;
+
+    /* Session state lives in slabs, so the thread stack can stay small */
+    line_reader_t *reader = slab_alloc(&session_slab);
+    Response *res = slab_alloc(&response_slab);
+    char *out = NULL;
+    int done = SESSION_CONTINUE;
+    if (!reader || !res)
+        goto disconnect;
+    line_reader_init(reader, connfd);
+
+    while (running && done == SESSION_CONTINUE) {
+
+        /* One recv() may carry several pipelined commands */
+        if (line_reader_fill(reader) <= 0)
+            break;
+
+        /* The batch buffer is only held while replies are being built */
+        if (!(out = slab_alloc(&batch_slab)))
+            break;
+
+        char *line;
+        size_t len, outlen = 0;
+
+        /* Answer every complete buffered line, in order, before replying */
+        while (done == SESSION_CONTINUE && line_reader_next(reader, &line, &len)) {
+            trim_newline(line);
+
+            memset(res, 0, sizeof(*res));
+            done = process_command(ip, port, line, res);
+
+            /* Large reply: batch, body and marker leave in one sendmsg() */
+            if (res->body) {
+                struct iovec iov[1 + RESPONSE_IOV];
+                iov[0].iov_base = out;
+                iov[0].iov_len = outlen;
+                int cnt = 1 + response_iov(iov + 1, res->body, strlen(res->body));
+                int failed = send_iov(connfd, iov, cnt, zc) < 0;
+                free(res->body);
+                if (failed)
+                    goto disconnect;
+                outlen = 0;
+                continue;
+            }
+
+            /* Streamed reply: cork so the batch and the first chunk share
+             * segments; once sent, the batch buffer holds the chunks */
+            if (res->stream) {
+                socket_set_cork(connfd, 1);
+                int failed = (outlen > 0 && send_bytes(connfd, out, outlen) < 0) ||
+                             send_stream(connfd, res->stream, res->stream_ctx, out) < 0;
+                socket_set_cork(connfd, 0);
+                if (res->stream_free) res->stream_free(res->stream_ctx);
+                else free(res->stream_ctx);
+                if (failed)
+                    goto disconnect;
+                outlen = 0;
+                continue;
+            }
+
+            size_t n = frame_response(out + outlen, SESSION_BATCH_BYTES - outlen, res->message);
+            if (n == 0) {
+                /* Batch full: flush it, then retry into the empty buffer */
+                if (outlen > 0 && send_bytes(connfd, out, outlen) < 0)
+                    goto disconnect;
+                outlen = 0;
+                n = frame_response(out, SESSION_BATCH_BYTES, res->message);
+            }
+            outlen += n;
+        }
+
+        int failed = outlen > 0 && send_bytes(connfd, out, outlen) < 0;
+        slab_free(&batch_slab, out);
+        out = NULL;
+        if (failed)
+            break;
+    }
+
+    /* The text batch is done with, so its buffer holds binary payloads */
+    if (done == SESSION_BINARY && (out = slab_alloc(&batch_slab)))
+        binary_session(ip, port, reader, zc, (uint8_t *)out);
+
+disconnect:
+    printf("[Server] Client disconnected: %s:%d\n", ip, port);
+    metrics_conn_close();
+    slab_free(&batch_slab, out);
+    slab_free(&response_slab, res);
+    slab_free(&session_slab, reader);
+    session_unregister(c);
+    close(connfd);
+    free(c);
+    return NULL;
+}
+
+/**
+ * \brief Worker-pool task adapter: run one queued client session.
+ */
+static void client_task(void *arg) {
+    client_thread(arg);
+}
+
+/**
+ * \brief Turn away a connection the worker pool has no room for.
+ */
+static void reject_client(int connfd) {
+    send_response(connfd, "Server busy. Try again later.");
+    close(connfd);
+}
+
+/* ========================================================================== */
+/* ================================= main ================================== */
+/* ========================================================================== */
+
+int main(int argc, char *argv[]) {
+    signal(SIGPIPE, SIG_IGN);               /* Prevent abrupt termination when client disconnects */
+    signal(SIGINT, server_sigint_handler);  /* Install graceful shutdown handler */
+    signal(SIGHUP, server_sighup_handler);  /* Reopen the log after rotation */
+
+    char port[32] = {0};
+    char logname[128] = {0};
+    int got_p=0, got_m=0, got_t=0, got_l=0;
+    int use_epoll = 0;      /* -e epoll selects the reactor front end */
+    int reactors = 0;       /* -r reactor thread count (0 → one per core) */
+    int workers = 0;        /* -w worker pool size (0 → thread per client) */
+    int queue_depth = 64;   /* -q pending connections the pool will hold */
+    double compact_ratio = 0; /* -c dead-slot ratio that triggers compaction */
+    int log_flush_ms = LOG_FLUSH_MS_DEFAULT;    /* -f logger wake-up period */
+    log_fsync_t log_fsync = LOG_FSYNC_NONE;     /* -y log durability policy */
+    int commit_ms = TRAINER_WAL_COMMIT_MS_DEFAULT; /* -g trainer WAL commit window */
+    const char *restore_from = NULL;    /* -s snapshot to start from */
+    const char *metrics_port = NULL;    /* -M Prometheus scrape port */
+    long cache_size = TRAINER_CACHE_DEFAULT;   /* -C cached trainer replies */
+    int stack_kb = SESSION_STACK_KB_DEFAULT;    /* -k session thread stack */
+    int shards = 1;         /* -S trainer shard files */
+    const char *repl_listen = NULL;     /* -R port replicas connect to */
+    const char *repl_primary = NULL;    /* -P primary this replica follows */
+
+    /* Parse command-line arguments (order-independent) */
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-p") == 0 && i+1 < argc) {
+            strncpy(port, argv[++i], 31);
+            got_p=1;
+        } else if (strcmp(argv[i], "-m") == 0 && i+1 < argc) {
+            strncpy(pokemon_path, argv[++i], 255);
+            got_m=1;
+        } else if (strcmp(argv[i], "-t") == 0 && i+1 < argc) {
+            strncpy(trainer_path, argv[++i], 255);
+            got_t=1;
+        } else if (strcmp(argv[i], "-l") == 0 && i+1 < argc) {
+            strncpy(logname, argv[++i], 127);
+            got_l=1;
+        } else if (strcmp(argv[i], "-e") == 0 && i+1 < argc) {
+            const char *mode = argv[++i];
+            if (strcmp(mode, "epoll") == 0) {
+                use_epoll = 1;
+            } else if (strcmp(mode, "threads") != 0) {
+                print_usage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-r") == 0 && i+1 < argc) {
+            reactors = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-w") == 0 && i+1 < argc) {
+            workers = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-q") == 0 && i+1 < argc) {
+            queue_depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0 && i+1 < argc) {
+            compact_ratio = atof(argv[++i]);
+        } else if (strcmp(argv[i], "-f") == 0 && i+1 < argc) {
+            log_flush_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-y") == 0 && i+1 < argc) {
+            if (logger_parse_fsync(argv[++i], &log_fsync) < 0) {
+                print_usage();
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-g") == 0 && i+1 < argc) {
+            commit_ms = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-s") == 0 && i+1 < argc) {
+            restore_from = argv[++i];
+        } else if (strcmp(argv[i], "-M") == 0 && i+1 < argc) {
+            metrics_port = argv[++i];
+        } else if (strcmp(argv[i], "-C") == 0 && i+1 < argc) {
+            cache_size = atol(argv[++i]);
+        } else if (strcmp(argv[i], "-k") == 0 && i+1 < argc) {
+            stack_kb = atoi(argv[++i]);
+            if (stack_kb < SESSION_STACK_KB_MIN) {
+                fprintf(stderr, "[Server] -k must be at least %d (KB).\n",
+                        SESSION_STACK_KB_MIN);
+                return 1;
+            }
+        } else if (strcmp(argv[i], "-u") == 0) {
+            storage_ring_disable();
+        } else if (strcmp(argv[i], "-z") == 0) {
+            zerocopy_replies = 1;
+        } else if (strcmp(argv[i], "-S") == 0 && i+1 < argc) {
+            shards = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-R") == 0 && i+1 < argc) {
+            repl_listen = argv[++i];
+        } else if (strcmp(argv[i], "-P") == 0 && i+1 < argc) {
+            repl_primary = argv[++i];
+        }
+    }
+
+    if (!got_p || !got_m || !got_t || !got_l || (repl_listen && repl_primary)) {
+        print_usage();
+        return 1;
+    }
+
+    /* Normalize trainer file name */
+    if (strcmp(trainer_path, "trainer.bin") == 0)
+        strcpy(trainer_path, "trainers.bin");
+
+    /* Resolve log file output path */
+    if (strchr(logname, '/'))
+        snprintf(log_path, sizeof(log_path), "%s", logname);
+    else
+        snprintf(log_path, sizeof(log_path), "data/%s", logname);
+
+    /* Start the background log writer before any request can arrive */
+    logger = logger_open(log_path, log_flush_ms, log_fsync);
+    if (!logger) return 1;
+
+    /* Load the read-only Pokémon catalog once for all threads */
+    const PokemonDB *catalog = pokedex_open(pokemon_path);
+    if (!catalog) return 1;
+    printf("[Server] Loaded %d Pokémon from %s\n", catalog->count, pokemon_path);
+
+    /* Warm start: the snapshot replaces the trainer file and its log */
+    if (restore_from) {
+        long restored = trainer_store_restore(trainer_path, shards, restore_from);
+        if (restored < 0) return 1;
+        printf("[Server] Restored %ld trainer(s) from snapshot %s\n", restored, restore_from);
+    }
+
+    /* Report the storage backend the reactors and WAL committer will use */
+    storage_ring_t *probe = storage_ring_create();
+    printf("[Server] Trainer storage I/O: %s\n", probe ? "io_uring" : "synchronous");
+    storage_ring_destroy(probe);
+
+    /* Open (creating if needed) and index every trainer shard */
+    trainers = trainer_store_open(trainer_path, shards);
+    if (!trainers) return 1;
+    if (shards > 1)
+        printf("[Server] Indexed %zu trainer(s) from %s.0-%d\n",
+               trainer_store_live(trainers), trainer_path, shards - 1);
+    else
+        printf("[Server] Indexed %zu trainer(s) from %s\n",
+               trainer_store_live(trainers), trainer_path);
+
+    /* Recover acknowledged writes, then acknowledge only after commit */
+    long replayed = trainer_store_enable_wal(trainers, commit_ms);
+    if (replayed < 0) {
+        fprintf(stderr, "[Server] Could not open the trainer WAL.\n");
+        return 1;
+    }
+    if (replayed > 0)
+        printf("[Server] Replayed %ld trainer WAL record(s)\n", replayed);
+
+    /* Rendered replies for hot trainers; -C 0 renders every request */
+    if (cache_size > 0) {
+        trainer_replies = trainer_cache_create((size_t)cache_size);
+        if (!trainer_replies) {
+            fprintf(stderr, "[Server] Could not allocate the trainer reply cache.\n");
+            return 1;
+        }
+    }
+
+    /* Ship committed batches to replicas, or follow a primary read-only */
+    if (repl_listen) {
+        if (repl_primary_start(repl_listen, trainers, trainer_path) < 0) {
+            fprintf(stderr, "[Server] Could not start the replication listener.\n");
+            return 1;
+        }
+        printf("[Server] Replication: primary, replicas connect to port %s\n", repl_listen);
+    } else if (repl_primary) {
+        if (repl_replica_start(repl_primary, trainers, replicated_change) < 0) {
+            fprintf(stderr, "[Server] -P expects <primary_host:port>.\n");
+            return 1;
+        }
+        printf("[Server] Replication: read-only replica of %s\n", repl_primary);
+    }
+
+    /* Optional background compaction of tombstoned slots */
+    if (compact_ratio > 0 &&
+        trainer_store_start_compactor(trainers, compact_ratio) < 0)
+        fprintf(stderr, "[Server] Could not start trainer compactor.\n");
+
+    /* Optional scrape endpoint; "get stats" works either way */
+    if (metrics_port) {
+        if (metrics_start_http(metrics_port) < 0) {
+            fprintf(stderr, "[Server] Could not start metrics endpoint.\n");
+            return 1;
+        }
+        printf("[Server] Metrics: GET /metrics on port %s\n", metrics_port);
+    }
+
+    /* Event-driven mode: reactor threads own their own listeners */
+    if (use_epoll) {
+        /* Returns once every reactor has drained and closed its connections */
+        int rc = reactor_run(port, reactors, reactor_command, reactor_binary,
+                             reactor_commit, &running);
+        trainer_store_checkpoint(trainers);
+        logger_close(logger);
+        if (rc < 0)
+            return 1;
+        printf("[Server] Shutdown complete.\n");
+        return 0;
+    }
+
+    /* Create and bind the listening socket */
+    listenfd = create_server_socket(port);
+    if (listenfd < 0) return 1;
+
+    printf("[Server] Listening on port %s ...\n", port);
+
+    /* Session threads keep their buffers in slabs, so small stacks suffice */
+    slab_init(&session_slab, sizeof(line_reader_t), SESSION_SLAB_CHUNK);
+    slab_init(&response_slab, sizeof(Response), SESSION_SLAB_CHUNK);
+    slab_init(&batch_slab, SESSION_BATCH_BYTES, SESSION_SLAB_CHUNK);
+
+    pthread_attr_t session_attr;
+    pthread_attr_init(&session_attr);
+    size_t stack = (size_t)stack_kb * 1024;
+    if (stack < PTHREAD_STACK_MIN) stack = PTHREAD_STACK_MIN;
+    if (pthread_attr_setstacksize(&session_attr, stack) != 0)
+        fprintf(stderr, "[Server] Invalid stack size; using the default.\n");
+
+    /* Optional fixed worker pool instead of a thread per connection */
+    worker_pool_t pool;
+    if (workers > 0) {
+        if (queue_depth < 1) queue_depth = 1;
+        if (pool_init(&pool, workers, (size_t)queue_depth, client_task,
+                      &session_attr) < 0) {
+            fprintf(stderr, "[Server] Could not start worker pool.\n");
+            return 1;
+        }
+        printf("[Server] Worker pool: %d thread(s), queue depth %zu\n",
+               pool.nthreads, pool.queue.mask + 1);
+    }
+
+    /* ====================== Accept Loop ====================== */
+    while (running) {
+        struct sockaddr_in client_addr;
+        socklen_t len = sizeof(client_addr);
+        int connfd = accept(listenfd, (struct sockaddr*)&client_addr, &len);
+
+        if (connfd < 0) {
+            if (!running) break;
+            if (errno == EINTR) continue;
+            perror("accept");
+            continue;
+        }
+
+        /* Allocate argument block for thread */
+        client_args_t *args = malloc(sizeof(client_args_t));
+        if (!args) {
+            reject_client(connfd);
+            continue;
+        }
+        args->connfd = connfd;
+        args->addr = client_addr;
+
+        /* Pool mode: queue the session, shed it when the queue is full */
+        session_register(args);
+        if (workers > 0) {
+            if (pool_submit(&pool, args) < 0) {
+                session_unregister(args);
+                free(args);
+                reject_client(connfd);
+            }
+            continue;
+        }
+
+        pthread_t tid;
+        if (pthread_create(&tid, &session_attr, client_thread, args) != 0) {
+            perror("[Server] pthread_create()");
+            session_unregister(args);
+            free(args);
+            reject_client(connfd);
+            continue;
+        }
+
+        /* Detached thread cleans itself up */
+        pthread_detach(tid);
+    }
+
+    /* Queued sessions still run; every session ends before the checkpoint */
+    if (workers > 0)
+        pool_shutdown(&pool);
+    sessions_drain();
+
+    /* Leave trainers.bin durable and the WAL empty */
+    trainer_store_checkpoint(trainers);
+
+    /* Flush whatever the writer has not yet written */
+    logger_close(logger);
+
+    printf("[Server] Shutdown complete.\n");
+    return 0;
+}
@@ -0,0 +1,114 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: slab.c                                          #
+# Purpose:                                                   #
+#     Implements the fixed-size object allocator. A chunk   #
+#     is one malloc() holding a small header followed by    #
+#     per_chunk objects; the free list is threaded through  #
+#     the objects themselves.                               #
+#############################################################
+# Citations:                                                #
+# [1] Bonwick, J. "The Slab Allocator: An Object-Caching    #
+#     Kernel Memory Allocator" (USENIX 1994)                #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdlib.h>     /* malloc, free */
+
+#include "slab.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Object alignment (malloc()'s guarantee on x86-64). */
+#define SLAB_ALIGN      16
+
+/*!< Chunk header size; keeps the first object aligned. */
+#define SLAB_HEADER     SLAB_ALIGN
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Prepare a slab for \p obj_size objects, \p per_chunk at a time.
+ */
+void slab_init(slab_t *s, size_t obj_size, size_t per_chunk) {
+    if (obj_size < sizeof(void *)) obj_size = sizeof(void *);
+    s->obj_size = (obj_size + SLAB_ALIGN - 1) & ~(size_t)(SLAB_ALIGN - 1);
+    s->per_chunk = per_chunk ? per_chunk : 1;
+    s->free_list = NULL;
+    s->chunks = NULL;
+    s->live = 0;
+    s->total = 0;
+    pthread_mutex_init(&s->mutex, NULL);
+}
+
+/**
+ * \brief           Release every chunk.
+ */
+void slab_destroy(slab_t *s) {
+    void *chunk = s->chunks;
+    while (chunk) {
+        void *next = *(void **)chunk;
+        free(chunk);
+        chunk = next;
+    }
+    s->chunks = NULL;
+    s->free_list = NULL;
+    pthread_mutex_destroy(&s->mutex);
+}
+
+/**
+ * \brief           Take one object, carving a new chunk when none is free.
+ */
+void *slab_alloc(slab_t *s) {
+    pthread_mutex_lock(&s->mutex);
+    if (!s->free_list) {
+        char *chunk = malloc(SLAB_HEADER + s->obj_size * s->per_chunk);
+        if (!chunk) {
+            pthread_mutex_unlock(&s->mutex);
+            return NULL;
+        }
+        *(void **)chunk = s->chunks;
+        s->chunks = chunk;
+
+        /* Thread the new objects onto the free list, first object on top */
+        for (size_t i = s->per_chunk; i-- > 0; ) {
+            void *obj = chunk + SLAB_HEADER + i * s->obj_size;
+            *(void **)obj = s->free_list;
+            s->free_list = obj;
+        }
+        s->total += s->per_chunk;
+    }
+
+    void *obj = s->free_list;
+    s->free_list = *(void **)obj;
+    s->live++;
+    pthread_mutex_unlock(&s->mutex);
+    return obj;
+}
+
+/**
+ * \brief           Return an object to the free list.
+ */
+void slab_free(slab_t *s, void *obj) {
+    if (!obj) return;
+    pthread_mutex_lock(&s->mutex);
+    *(void **)obj = s->free_list;
+    s->free_list = obj;
+    s->live--;
+    pthread_mutex_unlock(&s->mutex);
+}
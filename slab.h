@@ -0,0 +1,83 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: slab.h                                          #
+# Purpose:                                                   #
+#     Declares a fixed-size object allocator. Objects are   #
+#     carved from large chunks and recycled through a free  #
+#     list, so per-connection state and borrowed reply      #
+#     buffers cost one list pop instead of a malloc() and   #
+#     carry no per-allocation header.                       #
+#############################################################
+# Citations:                                                #
+# [1] Bonwick, J. "The Slab Allocator: An Object-Caching    #
+#     Kernel Memory Allocator" (USENIX 1994)                #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <stddef.h>     /* size_t */
+#include <pthread.h>    /* pthread_mutex_t */
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Allocator for objects of one size.
+ *
+ * \note            Freed objects stay cached for reuse, so memory tracks the
+ *                  peak number live at once. The mutex is uncontended when
+ *                  one thread owns the slab (a reactor) and short when a
+ *                  pool is shared.
+ */
+typedef struct {
+    pthread_mutex_t mutex;          /*!< Guards the lists and counters */
+    size_t      obj_size;           /*!< Object size, rounded for alignment */
+    size_t      per_chunk;          /*!< Objects carved from each chunk */
+    void       *free_list;          /*!< Freed objects, linked through their first word */
+    void       *chunks;             /*!< Every chunk, linked through its header */
+    size_t      live;               /*!< Objects handed out */
+    size_t      total;              /*!< Objects carved so far */
+} slab_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Prepare a slab for \p obj_size objects, \p per_chunk at a time.
+ */
+void slab_init(slab_t *s, size_t obj_size, size_t per_chunk);
+
+/**
+ * \brief           Release every chunk, including objects still handed out.
+ */
+void slab_destroy(slab_t *s);
+
+/**
+ * \brief           Take one object (contents undefined).
+ *
+ * \return          Object aligned to 16 bytes, or NULL if a chunk could not
+ *                  be allocated.
+ */
+void *slab_alloc(slab_t *s);
+
+/**
+ * \brief           Return an object from slab_alloc() to \p s.
+ */
+void slab_free(slab_t *s, void *obj);
+
+#endif /* SLAB_H */
@@ -0,0 +1,401 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: storage_ring.c                                  #
+# Purpose:                                                   #
+#     Implements the io_uring storage backend on the raw    #
+#     system calls: the rings are mapped once, submissions  #
+#     are published with a release store of the SQ tail,    #
+#     and completions are matched to their ops by index.    #
+#     Builds without <linux/io_uring.h> keep only the       #
+#     synchronous path.                                     #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: io_uring_setup(2), io_uring_enter(2) #
+#     https://man7.org/linux/man-pages/                     #
+# [2] Axboe, J. "Efficient IO with io_uring" (2019)         #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdlib.h>     /* calloc, free */
+#include <string.h>     /* memset */
+#include <stdint.h>     /* uintptr_t */
+#include <errno.h>      /* errno, EINTR, EAGAIN, EBUSY */
+#include <limits.h>     /* INT_MIN */
+#include <sched.h>      /* sched_yield */
+#include <unistd.h>     /* close, fdatasync, syscall */
+#include <stdatomic.h>  /* atomic_load_explicit, atomic_store_explicit */
+
+#include "storage_ring.h"
+#include "common.h"
+
+#if defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define STORAGE_RING_URING 1
+#endif
+#endif
+
+#ifdef STORAGE_RING_URING
+#include <sys/mman.h>       /* mmap, munmap */
+#include <sys/syscall.h>    /* __NR_io_uring_setup, __NR_io_uring_enter */
+#include <linux/io_uring.h> /* io_uring_params, io_uring_sqe, io_uring_cqe */
+#endif
+
+/*!< Set by storage_ring_disable(). */
+static atomic_int ring_disabled;
+
+/*!< The calling thread's ring for storage_io_batch(), if any. */
+static __thread storage_ring_t *bound_ring;
+
+/* ========================================================================== */
+/* ============================ Synchronous Path ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Finish \p op with pread()/pwrite(), after \p done bytes.
+ */
+static void op_finish_sync(storage_op_t *op, size_t done) {
+    char *at = (char *)op->buf + done;
+    off_t off = op->off + (off_t)done;
+    ssize_t got = op->write ? safe_pwrite(op->fd, at, op->len - done, off)
+                            : safe_pread(op->fd, at, op->len - done, off);
+    op->result = got < 0 ? -1 : (ssize_t)done + got;
+}
+
+/**
+ * \brief           write() then fdatasync(), the path without a ring.
+ */
+static int append_sync_plain(int fd, const void *buf, size_t len) {
+    if (safe_write(fd, buf, len) != (ssize_t)len) return -1;
+    return fdatasync(fd);
+}
+
+#ifdef STORAGE_RING_URING
+
+/* ========================================================================== */
+/* ================================== Ring ================================== */
+/* ========================================================================== */
+
+struct storage_ring {
+    int         fd;                 /*!< io_uring instance */
+    unsigned    tail;               /*!< Local SQ tail, published on submit */
+    unsigned    entries;            /*!< SQ size */
+    _Atomic unsigned *sq_head;      /*!< Advanced by the kernel */
+    _Atomic unsigned *sq_tail;      /*!< Advanced by us */
+    unsigned   *sq_mask;
+    unsigned   *sq_array;           /*!< SQ slot -> SQE index */
+    _Atomic unsigned *cq_head;      /*!< Advanced by us */
+    _Atomic unsigned *cq_tail;      /*!< Advanced by the kernel */
+    unsigned   *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void       *sq_map;             /*!< SQ ring mapping (and CQ if single) */
+    size_t      sq_map_len;
+    void       *cq_map;             /*!< CQ ring mapping */
+    size_t      cq_map_len;
+    size_t      sqes_len;           /*!< SQE array mapping length */
+    int         dead;               /*!< io_uring_enter() failed; never reused */
+};
+
+/*!< Completion result of an op the kernel never took (see ring_abort()). */
+#define RING_UNSENT     INT_MIN
+
+/**
+ * \brief           Claim the next SQE (zeroed); visible only after ring_wait().
+ */
+static struct io_uring_sqe *ring_sqe(storage_ring_t *r, uint64_t user_data) {
+    unsigned idx = r->tail & *r->sq_mask;
+    struct io_uring_sqe *sqe = &r->sqes[idx];
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->user_data = user_data;
+    r->sq_array[idx] = idx;
+    r->tail++;
+    return sqe;
+}
+
+/**
+ * \brief           Retire \p r after io_uring_enter() failed mid-batch.
+ *
+ * \param[in]       count       Completions the batch expects.
+ * \param[in]       reaped      Completions already passed to \p on_cqe.
+ *
+ * \note            SQEs the kernel has not taken yet are withdrawn (without
+ *                  SQPOLL it only reads the SQ inside io_uring_enter()), and
+ *                  every one it did take is waited for, so no completion can
+ *                  land in a caller's buffer after return or be left for a
+ *                  later batch. Ops never sent keep their RING_UNSENT result.
+ */
+static void ring_abort(storage_ring_t *r, unsigned count, unsigned reaped,
+                       void (*on_cqe)(void *ctx, uint64_t user_data, int res), void *ctx) {
+    unsigned head = atomic_load_explicit(r->sq_head, memory_order_acquire);
+    unsigned sent = count - (r->tail - head);
+    r->tail = head;
+    atomic_store_explicit(r->sq_tail, head, memory_order_release);
+    r->dead = 1;
+
+    while (reaped < sent) {
+        unsigned ch = atomic_load_explicit(r->cq_head, memory_order_relaxed);
+        unsigned ct = atomic_load_explicit(r->cq_tail, memory_order_acquire);
+        for (; ch != ct && reaped < sent; ch++, reaped++) {
+            struct io_uring_cqe *cqe = &r->cqes[ch & *r->cq_mask];
+            on_cqe(ctx, cqe->user_data, cqe->res);
+        }
+        atomic_store_explicit(r->cq_head, ch, memory_order_release);
+        if (reaped == sent) break;
+
+        /* Posting does not depend on enter, so poll if it keeps failing */
+        if (syscall(__NR_io_uring_enter, r->fd, 0, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0)
+            sched_yield();
+    }
+}
+
+/**
+ * \brief           Publish the claimed SQEs and reap \p count completions.
+ *
+ * \param[in]       on_cqe      Called with each completion's user_data and res.
+ *
+ * \return          0 once all \p count completed, -1 if io_uring_enter() failed;
+ *                  the ring is then dead and nothing of the batch is in flight.
+ *
+ * \note            Pending submissions are recomputed from the kernel's SQ
+ *                  head on every pass, so an interrupted enter is resumed
+ *                  without submitting anything twice.
+ */
+static int ring_wait(storage_ring_t *r, unsigned count,
+                     void (*on_cqe)(void *ctx, uint64_t user_data, int res), void *ctx) {
+    atomic_store_explicit(r->sq_tail, r->tail, memory_order_release);
+
+    unsigned reaped = 0;
+    while (reaped < count) {
+        unsigned head = atomic_load_explicit(r->cq_head, memory_order_relaxed);
+        unsigned tail = atomic_load_explicit(r->cq_tail, memory_order_acquire);
+        for (; head != tail && reaped < count; head++, reaped++) {
+            struct io_uring_cqe *cqe = &r->cqes[head & *r->cq_mask];
+            on_cqe(ctx, cqe->user_data, cqe->res);
+        }
+        atomic_store_explicit(r->cq_head, head, memory_order_release);
+        if (reaped == count) break;
+
+        unsigned pending = r->tail - atomic_load_explicit(r->sq_head, memory_order_acquire);
+        if (syscall(__NR_io_uring_enter, r->fd, pending, 1, IORING_ENTER_GETEVENTS, NULL, 0) < 0 &&
+            errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            ring_abort(r, count, reaped, on_cqe, ctx);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * \brief           Set up an io_uring instance of STORAGE_RING_DEPTH entries.
+ */
+storage_ring_t *storage_ring_create(void) {
+    if (atomic_load(&ring_disabled)) return NULL;
+
+    struct io_uring_params p;
+    memset(&p, 0, sizeof(p));
+    int fd = (int)syscall(__NR_io_uring_setup, STORAGE_RING_DEPTH, &p);
+    if (fd < 0) return NULL;
+
+    /* 5.6+: IORING_OP_READ/WRITE exist and offset -1 means "file position" */
+    if (!(p.features & IORING_FEAT_RW_CUR_POS)) {
+        close(fd);
+        return NULL;
+    }
+
+    storage_ring_t *r = calloc(1, sizeof(*r));
+    if (!r) {
+        close(fd);
+        return NULL;
+    }
+    r->fd = fd;
+    r->entries = p.sq_entries;
+    r->sq_map = r->cq_map = MAP_FAILED;
+    r->sqes = MAP_FAILED;
+
+    r->sq_map_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    r->cq_map_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    int single = (p.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && r->cq_map_len > r->sq_map_len) r->sq_map_len = r->cq_map_len;
+
+    r->sq_map = mmap(NULL, r->sq_map_len, PROT_READ | PROT_WRITE,
+                     MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (r->sq_map != MAP_FAILED)
+        r->cq_map = single ? r->sq_map
+                           : mmap(NULL, r->cq_map_len, PROT_READ | PROT_WRITE,
+                                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    r->sqes_len = p.sq_entries * sizeof(struct io_uring_sqe);
+    r->sqes = mmap(NULL, r->sqes_len, PROT_READ | PROT_WRITE,
+                   MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES);
+    if (r->sq_map == MAP_FAILED || r->cq_map == MAP_FAILED || r->sqes == MAP_FAILED) {
+        storage_ring_destroy(r);
+        return NULL;
+    }
+
+    char *sq = r->sq_map, *cq = r->cq_map;
+    r->sq_head  = (_Atomic unsigned *)(sq + p.sq_off.head);
+    r->sq_tail  = (_Atomic unsigned *)(sq + p.sq_off.tail);
+    r->sq_mask  = (unsigned *)(sq + p.sq_off.ring_mask);
+    r->sq_array = (unsigned *)(sq + p.sq_off.array);
+    r->cq_head  = (_Atomic unsigned *)(cq + p.cq_off.head);
+    r->cq_tail  = (_Atomic unsigned *)(cq + p.cq_off.tail);
+    r->cq_mask  = (unsigned *)(cq + p.cq_off.ring_mask);
+    r->cqes     = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+    r->tail     = atomic_load_explicit(r->sq_tail, memory_order_relaxed);
+    return r;
+}
+
+/**
+ * \brief           Unmap and close a ring; NULL is ignored.
+ */
+void storage_ring_destroy(storage_ring_t *r) {
+    if (!r) return;
+    if (r->sqes != MAP_FAILED) munmap(r->sqes, r->sqes_len);
+    if (r->cq_map != MAP_FAILED && r->cq_map != r->sq_map) munmap(r->cq_map, r->cq_map_len);
+    if (r->sq_map != MAP_FAILED) munmap(r->sq_map, r->sq_map_len);
+    close(r->fd);
+    free(r);
+}
+
+/**
+ * \brief           Record a batch completion in its op (user_data = index).
+ */
+static void batch_cqe(void *ctx, uint64_t user_data, int res) {
+    storage_op_t *ops = ctx;
+    ops[user_data].result = res;
+}
+
+/**
+ * \brief           Run ops[0..n) (n <= ring size) through \p r.
+ *
+ * \return          0 if every op completed (with any result), -1 if the
+ *                  ring is dead; ops it never ran still have result -1.
+ */
+static int ring_batch(storage_ring_t *r, storage_op_t *ops, size_t n) {
+    if (r->dead) return -1;
+    for (size_t i = 0; i < n; i++) {
+        struct io_uring_sqe *sqe = ring_sqe(r, i);
+        sqe->opcode = ops[i].write ? IORING_OP_WRITE : IORING_OP_READ;
+        sqe->fd = ops[i].fd;
+        sqe->addr = (uintptr_t)ops[i].buf;
+        sqe->len = (unsigned)ops[i].len;
+        sqe->off = (uint64_t)ops[i].off;
+    }
+    return ring_wait(r, (unsigned)n, batch_cqe, ops);
+}
+
+/* Completions of storage_ring_append_sync(): [0] write, [1] fdatasync */
+static void append_cqe(void *ctx, uint64_t user_data, int res) {
+    ((int *)ctx)[user_data] = res;
+}
+
+/**
+ * \brief           Append \p len bytes to \p fd and fdatasync() it.
+ */
+int storage_ring_append_sync(storage_ring_t *r, int fd, const void *buf, size_t len) {
+    if (!r || r->dead || len == 0) return append_sync_plain(fd, buf, len);
+
+    struct io_uring_sqe *w = ring_sqe(r, 0);
+    w->opcode = IORING_OP_WRITE;
+    w->flags = IOSQE_IO_LINK;       /* The sync runs only after a full write */
+    w->fd = fd;
+    w->addr = (uintptr_t)buf;
+    w->len = (unsigned)len;
+    w->off = (uint64_t)-1;          /* Current position (O_APPEND) */
+
+    struct io_uring_sqe *s = ring_sqe(r, 1);
+    s->opcode = IORING_OP_FSYNC;
+    s->fd = fd;
+    s->fsync_flags = IORING_FSYNC_DATASYNC;
+
+    /* If the ring dies, whatever it ran is kept and the rest done here */
+    int res[2] = { RING_UNSENT, RING_UNSENT };
+    (void)ring_wait(r, 2, append_cqe, res);
+    if (res[0] == (int)len && res[1] == 0) return 0;
+    if (res[0] == RING_UNSENT) return append_sync_plain(fd, buf, len);
+    if (res[0] < 0) {
+        errno = -res[0];
+        return -1;
+    }
+    if ((size_t)res[0] == len) {        /* The write landed; the sync failed */
+        if (res[1] == RING_UNSENT) return fdatasync(fd);
+        errno = -res[1];
+        return -1;
+    }
+    /* Short write: the link cancelled the sync, so finish both here */
+    return append_sync_plain(fd, (const char *)buf + res[0], len - (size_t)res[0]);
+}
+
+#else /* !STORAGE_RING_URING */
+
+storage_ring_t *storage_ring_create(void) { return NULL; }
+void storage_ring_destroy(storage_ring_t *r) { (void)r; }
+
+static int ring_batch(storage_ring_t *r, storage_op_t *ops, size_t n) {
+    (void)r; (void)ops; (void)n;
+    return -1;
+}
+
+int storage_ring_append_sync(storage_ring_t *r, int fd, const void *buf, size_t len) {
+    (void)r;
+    return append_sync_plain(fd, buf, len);
+}
+
+#endif /* STORAGE_RING_URING */
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Make storage_ring_create() fail from now on ("server -u").
+ */
+void storage_ring_disable(void) {
+    atomic_store(&ring_disabled, 1);
+}
+
+/**
+ * \brief           Make \p r the calling thread's ring for storage_io_batch().
+ */
+void storage_ring_bind(storage_ring_t *r) {
+    bound_ring = r;
+}
+
+/**
+ * \brief           Perform every transfer in \p ops.
+ */
+int storage_io_batch(storage_op_t *ops, size_t n) {
+    storage_ring_t *r = bound_ring;
+
+    /* Unfinished ops keep result -1 and are redone synchronously below */
+    for (size_t i = 0; i < n; i++)
+        ops[i].result = -1;
+
+    /* A lone transfer costs one syscall either way */
+    if (r && n > 1) {
+        for (size_t at = 0; at < n; at += STORAGE_RING_DEPTH) {
+            size_t chunk = n - at < STORAGE_RING_DEPTH ? n - at : STORAGE_RING_DEPTH;
+            if (ring_batch(r, ops + at, chunk) < 0)
+                break;
+        }
+    }
+
+    int rc = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (ops[i].result != (ssize_t)ops[i].len)
+            op_finish_sync(&ops[i], ops[i].result > 0 ? (size_t)ops[i].result : 0);
+        if (ops[i].result != (ssize_t)ops[i].len)
+            rc = -1;
+    }
+    return rc;
+}
@@ -0,0 +1,120 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: storage_ring.h                                  #
+# Purpose:                                                   #
+#     Declares the io_uring storage backend. A batch of     #
+#     trainer-file reads or writes is queued as one set of  #
+#     submissions and reaped with one io_uring_enter(),     #
+#     instead of one pread()/pwrite() per record. Threads   #
+#     without a ring, and kernels without io_uring, take    #
+#     the synchronous safe_pread()/safe_pwrite() path.      #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: io_uring_setup(2), io_uring_enter(2) #
+#     https://man7.org/linux/man-pages/                     #
+# [2] Axboe, J. "Efficient IO with io_uring" (2019)         #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef STORAGE_RING_H
+#define STORAGE_RING_H
+
+#include <stddef.h>     /* size_t */
+#include <sys/types.h>  /* off_t, ssize_t */
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Submission queue entries per ring; larger batches are split. */
+#define STORAGE_RING_DEPTH  64
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Opaque ring handle; use from one thread at a time. */
+typedef struct storage_ring storage_ring_t;
+
+/**
+ * \brief           One positioned transfer of a batch.
+ */
+typedef struct {
+    int         fd;                 /*!< File to read or write */
+    int         write;              /*!< 1 for a write, 0 for a read */
+    void       *buf;                /*!< Source or destination */
+    size_t      len;                /*!< Bytes to transfer */
+    off_t       off;                /*!< File offset */
+    ssize_t     result;             /*!< Out: bytes transferred, or -1 */
+} storage_op_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Make storage_ring_create() fail from now on ("server -u").
+ */
+void storage_ring_disable(void);
+
+/**
+ * \brief           Set up an io_uring instance of STORAGE_RING_DEPTH entries.
+ *
+ * \return          Ring, or NULL if io_uring is unavailable (old kernel,
+ *                  seccomp or io_uring_disabled) or was disabled.
+ */
+storage_ring_t *storage_ring_create(void);
+
+/**
+ * \brief           Unmap and close a ring; NULL is ignored.
+ */
+void storage_ring_destroy(storage_ring_t *r);
+
+/**
+ * \brief           Make \p r the calling thread's ring for storage_io_batch().
+ *
+ * \note            Pass NULL to detach before destroying the ring.
+ */
+void storage_ring_bind(storage_ring_t *r);
+
+/**
+ * \brief           Perform every transfer in \p ops.
+ *
+ * \param[in,out]   ops         Transfers; each \ref storage_op_t.result is set.
+ * \param[in]       n           Number of transfers.
+ *
+ * \return          0 if every transfer moved its full length, -1 otherwise.
+ *
+ * \note            Uses the thread's bound ring when there is one: the ops
+ *                  are submitted together and reaped on one wait. Short or
+ *                  failed completions are finished synchronously, so the
+ *                  result matches the synchronous path either way. A ring
+ *                  whose io_uring_enter() fails is retired once the ops it
+ *                  took have completed; the thread then stays synchronous.
+ */
+int storage_io_batch(storage_op_t *ops, size_t n);
+
+/**
+ * \brief           Append \p len bytes to \p fd and fdatasync() it.
+ *
+ * \param[in]       r           Ring, or NULL for write() then fdatasync().
+ *
+ * \return          0 once the data is durable, -1 on failure.
+ *
+ * \note            With a ring the write and the sync are linked, so both
+ *                  go to the kernel in a single io_uring_enter(). \p fd
+ *                  must be opened with O_APPEND.
+ */
+int storage_ring_append_sync(storage_ring_t *r, int fd, const void *buf, size_t len);
+
+#endif /* STORAGE_RING_H */
@@ -0,0 +1,152 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: textproto.c                                     #
+# Purpose:                                                   #
+#     Implements the text protocol's tokenizer, strict      #
+#     integer parsing and perfect-hash command lookup.      #
+#     Nothing here allocates or writes to the command line, #
+#     so it is safe on any thread and on const buffers.     #
+#############################################################
+# Citations:                                                #
+# [1] Schmidt, D. "GPERF: A Perfect Hash Function           #
+#     Generator" (C++ Report, 1990)                         #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <ctype.h>      /* isspace */
+#include <string.h>     /* memcmp, memcpy, strlen */
+
+#include "textproto.h"
+
+/* ========================================================================== */
+/* ================================ Tokenizer =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Split \p line into whitespace-separated words.
+ */
+int cmd_tokenize(const char *line, cmd_tokens_t *out) {
+    const unsigned char *p = (const unsigned char *)line;
+    out->n = 0;
+
+    for (;;) {
+        while (isspace(*p)) p++;
+        if (*p == '\0' || out->n == CMD_TOKENS_MAX) break;
+
+        const unsigned char *start = p;
+        while (*p != '\0' && !isspace(*p)) p++;
+        out->tok[out->n].s = (const char *)start;
+        out->tok[out->n].len = (uint32_t)(p - start);
+        out->n++;
+    }
+    out->more = *p != '\0';
+    return out->n;
+}
+
+/**
+ * \brief           Does token \p t spell exactly \p word?
+ */
+int cmd_tok_eq(const cmd_token_t *t, const char *word) {
+    size_t len = strlen(word);
+    return t->len == len && memcmp(t->s, word, len) == 0;
+}
+
+/* ========================================================================== */
+/* ============================ Strict Integers ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Parse \p len bytes at \p s as a decimal integer in [lo, hi].
+ */
+int cmd_parse_int(const char *s, size_t len, long lo, long hi, int *out) {
+    size_t i = 0;
+    int neg = 0;
+    long long v = 0;
+
+    if (len > 0 && s[0] == '-') {
+        neg = 1;
+        i = 1;
+    }
+    if (i == len) return 0;
+
+    for (; i < len; i++) {
+        if (s[i] < '0' || s[i] > '9') return 0;
+        v = v * 10 + (s[i] - '0');
+        if (v > (long long)INT32_MAX + 1) return 0;     /* Overflow */
+    }
+    if (neg) v = -v;
+    if (v < lo || v > hi) return 0;
+
+    *out = (int)v;
+    return 1;
+}
+
+/**
+ * \brief           cmd_parse_int() over one token.
+ */
+int cmd_tok_int(const cmd_token_t *t, long lo, long hi, int *out) {
+    return cmd_parse_int(t->s, t->len, lo, hi, out);
+}
+
+/**
+ * \brief           Copy token \p t into \p buf as a C string.
+ */
+int cmd_tok_cstr(const cmd_token_t *t, char *buf, size_t cap) {
+    if ((size_t)t->len + 1 > cap) return 0;
+    memcpy(buf, t->s, t->len);
+    buf[t->len] = '\0';
+    return 1;
+}
+
+/* ========================================================================== */
+/* ============================= Command Lookup ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Does \p e carry exactly this verb and noun?
+ */
+static int entry_matches(const cmd_entry_t *e, const cmd_token_t *verb,
+                         const cmd_token_t *noun) {
+    uint32_t nlen = noun ? noun->len : 0;
+    return e->fn && e->verb_len == verb->len && e->noun_len == nlen &&
+           memcmp(e->verb, verb->s, verb->len) == 0 &&
+           (nlen == 0 || memcmp(e->noun, noun->s, nlen) == 0);
+}
+
+/**
+ * \brief           Find the command \p words name in \p table.
+ */
+const cmd_entry_t *cmd_lookup(const cmd_entry_t table[CMD_TABLE_SIZE],
+                              const cmd_tokens_t *words, int *argi) {
+    if (words->n == 0) return NULL;
+    const cmd_token_t *verb = &words->tok[0];
+
+    /* Two-word commands ("get trainer") first, then one-word ones ("stats") */
+    if (words->n >= 2) {
+        const cmd_token_t *noun = &words->tok[1];
+        const cmd_entry_t *e = &table[CMD_HASH(verb->len, (unsigned char)verb->s[0],
+                                               noun->len, (unsigned char)noun->s[0])];
+        if (entry_matches(e, verb, noun)) {
+            *argi = 2;
+            return e;
+        }
+    }
+
+    const cmd_entry_t *e = &table[CMD_HASH(verb->len, (unsigned char)verb->s[0], 0, 0)];
+    if (entry_matches(e, verb, NULL)) {
+        *argi = 1;
+        return e;
+    }
+    return NULL;
+}
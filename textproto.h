@@ -0,0 +1,194 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: textproto.h                                     #
+# Purpose:                                                   #
+#     Declares the parsing half of the text protocol in     #
+#     protocol.h: a single-pass tokenizer that slices a     #
+#     command line in place without copying or modifying    #
+#     it, strict integer parsing of tokens, and a command   #
+#     table addressed by a compile-time perfect hash of     #
+#     the verb and noun.                                    #
+#############################################################
+# Citations:                                                #
+# [1] Schmidt, D. "GPERF: A Perfect Hash Function           #
+#     Generator" (C++ Report, 1990)                         #
+# [2] ISO/IEC 9899:2018 (C11 Standard), 6.7.9               #
+#     (designated initializers)                             #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef TEXTPROTO_H
+#define TEXTPROTO_H
+
+#include <stdint.h>     /* uint8_t, uint32_t */
+#include <stddef.h>     /* size_t */
+
+#include "protocol.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Words kept per command line; batch commands read the raw rest instead. */
+#define CMD_TOKENS_MAX          20
+
+/*!< Slots in a command table (a power of two). */
+#define CMD_TABLE_SIZE          32
+
+/*!< max_args value accepting any number of arguments. */
+#define CMD_ARGS_ANY            CMD_TOKENS_MAX
+
+/*!< Command flag: mutates trainers, so a read-only replica refuses it. */
+#define CMD_WRITE               0x01
+
+/*!< Command flag: parses the raw text after its noun, so it may run past
+ *   CMD_TOKENS_MAX words. */
+#define CMD_RAW                 0x02
+
+/**
+ * \brief           Table slot of a command with the given verb and noun.
+ *
+ * \param[in]       vlen        Verb length.
+ * \param[in]       v0          First character of the verb.
+ * \param[in]       nlen        Noun length (0 for one-word commands).
+ * \param[in]       n0          First character of the noun (0 if none).
+ *
+ * \note            Perfect over the server's command set: no two commands
+ *                  share a slot. A new command that collides makes the
+ *                  table's designated initializers overlap, which -Wextra
+ *                  (-Woverride-init) reports at build time; change the
+ *                  multipliers until the build is clean again.
+ */
+#define CMD_HASH(vlen, v0, nlen, n0) \
+    ((2u * (unsigned)(vlen) + (unsigned)(v0) + (unsigned)(nlen) + (unsigned)(n0)) & \
+     (CMD_TABLE_SIZE - 1))
+
+/**
+ * \brief           Define the table slot of one command.
+ *
+ * \param[in]       verb, noun  String literals ("" for a one-word command).
+ * \param[in]       v0, n0      Their first characters (0 for ""). C cannot
+ *                              index a string literal in a constant
+ *                              expression, so the hash takes them apart.
+ * \param[in]       min, max    Accepted number of arguments after the key.
+ * \param[in]       flags       CMD_WRITE or 0.
+ * \param[in]       kind        Metrics command class (metric_cmd_t).
+ * \param[in]       fn          Handler.
+ */
+#define CMD_ENTRY(verb, v0, noun, n0, min, max, flags, kind, fn) \
+    [CMD_HASH(sizeof(verb) - 1, v0, sizeof(noun) - 1, n0)] = \
+        { verb, noun, sizeof(verb) - 1, sizeof(noun) - 1, min, max, flags, kind, fn }
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< One word of a command line: a slice of the line, not a copy. */
+typedef struct {
+    const char *s;                  /*!< First character (not NUL-terminated) */
+    uint32_t    len;                /*!< Length in bytes */
+} cmd_token_t;
+
+/*!< A tokenized command line. */
+typedef struct {
+    cmd_token_t tok[CMD_TOKENS_MAX];
+    int         n;                  /*!< Tokens kept (at most CMD_TOKENS_MAX) */
+    int         more;               /*!< Words followed the last kept token */
+} cmd_tokens_t;
+
+/*!< Everything one handler call works on. */
+typedef struct {
+    const char         *line;       /*!< Whole command line */
+    const cmd_tokens_t *words;      /*!< Its tokens */
+    const cmd_token_t  *args;       /*!< Arguments after the verb (and noun) */
+    int                 nargs;      /*!< Entries in \ref args */
+    Response           *res;        /*!< Reply being built */
+    int                 kind;       /*!< Metrics class; handlers may refine it */
+} cmd_ctx_t;
+
+/*!< Command handler: fills c->res and returns a SessionAction. */
+typedef int (*cmd_handler_fn)(cmd_ctx_t *c);
+
+/*!< One command of a table built with CMD_ENTRY(). */
+typedef struct {
+    const char     *verb;
+    const char     *noun;           /*!< "" for one-word commands */
+    uint8_t         verb_len;
+    uint8_t         noun_len;
+    uint8_t         min_args;
+    uint8_t         max_args;
+    uint8_t         flags;          /*!< CMD_WRITE, CMD_RAW */
+    int             kind;           /*!< Default metrics class */
+    cmd_handler_fn  fn;             /*!< NULL in empty slots */
+} cmd_entry_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Split \p line into words separated by isspace() runs.
+ *
+ * \return          Number of tokens kept.
+ *
+ * \note            One pass, no copy and no writes to \p line; tokens point
+ *                  into it and stay valid as long as the line does. Words
+ *                  past CMD_TOKENS_MAX are not kept, but set
+ *                  \ref cmd_tokens_t.more so the caller can reject the line.
+ */
+int cmd_tokenize(const char *line, cmd_tokens_t *out);
+
+/**
+ * \brief           Does token \p t spell exactly \p word?
+ */
+int cmd_tok_eq(const cmd_token_t *t, const char *word);
+
+/**
+ * \brief           Parse \p len bytes at \p s as a decimal integer in [lo, hi].
+ *
+ * \return          1 on success, 0 on an empty string, a stray character,
+ *                  overflow or a value out of range (\p out is then unchanged).
+ *
+ * \note            Accepts an optional '-' followed by digits only: no
+ *                  spaces, '+', hex or trailing text, unlike atoi().
+ */
+int cmd_parse_int(const char *s, size_t len, long lo, long hi, int *out);
+
+/**
+ * \brief           cmd_parse_int() over one token.
+ */
+int cmd_tok_int(const cmd_token_t *t, long lo, long hi, int *out);
+
+/**
+ * \brief           Copy token \p t into \p buf as a C string.
+ *
+ * \return          1 on success, 0 if it does not fit in \p cap bytes.
+ *
+ * \note            For the few spots that hand a word to a C-string API.
+ */
+int cmd_tok_cstr(const cmd_token_t *t, char *buf, size_t cap);
+
+/**
+ * \brief           Find the command \p words name in \p table.
+ *
+ * \param[out]      argi        Index of the first argument token.
+ *
+ * \return          Matching entry, or NULL if none.
+ *
+ * \note            Probes the verb+noun slot, then the verb-only slot, and
+ *                  confirms a hit with one length check and memcmp() each.
+ */
+const cmd_entry_t *cmd_lookup(const cmd_entry_t table[CMD_TABLE_SIZE],
+                              const cmd_tokens_t *words, int *argi);
+
+#endif /* TEXTPROTO_H */
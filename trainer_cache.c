@@ -0,0 +1,262 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_cache.c                                 #
+# Purpose:                                                   #
+#     Implements the rendered-reply cache. Trainer IDs are  #
+#     sequential, so the low bits pick a segment and the    #
+#     next bits a hash bucket; a hit is one mutex, a short  #
+#     chain walk and a memcpy. Each segment runs its own    #
+#     CLOCK hand over a fixed entry array.                  #
+#############################################################
+# Citations:                                                #
+# [1] Corbató, F. J. "A Paging Experiment with the Multics  #
+#     System" (1968) — CLOCK replacement                    #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdlib.h>     /* aligned_alloc, malloc, calloc, free */
+#include <string.h>     /* memcpy, memset */
+#include <pthread.h>    /* pthread_mutex_* */
+
+#include "trainer_cache.h"
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Chain terminator. */
+#define NO_ENTRY        UINT32_MAX
+
+/*!< One cached reply. */
+typedef struct {
+    int         id;                         /*!< Trainer ID (valid if used) */
+    uint32_t    next;                       /*!< Next entry in the bucket chain */
+    uint16_t    len;                        /*!< Reply bytes, without the NUL */
+    uint8_t     used;                       /*!< Holds a reply */
+    uint8_t     ref;                        /*!< CLOCK reference bit */
+    char        text[TRAINER_CACHE_TEXT_MAX]; /*!< Rendered reply */
+} cache_entry_t;
+
+/*!< One independently locked part of the cache. */
+typedef struct {
+    pthread_mutex_t mutex;                  /*!< Guards everything below */
+    uint32_t    nentries;                   /*!< Entry array size */
+    uint32_t    filled;                     /*!< Entries handed out so far */
+    uint32_t    hand;                       /*!< CLOCK position */
+    uint32_t    mask;                       /*!< Bucket count - 1 */
+    uint32_t   *heads;                      /*!< Bucket chain heads */
+    uint32_t   *epochs;                     /*!< Per-bucket invalidation counters */
+    cache_entry_t *entries;                 /*!< Fixed entry array */
+} __attribute__((aligned(64))) cache_segment_t;
+
+struct trainer_cache {
+    cache_segment_t seg[TRAINER_CACHE_SEGMENTS];
+};
+
+/* ========================================================================== */
+/* ================================ Helpers ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Segment owning trainer \p id.
+ */
+static cache_segment_t *segment_for(trainer_cache_t *c, int id) {
+    return &c->seg[(uint32_t)id & (TRAINER_CACHE_SEGMENTS - 1)];
+}
+
+/**
+ * \brief           Bucket of trainer \p id within its segment.
+ */
+static uint32_t bucket_for(const cache_segment_t *s, int id) {
+    return ((uint32_t)id / TRAINER_CACHE_SEGMENTS) & s->mask;
+}
+
+/**
+ * \brief           Find the entry for \p id, or NO_ENTRY.
+ */
+static uint32_t segment_find(const cache_segment_t *s, uint32_t bucket, int id) {
+    uint32_t i = s->heads[bucket];
+    while (i != NO_ENTRY && s->entries[i].id != id)
+        i = s->entries[i].next;
+    return i;
+}
+
+/**
+ * \brief           Remove entry \p i from its bucket chain and mark it free.
+ */
+static void segment_unlink(cache_segment_t *s, uint32_t i) {
+    uint32_t *link = &s->heads[bucket_for(s, s->entries[i].id)];
+    while (*link != i)
+        link = &s->entries[*link].next;
+    *link = s->entries[i].next;
+    s->entries[i].used = 0;
+}
+
+/**
+ * \brief           Pick an entry to fill: an unused one, else the CLOCK victim.
+ */
+static uint32_t segment_victim(cache_segment_t *s) {
+    if (s->filled < s->nentries)
+        return s->filled++;
+
+    /* Give referenced entries a second chance; terminates within two sweeps */
+    for (;;) {
+        cache_entry_t *e = &s->entries[s->hand];
+        uint32_t i = s->hand;
+        s->hand = (s->hand + 1 == s->nentries) ? 0 : s->hand + 1;
+        if (!e->used)
+            return i;
+        if (!e->ref) {
+            segment_unlink(s, i);
+            return i;
+        }
+        e->ref = 0;
+    }
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Create a cache holding up to about \p capacity replies.
+ */
+trainer_cache_t *trainer_cache_create(size_t capacity) {
+    trainer_cache_t *c = aligned_alloc(64, sizeof(*c));
+    if (!c) return NULL;
+    memset(c, 0, sizeof(*c));
+
+    uint32_t per = (uint32_t)((capacity + TRAINER_CACHE_SEGMENTS - 1) / TRAINER_CACHE_SEGMENTS);
+    if (per == 0) per = 1;
+    uint32_t buckets = 1;
+    while (buckets < per) buckets <<= 1;
+
+    for (int i = 0; i < TRAINER_CACHE_SEGMENTS; i++)
+        pthread_mutex_init(&c->seg[i].mutex, NULL);
+
+    for (int i = 0; i < TRAINER_CACHE_SEGMENTS; i++) {
+        cache_segment_t *s = &c->seg[i];
+        s->nentries = per;
+        s->mask = buckets - 1;
+        s->heads = malloc(buckets * sizeof(*s->heads));
+        s->epochs = calloc(buckets, sizeof(*s->epochs));
+        s->entries = calloc(per, sizeof(*s->entries));
+        if (!s->heads || !s->epochs || !s->entries) {
+            trainer_cache_destroy(c);
+            return NULL;
+        }
+        memset(s->heads, 0xFF, buckets * sizeof(*s->heads));   /* NO_ENTRY */
+    }
+    return c;
+}
+
+/**
+ * \brief           Free the cache and every entry.
+ */
+void trainer_cache_destroy(trainer_cache_t *c) {
+    if (!c) return;
+    for (int i = 0; i < TRAINER_CACHE_SEGMENTS; i++) {
+        cache_segment_t *s = &c->seg[i];
+        free(s->heads);
+        free(s->epochs);
+        free(s->entries);
+        pthread_mutex_destroy(&s->mutex);
+    }
+    free(c);
+}
+
+/**
+ * \brief           Copy the cached reply for trainer \p id into \p out.
+ */
+size_t trainer_cache_get(trainer_cache_t *c, int id, char *out, size_t cap,
+                         uint32_t *epoch) {
+    cache_segment_t *s = segment_for(c, id);
+    uint32_t b = bucket_for(s, id);
+    size_t len = 0;
+
+    pthread_mutex_lock(&s->mutex);
+    uint32_t i = segment_find(s, b, id);
+    if (i != NO_ENTRY && s->entries[i].len < cap) {
+        cache_entry_t *e = &s->entries[i];
+        e->ref = 1;
+        len = e->len;
+        memcpy(out, e->text, len + 1);
+    } else {
+        *epoch = s->epochs[b];
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return len;
+}
+
+/**
+ * \brief           Cache a rendered reply unless \p id changed since \p epoch.
+ */
+void trainer_cache_put(trainer_cache_t *c, int id, uint32_t epoch,
+                       const char *text, size_t len) {
+    if (len == 0 || len >= TRAINER_CACHE_TEXT_MAX) return;
+
+    cache_segment_t *s = segment_for(c, id);
+    uint32_t b = bucket_for(s, id);
+
+    pthread_mutex_lock(&s->mutex);
+    /* A write since the caller's miss, or another thread got here first */
+    if (s->epochs[b] != epoch || segment_find(s, b, id) != NO_ENTRY) {
+        pthread_mutex_unlock(&s->mutex);
+        return;
+    }
+
+    uint32_t i = segment_victim(s);
+    cache_entry_t *e = &s->entries[i];
+    e->id = id;
+    e->len = (uint16_t)len;
+    e->used = 1;
+    e->ref = 0;     /* Must be hit once before it outlives a CLOCK sweep */
+    memcpy(e->text, text, len);
+    e->text[len] = '\0';
+    e->next = s->heads[b];
+    s->heads[b] = i;
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/**
+ * \brief           Drop trainer \p id and reject renders still in flight.
+ */
+void trainer_cache_invalidate(trainer_cache_t *c, int id) {
+    cache_segment_t *s = segment_for(c, id);
+    uint32_t b = bucket_for(s, id);
+
+    pthread_mutex_lock(&s->mutex);
+    s->epochs[b]++;
+    uint32_t i = segment_find(s, b, id);
+    if (i != NO_ENTRY)
+        segment_unlink(s, i);
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/**
+ * \brief           Drop every entry.
+ */
+void trainer_cache_clear(trainer_cache_t *c) {
+    for (int i = 0; i < TRAINER_CACHE_SEGMENTS; i++) {
+        cache_segment_t *s = &c->seg[i];
+        pthread_mutex_lock(&s->mutex);
+        for (uint32_t b = 0; b <= s->mask; b++) {
+            s->epochs[b]++;
+            s->heads[b] = NO_ENTRY;
+        }
+        for (uint32_t e = 0; e < s->filled; e++)
+            s->entries[e].used = 0;
+        pthread_mutex_unlock(&s->mutex);
+    }
+}
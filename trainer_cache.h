@@ -0,0 +1,110 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_cache.h                                 #
+# Purpose:                                                   #
+#     Declares a bounded cache of rendered "get trainer     #
+#     <id>" replies. Entries are spread over independently  #
+#     locked segments and evicted with the CLOCK algorithm; #
+#     writers invalidate by ID, and per-bucket epochs stop  #
+#     a reply rendered before a write from being cached     #
+#     after it.                                             #
+#############################################################
+# Citations:                                                #
+# [1] Corbató, F. J. "A Paging Experiment with the Multics  #
+#     System" (1968) — CLOCK replacement                    #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef TRAINER_CACHE_H
+#define TRAINER_CACHE_H
+
+#include <stdint.h>     /* uint32_t */
+#include <stddef.h>     /* size_t */
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Default number of cached replies. */
+#define TRAINER_CACHE_DEFAULT       1024
+
+/*!< Independently locked segments (power of two). */
+#define TRAINER_CACHE_SEGMENTS      16
+
+/*!< Longest reply kept; longer ones are rendered every time. */
+#define TRAINER_CACHE_TEXT_MAX      768
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Opaque cache handle. */
+typedef struct trainer_cache trainer_cache_t;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Create a cache holding up to about \p capacity replies.
+ *
+ * \return          Cache, or NULL on allocation failure.
+ */
+trainer_cache_t *trainer_cache_create(size_t capacity);
+
+/**
+ * \brief           Free the cache and every entry.
+ */
+void trainer_cache_destroy(trainer_cache_t *c);
+
+/**
+ * \brief           Copy the cached reply for trainer \p id into \p out.
+ *
+ * \param[in]       c           Cache.
+ * \param[in]       id          Trainer ID.
+ * \param[out]      out         Destination, NUL-terminated on a hit.
+ * \param[in]       cap         Size of \p out.
+ * \param[out]      epoch       On a miss, the token to pass to
+ *                              trainer_cache_put() once rendered.
+ *
+ * \return          Reply length on a hit, 0 on a miss.
+ *
+ * \note            Read the token before reading the trainer, so a write
+ *                  that lands in between is detected.
+ */
+size_t trainer_cache_get(trainer_cache_t *c, int id, char *out, size_t cap,
+                         uint32_t *epoch);
+
+/**
+ * \brief           Cache a rendered reply unless \p id changed since \p epoch.
+ *
+ * \note            Replies of TRAINER_CACHE_TEXT_MAX bytes or more are
+ *                  not cached.
+ */
+void trainer_cache_put(trainer_cache_t *c, int id, uint32_t epoch,
+                       const char *text, size_t len);
+
+/**
+ * \brief           Drop trainer \p id and reject renders still in flight.
+ *
+ * \note            Call after the store has applied the post, put or delete.
+ */
+void trainer_cache_invalidate(trainer_cache_t *c, int id);
+
+/**
+ * \brief           Drop every entry (e.g. when the rendered data changes).
+ */
+void trainer_cache_clear(trainer_cache_t *c);
+
+#endif /* TRAINER_CACHE_H */
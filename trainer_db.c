@@ -0,0 +1,2148 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_db.c                                    #
+# Purpose:                                                   #
+#     Implements the indexed trainer store. The file is     #
+#     scanned once at open to build an open-addressing      #
+#     ID → slot hash table; afterwards gets and updates     #
+#     are one positioned read or write of a single record.  #
+#     Deletes tombstone the slot and push it on a free list #
+#     so the file only needs rewriting during compaction.   #
+#     Mutations are logged to the trainer WAL under their   #
+#     locks and written in place only once group-committed, #
+#     so the file never holds a change the log lacks. While #
+#     a snapshot runs, writers save each slot's pre-image   #
+#     before first overwriting it.                          #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: open(2), pread(2), pwrite(2),        #
+#     rename(2), fstat(2)                                   #
+#     https://man7.org/linux/man-pages/                     #
+# [2] D. Knuth, TAOCP Vol. 3, §6.4 (linear probing and      #
+#     deletion without tombstones)                          #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#define _GNU_SOURCE     /* pthread_rwlockattr_setkind_np */
+
+#include <stdio.h>      /* perror, snprintf, rename */
+#include <errno.h>      /* errno, EBUSY, ENOMEM, ENOENT */
+#include <stdlib.h>     /* calloc, realloc, free, qsort */
+#include <string.h>     /* memset */
+#include <time.h>       /* time */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, fdatasync, sleep */
+#include <pthread.h>    /* pthread_create, pthread_rwlock_* */
+#include <sys/stat.h>   /* fstat */
+
+#include "common.h"
+#include "trainer_db.h"
+#include "metrics.h"
+#include "storage_ring.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Records read per pread() while scanning the file. */
+#define TRAINER_SCAN_BATCH  128
+
+/*!< Initial hash table size (grows at 50% load). */
+#define TRAINER_INDEX_MIN   64
+
+/*!< Seconds between compactor checks. */
+#define TRAINER_COMPACT_INTERVAL    5
+
+/*!< Dead slots required before the ratio is even considered. */
+#define TRAINER_COMPACT_MIN_DEAD    64
+
+/*!< Snapshot slot state: copied into the image (other values: pre-image + 1). */
+#define SNAP_COPIED     UINT32_MAX
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Copy-on-write bookkeeping for a running snapshot.
+ *
+ * \note            \ref state has one entry per slot that existed at the
+ *                  snapshot point: 0 while untouched, SNAP_COPIED once the
+ *                  copier has read it, otherwise 1 + the index of the old
+ *                  record a writer saved in \ref pre. Writers set the state
+ *                  under \ref mutex before their pwrite(), and the copier only
+ *                  trusts file contents of slots still at 0, so it never
+ *                  sees a half-written record. A compaction uses \ref dirty
+ *                  instead: writers only mark their slots, and it copies
+ *                  those again once it holds the lock to swap the files.
+ */
+struct trainer_snap {
+    pthread_mutex_t mutex;          /*!< Guards every field below */
+    uint32_t        nslots;         /*!< Slots covered by the image */
+    uint32_t       *state;          /*!< Per-slot state (see above) */
+    Trainer        *pre;            /*!< Saved pre-images */
+    size_t          npre;           /*!< Entries in \ref pre */
+    size_t          pre_cap;        /*!< Allocated size of \ref pre */
+    int             failed;         /*!< A pre-image could not be saved */
+    uint8_t        *dirty;          /*!< Compaction only: slots written since */
+};
+
+/*!< One logged record whose in-place write is still to come. */
+typedef struct {
+    uint32_t    slot;               /*!< Slot it rewrites */
+    uint8_t     op;                 /*!< WAL_OP_PUT, or WAL_OP_DELETE (tombstone, then free) */
+    Trainer     rec;                /*!< New record (only id for deletes) */
+} write_op_t;
+
+/**
+ * \brief           Logged records of one request, queued for the applier.
+ *
+ * \note            Allocated before the request takes any lock, so once a
+ *                  record is logged it can always be queued.
+ */
+struct trainer_write {
+    struct trainer_write *next;     /*!< Next request in log order */
+    uint64_t        lsn;            /*!< LSN of its last record */
+    size_t          n;              /*!< Entries in \ref ops */
+    write_op_t      ops[];          /*!< Writes in log order */
+};
+
+/* ========================================================================== */
+/* ================================ ID Index ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Home bucket for a trainer ID.
+ */
+static size_t index_hash(const TrainerDB *db, int32_t id) {
+    uint32_t h = (uint32_t)id * 2654435761u;
+    return (size_t)(h ^ (h >> 16)) & (db->cap - 1);
+}
+
+/**
+ * \brief           Find the bucket holding \p id.
+ *
+ * \return          Bucket position, or (size_t)-1 if \p id is not indexed.
+ */
+static size_t index_find(const TrainerDB *db, int32_t id) {
+    size_t i = index_hash(db, id);
+    while (db->keys[i] != 0) {
+        if (db->keys[i] == id) return i;
+        i = (i + 1) & (db->cap - 1);
+    }
+    return (size_t)-1;
+}
+
+/**
+ * \brief           Insert or overwrite an ID → slot mapping (no growth).
+ */
+static void index_put_nogrow(TrainerDB *db, int32_t id, uint32_t slot) {
+    size_t i = index_hash(db, id);
+    while (db->keys[i] != 0 && db->keys[i] != id)
+        i = (i + 1) & (db->cap - 1);
+    if (db->keys[i] == 0) db->live++;
+    db->keys[i] = id;
+    db->slots[i] = slot;
+}
+
+/**
+ * \brief           Resize the table to \p cap buckets and rehash.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int index_resize(TrainerDB *db, size_t cap) {
+    int32_t  *old_keys  = db->keys;
+    uint32_t *old_slots = db->slots;
+    size_t    old_cap   = db->cap;
+
+    int32_t  *keys  = calloc(cap, sizeof(*keys));
+    uint32_t *slots = calloc(cap, sizeof(*slots));
+    if (!keys || !slots) {
+        free(keys);
+        free(slots);
+        return -1;
+    }
+
+    db->keys = keys;
+    db->slots = slots;
+    db->cap = cap;
+    db->live = 0;
+    for (size_t i = 0; i < old_cap; i++) {
+        if (old_keys[i] != 0)
+            index_put_nogrow(db, old_keys[i], old_slots[i]);
+    }
+    free(old_keys);
+    free(old_slots);
+    return 0;
+}
+
+/**
+ * \brief           Insert or overwrite a mapping, growing at 50% load.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int index_put(TrainerDB *db, int32_t id, uint32_t slot) {
+    if ((db->live + 1) * 2 > db->cap && index_resize(db, db->cap * 2) < 0)
+        return -1;
+    index_put_nogrow(db, id, slot);
+    return 0;
+}
+
+/**
+ * \brief           Remove \p id, shifting later probes back into the hole.
+ */
+static void index_remove(TrainerDB *db, int32_t id) {
+    size_t mask = db->cap - 1;
+    size_t hole = index_find(db, id);
+    if (hole == (size_t)-1) return;
+
+    db->keys[hole] = 0;
+    db->live--;
+
+    /* Backward-shift deletion keeps every probe chain unbroken */
+    size_t i = (hole + 1) & mask;
+    while (db->keys[i] != 0) {
+        size_t home = index_hash(db, db->keys[i]);
+        /* Move the entry if the hole lies on its probe path */
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            db->keys[hole] = db->keys[i];
+            db->slots[hole] = db->slots[i];
+            db->keys[i] = 0;
+            hole = i;
+        }
+        i = (i + 1) & mask;
+    }
+}
+
+/* ========================================================================== */
+/* ================================ ID Order ================================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Position of the first listed ID greater than \p after_id.
+ */
+static size_t order_lower_bound(const TrainerDB *db, int after_id) {
+    size_t lo = 0, hi = db->norder;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (db->order[mid] <= after_id)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/**
+ * \brief           Append \p id to the ID list without keeping it sorted.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int order_append(TrainerDB *db, int32_t id) {
+    if (db->norder == db->order_cap) {
+        size_t cap = db->order_cap ? db->order_cap * 2 : 64;
+        int32_t *p = realloc(db->order, cap * sizeof(*p));
+        if (!p) return -1;
+        db->order = p;
+        db->order_cap = cap;
+    }
+    db->order[db->norder++] = id;
+    return 0;
+}
+
+/**
+ * \brief           Add \p id to the sorted ID list.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ *
+ * \note            New IDs normally exceed every stored one, so this is an
+ *                  append. Replicated and replayed records may bring back a
+ *                  lower or recently deleted ID: a stale entry for it is
+ *                  reused, otherwise it is inserted in place.
+ */
+static int order_push(TrainerDB *db, int32_t id) {
+    if (db->norder == 0 || db->order[db->norder - 1] < id)
+        return order_append(db, id);
+
+    size_t pos = order_lower_bound(db, id - 1);
+    if (pos < db->norder && db->order[pos] == id) {
+        if (db->order_stale > 0) db->order_stale--;
+        return 0;
+    }
+    if (order_append(db, id) < 0)
+        return -1;
+    memmove(&db->order[pos + 1], &db->order[pos],
+            (db->norder - 1 - pos) * sizeof(*db->order));
+    db->order[pos] = id;
+    return 0;
+}
+
+/**
+ * \brief           Drop deleted IDs from the sorted list once they dominate.
+ *
+ * \note            Caller holds the DB lock exclusively. Deletes only bump
+ *                  \ref order_stale, so this O(n) pass is amortized.
+ */
+static void order_prune(TrainerDB *db) {
+    if (db->order_stale < 64 || db->order_stale < db->live)
+        return;
+
+    size_t keep = 0;
+    for (size_t i = 0; i < db->norder; i++) {
+        if (index_find(db, db->order[i]) != (size_t)-1)
+            db->order[keep++] = db->order[i];
+    }
+    db->norder = keep;
+    db->order_stale = 0;
+}
+
+/**
+ * \brief           qsort() comparator for trainer IDs.
+ */
+static int cmp_id(const void *a, const void *b) {
+    int32_t x = *(const int32_t *)a, y = *(const int32_t *)b;
+    return (x > y) - (x < y);
+}
+
+/**
+ * \brief           Rebuild the sorted ID list from the hash index.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int order_rebuild(TrainerDB *db) {
+    db->norder = 0;
+    db->order_stale = 0;
+    for (size_t i = 0; i < db->cap; i++) {
+        if (db->keys[i] != 0 && order_append(db, db->keys[i]) < 0)
+            return -1;
+    }
+    qsort(db->order, db->norder, sizeof(*db->order), cmp_id);
+    return 0;
+}
+
+/* ========================================================================== */
+/* ================================ Free List =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Remember a tombstoned slot for reuse.
+ *
+ * \return          0 on success, -1 on allocation failure.
+ */
+static int free_push(TrainerDB *db, uint32_t slot) {
+    if (db->nfree == db->free_cap) {
+        size_t cap = db->free_cap ? db->free_cap * 2 : 64;
+        uint32_t *p = realloc(db->free_slots, cap * sizeof(*p));
+        if (!p) return -1;
+        db->free_slots = p;
+        db->free_cap = cap;
+    }
+    db->free_slots[db->nfree++] = slot;
+    return 0;
+}
+
+/**
+ * \brief           Move slots released by finished deletes onto the free list.
+ *
+ * \note            Caller holds the DB lock exclusively, but not
+ *                  \ref TrainerDB.pending_mutex. The applier frees a slot
+ *                  only after writing its tombstone, so a new trainer can
+ *                  never land in a slot whose tombstone write is still to
+ *                  come.
+ */
+static void free_reclaim(TrainerDB *db) {
+    pthread_mutex_lock(&db->pending_mutex);
+    for (size_t i = 0; i < db->nfreed; i++)
+        free_push(db, db->freed[i]);    /* On failure the slot stays dead */
+    db->nfreed = 0;
+    pthread_mutex_unlock(&db->pending_mutex);
+}
+
+/**
+ * \brief           Smallest ID of the DB's sequence that is greater than \p id.
+ */
+static int id_after(const TrainerDB *db, int id) {
+    if (id < db->id_first) return db->id_first;
+    return id + db->id_step - (id - db->id_first) % db->id_step;
+}
+
+/**
+ * \brief           Drop every mapping and rebuild from the file contents.
+ *
+ * \return          0 on success, -1 on read or allocation failure.
+ */
+static int index_rebuild(TrainerDB *db) {
+    struct stat st;
+    if (fstat(db->fd, &st) < 0) return -1;
+
+    memset(db->keys, 0, db->cap * sizeof(*db->keys));
+    db->live = 0;
+    db->nfree = 0;
+    db->nfreed = 0;     /* Their tombstones are found below */
+    db->nslots = (uint32_t)(st.st_size / (off_t)sizeof(Trainer));
+
+    Trainer batch[TRAINER_SCAN_BATCH];
+    int max_id = 0;
+
+    for (uint32_t base = 0; base < db->nslots; base += TRAINER_SCAN_BATCH) {
+        size_t want = db->nslots - base;
+        if (want > TRAINER_SCAN_BATCH) want = TRAINER_SCAN_BATCH;
+
+        ssize_t got = safe_pread(db->fd, batch, want * sizeof(Trainer),
+                                 (off_t)base * (off_t)sizeof(Trainer));
+        if (got < 0 || (size_t)got != want * sizeof(Trainer)) return -1;
+
+        for (size_t i = 0; i < want; i++) {
+            if (batch[i].id <= TRAINER_FREE_ID) {
+                if (free_push(db, base + (uint32_t)i) < 0) return -1;
+                continue;
+            }
+            if (index_put(db, batch[i].id, base + (uint32_t)i) < 0) return -1;
+            if (batch[i].id > max_id) max_id = batch[i].id;
+        }
+    }
+
+    if (max_id >= db->next_id)
+        db->next_id = id_after(db, max_id);
+    return order_rebuild(db);
+}
+
+/* ========================================================================== */
+/* ============================= Record Access ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Byte offset of a record slot.
+ */
+static off_t slot_offset(uint32_t slot) {
+    return (off_t)slot * (off_t)sizeof(Trainer);
+}
+
+/**
+ * \brief           Stripe lock guarding the record of trainer \p id.
+ */
+static pthread_rwlock_t *stripe_for(TrainerDB *db, int id) {
+    return &db->stripes[(uint32_t)id & (TRAINER_LOCK_STRIPES - 1)];
+}
+
+/**
+ * \brief           Acquire \p lock, timing the wait only if it blocks.
+ *
+ * \param[in]       lock        Index or stripe lock.
+ * \param[in]       exclusive   Nonzero for write mode.
+ * \param[in]       where       Metrics wait class charged for a block.
+ *
+ * \note            The try-lock keeps the uncontended path free of clock
+ *                  reads, so the metrics count genuine contention only.
+ */
+static void rwlock_acquire(pthread_rwlock_t *lock, int exclusive, metric_wait_t where) {
+    if ((exclusive ? pthread_rwlock_trywrlock(lock) : pthread_rwlock_tryrdlock(lock)) == 0)
+        return;
+
+    uint64_t start = metrics_now();
+    if (exclusive)
+        pthread_rwlock_wrlock(lock);
+    else
+        pthread_rwlock_rdlock(lock);
+    metrics_wait(where, metrics_now() - start);
+}
+
+/**
+ * \brief           Take the index lock shared / exclusive (see rwlock_acquire()).
+ */
+static void db_lock_shared(TrainerDB *db) {
+    rwlock_acquire(&db->lock, 0, MWAIT_TRAINER_SHARED);
+}
+static void db_lock_exclusive(TrainerDB *db) {
+    rwlock_acquire(&db->lock, 1, MWAIT_TRAINER_EXCL);
+}
+
+/**
+ * \brief           Take the DB lock exclusively and wait out pending writes.
+ *
+ * \note            For checkpoints, snapshot points and compaction, which
+ *                  need every logged change in the file and
+ *                  \ref TrainerDB.fd and \ref TrainerDB.snap to hold still.
+ *                  The applier never takes the DB lock, so the queue always
+ *                  drains.
+ */
+static void db_lock_quiesced(TrainerDB *db) {
+    db_lock_exclusive(db);
+    pthread_mutex_lock(&db->pending_mutex);
+    while (db->pending > 0)
+        pthread_cond_wait(&db->pending_done, &db->pending_mutex);
+    pthread_mutex_unlock(&db->pending_mutex);
+}
+
+/**
+ * \brief           Lock the stripes flagged in \p held, in stripe order.
+ *
+ * \param[in]       exclusive   Nonzero for write mode.
+ *
+ * \note            Listings and the applier take several stripes; the fixed
+ *                  order keeps them from deadlocking against each other.
+ */
+static void stripes_lock(TrainerDB *db, const uint8_t held[TRAINER_LOCK_STRIPES], int exclusive) {
+    for (int s = 0; s < TRAINER_LOCK_STRIPES; s++)
+        if (held[s]) rwlock_acquire(&db->stripes[s], exclusive, MWAIT_TRAINER_STRIPE);
+}
+
+/**
+ * \brief           Release the stripes flagged in \p held.
+ */
+static void stripes_unlock(TrainerDB *db, const uint8_t held[TRAINER_LOCK_STRIPES]) {
+    for (int s = TRAINER_LOCK_STRIPES - 1; s >= 0; s--)
+        if (held[s]) pthread_rwlock_unlock(&db->stripes[s]);
+}
+
+/**
+ * \brief           Initialize a writer-preferring rwlock.
+ *
+ * \note            glibc's default rwlock favours readers, which would let a
+ *                  steady 95%-read workload starve post/delete forever.
+ */
+static void rwlock_init_writer_pref(pthread_rwlock_t *lock) {
+    pthread_rwlockattr_t attr;
+    pthread_rwlockattr_init(&attr);
+    pthread_rwlockattr_setkind_np(&attr, PTHREAD_RWLOCK_PREFER_WRITER_NONRECURSIVE_NP);
+    pthread_rwlock_init(lock, &attr);
+    pthread_rwlockattr_destroy(&attr);
+}
+
+/* ========================================================================== */
+/* ================================ Snapshots =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Save the current record of \p slot before it is overwritten.
+ *
+ * \note            Caller holds the DB lock (any mode) or is the applier;
+ *                  either keeps \ref TrainerDB.snap stable (see
+ *                  db_lock_quiesced()). Only the first write to a slot
+ *                  the copier has not reached costs anything; a failure
+ *                  fails the snapshot, never the write.
+ */
+static void snap_preserve(TrainerDB *db, uint32_t slot) {
+    trainer_snap_t *s = db->snap;
+    if (!s || slot >= s->nslots) return;
+
+    pthread_mutex_lock(&s->mutex);
+    if (s->dirty) {
+        s->dirty[slot] = 1;
+    } else if (s->state[slot] == 0 && !s->failed) {
+        if (s->npre == s->pre_cap) {
+            size_t cap = s->pre_cap ? s->pre_cap * 2 : 64;
+            Trainer *p = realloc(s->pre, cap * sizeof(*p));
+            if (p) {
+                s->pre = p;
+                s->pre_cap = cap;
+            }
+        }
+        if (s->npre < s->pre_cap &&
+            safe_pread(db->fd, &s->pre[s->npre], sizeof(Trainer), slot_offset(slot))
+                == (ssize_t)sizeof(Trainer))
+            s->state[slot] = (uint32_t)++s->npre;
+        else
+            s->failed = 1;
+    }
+    pthread_mutex_unlock(&s->mutex);
+}
+
+/**
+ * \brief           Copy slots [\p base, \p base + \p want) as of the snapshot.
+ *
+ * \return          0 on success, -1 on read failure.
+ *
+ * \note            Holding the snapshot mutex across the pread() stops
+ *                  writers from saving (and then overwriting) these slots
+ *                  halfway through; slots they saved earlier come from
+ *                  \ref trainer_snap.pre instead of the file.
+ */
+static int snap_copy_batch(TrainerDB *db, trainer_snap_t *s, uint32_t base,
+                           size_t want, Trainer *batch) {
+    int rc = 0;
+
+    pthread_mutex_lock(&s->mutex);
+    ssize_t got = safe_pread(db->fd, batch, want * sizeof(Trainer), slot_offset(base));
+    if (got < 0 || (size_t)got != want * sizeof(Trainer)) {
+        rc = -1;
+    } else {
+        for (size_t i = 0; i < want; i++) {
+            uint32_t *st = &s->state[base + i];
+            if (*st == 0)
+                *st = SNAP_COPIED;
+            else
+                batch[i] = s->pre[*st - 1];
+        }
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return rc;
+}
+
+/**
+ * \brief           Free a snapshot's bookkeeping.
+ */
+static void snap_free(trainer_snap_t *s) {
+    if (!s) return;
+    pthread_mutex_destroy(&s->mutex);
+    free(s->state);
+    free(s->pre);
+    free(s->dirty);
+    free(s);
+}
+
+/* ========================================================================== */
+/* ============================ Write-Ahead Log ============================= */
+/* ========================================================================== */
+
+/*!< Per-thread deferred acknowledgement (see trainer_db_defer_commits()). */
+static __thread int      defer_commit;
+static __thread uint64_t deferred_lsn;
+
+/*!< Tombstone written over a deleted record's ID field. */
+static const int32_t tombstone = TRAINER_FREE_ID;
+
+/**
+ * \brief           Log one record and add its in-place write to \p w.
+ *
+ * \param[in]       slot        Slot the applier writes \p t (or a tombstone) to.
+ *
+ * \return          LSN of the record, or 0 if the log has failed (\p w is
+ *                  unchanged).
+ *
+ * \note            Caller holds the locks that ordered the mutation and
+ *                  \ref TrainerDB.pending_mutex until write_queue(), so
+ *                  requests reach the applier in log order. Without a WAL a
+ *                  private counter stands in for the LSN.
+ */
+static uint64_t write_log(TrainerDB *db, trainer_write_t *w, wal_op_t op,
+                          const Trainer *t, uint32_t slot) {
+    uint64_t lsn = db->wal ? trainer_wal_append(db->wal, op, t) : ++db->nolog_lsn;
+    if (lsn == 0) return 0;
+
+    w->ops[w->n++] = (write_op_t){ .slot = slot, .op = (uint8_t)op, .rec = *t };
+    w->lsn = lsn;
+    return lsn;
+}
+
+/**
+ * \brief           Checkpoint once the log has outgrown its threshold.
+ *
+ * \note            Skipped after a failed in-place write: the log then
+ *                  holds the only copy of that change until the next start
+ *                  replays it.
+ */
+static void wal_maybe_checkpoint(TrainerDB *db) {
+    if (atomic_load(&db->failed) || !trainer_wal_should_checkpoint(db->wal))
+        return;
+
+    /* Quiesced, every logged change is in the file */
+    db_lock_quiesced(db);
+    if (trainer_wal_should_checkpoint(db->wal))
+        trainer_wal_checkpoint(db->wal, db->fd);
+    pthread_rwlock_unlock(&db->lock);
+}
+
+/* ========================================================================== */
+/* ============================= Pending Writes ============================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Allocate an empty request for up to \p n records.
+ *
+ * \return          Request, or NULL on allocation failure.
+ */
+static trainer_write_t *write_new(size_t n) {
+    trainer_write_t *w = malloc(sizeof(*w) + n * sizeof(w->ops[0]));
+    if (w) {
+        w->next = NULL;
+        w->lsn = 0;
+        w->n = 0;
+    }
+    return w;
+}
+
+/**
+ * \brief           Hand \p w to the applier, or free it if nothing was logged.
+ *
+ * \note            Caller still holds \ref TrainerDB.pending_mutex from the
+ *                  write_log() calls that filled \p w.
+ */
+static void write_queue(TrainerDB *db, trainer_write_t *w) {
+    if (w->n == 0) {
+        free(w);
+        return;
+    }
+    *db->queue_tail = w;
+    db->queue_tail = &w->next;
+    db->pending++;
+    atomic_store(&db->queued_lsn, w->lsn);
+    pthread_cond_signal(&db->pending_work);
+}
+
+/**
+ * \brief           Latest logged contents of the trainer indexed at \p slot.
+ *
+ * \return          1 on success, 0 on read failure.
+ *
+ * \note            Caller holds the DB lock and \ref TrainerDB.pending_mutex.
+ *                  A queued or in-flight write is newer than the file; with
+ *                  neither, no write to \p slot can be under way, so the
+ *                  file is read as it is.
+ */
+static int write_latest(TrainerDB *db, uint32_t slot, Trainer *out) {
+    const write_op_t *hit = NULL;
+
+    /* Queued requests are newer than the batch being applied */
+    for (int pass = 0; pass < 2 && !hit; pass++) {
+        for (const trainer_write_t *w = pass ? db->applying : db->queue; w; w = w->next)
+            for (size_t k = 0; k < w->n; k++)
+                if (w->ops[k].slot == slot && w->ops[k].op == WAL_OP_PUT)
+                    hit = &w->ops[k];
+    }
+    if (hit) {
+        *out = hit->rec;
+        return 1;
+    }
+    return safe_pread(db->fd, out, sizeof(*out), slot_offset(slot)) == (ssize_t)sizeof(*out);
+}
+
+/**
+ * \brief           Queue slots whose tombstones are written for free_reclaim().
+ *
+ * \note            If they cannot be queued they stay dead until compaction.
+ */
+static void freed_add(TrainerDB *db, const uint32_t *slots, size_t n) {
+    pthread_mutex_lock(&db->pending_mutex);
+    if (db->nfreed + n > db->freed_cap) {
+        size_t cap = db->freed_cap ? db->freed_cap : 64;
+        while (cap < db->nfreed + n) cap *= 2;
+        uint32_t *p = realloc(db->freed, cap * sizeof(*p));
+        if (p) {
+            db->freed = p;
+            db->freed_cap = cap;
+        }
+    }
+    for (size_t i = 0; i < n && db->nfreed < db->freed_cap; i++)
+        db->freed[db->nfreed++] = slots[i];
+    pthread_mutex_unlock(&db->pending_mutex);
+}
+
+/**
+ * \brief           Describe writing \p len bytes of \p buf over \p slot.
+ */
+static storage_op_t slot_write_op(TrainerDB *db, uint32_t slot, const void *buf, size_t len) {
+    return (storage_op_t){ .fd = db->fd, .write = 1, .buf = (void *)buf, .len = len,
+                           .off = slot_offset(slot) };
+}
+
+/**
+ * \brief           Perform one chunk of a batch in place.
+ *
+ * \param[in]       src         Queued write behind each of \p ops.
+ *
+ * \note            Runs on the applier, which never takes the DB lock. The
+ *                  chunk's stripes are write-locked in stripe order, so
+ *                  readers never see a half-written record and wait for at
+ *                  most one submission.
+ */
+static void apply_chunk(TrainerDB *db, storage_op_t *ops, const write_op_t **src, size_t n) {
+    uint8_t held[TRAINER_LOCK_STRIPES] = { 0 };
+    uint32_t freed[TRAINER_BATCH_MAX];
+    size_t nfreed = 0;
+
+    for (size_t j = 0; j < n; j++)
+        held[(uint32_t)src[j]->rec.id & (TRAINER_LOCK_STRIPES - 1)] = 1;
+    stripes_lock(db, held, 1);
+    for (size_t j = 0; j < n; j++)
+        snap_preserve(db, src[j]->slot);
+    storage_io_batch(ops, n);
+    stripes_unlock(db, held);
+
+    for (size_t j = 0; j < n; j++) {
+        if (ops[j].result != (ssize_t)ops[j].len) {
+            if (!atomic_exchange(&db->failed, 1))
+                fprintf(stderr, "[Server] %s: write of slot %u failed.\n", db->path, src[j]->slot);
+        } else if (src[j]->op == WAL_OP_DELETE) {
+            freed[nfreed++] = src[j]->slot;
+        }
+    }
+    if (nfreed > 0)
+        freed_add(db, freed, nfreed);
+}
+
+/**
+ * \brief           Write every record of \p batch in place, in log order.
+ *
+ * \note            Up to TRAINER_BATCH_MAX slots go out per submission. A
+ *                  later write to a slot replaces an earlier one of the
+ *                  same chunk, since two writes to one slot must not race
+ *                  in a submission.
+ */
+static void apply_batch(TrainerDB *db, const trainer_write_t *batch) {
+    storage_op_t ops[TRAINER_BATCH_MAX];
+    const write_op_t *src[TRAINER_BATCH_MAX];
+    size_t n = 0;
+
+    for (const trainer_write_t *w = batch; w; w = w->next) {
+        for (size_t k = 0; k < w->n; k++) {
+            const write_op_t *op = &w->ops[k];
+            size_t j = 0;
+            while (j < n && src[j]->slot != op->slot) j++;
+            if (j == TRAINER_BATCH_MAX) {
+                apply_chunk(db, ops, src, n);
+                n = j = 0;
+            }
+            src[j] = op;
+            ops[j] = op->op == WAL_OP_DELETE
+                   ? slot_write_op(db, op->slot, &tombstone, sizeof(tombstone))
+                   : slot_write_op(db, op->slot, &op->rec, sizeof(op->rec));
+            if (j == n) n++;
+        }
+    }
+    if (n > 0)
+        apply_chunk(db, ops, src, n);
+}
+
+/**
+ * \brief           Applier loop: wait for queued requests to be durable,
+ *                  then write them in place.
+ *
+ * \note            Takes the whole queue at once, so one commit wait covers
+ *                  every request logged meanwhile. The writes go ahead even
+ *                  if the commit failed, because the index has already
+ *                  changed; the log stays failed and the requests report
+ *                  it.
+ */
+static void *applier_thread(void *arg) {
+    TrainerDB *db = arg;
+
+    /* Where io_uring is available, each chunk is one submission */
+    storage_ring_t *ring = storage_ring_create();
+    storage_ring_bind(ring);
+
+    pthread_mutex_lock(&db->pending_mutex);
+    for (;;) {
+        while (!db->queue && !db->applier_stop)
+            pthread_cond_wait(&db->pending_work, &db->pending_mutex);
+        if (!db->queue)
+            break;
+
+        trainer_write_t *batch = db->queue;
+        uint64_t upto = atomic_load(&db->queued_lsn);
+        int taken = db->pending;
+        db->applying = batch;
+        db->queue = NULL;
+        db->queue_tail = &db->queue;
+        pthread_mutex_unlock(&db->pending_mutex);
+
+        if (db->wal)
+            trainer_wal_commit(db->wal, upto);
+        apply_batch(db, batch);
+
+        pthread_mutex_lock(&db->pending_mutex);
+        db->applying = NULL;
+        db->pending -= taken;
+        atomic_store(&db->applied_lsn, upto);
+        pthread_cond_broadcast(&db->pending_done);
+        while (batch) {
+            trainer_write_t *next = batch->next;
+            free(batch);
+            batch = next;
+        }
+    }
+    pthread_mutex_unlock(&db->pending_mutex);
+
+    storage_ring_bind(NULL);
+    storage_ring_destroy(ring);
+    return NULL;
+}
+
+/**
+ * \brief           Finish a queued request once all its locks are released.
+ *
+ * \param[in]       lsn         LSN of its last record.
+ *
+ * \return          1 once it is durable and written in place, 0 on failure.
+ *
+ * \note            Nothing is held while waiting, so posts and gets carry
+ *                  on through the sync. In deferred mode (with a WAL) it
+ *                  returns at once and leaves \p lsn for
+ *                  trainer_db_take_commit() instead.
+ */
+static int write_finish(TrainerDB *db, uint64_t lsn) {
+    if (defer_commit && db->wal) {
+        if (lsn > deferred_lsn)
+            deferred_lsn = lsn;
+        return 1;
+    }
+
+    uint64_t start = metrics_now();
+    pthread_mutex_lock(&db->pending_mutex);
+    while (atomic_load(&db->applied_lsn) < lsn)
+        pthread_cond_wait(&db->pending_done, &db->pending_mutex);
+    pthread_mutex_unlock(&db->pending_mutex);
+    metrics_wait(MWAIT_WAL_COMMIT, metrics_now() - start);
+
+    if (!db->wal)
+        return !atomic_load(&db->failed);
+    int ok = trainer_wal_commit(db->wal, lsn) == 0 && !atomic_load(&db->failed);
+    wal_maybe_checkpoint(db);
+    return ok;
+}
+
+/*!< Forward declarations for replay. */
+static int insert_locked(TrainerDB *db, const Trainer *t);
+static int update_locked(TrainerDB *db, const Trainer *t);
+static int delete_locked(TrainerDB *db, int id);
+
+/**
+ * \brief           Reapply one logged mutation (wal_apply_fn).
+ *
+ * \note            Idempotent: the file may already hold any prefix of the
+ *                  logged changes, so a put overwrites or inserts and a
+ *                  delete of a missing trainer is a no-op.
+ */
+static int replay_apply(wal_op_t op, const Trainer *rec, void *ctx) {
+    TrainerDB *db = ctx;
+
+    if (rec->id <= TRAINER_FREE_ID) return 0;
+    if (op == WAL_OP_DELETE) {
+        delete_locked(db, rec->id);
+        return 0;
+    }
+    if (index_find(db, rec->id) != (size_t)-1)
+        return update_locked(db, rec) ? 0 : -1;
+    return insert_locked(db, rec);
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Open the trainer file and build its ID index.
+ *
+ * \param[in]       path        Trainer binary file (created if missing).
+ *
+ * \return          Open database, or NULL on failure.
+ */
+TrainerDB *trainer_db_open(const char *path) {
+    TrainerDB *db = calloc(1, sizeof(*db));
+    if (!db) return NULL;
+
+    snprintf(db->path, sizeof(db->path), "%s", path);
+    db->next_id = 1;
+    db->id_first = 1;
+    db->id_step = 1;
+    db->cap = TRAINER_INDEX_MIN;
+    db->keys = calloc(db->cap, sizeof(*db->keys));
+    db->slots = calloc(db->cap, sizeof(*db->slots));
+
+    rwlock_init_writer_pref(&db->lock);
+    for (int i = 0; i < TRAINER_LOCK_STRIPES; i++)
+        pthread_rwlock_init(&db->stripes[i], NULL);
+    pthread_mutex_init(&db->pending_mutex, NULL);
+    pthread_cond_init(&db->pending_work, NULL);
+    pthread_cond_init(&db->pending_done, NULL);
+    db->queue_tail = &db->queue;
+
+    db->fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (db->fd < 0) perror("[Server] open()");
+
+    if (db->fd < 0 || !db->keys || !db->slots || index_rebuild(db) < 0) {
+        trainer_db_close(db);
+        return NULL;
+    }
+    if (pthread_create(&db->applier, NULL, applier_thread, db) != 0) {
+        perror("[Server] pthread_create(applier)");
+        trainer_db_close(db);
+        return NULL;
+    }
+    db->applier_started = 1;
+    return db;
+}
+
+/**
+ * \brief           Close the descriptor and free the index.
+ */
+void trainer_db_close(TrainerDB *db) {
+    if (!db) return;
+    /* A clean shutdown leaves the file durable and the log empty */
+    if (db->wal)
+        trainer_db_checkpoint(db);
+    if (db->applier_started) {
+        pthread_mutex_lock(&db->pending_mutex);
+        db->applier_stop = 1;
+        pthread_cond_signal(&db->pending_work);
+        pthread_mutex_unlock(&db->pending_mutex);
+        pthread_join(db->applier, NULL);
+    }
+    if (db->wal)
+        trainer_wal_close(db->wal);
+    if (db->fd >= 0) close(db->fd);
+    pthread_rwlock_destroy(&db->lock);
+    for (int i = 0; i < TRAINER_LOCK_STRIPES; i++)
+        pthread_rwlock_destroy(&db->stripes[i]);
+    pthread_mutex_destroy(&db->pending_mutex);
+    pthread_cond_destroy(&db->pending_work);
+    pthread_cond_destroy(&db->pending_done);
+    free(db->freed);
+    free(db->keys);
+    free(db->slots);
+    free(db->free_slots);
+    free(db->order);
+    free(db);
+}
+
+/**
+ * \brief           Hand out only IDs congruent to \p first modulo \p step.
+ */
+void trainer_db_set_id_sequence(TrainerDB *db, int first, int step) {
+    int max_id = db->next_id - 1;
+    db->id_first = first;
+    db->id_step = step;
+    db->next_id = id_after(db, max_id);
+}
+
+/**
+ * \brief           Replay the log next to the DB file and attach a new one.
+ *
+ * \return          Records replayed, or -1 on failure.
+ */
+long trainer_db_enable_wal(TrainerDB *db, int commit_ms, _Atomic uint64_t *clock) {
+    char wal_path[sizeof(db->path) + 8];
+    snprintf(wal_path, sizeof(wal_path), "%s.wal", db->path);
+
+    long replayed = trainer_wal_replay(wal_path, replay_apply, db);
+
+    /* Replayed inserts may be out of ID order; the file must be durable
+     * before trainer_wal_open() truncates the log it came from */
+    if (replayed < 0 || order_rebuild(db) < 0 || fdatasync(db->fd) < 0)
+        return -1;
+
+    db->wal = trainer_wal_open(wal_path, commit_ms, clock);
+    return db->wal ? replayed : -1;
+}
+
+/**
+ * \brief           Switch the calling thread between blocking and deferred acks.
+ */
+void trainer_db_defer_commits(int on) {
+    defer_commit = on;
+}
+
+/**
+ * \brief           Return and clear the calling thread's deferred LSN.
+ */
+uint64_t trainer_db_take_commit(void) {
+    uint64_t lsn = deferred_lsn;
+    deferred_lsn = 0;
+    return lsn;
+}
+
+/**
+ * \brief           Non-blocking check that a deferred commit is durable and
+ *                  written in place.
+ *
+ * \return          1 if done, 0 if pending, -1 on log or write failure.
+ *
+ * \note            Lock-free until the very end, so a reactor polling it
+ *                  never waits behind a writer. With nothing queued, LSNs
+ *                  of other shards count as done.
+ */
+int trainer_db_commit_status(TrainerDB *db, uint64_t lsn) {
+    if (!db->wal || lsn == 0) return 1;
+
+    uint64_t applied = atomic_load(&db->applied_lsn);
+    if (applied < lsn && applied < atomic_load(&db->queued_lsn))
+        return 0;
+
+    int st = atomic_load(&db->failed) ? -1 : trainer_wal_status(db->wal, lsn);
+    if (st == 1)
+        wal_maybe_checkpoint(db);
+    return st;
+}
+
+/**
+ * \brief           Checkpoint the log under the exclusive DB lock.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int trainer_db_checkpoint(TrainerDB *db) {
+    if (!db->wal) return 0;
+
+    /* After a failed in-place write only the log still has the change */
+    db_lock_quiesced(db);
+    int rc = atomic_load(&db->failed) ? -1 : trainer_wal_checkpoint(db->wal, db->fd);
+    pthread_rwlock_unlock(&db->lock);
+    return rc;
+}
+
+/**
+ * \brief           Look up \p id in the index and read its record.
+ *
+ * \return          1 if found, 0 otherwise.
+ *
+ * \note            Shared index lock plus the record's stripe in read mode:
+ *                  gets run in parallel with each other and with writes to
+ *                  other stripes. A trainer whose insert is not yet written
+ *                  in place (not yet acknowledged either) is not found.
+ */
+int trainer_db_get(TrainerDB *db, int id, Trainer *out) {
+    if (id <= 0) return 0;
+
+    db_lock_shared(db);
+    int found = 0;
+    size_t i = index_find(db, id);
+    if (i != (size_t)-1) {
+        pthread_rwlock_t *stripe = stripe_for(db, id);
+        rwlock_acquire(stripe, 0, MWAIT_TRAINER_STRIPE);
+        ssize_t n = safe_pread(db->fd, out, sizeof(*out), slot_offset(db->slots[i]));
+        pthread_rwlock_unlock(stripe);
+        found = n == (ssize_t)sizeof(*out) && out->id == id;
+    }
+    pthread_rwlock_unlock(&db->lock);
+    return found;
+}
+
+/**
+ * \brief           Give \p t (ID already set) a free slot or one at the end.
+ *
+ * \param[out]      slot        Slot the caller must write \p t to.
+ *
+ * \return          0 on success, -1 on allocation failure (nothing changed).
+ *
+ * \note            Caller holds the DB lock exclusively and has run
+ *                  free_reclaim(). Only the index, ID order and slot
+ *                  bookkeeping change here.
+ */
+static int reserve_locked(TrainerDB *db, const Trainer *t, uint32_t *slot) {
+    int reuse = db->nfree > 0;
+    *slot = reuse ? db->free_slots[db->nfree - 1] : db->nslots;
+
+    if (index_put(db, t->id, *slot) < 0)
+        return -1;
+
+    /* Without an order entry the trainer would be missing from listings */
+    if (order_push(db, t->id) < 0) {
+        index_remove(db, t->id);
+        return -1;
+    }
+
+    if (reuse)
+        db->nfree--;
+    else
+        db->nslots++;
+    if (t->id >= db->next_id)
+        db->next_id = id_after(db, t->id);
+    return 0;
+}
+
+/**
+ * \brief           Drop \p id from the index and ID order.
+ *
+ * \return          Slot it occupied, or UINT32_MAX if it is not stored.
+ *
+ * \note            Caller holds the DB lock exclusively; the tombstone is
+ *                  written (and the slot freed) by the applier.
+ */
+static uint32_t unindex_locked(TrainerDB *db, int id) {
+    size_t i = index_find(db, id);
+    if (i == (size_t)-1) return UINT32_MAX;
+
+    uint32_t slot = db->slots[i];
+    index_remove(db, id);
+    db->order_stale++;
+    order_prune(db);
+    return slot;
+}
+
+/**
+ * \brief           Undo reserve_locked() for a trainer that was never logged.
+ *
+ * \note            Caller holds the DB lock exclusively. Undo the most
+ *                  recent reservation first, so an appended slot is always
+ *                  the last one.
+ */
+static void unreserve_locked(TrainerDB *db, int id, uint32_t slot) {
+    unindex_locked(db, id);
+    if (slot + 1 == db->nslots)
+        db->nslots--;
+    else
+        free_push(db, slot);        /* On failure the slot stays dead */
+}
+
+/**
+ * \brief           Store \p t (ID already set) in a free slot or at the end.
+ *
+ * \return          0 on success, -1 on failure.
+ *
+ * \note            For replay: caller holds the DB lock exclusively and
+ *                  nothing is pending. The record is written before it is
+ *                  indexed; reserve_locked() then picks the same slot.
+ */
+static int insert_locked(TrainerDB *db, const Trainer *t) {
+    free_reclaim(db);
+    uint32_t slot = db->nfree > 0 ? db->free_slots[db->nfree - 1] : db->nslots;
+
+    snap_preserve(db, slot);
+    if (safe_pwrite(db->fd, t, sizeof(*t), slot_offset(slot)) != (ssize_t)sizeof(*t))
+        return -1;
+    return reserve_locked(db, t, &slot);
+}
+
+/**
+ * \brief           Store \p t under the next ID, reusing a free slot if any.
+ *
+ * \return          New ID, or -1 on failure.
+ *
+ * \note            The index changes under the exclusive DB lock, together
+ *                  with the log append. The applier writes the record once
+ *                  it is durable; no lock is held meanwhile.
+ */
+int trainer_db_add(TrainerDB *db, Trainer *t) {
+    trainer_write_t *w = write_new(1);
+    if (!w) return -1;
+
+    db_lock_exclusive(db);
+    free_reclaim(db);
+    t->id = db->next_id;
+
+    uint32_t slot;
+    uint64_t lsn = 0;
+    if (reserve_locked(db, t, &slot) == 0) {
+        pthread_mutex_lock(&db->pending_mutex);
+        lsn = write_log(db, w, WAL_OP_PUT, t, slot);
+        if (lsn == 0) {
+            unreserve_locked(db, t->id, slot);
+            db->next_id = t->id;
+        }
+        write_queue(db, w);
+        pthread_mutex_unlock(&db->pending_mutex);
+    } else {
+        free(w);
+    }
+    pthread_rwlock_unlock(&db->lock);
+
+    return lsn && write_finish(db, lsn) ? t->id : -1;
+}
+
+/**
+ * \brief           Write \p t over the slot of an indexed trainer.
+ *
+ * \note            For replay: caller holds the DB lock exclusively.
+ */
+static int update_locked(TrainerDB *db, const Trainer *t) {
+    size_t i = index_find(db, t->id);
+    if (i == (size_t)-1) return 0;
+
+    snap_preserve(db, db->slots[i]);
+    ssize_t n = safe_pwrite(db->fd, t, sizeof(*t), slot_offset(db->slots[i]));
+    return n == (ssize_t)sizeof(*t);
+}
+
+/**
+ * \brief           Overwrite the record for \p t->id in place.
+ *
+ * \return          1 on success, 0 if not found or on write failure.
+ *
+ * \note            Logged and queued under the shared DB lock and
+ *                  \ref TrainerDB.pending_mutex, so puts to one trainer
+ *                  reach the log and the file in the same order.
+ */
+int trainer_db_update(TrainerDB *db, const Trainer *t) {
+    if (t->id <= 0) return 0;
+
+    trainer_write_t *w = write_new(1);
+    if (!w) return 0;
+
+    db_lock_shared(db);
+    pthread_mutex_lock(&db->pending_mutex);
+    size_t i = index_find(db, t->id);
+    uint64_t lsn = i != (size_t)-1 ? write_log(db, w, WAL_OP_PUT, t, db->slots[i]) : 0;
+    write_queue(db, w);
+    pthread_mutex_unlock(&db->pending_mutex);
+    pthread_rwlock_unlock(&db->lock);
+
+    return lsn && write_finish(db, lsn);
+}
+
+/**
+ * \brief           Replace a trainer's team as one read-modify-write.
+ *
+ * \return          1 on success, 0 if not found or on I/O failure.
+ *
+ * \note            The read, the log append and the queueing share one
+ *                  hold of \ref TrainerDB.pending_mutex, and the read sees
+ *                  writes still queued for the trainer, so no put to it can
+ *                  slip in between. No stripe is taken.
+ */
+int trainer_db_set_team(TrainerDB *db, int id, const int *ids, int count) {
+    if (id <= 0 || count < 0 || count > MAX_POKEMON) return 0;
+
+    trainer_write_t *w = write_new(1);
+    if (!w) return 0;
+
+    db_lock_shared(db);
+    pthread_mutex_lock(&db->pending_mutex);
+    uint64_t lsn = 0;
+    Trainer t;
+    size_t i = index_find(db, id);
+    if (i != (size_t)-1 && write_latest(db, db->slots[i], &t) && t.id == id) {
+        for (int k = 0; k < count; k++) t.pokemon_ids[k] = ids[k];
+        t.count = count;
+        lsn = write_log(db, w, WAL_OP_PUT, &t, db->slots[i]);
+    }
+    write_queue(db, w);
+    pthread_mutex_unlock(&db->pending_mutex);
+    pthread_rwlock_unlock(&db->lock);
+
+    return lsn && write_finish(db, lsn);
+}
+
+/**
+ * \brief           Tombstone the slot of \p id and queue it for reuse.
+ *
+ * \return          1 if the trainer existed and was removed, 0 otherwise.
+ *
+ * \note            For replay: caller holds the DB lock exclusively.
+ */
+static int delete_locked(TrainerDB *db, int id) {
+    size_t i = index_find(db, id);
+    if (i == (size_t)-1) return 0;
+
+    uint32_t slot = db->slots[i];
+    int32_t tomb = TRAINER_FREE_ID;
+    snap_preserve(db, slot);
+    if (safe_pwrite(db->fd, &tomb, sizeof(tomb), slot_offset(slot)) != (ssize_t)sizeof(tomb))
+        return 0;
+
+    unindex_locked(db, id);
+
+    /* If the free list cannot grow the slot simply stays dead until compaction */
+    free_push(db, slot);
+    return 1;
+}
+
+/**
+ * \brief           Tombstone a trainer's slot and queue it for reuse.
+ *
+ * \return          1 if the trainer existed and was removed, 0 otherwise.
+ *
+ * \note            Only the 4-byte ID field is rewritten, so a delete costs
+ *                  one small pwrite() regardless of file size. The slot is
+ *                  reusable once the applier has written the tombstone.
+ */
+int trainer_db_delete(TrainerDB *db, int id) {
+    if (id <= 0) return 0;
+
+    trainer_write_t *w = write_new(1);
+    if (!w) return 0;
+
+    Trainer gone = { .id = id };
+    uint64_t lsn = 0;
+    db_lock_exclusive(db);
+    size_t i = index_find(db, id);
+    if (i != (size_t)-1) {
+        pthread_mutex_lock(&db->pending_mutex);
+        lsn = write_log(db, w, WAL_OP_DELETE, &gone, db->slots[i]);
+        if (lsn)
+            unindex_locked(db, id);
+        write_queue(db, w);
+        pthread_mutex_unlock(&db->pending_mutex);
+    } else {
+        free(w);
+    }
+    pthread_rwlock_unlock(&db->lock);
+
+    return lsn && write_finish(db, lsn);
+}
+
+/**
+ * \brief           Read several trainers under one shared lock acquisition.
+ *
+ * \return          Number of IDs found.
+ *
+ * \note            The stripes of every requested ID are read-locked in
+ *                  stripe order for the batch, so it never observes a
+ *                  half-written record; the applier takes its stripes in
+ *                  the same order, so this cannot deadlock. The records
+ *                  are then read as one storage_io_batch(), which is a
+ *                  single io_uring submission on threads that bound a ring.
+ *                  The submission list is allocated, not on the caller's
+ *                  (small) session stack; without memory nothing is found.
+ */
+size_t trainer_db_get_many(TrainerDB *db, const int *ids, size_t n,
+                           Trainer *out, uint8_t *found) {
+    storage_op_t *ops = malloc(TRAINER_BATCH_MAX * (sizeof(*ops) + sizeof(size_t)));
+    size_t *which = (size_t *)(ops + TRAINER_BATCH_MAX);
+    size_t hits = 0;
+
+    if (!ops) {
+        memset(found, 0, n);
+        return 0;
+    }
+
+    for (size_t base = 0; base < n; base += TRAINER_BATCH_MAX) {
+        size_t end = n - base < TRAINER_BATCH_MAX ? n : base + TRAINER_BATCH_MAX;
+        uint8_t held[TRAINER_LOCK_STRIPES] = { 0 };
+        size_t nops = 0;
+
+        db_lock_shared(db);
+        for (size_t k = base; k < end; k++) {
+            found[k] = 0;
+            size_t i = ids[k] > 0 ? index_find(db, ids[k]) : (size_t)-1;
+            if (i == (size_t)-1) continue;
+            held[(uint32_t)ids[k] & (TRAINER_LOCK_STRIPES - 1)] = 1;
+            ops[nops] = (storage_op_t){ .fd = db->fd, .buf = &out[k], .len = sizeof(out[k]),
+                                        .off = slot_offset(db->slots[i]) };
+            which[nops++] = k;
+        }
+
+        stripes_lock(db, held, 0);
+        storage_io_batch(ops, nops);
+        stripes_unlock(db, held);
+        pthread_rwlock_unlock(&db->lock);
+
+        /* A slot whose insert is still queued holds some other record */
+        for (size_t j = 0; j < nops; j++) {
+            if (ops[j].result == (ssize_t)ops[j].len && out[which[j]].id == ids[which[j]]) {
+                found[which[j]] = 1;
+                hits++;
+            }
+        }
+    }
+    free(ops);
+    return hits;
+}
+
+/**
+ * \brief           Store a batch of new trainers under consecutive IDs.
+ *
+ * \return          \p n once the batch is durable, 0 for an empty batch, or
+ *                  -1 on failure.
+ *
+ * \note            All or nothing: every slot is reserved before the first
+ *                  record is logged, and a failure to reserve or log undoes
+ *                  the whole batch and clears each ts[k].id to 0. Only a
+ *                  failed commit leaves the IDs set, because the batch is
+ *                  then indexed but not durable. The batch is queued as one
+ *                  request, so it shares a single group commit and is
+ *                  written in place by one storage_io_batch().
+ */
+long trainer_db_add_many(TrainerDB *db, Trainer *ts, size_t n) {
+    size_t done = 0;
+    uint64_t lsn = 0;
+
+    if (n == 0) return 0;
+    if (n > TRAINER_BATCH_MAX) return -1;
+    trainer_write_t *w = write_new(n);
+    if (!w) return -1;
+    uint32_t *slots = malloc(n * sizeof(*slots));
+    if (!slots) {
+        free(w);
+        return -1;
+    }
+
+    db_lock_exclusive(db);
+    free_reclaim(db);
+    int first = db->next_id;
+    for (; done < n; done++) {
+        ts[done].id = db->next_id;
+        if (reserve_locked(db, &ts[done], &slots[done]) < 0)
+            break;
+    }
+
+    pthread_mutex_lock(&db->pending_mutex);
+    for (size_t k = 0; done == n && k < n; k++) {
+        lsn = write_log(db, w, WAL_OP_PUT, &ts[k], slots[k]);
+        if (lsn == 0)
+            done = k;   /* The log failed; nothing more can become durable */
+    }
+    if (done == n) {
+        write_queue(db, w);
+    } else {
+        /* Undo newest first so an appended slot is always the last one */
+        while (done > 0) {
+            done--;
+            unreserve_locked(db, ts[done].id, slots[done]);
+        }
+        for (size_t k = 0; k < n; k++)
+            ts[k].id = 0;
+        db->next_id = first;
+        free(w);
+    }
+    pthread_mutex_unlock(&db->pending_mutex);
+    pthread_rwlock_unlock(&db->lock);
+    free(slots);
+
+    return lsn && write_finish(db, lsn) ? (long)n : -1;
+}
+
+/**
+ * \brief           Tombstone a batch of trainers under one exclusive lock.
+ *
+ * \return          Number removed, or -1 if the commit failed.
+ */
+long trainer_db_delete_many(TrainerDB *db, const int *ids, size_t n, uint8_t *deleted) {
+    size_t removed = 0;
+    uint64_t lsn = 0;
+
+    for (size_t k = TRAINER_BATCH_MAX; k < n; k++)
+        deleted[k] = 0;
+    if (n > TRAINER_BATCH_MAX) n = TRAINER_BATCH_MAX;
+    trainer_write_t *w = write_new(n);
+    if (!w) return -1;
+
+    db_lock_exclusive(db);
+    pthread_mutex_lock(&db->pending_mutex);
+    for (size_t k = 0; k < n; k++) {
+        deleted[k] = 0;
+        size_t i = ids[k] > 0 ? index_find(db, ids[k]) : (size_t)-1;
+        if (i == (size_t)-1) continue;
+
+        Trainer gone = { .id = ids[k] };
+        uint64_t l = write_log(db, w, WAL_OP_DELETE, &gone, db->slots[i]);
+        if (l == 0) break;
+        lsn = l;
+        unindex_locked(db, ids[k]);
+        deleted[k] = 1;
+        removed++;
+    }
+    write_queue(db, w);
+    pthread_mutex_unlock(&db->pending_mutex);
+    pthread_rwlock_unlock(&db->lock);
+
+    return removed == 0 || write_finish(db, lsn) ? (long)removed : -1;
+}
+
+/**
+ * \brief           Apply replicated mutations under one exclusive lock.
+ *
+ * \return          Number applied (a prefix of \p recs), or -1 if the
+ *                  batch did not become durable.
+ *
+ * \note            The records go through the same queue as local writes,
+ *                  so readers only wait for the index changes, never for
+ *                  the follower's sync.
+ */
+long trainer_db_apply(TrainerDB *db, const wal_record_t *recs, size_t n) {
+    size_t done = 0;
+    uint64_t lsn = 0;
+
+    if (n == 0) return 0;
+    trainer_write_t *w = write_new(n);
+    if (!w) return -1;
+
+    db_lock_exclusive(db);
+    free_reclaim(db);
+    pthread_mutex_lock(&db->pending_mutex);
+    for (; done < n; done++) {
+        const Trainer *rec = &recs[done].rec;
+        size_t i = rec->id > TRAINER_FREE_ID ? index_find(db, rec->id) : (size_t)-1;
+        uint32_t slot;
+        uint64_t l;
+
+        /* Like replay: a put inserts or overwrites, a stale delete is a no-op */
+        if (rec->id <= TRAINER_FREE_ID || (recs[done].op == WAL_OP_DELETE && i == (size_t)-1))
+            continue;
+        if (recs[done].op == WAL_OP_DELETE) {
+            if ((l = write_log(db, w, WAL_OP_DELETE, rec, db->slots[i])) == 0) break;
+            unindex_locked(db, rec->id);
+        } else if (i != (size_t)-1) {
+            if ((l = write_log(db, w, WAL_OP_PUT, rec, db->slots[i])) == 0) break;
+        } else {
+            if (reserve_locked(db, rec, &slot) < 0) break;
+            if ((l = write_log(db, w, WAL_OP_PUT, rec, slot)) == 0) {
+                unreserve_locked(db, rec->id, slot);
+                break;
+            }
+        }
+        lsn = l;
+    }
+    write_queue(db, w);
+    pthread_mutex_unlock(&db->pending_mutex);
+    pthread_rwlock_unlock(&db->lock);
+
+    if (lsn && !write_finish(db, lsn))
+        return -1;
+    return (long)done;
+}
+
+/**
+ * \brief           Stream every stored trainer to \p fn in file order.
+ *
+ * \return          0 on completion or early stop, -1 on read error.
+ *
+ * \note            Holds the DB lock shared for the whole scan: listings run
+ *                  alongside gets and puts, and only post/delete wait. Each
+ *                  batch is read under every stripe's read lock, so no
+ *                  record is seen half-written; \p fn runs after they are
+ *                  released, so the applier waits for one read at most.
+ */
+int trainer_db_scan(TrainerDB *db, trainer_visit_fn fn, void *ctx) {
+    Trainer batch[TRAINER_SCAN_BATCH];
+    uint8_t all[TRAINER_LOCK_STRIPES];
+    int rc = 0;
+
+    memset(all, 1, sizeof(all));
+    db_lock_shared(db);
+    for (uint32_t base = 0; base < db->nslots; base += TRAINER_SCAN_BATCH) {
+        size_t want = db->nslots - base;
+        if (want > TRAINER_SCAN_BATCH) want = TRAINER_SCAN_BATCH;
+
+        stripes_lock(db, all, 0);
+        ssize_t got = safe_pread(db->fd, batch, want * sizeof(Trainer), slot_offset(base));
+        stripes_unlock(db, all);
+        if (got < 0) {
+            rc = -1;
+            break;
+        }
+
+        size_t n = (size_t)got / sizeof(Trainer);
+        int stop = 0;
+        for (size_t i = 0; i < n && !stop; i++) {
+            if (batch[i].id <= TRAINER_FREE_ID) continue;
+            stop = fn(&batch[i], ctx);
+        }
+        if (stop || n < want) break;
+    }
+    pthread_rwlock_unlock(&db->lock);
+    return rc;
+}
+
+/**
+ * \brief           Read up to \p want trainers of the ID order from \p *k on.
+ *
+ * \param[in,out]   k           Position in \ref TrainerDB.order, advanced
+ *                              past every entry looked at.
+ * \param[out]      span        Scratch of TRAINER_PAGE_MAX records.
+ * \param[out]      ops         Scratch of TRAINER_PAGE_MAX transfers.
+ *
+ * \return          Records stored in \p out, or -1 on read error.
+ *
+ * \note            Caller holds the DB lock shared. As in
+ *                  trainer_db_get_many(), the read locks of the stripes
+ *                  involved (in stripe order) are held while reading, so
+ *                  every record is whole. Trainers whose insert is still
+ *                  queued are left out, so fewer than \p want may come back
+ *                  before the order ends.
+ */
+static int page_fill(TrainerDB *db, size_t *k, Trainer *out, int want,
+                     Trainer *span, storage_op_t *ops) {
+    uint32_t slots[TRAINER_PAGE_MAX];
+    int32_t ids[TRAINER_PAGE_MAX];
+    uint8_t held[TRAINER_LOCK_STRIPES] = { 0 };
+    int n = 0, kept = 0;
+
+    /* Resolve the next live IDs to slots, skipping deleted entries */
+    uint32_t lo = UINT32_MAX, hi = 0;
+    for (; *k < db->norder && n < want; (*k)++) {
+        size_t i = index_find(db, db->order[*k]);
+        if (i == (size_t)-1) continue;
+        held[(uint32_t)db->order[*k] & (TRAINER_LOCK_STRIPES - 1)] = 1;
+        ids[n] = db->order[*k];
+        slots[n++] = db->slots[i];
+        if (db->slots[i] < lo) lo = db->slots[i];
+        if (db->slots[i] > hi) hi = db->slots[i];
+    }
+    if (n == 0) return 0;
+
+    stripes_lock(db, held, 0);
+    if (hi - lo < TRAINER_PAGE_MAX) {
+        /* Neighbouring slots (the common case): read them in one go; a
+         * queued append past the end of the file just reads short */
+        ssize_t got = safe_pread(db->fd, span, (size_t)(hi - lo + 1) * sizeof(Trainer),
+                                 slot_offset(lo));
+        size_t whole = got > 0 ? (size_t)got / sizeof(Trainer) : 0;
+        if (got < 0) kept = -1;
+        for (int j = 0; j < n && kept >= 0; j++)
+            if (slots[j] - lo < whole && span[slots[j] - lo].id == ids[j])
+                out[kept++] = span[slots[j] - lo];
+    } else {
+        /* Scattered slots: one batch of reads (one submission with a ring) */
+        for (int j = 0; j < n; j++)
+            ops[j] = (storage_op_t){ .fd = db->fd, .buf = &span[j], .len = sizeof(Trainer),
+                                     .off = slot_offset(slots[j]) };
+        storage_io_batch(ops, (size_t)n);
+        for (int j = 0; j < n && kept >= 0; j++) {
+            if (ops[j].result < 0)
+                kept = -1;
+            else if (ops[j].result == (ssize_t)sizeof(Trainer) && span[j].id == ids[j])
+                out[kept++] = span[j];
+        }
+    }
+    stripes_unlock(db, held);
+    return kept;
+}
+
+/**
+ * \brief           Fill \p out with the trainers following \p after_id by ID.
+ *
+ * \return          Records returned, or -1 on read error.
+ *
+ * \note            Fewer than \p max only at the end of the ID order, even
+ *                  if some trainers on the way were skipped by page_fill().
+ *                  The read scratch is allocated, since listings run on
+ *                  small session stacks.
+ */
+int trainer_db_page(TrainerDB *db, int after_id, Trainer *out, int max) {
+    int n = 0;
+
+    if (max > TRAINER_PAGE_MAX) max = TRAINER_PAGE_MAX;
+    if (max <= 0) return 0;
+    storage_op_t *ops = malloc(TRAINER_PAGE_MAX * (sizeof(*ops) + sizeof(Trainer)));
+    if (!ops) return -1;
+    Trainer *span = (Trainer *)(ops + TRAINER_PAGE_MAX);
+
+    db_lock_shared(db);
+    size_t k = order_lower_bound(db, after_id);
+    while (n < max && k < db->norder) {
+        int got = page_fill(db, &k, out + n, max - n, span, ops);
+        if (got < 0) {
+            n = -1;
+            break;
+        }
+        n += got;
+    }
+    pthread_rwlock_unlock(&db->lock);
+    free(ops);
+    return n;
+}
+
+/* ========================================================================== */
+/* =============================== Compaction =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Bring \<path\>.compact up to date with writes made during the copy.
+ *
+ * \param[in,out]   moved       Old slot -> new slot (UINT32_MAX: not copied),
+ *                              grown to cover slots appended since.
+ * \param[in,out]   out         Records in \p tmp.
+ *
+ * \return          0 on success, -1 on failure (nothing in \p db changed).
+ *
+ * \note            Caller holds the DB lock quiesced. Only dirty slots and
+ *                  slots appended after the compaction point are read;
+ *                  a copied slot that has since been deleted keeps its place
+ *                  as a tombstone (marked 2 in \ref trainer_snap.dirty).
+ */
+static int compact_catch_up(TrainerDB *db, trainer_snap_t *s, int tmp,
+                            uint32_t **moved, uint32_t *out) {
+    uint32_t *m = realloc(*moved, (db->nslots ? db->nslots : 1) * sizeof(*m));
+    if (!m) return -1;
+    *moved = m;
+
+    for (uint32_t slot = 0; slot < db->nslots; slot++) {
+        if (slot >= s->nslots)
+            m[slot] = UINT32_MAX;
+        else if (!s->dirty[slot])
+            continue;
+
+        Trainer t;
+        if (safe_pread(db->fd, &t, sizeof(t), slot_offset(slot)) != (ssize_t)sizeof(t))
+            t.id = TRAINER_FREE_ID;     /* A failed append left nothing there */
+        if (t.id <= TRAINER_FREE_ID) {
+            if (m[slot] == UINT32_MAX) continue;
+            s->dirty[slot] = 2;
+        } else if (m[slot] == UINT32_MAX) {
+            m[slot] = (*out)++;
+        }
+        if (safe_pwrite(tmp, &t, sizeof(t), slot_offset(m[slot])) != (ssize_t)sizeof(t))
+            return -1;
+    }
+    return 0;
+}
+
+/**
+ * \brief           Point the index and free list at the compacted file.
+ *
+ * \return          0 on success, -1 if it had to be rebuilt from the file
+ *                  and that failed.
+ *
+ * \note            Caller holds the DB lock quiesced. An indexed trainer
+ *                  without a copied record (its write failed) means the
+ *                  index no longer matches the file, so the file wins.
+ */
+static int compact_remap(TrainerDB *db, const trainer_snap_t *s,
+                         const uint32_t *moved, uint32_t out) {
+    uint32_t nslots = db->nslots;
+
+    db->nslots = out;
+    db->nfree = 0;
+    db->nfreed = 0;
+    for (size_t i = 0; i < db->cap; i++) {
+        if (db->keys[i] == 0) continue;
+        if (db->slots[i] >= nslots || moved[db->slots[i]] == UINT32_MAX)
+            return index_rebuild(db);
+        db->slots[i] = moved[db->slots[i]];
+    }
+    for (uint32_t slot = 0; slot < s->nslots; slot++) {
+        if (s->dirty[slot] == 2)
+            free_push(db, moved[slot]);     /* On failure the slot stays dead */
+    }
+    return 0;
+}
+
+/**
+ * \brief           Rewrite the file with only live records.
+ *
+ * \return          0 on success, -1 on failure or while a snapshot runs
+ *                  (the original file is kept).
+ *
+ * \note            Runs like a snapshot into \<path\>.compact: the
+ *                  compaction point is fixed under the quiesced lock, the
+ *                  bulk copy runs and is synced with no DB lock held, and
+ *                  the lock is taken again only to copy the slots written
+ *                  meanwhile, sync them and rename the copy into place. A
+ *                  crash leaves either the old or the new file.
+ */
+int trainer_db_compact(TrainerDB *db) {
+    char tmp_path[sizeof(db->path) + 16];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.compact", db->path);
+
+    trainer_snap_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    pthread_mutex_init(&s->mutex, NULL);
+
+    int tmp = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tmp < 0) {
+        perror("[Server] open()");
+        snap_free(s);
+        return -1;
+    }
+
+    /* Renumbering slots under a running snapshot would corrupt its image */
+    db_lock_quiesced(db);
+    int busy = db->snap != NULL;
+    if (!busy) {
+        s->nslots = db->nslots;
+        s->dirty = calloc(s->nslots ? s->nslots : 1, 1);
+        if (s->dirty) db->snap = s;
+    }
+    pthread_rwlock_unlock(&db->lock);
+
+    uint32_t *moved = malloc((s->nslots ? s->nslots : 1) * sizeof(*moved));
+    if (busy || !s->dirty || !moved) {
+        if (!busy && s->dirty) {
+            db_lock_quiesced(db);
+            db->snap = NULL;
+            pthread_rwlock_unlock(&db->lock);
+        }
+        close(tmp);
+        unlink(tmp_path);
+        snap_free(s);
+        free(moved);
+        return -1;
+    }
+
+    /* Torn reads of slots being written are harmless: those slots are dirty */
+    Trainer batch[TRAINER_SCAN_BATCH];
+    uint32_t out = 0;
+    int rc = 0, swapped = 0;
+
+    for (uint32_t base = 0; base < s->nslots && rc == 0; base += TRAINER_SCAN_BATCH) {
+        size_t want = s->nslots - base;
+        if (want > TRAINER_SCAN_BATCH) want = TRAINER_SCAN_BATCH;
+
+        ssize_t got = safe_pread(db->fd, batch, want * sizeof(Trainer), slot_offset(base));
+        if (got < 0 || (size_t)got != want * sizeof(Trainer)) {
+            rc = -1;
+            break;
+        }
+
+        /* Pack the live records of this batch together */
+        size_t keep = 0;
+        for (size_t i = 0; i < want; i++) {
+            moved[base + i] = UINT32_MAX;
+            if (batch[i].id > TRAINER_FREE_ID) {
+                moved[base + i] = out + (uint32_t)keep;
+                batch[keep++] = batch[i];
+            }
+        }
+        if (keep > 0) {
+            size_t bytes = keep * sizeof(Trainer);
+            if (safe_pwrite(tmp, batch, bytes, slot_offset(out)) != (ssize_t)bytes)
+                rc = -1;
+            out += (uint32_t)keep;
+        }
+    }
+    if (rc == 0 && fdatasync(tmp) < 0)
+        rc = -1;
+
+    db_lock_quiesced(db);
+    if (rc == 0 &&
+        (compact_catch_up(db, s, tmp, &moved, &out) < 0 ||
+         fdatasync(tmp) < 0 || rename(tmp_path, db->path) < 0))
+        rc = -1;
+    if (rc == 0) {
+        /* The compacted copy is now the database */
+        close(db->fd);
+        db->fd = tmp;
+        swapped = 1;
+        rc = compact_remap(db, s, moved, out);
+    }
+    db->snap = NULL;
+    pthread_rwlock_unlock(&db->lock);
+
+    if (!swapped) {
+        perror("[Server] compaction");
+        close(tmp);
+        unlink(tmp_path);
+        rc = -1;
+    }
+    snap_free(s);
+    free(moved);
+    return rc;
+}
+
+/**
+ * \brief           Background loop: compact whenever the dead ratio is high.
+ */
+static void *compactor_thread(void *arg) {
+    TrainerDB *db = arg;
+
+    for (;;) {
+        sleep(TRAINER_COMPACT_INTERVAL);
+
+        /* Slots of finished deletes wait in freed until the next insert */
+        db_lock_shared(db);
+        uint32_t before = db->nslots;
+        pthread_mutex_lock(&db->pending_mutex);
+        size_t dead = db->nfree + db->nfreed;
+        pthread_mutex_unlock(&db->pending_mutex);
+        int due = !db->snap && dead >= TRAINER_COMPACT_MIN_DEAD &&
+                  (double)dead > db->compact_ratio * (double)db->nslots;
+        pthread_rwlock_unlock(&db->lock);
+
+        if (due && trainer_db_compact(db) == 0) {
+            db_lock_shared(db);
+            uint32_t after = db->nslots;
+            pthread_rwlock_unlock(&db->lock);
+            printf("[Server] Compacted trainer DB: %u → %u slots\n", before, after);
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Launch the detached compactor thread.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int trainer_db_start_compactor(TrainerDB *db, double ratio) {
+    pthread_t tid;
+
+    db->compact_ratio = ratio;
+    if (pthread_create(&tid, NULL, compactor_thread, db) != 0)
+        return -1;
+    pthread_detach(tid);
+    return 0;
+}
+
+/* ========================================================================== */
+/* ============================ Snapshot Files ============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Fix a snapshot point and stream the image to \p path.
+ *
+ * \return          0 on success, -1 on failure (the old \p path is kept).
+ */
+int trainer_db_snapshot(TrainerDB *db, const char *path, TrainerSnapshotHeader *info) {
+    char tmp_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    trainer_snap_t *s = calloc(1, sizeof(*s));
+    if (!s) return -1;
+    pthread_mutex_init(&s->mutex, NULL);
+
+    int tmp = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tmp < 0) {
+        perror("[Server] open()");
+        snap_free(s);
+        return -1;
+    }
+
+    TrainerSnapshotHeader hdr = {
+        .magic = TRAINER_SNAPSHOT_MAGIC,
+        .version = TRAINER_SNAPSHOT_VERSION,
+        .record_size = (uint16_t)sizeof(Trainer),
+        .created = (int64_t)time(NULL)
+    };
+
+    /* The snapshot point: no mutation is in flight while the lock is held */
+    db_lock_quiesced(db);
+    int busy = db->snap != NULL;
+    if (!busy) {
+        s->nslots = db->nslots;
+        s->state = calloc(s->nslots ? s->nslots : 1, sizeof(*s->state));
+        if (s->state) {
+            hdr.lsn = db->wal ? trainer_wal_last_lsn(db->wal) : 0;
+            db->snap = s;
+        }
+    }
+    pthread_rwlock_unlock(&db->lock);
+
+    if (busy || !s->state) {
+        close(tmp);
+        unlink(tmp_path);
+        snap_free(s);
+        errno = busy ? EBUSY : ENOMEM;
+        return -1;
+    }
+
+    /* Copy without the DB lock; compaction is held off while db->snap is set */
+    Trainer batch[TRAINER_SCAN_BATCH];
+    off_t out = (off_t)sizeof(hdr);
+    int rc = 0;
+
+    for (uint32_t base = 0; base < s->nslots && rc == 0; base += TRAINER_SCAN_BATCH) {
+        size_t want = s->nslots - base;
+        if (want > TRAINER_SCAN_BATCH) want = TRAINER_SCAN_BATCH;
+
+        if (snap_copy_batch(db, s, base, want, batch) < 0) {
+            rc = -1;
+            break;
+        }
+
+        size_t keep = 0;
+        for (size_t i = 0; i < want; i++) {
+            if (batch[i].id > TRAINER_FREE_ID)
+                batch[keep++] = batch[i];
+        }
+        if (keep > 0) {
+            size_t bytes = keep * sizeof(Trainer);
+            if (safe_pwrite(tmp, batch, bytes, out) != (ssize_t)bytes)
+                rc = -1;
+            out += (off_t)bytes;
+            hdr.count += (uint32_t)keep;
+        }
+    }
+
+    /* Pending writers may still be saving pre-images into s */
+    db_lock_quiesced(db);
+    db->snap = NULL;
+    pthread_rwlock_unlock(&db->lock);
+    if (s->failed) rc = -1;
+    snap_free(s);
+
+    /* Never publish a change that a crash could still take back */
+    if (rc == 0 && db->wal && hdr.lsn > 0 && trainer_wal_commit(db->wal, hdr.lsn) < 0)
+        rc = -1;
+
+    if (rc == 0 &&
+        (safe_pwrite(tmp, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+         fdatasync(tmp) < 0 || rename(tmp_path, path) < 0))
+        rc = -1;
+
+    if (rc < 0) {
+        perror("[Server] snapshot");
+        unlink(tmp_path);
+    } else if (info) {
+        *info = hdr;
+    }
+    close(tmp);
+    return rc;
+}
+
+/**
+ * \brief           Validate \p snapshot and install its records as \p path.
+ *
+ * \return          Trainers restored, or -1 on failure.
+ */
+long trainer_db_restore(const char *path, const char *snapshot) {
+    return trainer_db_restore_part(path, snapshot, 0, 1);
+}
+
+/**
+ * \brief           trainer_db_restore() keeping only shard \p part of \p nparts.
+ *
+ * \return          Trainers restored into \p path, or -1 on failure.
+ */
+long trainer_db_restore_part(const char *path, const char *snapshot, int part, int nparts) {
+    char tmp_path[512], wal_path[512];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.restore", path);
+    snprintf(wal_path, sizeof(wal_path), "%s.wal", path);
+
+    int in = open(snapshot, O_RDONLY);
+    if (in < 0) {
+        perror("[Server] open()");
+        return -1;
+    }
+
+    TrainerSnapshotHeader hdr;
+    struct stat st;
+    if (safe_pread(in, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+        fstat(in, &st) < 0 ||
+        hdr.magic != TRAINER_SNAPSHOT_MAGIC ||
+        hdr.version != TRAINER_SNAPSHOT_VERSION ||
+        hdr.record_size != sizeof(Trainer) ||
+        st.st_size != (off_t)sizeof(hdr) + (off_t)hdr.count * (off_t)sizeof(Trainer)) {
+        fprintf(stderr, "[Server] %s is not a valid trainer snapshot.\n", snapshot);
+        close(in);
+        return -1;
+    }
+
+    int tmp = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (tmp < 0) {
+        perror("[Server] open()");
+        close(in);
+        return -1;
+    }
+
+    /* The image is already a packed trainer file: copy it in large chunks,
+     * dropping the records another shard owns */
+    Trainer batch[TRAINER_SCAN_BATCH * 4];
+    uint32_t kept = 0;
+    int rc = 0;
+    for (uint32_t done = 0; done < hdr.count && rc == 0; ) {
+        size_t want = hdr.count - done;
+        if (want > sizeof(batch) / sizeof(batch[0])) want = sizeof(batch) / sizeof(batch[0]);
+
+        size_t bytes = want * sizeof(Trainer);
+        off_t at = (off_t)done * (off_t)sizeof(Trainer);
+        if (safe_pread(in, batch, bytes, (off_t)sizeof(hdr) + at) != (ssize_t)bytes) {
+            rc = -1;
+            break;
+        }
+        size_t keep = 0;
+        for (size_t i = 0; i < want; i++)
+            if (nparts == 1 || TRAINER_SHARD_OF(batch[i].id, nparts) == part)
+                batch[keep++] = batch[i];
+
+        bytes = keep * sizeof(Trainer);
+        at = (off_t)kept * (off_t)sizeof(Trainer);
+        if (keep && safe_pwrite(tmp, batch, bytes, at) != (ssize_t)bytes)
+            rc = -1;
+        kept += (uint32_t)keep;
+        done += (uint32_t)want;
+    }
+    close(in);
+
+    /* A crash leaves either the old file and log or the restored file */
+    if (rc == 0 && (fdatasync(tmp) < 0 || rename(tmp_path, path) < 0 ||
+                    (unlink(wal_path) < 0 && errno != ENOENT)))
+        rc = -1;
+
+    close(tmp);
+    if (rc < 0) {
+        perror("[Server] restore");
+        unlink(tmp_path);
+        return -1;
+    }
+    return (long)kept;
+}
@@ -0,0 +1,437 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_db.h                                    #
+# Purpose:                                                   #
+#     Declares the indexed trainer storage engine. Records  #
+#     stay in the fixed-size binary trainers.bin layout,    #
+#     while an in-memory ID → slot hash index and a cached  #
+#     next-ID counter turn lookups and updates into a       #
+#     single pread()/pwrite(). Deletes leave tombstones     #
+#     that new trainers reuse; a background compactor       #
+#     rewrites the file once too many slots are dead. A     #
+#     sorted ID list serves cursor-paged listings in ID     #
+#     order. With a write-ahead log attached, mutations are #
+#     acknowledged only once group-committed to the log.    #
+#     Copy-on-write snapshots image the store while writers #
+#     continue.                                             #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: open(2), pread(2), pwrite(2),        #
+#     rename(2), fstat(2)                                   #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef TRAINER_DB_H
+#define TRAINER_DB_H
+
+#include <stdint.h>     /* int32_t, uint32_t, uint64_t */
+#include <stddef.h>     /* size_t */
+#include <pthread.h>    /* pthread_rwlock_t */
+
+#include "protocol.h"
+#include "trainer.h"
+#include "trainer_wal.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Per-record lock stripes (power of two); trainer ID selects the stripe. */
+#define TRAINER_LOCK_STRIPES    64
+
+/*!< Most records a single trainer_db_page() call returns. */
+#define TRAINER_PAGE_MAX        128
+
+/*!< Most records one batch call (mget/mpost/mdelete) accepts. */
+#define TRAINER_BATCH_MAX       256
+
+/*!< Shard owning trainer \p id when IDs are split \p n ways (IDs start at 1). */
+#define TRAINER_SHARD_OF(id, n) ((int)(((uint32_t)(id) - 1u) % (uint32_t)(n)))
+
+/*!< Snapshot file magic ("TSNP", little-endian) and format version. */
+#define TRAINER_SNAPSHOT_MAGIC      0x504E5354u
+#define TRAINER_SNAPSHOT_VERSION    1
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+#pragma pack(push, 1)
+/*!< Snapshot file header; \ref count packed records follow it. */
+typedef struct {
+    uint32_t    magic;              /*!< TRAINER_SNAPSHOT_MAGIC */
+    uint16_t    version;            /*!< TRAINER_SNAPSHOT_VERSION */
+    uint16_t    record_size;        /*!< sizeof(Trainer) */
+    uint32_t    count;              /*!< Live trainers in the image */
+    uint32_t    reserved;           /*!< Zero */
+    uint64_t    lsn;                /*!< Last WAL record included (0 without a WAL) */
+    int64_t     created;            /*!< time() when the snapshot was taken */
+} TrainerSnapshotHeader;
+#pragma pack(pop)
+
+/*!< Copy-on-write state of a running snapshot (private to trainer_db.c). */
+typedef struct trainer_snap trainer_snap_t;
+
+/*!< Logged request waiting to be written in place (private to trainer_db.c). */
+typedef struct trainer_write trainer_write_t;
+
+/**
+ * \brief           Open trainer database plus its in-memory index.
+ *
+ * \note            Thread-safe. \ref lock guards the index, free list and
+ *                  slot count: shared for lookups and scans, exclusive for
+ *                  add/delete/compaction. Record contents are additionally
+ *                  guarded by \ref stripes, so a put only excludes readers
+ *                  of trainers that hash to the same stripe. Mutations
+ *                  change the index and are appended to \ref wal under the
+ *                  DB lock and \ref pending_mutex, so the log records them
+ *                  in the order they were applied, and are then queued for
+ *                  \ref applier. It writes each batch into the file once it
+ *                  is durable, taking only the stripes, so no request holds
+ *                  a lock through the sync and readers see a change only
+ *                  once it can no longer be lost. While \ref snap is set,
+ *                  the first write to each slot saves its old contents for
+ *                  the snapshot first.
+ */
+typedef struct {
+    int         fd;                 /*!< Long-lived descriptor on the DB file */
+    char        path[256];          /*!< DB path (used for rewrites) */
+    int32_t    *keys;               /*!< Hash slots: trainer ID, 0 = empty */
+    uint32_t   *slots;              /*!< Hash slots: record index in file */
+    size_t      cap;                /*!< Hash table size (power of two) */
+    size_t      live;               /*!< Indexed trainers */
+    uint32_t    nslots;             /*!< Records stored in the file */
+    int         next_id;            /*!< ID handed to the next new trainer */
+    int         id_first;           /*!< Smallest ID it hands out */
+    int         id_step;            /*!< Distance between the IDs it hands out */
+    uint32_t   *free_slots;         /*!< Stack of tombstoned slots */
+    size_t      nfree;              /*!< Entries in \ref free_slots */
+    size_t      free_cap;           /*!< Allocated size of \ref free_slots */
+    double      compact_ratio;      /*!< Dead/total ratio that triggers it */
+    int32_t    *order;              /*!< Ascending IDs (may hold deleted ones) */
+    size_t      norder;             /*!< Entries in \ref order */
+    size_t      order_cap;          /*!< Allocated size of \ref order */
+    size_t      order_stale;        /*!< Deleted IDs still in \ref order */
+    trainer_wal_t *wal;             /*!< Write-ahead log, or NULL */
+    trainer_snap_t *snap;           /*!< Snapshot in progress, or NULL */
+    pthread_mutex_t pending_mutex;  /*!< Guards the fields below up to \ref applier_stop */
+    pthread_cond_t  pending_work;   /*!< Signalled when \ref queue gains a request */
+    pthread_cond_t  pending_done;   /*!< Signalled after every applied batch */
+    int             pending;        /*!< Requests queued or being applied */
+    trainer_write_t *queue;         /*!< Logged requests in log order, oldest first */
+    trainer_write_t **queue_tail;   /*!< Link the next request is queued at */
+    trainer_write_t *applying;      /*!< Batch the applier is writing, or NULL */
+    uint64_t        nolog_lsn;      /*!< Stands in for LSNs without a WAL */
+    uint32_t       *freed;          /*!< Slots tombstoned since, not yet on the free list */
+    size_t          nfreed;         /*!< Entries in \ref freed */
+    size_t          freed_cap;      /*!< Allocated size of \ref freed */
+    int             applier_stop;   /*!< Set by trainer_db_close() */
+    _Atomic uint64_t queued_lsn;    /*!< LSN of the newest queued request */
+    _Atomic uint64_t applied_lsn;   /*!< Requests up to this LSN are in the file */
+    _Atomic int     failed;         /*!< Sticky in-place write failure */
+    pthread_t       applier;        /*!< Writes logged requests in place */
+    int             applier_started; /*!< \ref applier is running */
+    pthread_rwlock_t lock;          /*!< Structural lock (index, free list) */
+    pthread_rwlock_t stripes[TRAINER_LOCK_STRIPES]; /*!< Record locks */
+} TrainerDB;
+
+/*!< Callback for trainer_db_scan(); return non-zero to stop early. */
+typedef int (*trainer_visit_fn)(const Trainer *t, void *ctx);
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Open (creating if needed) a trainer DB and index it.
+ *
+ * \param[in]       path        Trainer binary file.
+ *
+ * \return          Open database, or NULL on failure.
+ */
+TrainerDB *trainer_db_open(const char *path);
+
+/**
+ * \brief           Hand out only IDs congruent to \p first modulo \p step.
+ *
+ * \note            Call right after trainer_db_open(). Shard k of n uses
+ *                  (k + 1, n), so the shards never assign the same ID and
+ *                  TRAINER_SHARD_OF() routes every ID back to its shard.
+ */
+void trainer_db_set_id_sequence(TrainerDB *db, int first, int step);
+
+/**
+ * \brief           Replay \<path\>.wal into the file, then log all mutations.
+ *
+ * \param[in]       commit_ms   Group-commit window (< 0 → default).
+ * \param[in]       clock       LSN source shared by the shards of one store,
+ *                              or NULL (see trainer_wal_open()).
+ *
+ * \return          Records replayed, or -1 on failure.
+ *
+ * \note            Call once, before the database is shared. Afterwards
+ *                  add, update, set_team and delete return only once their
+ *                  change is durable in the log and written in place (see
+ *                  trainer_db_defer_commits()); trainers.bin itself is
+ *                  synced at checkpoints rather than per request.
+ */
+long trainer_db_enable_wal(TrainerDB *db, int commit_ms, _Atomic uint64_t *clock);
+
+/**
+ * \brief           Choose how the calling thread's mutations are acknowledged.
+ *
+ * \param[in]       on          0 (default): mutations return once durable
+ *                              and written in place. 1: they return once
+ *                              logged, and their LSNs are collected for
+ *                              trainer_db_take_commit().
+ *
+ * \note            Per thread, for event loops that must not sleep through
+ *                  a sync: they hold the reply until
+ *                  trainer_db_commit_status() reports the LSN done. Without
+ *                  a WAL mutations always wait, which costs only the write.
+ */
+void trainer_db_defer_commits(int on);
+
+/**
+ * \brief           Collect the calling thread's deferred commit.
+ *
+ * \return          LSN covering every mutation deferred since the last call,
+ *                  or 0 if there were none.
+ */
+uint64_t trainer_db_take_commit(void);
+
+/**
+ * \brief           Poll a commit returned by trainer_db_take_commit().
+ *
+ * \return          1 once durable and written in place (always without a
+ *                  WAL), 0 if still pending, -1 if the log or the file
+ *                  write failed.
+ */
+int trainer_db_commit_status(TrainerDB *db, uint64_t lsn);
+
+/**
+ * \brief           Sync the file and empty the write-ahead log.
+ *
+ * \return          0 on success (or without a WAL), -1 on failure.
+ *
+ * \note            Safe while other threads use \p db; mutations wait for
+ *                  the checkpoint to finish.
+ */
+int trainer_db_checkpoint(TrainerDB *db);
+
+/**
+ * \brief           Checkpoint and close the log, close the file, free the index.
+ */
+void trainer_db_close(TrainerDB *db);
+
+/**
+ * \brief           Fetch one trainer by ID.
+ *
+ * \return          1 if found (copied into \p out), 0 otherwise.
+ */
+int trainer_db_get(TrainerDB *db, int id, Trainer *out);
+
+/**
+ * \brief           Append a new trainer, assigning the next free ID.
+ *
+ * \param[in,out]   t           Record to store; \p t->id is set on success.
+ *
+ * \return          New trainer ID, or -1 on failure.
+ */
+int trainer_db_add(TrainerDB *db, Trainer *t);
+
+/**
+ * \brief           Overwrite the stored record whose ID matches \p t->id.
+ *
+ * \return          1 on success, 0 if the trainer does not exist or on I/O error.
+ */
+int trainer_db_update(TrainerDB *db, const Trainer *t);
+
+/**
+ * \brief           Replace a trainer's team atomically.
+ *
+ * \param[in]       id          Trainer to modify.
+ * \param[in]       ids         New Pokémon IDs (already validated).
+ * \param[in]       count       Number of IDs (0..MAX_POKEMON).
+ *
+ * \return          1 on success, 0 if the trainer does not exist or on I/O error.
+ */
+int trainer_db_set_team(TrainerDB *db, int id, const int *ids, int count);
+
+/**
+ * \brief           Remove a trainer by ID.
+ *
+ * \return          1 if a record was removed, 0 otherwise.
+ *
+ * \note            Constant time: the slot is tombstoned in place and
+ *                  queued for reuse by the next trainer_db_add().
+ */
+int trainer_db_delete(TrainerDB *db, int id);
+
+/**
+ * \brief           Fetch several trainers under one shared lock acquisition.
+ *
+ * \param[in]       ids         Trainer IDs (any order, duplicates allowed).
+ * \param[in]       n           Number of IDs.
+ * \param[out]      out         \p n records; out[k] is valid if found[k].
+ * \param[out]      found       \p n flags.
+ *
+ * \return          Number of IDs found.
+ */
+size_t trainer_db_get_many(TrainerDB *db, const int *ids, size_t n,
+                           Trainer *out, uint8_t *found);
+
+/**
+ * \brief           Append several trainers as one transaction.
+ *
+ * \param[in,out]   ts          Records to store; each id is set while stored.
+ * \param[in]       n           Number of records (at most TRAINER_BATCH_MAX).
+ *
+ * \return          \p n once the batch is durable, 0 if \p n is 0, or -1
+ *                  on failure.
+ *
+ * \note            One exclusive lock acquisition and one WAL commit cover
+ *                  the whole batch, which receives the next IDs of the
+ *                  sequence (consecutive unless the DB is a shard). The
+ *                  batch is stored whole or not at all: a failure before
+ *                  the commit rolls it back and clears every id to 0. After
+ *                  a failed commit the ids stay set, since those trainers
+ *                  are indexed even though they are not durable.
+ */
+long trainer_db_add_many(TrainerDB *db, Trainer *ts, size_t n);
+
+/**
+ * \brief           Remove several trainers as one transaction.
+ *
+ * \param[in]       ids         Trainer IDs.
+ * \param[in]       n           Number of IDs.
+ * \param[out]      deleted     \p n flags: set if that ID was removed.
+ *
+ * \return          Number removed, or -1 if the batch did not become durable.
+ *
+ * \note            At most TRAINER_BATCH_MAX IDs are considered per call;
+ *                  later flags are cleared.
+ */
+long trainer_db_delete_many(TrainerDB *db, const int *ids, size_t n, uint8_t *deleted);
+
+/**
+ * \brief           Apply mutation records received from another store.
+ *
+ * \param[in]       recs        Records in the order they were logged.
+ * \param[in]       n           Number of records.
+ *
+ * \return          Number applied (a prefix of \p recs), or -1 if the
+ *                  batch did not become durable.
+ *
+ * \note            Same rules as WAL replay (a put inserts or overwrites,
+ *                  deleting a missing trainer is a no-op), so re-applying a
+ *                  record is harmless. One exclusive lock acquisition and
+ *                  one commit to this DB's own log cover the batch; the lock
+ *                  is held across the commit, since the records may only
+ *                  reach the file once they are durable.
+ */
+long trainer_db_apply(TrainerDB *db, const wal_record_t *recs, size_t n);
+
+/**
+ * \brief           Visit every stored trainer in file order.
+ *
+ * \return          0 when the scan completed or was stopped by \p fn,
+ *                  -1 on read error.
+ *
+ * \note            Records are read under the stripe locks, so \p fn never
+ *                  sees a half-written one.
+ */
+int trainer_db_scan(TrainerDB *db, trainer_visit_fn fn, void *ctx);
+
+/**
+ * \brief           Read the next page of trainers in ascending ID order.
+ *
+ * \param[in]       after_id    Cursor: only IDs greater than this are returned.
+ * \param[out]      out         Receives up to \p max records.
+ * \param[in]       max         Page size (clamped to TRAINER_PAGE_MAX).
+ *
+ * \return          Records stored (0 past the last trainer), -1 on read error.
+ *
+ * \note            O(log n + max): a binary search in the sorted ID list,
+ *                  then one pread() per page when the records sit close
+ *                  together in the file. Pass the last returned ID as the
+ *                  next cursor; the shared lock and the page's stripe
+ *                  read locks are only held per page.
+ */
+int trainer_db_page(TrainerDB *db, int after_id, Trainer *out, int max);
+
+/**
+ * \brief           Write a point-in-time image of every live trainer.
+ *
+ * \param[in]       path        Snapshot file (written as \<path\>.tmp first).
+ * \param[out]      info        Header of the written snapshot, or NULL.
+ *
+ * \return          0 on success, -1 on failure (errno EBUSY if another
+ *                  snapshot or a compaction is running).
+ *
+ * \note            Mutations are blocked only while the snapshot point is
+ *                  fixed. Afterwards reads and writes continue: a write to a
+ *                  slot the copy has not reached yet saves the slot's old
+ *                  record first, so the image holds exactly the trainers that
+ *                  existed at the snapshot point. Returns once every change
+ *                  in the image is durable and the file is renamed into place.
+ */
+int trainer_db_snapshot(TrainerDB *db, const char *path, TrainerSnapshotHeader *info);
+
+/**
+ * \brief           Replace the trainer file at \p path with a snapshot's image.
+ *
+ * \return          Trainers restored, or -1 if \p snapshot is unreadable or
+ *                  malformed (\p path is then untouched).
+ *
+ * \note            Call before trainer_db_open(). The image is one sequential
+ *                  copy; \<path\>.wal is removed because it describes the
+ *                  file being replaced.
+ */
+long trainer_db_restore(const char *path, const char *snapshot);
+
+/**
+ * \brief           trainer_db_restore() keeping only shard \p part of \p nparts.
+ *
+ * \return          Trainers restored into \p path, or -1 on failure.
+ *
+ * \note            Records are routed with TRAINER_SHARD_OF(), so one image
+ *                  can seed a store of any shard count.
+ */
+long trainer_db_restore_part(const char *path, const char *snapshot, int part, int nparts);
+
+/**
+ * \brief           Rewrite the file with only live records.
+ *
+ * \return          0 on success, -1 on failure or while a snapshot runs
+ *                  (the old file is kept).
+ *
+ * \note            Reads and writes continue during the copy; the DB lock
+ *                  is held exclusively only to copy the slots written
+ *                  meanwhile and swap the files.
+ */
+int trainer_db_compact(TrainerDB *db);
+
+/**
+ * \brief           Start a detached thread that compacts in the background.
+ *
+ * \param[in]       db          Database to watch.
+ * \param[in]       ratio       Compact once dead slots exceed this fraction.
+ *
+ * \return          0 on success, -1 if the thread could not start.
+ */
+int trainer_db_start_compactor(TrainerDB *db, double ratio);
+
+#endif /* TRAINER_DB_H */
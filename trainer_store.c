@@ -0,0 +1,528 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_store.c                                 #
+# Purpose:                                                   #
+#     Implements the sharded trainer store. Single-trainer  #
+#     calls route straight to the owning shard; batches are #
+#     split into one call per shard; pages and snapshots    #
+#     are merged from every shard.                          #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: open(2), stat(2), rename(2)          #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* fprintf, snprintf, perror, rename */
+#include <errno.h>      /* errno, EBUSY */
+#include <stdlib.h>     /* calloc, malloc, free */
+#include <string.h>     /* memset */
+#include <time.h>       /* time */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, unlink, fdatasync */
+#include <sys/stat.h>   /* stat */
+
+#include "common.h"
+#include "trainer_store.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Records copied per read while joining snapshot parts. */
+#define STORE_JOIN_BATCH    64
+
+/* ========================================================================== */
+/* ================================ Helpers ================================= */
+/* ========================================================================== */
+
+/*!< Shard owning trainer \p id. */
+#define SHARD(st, id)   ((st)->shards[TRAINER_SHARD_OF((id), (st)->nshards)])
+
+/**
+ * \brief           File of shard \p k: \p path itself when unsharded.
+ */
+static void shard_path(const char *path, int nshards, int k, char *out, size_t cap) {
+    if (nshards == 1)
+        snprintf(out, cap, "%s", path);
+    else
+        snprintf(out, cap, "%s.%d", path, k);
+}
+
+/**
+ * \brief           Temporary image of shard \p k written by trainer_store_snapshot().
+ */
+static void part_path(const char *path, int k, char *out, size_t cap) {
+    snprintf(out, cap, "%s.%d.part", path, k);
+}
+
+/*!< State of the ownership check run while opening. */
+typedef struct {
+    int         shard;              /*!< Shard being scanned */
+    int         nshards;            /*!< Store shard count */
+    int         foreign;            /*!< First ID owned by another shard, or 0 */
+} owner_check_t;
+
+/**
+ * \brief           trainer_db_scan() visitor: stop at the first misplaced ID.
+ */
+static int check_owner(const Trainer *t, void *ctx) {
+    owner_check_t *c = ctx;
+    if (TRAINER_SHARD_OF(t->id, c->nshards) == c->shard) return 0;
+    c->foreign = t->id;
+    return 1;
+}
+
+/**
+ * \brief           Group \p ids by shard.
+ *
+ * \param[out]      perm        \p n positions of \p ids, shard 0's first.
+ * \param[out]      start       nshards + 1 offsets into \p perm.
+ */
+static void group_by_shard(const TrainerStore *st, const int *ids, size_t n,
+                           size_t *perm, size_t *start) {
+    memset(start, 0, (size_t)(st->nshards + 1) * sizeof(*start));
+    for (size_t i = 0; i < n; i++)
+        start[TRAINER_SHARD_OF(ids[i], st->nshards) + 1]++;
+    for (int k = 0; k < st->nshards; k++)
+        start[k + 1] += start[k];
+
+    size_t fill[TRAINER_SHARDS_MAX];
+    memcpy(fill, start, (size_t)st->nshards * sizeof(*fill));
+    for (size_t i = 0; i < n; i++)
+        perm[fill[TRAINER_SHARD_OF(ids[i], st->nshards)]++] = i;
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Open (creating if needed) and index every shard of \p path.
+ */
+TrainerStore *trainer_store_open(const char *path, int nshards) {
+    if (nshards < 1 || nshards > TRAINER_SHARDS_MAX) {
+        fprintf(stderr, "[Server] Shard count must be 1..%d.\n", TRAINER_SHARDS_MAX);
+        return NULL;
+    }
+
+    /* Shard files live next to the plain file; never shadow its trainers */
+    struct stat sb;
+    char file[512];
+    shard_path(path, nshards, 0, file, sizeof(file));
+    if (nshards > 1 && stat(path, &sb) == 0 && sb.st_size > 0 && stat(file, &sb) < 0) {
+        fprintf(stderr, "[Server] %s holds an unsharded store; snapshot it and "
+                "restart with -s to split it into %d shards.\n", path, nshards);
+        return NULL;
+    }
+
+    /* A store with more shards leaves files no shard of this one would open */
+    snprintf(file, sizeof(file), "%s.%d", path, nshards);
+    if (stat(file, &sb) == 0) {
+        fprintf(stderr, "[Server] %s exists: the store was split into more than %d "
+                "shard(s); restore from a snapshot to change -S.\n", file, nshards);
+        return NULL;
+    }
+
+    TrainerStore *st = calloc(1, sizeof(*st));
+    if (!st) return NULL;
+    st->nshards = nshards;
+    atomic_init(&st->clock, 1);
+    atomic_init(&st->next_shard, 0);
+    atomic_init(&st->snapshotting, 0);
+
+    for (int k = 0; k < nshards; k++) {
+        shard_path(path, nshards, k, file, sizeof(file));
+        st->shards[k] = trainer_db_open(file);
+        if (!st->shards[k]) goto fail;
+        if (nshards == 1) break;
+
+        trainer_db_set_id_sequence(st->shards[k], k + 1, nshards);
+        owner_check_t c = { .shard = k, .nshards = nshards };
+        if (trainer_db_scan(st->shards[k], check_owner, &c) < 0) goto fail;
+        if (c.foreign) {
+            fprintf(stderr, "[Server] %s holds trainer %d of shard %d: it was written "
+                    "with another shard count; restore from a snapshot to change -S.\n",
+                    file, c.foreign, TRAINER_SHARD_OF(c.foreign, nshards));
+            goto fail;
+        }
+    }
+    return st;
+
+fail:
+    for (int k = 0; k < nshards; k++)
+        if (st->shards[k]) trainer_db_close(st->shards[k]);
+    free(st);
+    return NULL;
+}
+
+/**
+ * \brief           trainer_db_enable_wal() on every shard.
+ */
+long trainer_store_enable_wal(TrainerStore *st, int commit_ms) {
+    long total = 0;
+    for (int k = 0; k < st->nshards; k++) {
+        long n = trainer_db_enable_wal(st->shards[k], commit_ms, &st->clock);
+        if (n < 0) return -1;
+        total += n;
+    }
+    return total;
+}
+
+/**
+ * \brief           Replace the store at \p path with a snapshot's image.
+ */
+long trainer_store_restore(const char *path, int nshards, const char *snapshot) {
+    char file[512];
+    long total = 0;
+    for (int k = 0; k < nshards; k++) {
+        shard_path(path, nshards, k, file, sizeof(file));
+        long n = trainer_db_restore_part(file, snapshot, k, nshards);
+        if (n < 0) return -1;
+        total += n;
+    }
+
+    /* Drop the files of a store with another layout, so the image is all
+     * trainer_store_open() finds */
+    for (int k = nshards == 1 ? 0 : nshards; k < TRAINER_SHARDS_MAX; k++) {
+        snprintf(file, sizeof(file), "%s.%d", path, k);
+        unlink(file);
+        snprintf(file, sizeof(file), "%s.%d.wal", path, k);
+        unlink(file);
+    }
+    if (nshards > 1) {
+        snprintf(file, sizeof(file), "%s.wal", path);
+        unlink(file);
+        unlink(path);
+    }
+    return total;
+}
+
+/**
+ * \brief           Trainers indexed across all shards.
+ */
+size_t trainer_store_live(TrainerStore *st) {
+    size_t live = 0;
+    for (int k = 0; k < st->nshards; k++)
+        live += st->shards[k]->live;
+    return live;
+}
+
+/**
+ * \brief           Poll a commit returned by trainer_db_take_commit().
+ */
+int trainer_store_commit_status(TrainerStore *st, uint64_t lsn) {
+    int status = 1;
+    for (int k = 0; k < st->nshards; k++) {
+        int s = trainer_db_commit_status(st->shards[k], lsn);
+        if (s < 0) return -1;
+        if (s == 0) status = 0;
+    }
+    return status;
+}
+
+/**
+ * \brief           trainer_db_checkpoint() on every shard.
+ */
+int trainer_store_checkpoint(TrainerStore *st) {
+    int rc = 0;
+    for (int k = 0; k < st->nshards; k++)
+        if (trainer_db_checkpoint(st->shards[k]) < 0)
+            rc = -1;
+    return rc;
+}
+
+/**
+ * \brief           trainer_db_start_compactor() on every shard.
+ */
+int trainer_store_start_compactor(TrainerStore *st, double ratio) {
+    for (int k = 0; k < st->nshards; k++)
+        if (trainer_db_start_compactor(st->shards[k], ratio) < 0)
+            return -1;
+    return 0;
+}
+
+/**
+ * \brief           Fetch one trainer by ID.
+ */
+int trainer_store_get(TrainerStore *st, int id, Trainer *out) {
+    return trainer_db_get(SHARD(st, id), id, out);
+}
+
+/**
+ * \brief           Store a new trainer in the next shard, round-robin.
+ */
+int trainer_store_add(TrainerStore *st, Trainer *t) {
+    unsigned k = atomic_fetch_add_explicit(&st->next_shard, 1, memory_order_relaxed);
+    return trainer_db_add(st->shards[k % (unsigned)st->nshards], t);
+}
+
+/**
+ * \brief           Replace a trainer's team.
+ */
+int trainer_store_set_team(TrainerStore *st, int id, const int *ids, int count) {
+    return trainer_db_set_team(SHARD(st, id), id, ids, count);
+}
+
+/**
+ * \brief           Remove a trainer by ID.
+ */
+int trainer_store_delete(TrainerStore *st, int id) {
+    return trainer_db_delete(SHARD(st, id), id);
+}
+
+/**
+ * \brief           Fetch several trainers, one trainer_db_get_many() per shard.
+ */
+size_t trainer_store_get_many(TrainerStore *st, const int *ids, size_t n,
+                              Trainer *out, uint8_t *found) {
+    if (st->nshards == 1)
+        return trainer_db_get_many(st->shards[0], ids, n, out, found);
+
+    size_t start[TRAINER_SHARDS_MAX + 1];
+    size_t *perm = malloc(n * (sizeof(*perm) + sizeof(int) + sizeof(Trainer) + 1));
+    if (!perm) {
+        memset(found, 0, n);
+        return 0;
+    }
+    int *sub = (int *)(perm + n);
+    Trainer *recs = (Trainer *)(sub + n);   /* Packed records: no alignment */
+    uint8_t *hit = (uint8_t *)(recs + n);
+
+    group_by_shard(st, ids, n, perm, start);
+    for (size_t i = 0; i < n; i++)
+        sub[i] = ids[perm[i]];
+
+    size_t total = 0;
+    for (int k = 0; k < st->nshards; k++) {
+        size_t len = start[k + 1] - start[k];
+        if (len > 0)
+            total += trainer_db_get_many(st->shards[k], sub + start[k], len,
+                                         recs + start[k], hit + start[k]);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        found[perm[i]] = hit[i];
+        if (hit[i]) out[perm[i]] = recs[i];
+    }
+    free(perm);
+    return total;
+}
+
+/**
+ * \brief           Append several trainers to one shard as one transaction.
+ */
+long trainer_store_add_many(TrainerStore *st, Trainer *ts, size_t n) {
+    unsigned k = atomic_fetch_add_explicit(&st->next_shard, 1, memory_order_relaxed);
+    return trainer_db_add_many(st->shards[k % (unsigned)st->nshards], ts, n);
+}
+
+/**
+ * \brief           Remove several trainers, one trainer_db_delete_many() per shard.
+ */
+long trainer_store_delete_many(TrainerStore *st, const int *ids, size_t n, uint8_t *deleted) {
+    if (st->nshards == 1)
+        return trainer_db_delete_many(st->shards[0], ids, n, deleted);
+
+    size_t start[TRAINER_SHARDS_MAX + 1];
+    size_t *perm = malloc(n * (sizeof(*perm) + sizeof(int) + 1));
+    if (!perm) return -1;
+    int *sub = (int *)(perm + n);
+    uint8_t *hit = (uint8_t *)(sub + n);
+
+    group_by_shard(st, ids, n, perm, start);
+    for (size_t i = 0; i < n; i++)
+        sub[i] = ids[perm[i]];
+
+    long total = 0;
+    memset(hit, 0, n);
+    for (int k = 0; k < st->nshards && total >= 0; k++) {
+        size_t len = start[k + 1] - start[k];
+        long removed = len ? trainer_db_delete_many(st->shards[k], sub + start[k], len,
+                                                    hit + start[k]) : 0;
+        total = removed < 0 ? -1 : total + removed;
+    }
+
+    for (size_t i = 0; i < n; i++)
+        deleted[perm[i]] = hit[i];
+    free(perm);
+    return total;
+}
+
+/**
+ * \brief           Apply replicated records, one trainer_db_apply() per shard.
+ */
+long trainer_store_apply(TrainerStore *st, const wal_record_t *recs, size_t n) {
+    if (n == 0) return 0;
+    if (st->nshards == 1)
+        return trainer_db_apply(st->shards[0], recs, n) == (long)n ? (long)n : -1;
+
+    size_t start[TRAINER_SHARDS_MAX + 1];
+    size_t *perm = malloc(n * (sizeof(*perm) + sizeof(int) + sizeof(wal_record_t)));
+    if (!perm) return -1;
+    int *ids = (int *)(perm + n);
+    wal_record_t *sorted = (wal_record_t *)(ids + n);  /* Packed records */
+
+    for (size_t i = 0; i < n; i++)
+        ids[i] = recs[i].rec.id;
+    group_by_shard(st, ids, n, perm, start);
+    for (size_t i = 0; i < n; i++)
+        sorted[i] = recs[perm[i]];
+
+    long total = 0;
+    for (int k = 0; k < st->nshards && total >= 0; k++) {
+        size_t len = start[k + 1] - start[k];
+        if (len > 0 && trainer_db_apply(st->shards[k], sorted + start[k], len) != (long)len)
+            total = -1;
+        else
+            total += (long)len;
+    }
+    free(perm);
+    return total;
+}
+
+/**
+ * \brief           trainer_wal_set_tap() on every shard's log.
+ */
+void trainer_store_set_tap(TrainerStore *st, wal_tap_fn fn, void *ctx) {
+    for (int k = 0; k < st->nshards; k++)
+        if (st->shards[k]->wal)
+            trainer_wal_set_tap(st->shards[k]->wal, fn, ctx);
+}
+
+/**
+ * \brief           Copy up to \p max trainers with ID > \p after_id, ascending.
+ */
+int trainer_store_page(TrainerStore *st, int after_id, Trainer *out, int max) {
+    if (st->nshards == 1)
+        return trainer_db_page(st->shards[0], after_id, out, max);
+
+    if (max > TRAINER_PAGE_MAX) max = TRAINER_PAGE_MAX;
+    if (max <= 0) return 0;
+
+    /* Shard pages only hold IDs > after_id, so the smallest max of their
+     * union are exactly the next max trainers of the whole store */
+    Trainer *pages = malloc((size_t)st->nshards * (size_t)max * sizeof(*pages));
+    if (!pages) return -1;
+    int len[TRAINER_SHARDS_MAX], head[TRAINER_SHARDS_MAX];
+    for (int k = 0; k < st->nshards; k++) {
+        len[k] = trainer_db_page(st->shards[k], after_id, pages + (size_t)k * (size_t)max, max);
+        head[k] = 0;
+        if (len[k] < 0) {
+            free(pages);
+            return -1;
+        }
+    }
+
+    int n = 0;
+    while (n < max) {
+        const Trainer *best = NULL;
+        int from = -1;
+        for (int k = 0; k < st->nshards; k++) {
+            const Trainer *t = pages + (size_t)k * (size_t)max + head[k];
+            if (head[k] < len[k] && (!best || t->id < best->id)) {
+                best = t;
+                from = k;
+            }
+        }
+        if (!best) break;
+        out[n++] = *best;
+        head[from]++;
+    }
+    free(pages);
+    return n;
+}
+
+/**
+ * \brief           Write one point-in-time image of every shard to \p path.
+ */
+int trainer_store_snapshot(TrainerStore *st, const char *path, TrainerSnapshotHeader *info) {
+    if (st->nshards == 1)
+        return trainer_db_snapshot(st->shards[0], path, info);
+
+    if (atomic_exchange(&st->snapshotting, 1)) {
+        errno = EBUSY;
+        return -1;
+    }
+
+    char part[512], tmp_path[512];
+    TrainerSnapshotHeader hdr = {
+        .magic = TRAINER_SNAPSHOT_MAGIC,
+        .version = TRAINER_SNAPSHOT_VERSION,
+        .record_size = (uint16_t)sizeof(Trainer),
+        .created = (int64_t)time(NULL),
+        .lsn = UINT64_MAX
+    };
+    int made = 0, rc = 0;
+
+    /* Image the shards one at a time; each blocks only its own writers */
+    for (; made < st->nshards && rc == 0; made++) {
+        TrainerSnapshotHeader h;
+        part_path(path, made, part, sizeof(part));
+        if (trainer_db_snapshot(st->shards[made], part, &h) < 0) {
+            rc = -1;
+            break;
+        }
+        hdr.count += h.count;
+        if (h.lsn < hdr.lsn) hdr.lsn = h.lsn;
+    }
+
+    /* Join the parts behind one header: a single image for any shard count */
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+    int tmp = rc == 0 ? open(tmp_path, O_RDWR | O_CREAT | O_TRUNC, 0644) : -1;
+    if (rc == 0 && tmp < 0) rc = -1;
+
+    Trainer batch[STORE_JOIN_BATCH];
+    off_t out = (off_t)sizeof(hdr);
+    for (int k = 0; k < made && rc == 0; k++) {
+        part_path(path, k, part, sizeof(part));
+        int in = open(part, O_RDONLY);
+        if (in < 0) {
+            rc = -1;
+            break;
+        }
+        off_t at = (off_t)sizeof(hdr);
+        for (;;) {
+            ssize_t got = safe_pread(in, batch, sizeof(batch), at);
+            if (got < 0 || (got > 0 && safe_pwrite(tmp, batch, (size_t)got, out) != got))
+                rc = -1;
+            if (got <= 0) break;
+            at += got;
+            out += got;
+        }
+        close(in);
+    }
+
+    if (rc == 0 &&
+        (safe_pwrite(tmp, &hdr, sizeof(hdr), 0) != (ssize_t)sizeof(hdr) ||
+         fdatasync(tmp) < 0 || rename(tmp_path, path) < 0))
+        rc = -1;
+
+    if (tmp >= 0) {
+        close(tmp);
+        if (rc < 0) {
+            perror("[Server] snapshot");
+            unlink(tmp_path);
+        }
+    }
+    for (int k = 0; k < made; k++) {
+        part_path(path, k, part, sizeof(part));
+        unlink(part);
+    }
+    if (rc == 0 && info)
+        *info = hdr;
+
+    atomic_store(&st->snapshotting, 0);
+    return rc;
+}
@@ -0,0 +1,225 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_store.h                                 #
+# Purpose:                                                   #
+#     Declares the sharded trainer store. Trainers are      #
+#     split by ID over N independent TrainerDB shards, each #
+#     with its own file, index, locks, WAL committer and    #
+#     compactor, so writes to different shards never share  #
+#     a lock or a sync. Listings merge the shards back into #
+#     ID order; snapshots merge them into one image that    #
+#     restores into any shard count.                        #
+#############################################################
+# Citations:                                                #
+# [1] DeWitt, D. and Gray, J. "Parallel Database Systems"   #
+#     (CACM 1992)                                           #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef TRAINER_STORE_H
+#define TRAINER_STORE_H
+
+#include <stdint.h>     /* uint8_t, uint64_t */
+#include <stddef.h>     /* size_t */
+#include <stdatomic.h>  /* _Atomic, atomic_uint, atomic_int */
+
+#include "trainer_db.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Most shards one store can be split into ("server -S"). */
+#define TRAINER_SHARDS_MAX      64
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Trainer DB split by ID over \ref nshards shard files.
+ *
+ * \note            Trainer \p id lives in shard TRAINER_SHARD_OF(id, nshards);
+ *                  shard k hands out IDs k + 1, k + 1 + nshards, ... With one
+ *                  shard the store is exactly the plain \<path\> file. With
+ *                  more, shard k is \<path\>.k with its log at \<path\>.k.wal.
+ *                  All shard logs draw LSNs from \ref clock, so an LSN taken
+ *                  by trainer_db_take_commit() names a point for every shard.
+ */
+typedef struct {
+    int         nshards;            /*!< Shards in use (1..TRAINER_SHARDS_MAX) */
+    TrainerDB  *shards[TRAINER_SHARDS_MAX]; /*!< Open shards */
+    _Atomic uint64_t clock;         /*!< LSN source shared by the shard logs */
+    atomic_uint next_shard;         /*!< Round-robin cursor for new trainers */
+    atomic_int  snapshotting;       /*!< A trainer_store_snapshot() runs */
+} TrainerStore;
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Open (creating if needed) and index every shard of \p path.
+ *
+ * \param[in]       path        Trainer file (or shard file prefix).
+ * \param[in]       nshards     Shard count (1..TRAINER_SHARDS_MAX).
+ *
+ * \return          Open store, or NULL on failure.
+ *
+ * \note            Fails if the files were written with a different shard
+ *                  count (a shard holds an ID another shard owns, a shard
+ *                  past \p nshards exists, or \p path still holds an
+ *                  unsharded store); restore a snapshot with
+ *                  trainer_store_restore() to change the shard count.
+ */
+TrainerStore *trainer_store_open(const char *path, int nshards);
+
+/**
+ * \brief           trainer_db_enable_wal() on every shard.
+ *
+ * \return          Records replayed across the shards, or -1 on failure.
+ */
+long trainer_store_enable_wal(TrainerStore *st, int commit_ms);
+
+/**
+ * \brief           Replace the store at \p path with a snapshot's image.
+ *
+ * \return          Trainers restored, or -1 on failure.
+ *
+ * \note            Call before trainer_store_open(). Each shard keeps the
+ *                  records it owns, so the image may come from any shard count;
+ *                  files left by a store with another layout are removed.
+ */
+long trainer_store_restore(const char *path, int nshards, const char *snapshot);
+
+/**
+ * \brief           Trainers indexed across all shards.
+ */
+size_t trainer_store_live(TrainerStore *st);
+
+/**
+ * \brief           Poll a commit returned by trainer_db_take_commit().
+ *
+ * \return          1 once every shard has synced its records up to \p lsn,
+ *                  0 while one is pending, -1 if a shard log failed.
+ */
+int trainer_store_commit_status(TrainerStore *st, uint64_t lsn);
+
+/**
+ * \brief           trainer_db_checkpoint() on every shard.
+ *
+ * \return          0 on success, -1 if any shard failed.
+ */
+int trainer_store_checkpoint(TrainerStore *st);
+
+/**
+ * \brief           trainer_db_start_compactor() on every shard.
+ *
+ * \return          0 on success, -1 if any compactor could not start.
+ */
+int trainer_store_start_compactor(TrainerStore *st, double ratio);
+
+/**
+ * \brief           Fetch one trainer by ID (see trainer_db_get()).
+ */
+int trainer_store_get(TrainerStore *st, int id, Trainer *out);
+
+/**
+ * \brief           Store a new trainer in the next shard, round-robin.
+ *
+ * \return          New trainer ID, or -1 on failure.
+ */
+int trainer_store_add(TrainerStore *st, Trainer *t);
+
+/**
+ * \brief           Replace a trainer's team (see trainer_db_set_team()).
+ */
+int trainer_store_set_team(TrainerStore *st, int id, const int *ids, int count);
+
+/**
+ * \brief           Remove a trainer by ID (see trainer_db_delete()).
+ */
+int trainer_store_delete(TrainerStore *st, int id);
+
+/**
+ * \brief           Fetch several trainers, one trainer_db_get_many() per shard.
+ *
+ * \return          Number of IDs found.
+ */
+size_t trainer_store_get_many(TrainerStore *st, const int *ids, size_t n,
+                              Trainer *out, uint8_t *found);
+
+/**
+ * \brief           Append several trainers to one shard as one transaction.
+ *
+ * \return          \p n once stored and durable, or -1; the batch is
+ *                  stored whole or not at all (see trainer_db_add_many()).
+ *
+ * \note            The batch keeps a single lock acquisition and WAL commit,
+ *                  so its IDs step by \ref TrainerStore.nshards.
+ */
+long trainer_store_add_many(TrainerStore *st, Trainer *ts, size_t n);
+
+/**
+ * \brief           Remove several trainers, one trainer_db_delete_many() per shard.
+ *
+ * \return          Number removed, or -1 if a shard's batch did not become durable.
+ */
+long trainer_store_delete_many(TrainerStore *st, const int *ids, size_t n, uint8_t *deleted);
+
+/**
+ * \brief           Apply replicated records, one trainer_db_apply() per shard.
+ *
+ * \return          Number applied, or -1 if a shard failed.
+ *
+ * \note            Records keep their order within each shard, and every
+ *                  trainer lives in one shard, so each trainer sees its
+ *                  changes in log order.
+ */
+long trainer_store_apply(TrainerStore *st, const wal_record_t *recs, size_t n);
+
+/**
+ * \brief           trainer_wal_set_tap() on every shard's log.
+ *
+ * \note            Call after trainer_store_enable_wal(). Batches of
+ *                  different shards reach \p fn from different threads.
+ */
+void trainer_store_set_tap(TrainerStore *st, wal_tap_fn fn, void *ctx);
+
+/**
+ * \brief           Copy up to \p max trainers with ID > \p after_id, ascending.
+ *
+ * \return          Number of records written to \p out, or -1 on failure.
+ *
+ * \note            Takes one page from every shard and merges them, so a
+ *                  cursor works exactly as with trainer_db_page().
+ */
+int trainer_store_page(TrainerStore *st, int after_id, Trainer *out, int max);
+
+/**
+ * \brief           Write one point-in-time image of every shard to \p path.
+ *
+ * \param[out]      info        Header of the written snapshot, or NULL.
+ *
+ * \return          0 on success, -1 on failure (errno EBUSY if another
+ *                  snapshot is running).
+ *
+ * \note            Each shard is imaged by trainer_db_snapshot() into
+ *                  \<path\>.k.part, then the parts are joined. The header LSN
+ *                  is the smallest shard LSN: every change after it is either
+ *                  in the image already or in a log, and replay is idempotent.
+ */
+int trainer_store_snapshot(TrainerStore *st, const char *path, TrainerSnapshotHeader *info);
+
+#endif /* TRAINER_STORE_H */
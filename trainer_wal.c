@@ -0,0 +1,428 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_wal.c                                   #
+# Purpose:                                                   #
+#     Implements the trainer write-ahead log. Appenders     #
+#     fill a shared buffer; the committer waits out a short #
+#     window, writes the whole batch and issues one         #
+#     fdatasync() for every client in it. Replay validates  #
+#     each record's checksum and sequence number.           #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: write(2), fdatasync(2),              #
+#     ftruncate(2), pthread_cond_timedwait(3p)              #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO 3309 / ITU-T V.42 CRC-32 (reflected, 0xEDB88320)  #
+# [3] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [4] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#include <stdio.h>      /* perror */
+#include <stdlib.h>     /* calloc, malloc, free */
+#include <string.h>     /* memset, memcpy */
+#include <errno.h>      /* errno, ENOENT, ETIMEDOUT */
+#include <fcntl.h>      /* open */
+#include <unistd.h>     /* close, fdatasync, ftruncate */
+#include <time.h>       /* clock_gettime */
+
+#include "common.h"
+#include "trainer_wal.h"
+#include "storage_ring.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Records read per read() during replay. */
+#define WAL_REPLAY_BATCH    256
+
+/* ========================================================================== */
+/* ================================ Checksum ================================ */
+/* ========================================================================== */
+
+/*!< CRC-32 lookup table, built once. */
+static uint32_t crc_table[256];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT;
+
+/**
+ * \brief           Fill \ref crc_table for the reflected 0xEDB88320 polynomial.
+ */
+static void crc_init(void) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t c = i;
+        for (int k = 0; k < 8; k++)
+            c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+        crc_table[i] = c;
+    }
+}
+
+/**
+ * \brief           CRC-32 of \p len bytes.
+ */
+static uint32_t crc32_bytes(const void *data, size_t len) {
+    const uint8_t *p = data;
+    uint32_t c = 0xFFFFFFFFu;
+
+    pthread_once(&crc_once, crc_init);
+    for (size_t i = 0; i < len; i++)
+        c = crc_table[(c ^ p[i]) & 0xFF] ^ (c >> 8);
+    return c ^ 0xFFFFFFFFu;
+}
+
+/**
+ * \brief           Checksum covering every field before \ref wal_record_t.crc.
+ */
+static uint32_t record_crc(const wal_record_t *r) {
+    return crc32_bytes(r, offsetof(wal_record_t, crc));
+}
+
+/* ========================================================================== */
+/* ================================= Replay ================================= */
+/* ========================================================================== */
+
+/**
+ * \brief           Apply the intact prefix of the log at \p path.
+ *
+ * \return          Records applied, or -1 on failure.
+ */
+long trainer_wal_replay(const char *path, wal_apply_fn fn, void *ctx) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        if (errno == ENOENT) return 0;
+        perror("[Server] open(wal)");
+        return -1;
+    }
+
+    wal_record_t batch[WAL_REPLAY_BATCH];
+    uint64_t expect = 1;
+    long applied = 0;
+
+    for (;;) {
+        ssize_t got = safe_read(fd, batch, sizeof(batch));
+        if (got < 0) {
+            perror("[Server] read(wal)");
+            applied = -1;
+            break;
+        }
+
+        size_t n = (size_t)got / sizeof(wal_record_t);
+        for (size_t i = 0; i < n; i++) {
+            const wal_record_t *r = &batch[i];
+            if (!trainer_wal_record_valid(r) || r->lsn < expect)
+                goto done;          /* Torn tail: nothing past it was acknowledged */
+
+            if (fn((wal_op_t)r->op, &r->rec, ctx) < 0) {
+                applied = -1;
+                goto done;
+            }
+            expect = r->lsn + 1;
+            applied++;
+        }
+        if ((size_t)got < sizeof(batch))
+            break;
+    }
+
+done:
+    close(fd);
+    return applied;
+}
+
+/* ========================================================================== */
+/* ================================ Committer =============================== */
+/* ========================================================================== */
+
+/**
+ * \brief           Absolute CLOCK_MONOTONIC time \p ms from now.
+ */
+static struct timespec deadline_after(int ms) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec  += ms / 1000;
+    ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+    return ts;
+}
+
+/**
+ * \brief           Committer loop: gather a batch, write it, sync once.
+ *
+ * \note            The window starts with the first record of a batch, so
+ *                  an idle server adds at most commit_ms to a lone write,
+ *                  while a busy one fills the buffer and syncs early.
+ */
+static void *wal_committer(void *arg) {
+    trainer_wal_t *wal = arg;
+
+    /* Where io_uring is available, each commit is one linked write+sync */
+    storage_ring_t *ring = storage_ring_create();
+
+    pthread_mutex_lock(&wal->mutex);
+    for (;;) {
+        while (wal->len == 0 && !wal->stop)
+            pthread_cond_wait(&wal->work, &wal->mutex);
+        if (wal->len == 0)
+            break;
+
+        /* Group-commit window: let more clients join this sync */
+        if (wal->commit_ms > 0 && !wal->stop) {
+            struct timespec until = deadline_after(wal->commit_ms);
+            while (!wal->stop && wal->len < TRAINER_WAL_BUF_BYTES / 2 &&
+                   pthread_cond_timedwait(&wal->work, &wal->mutex, &until) != ETIMEDOUT)
+                ;
+        }
+
+        /* Take the batch; appenders continue into the other buffer */
+        char *out = wal->buf;
+        size_t bytes = wal->len;
+        uint64_t upto = wal->last_lsn;
+        wal_tap_fn tap = wal->tap;
+        void *tap_ctx = wal->tap_ctx;
+        wal->buf = wal->spare;
+        wal->spare = out;
+        wal->len = 0;
+        int failed = wal->failed;
+        pthread_cond_broadcast(&wal->space);
+        pthread_mutex_unlock(&wal->mutex);
+
+        int rc = -1;
+        if (!failed) {
+            rc = storage_ring_append_sync(ring, wal->fd, out, bytes);
+            if (rc < 0) perror("[Server] trainer WAL commit");
+        }
+        if (rc == 0 && tap)
+            tap((const wal_record_t *)out, bytes / sizeof(wal_record_t), tap_ctx);
+
+        pthread_mutex_lock(&wal->mutex);
+        if (rc < 0) {
+            wal->failed = 1;
+        } else {
+            wal->size += (off_t)bytes;
+            wal->durable_lsn = upto;
+        }
+        pthread_cond_broadcast(&wal->done);
+    }
+    pthread_mutex_unlock(&wal->mutex);
+    storage_ring_destroy(ring);
+    return NULL;
+}
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Check a record's magic, operation and checksum.
+ */
+int trainer_wal_record_valid(const wal_record_t *r) {
+    return r->magic == TRAINER_WAL_MAGIC && r->crc == record_crc(r) &&
+           (r->op == WAL_OP_PUT || r->op == WAL_OP_DELETE);
+}
+
+/**
+ * \brief           Truncate \p path and launch the committer.
+ *
+ * \return          Log handle, or NULL on failure.
+ */
+trainer_wal_t *trainer_wal_open(const char *path, int commit_ms, _Atomic uint64_t *clock) {
+    trainer_wal_t *wal = calloc(1, sizeof(*wal));
+    if (!wal) return NULL;
+
+    wal->fd = open(path, O_WRONLY | O_APPEND | O_CREAT | O_TRUNC, 0644);
+    if (wal->fd < 0) {
+        perror("[Server] open(wal)");
+        free(wal);
+        return NULL;
+    }
+    wal->commit_ms = commit_ms >= 0 ? commit_ms : TRAINER_WAL_COMMIT_MS_DEFAULT;
+    atomic_init(&wal->own_clock, 1);
+    wal->clock = clock ? clock : &wal->own_clock;
+
+    wal->buf = malloc(TRAINER_WAL_BUF_BYTES);
+    wal->spare = malloc(TRAINER_WAL_BUF_BYTES);
+    if (!wal->buf || !wal->spare || fdatasync(wal->fd) < 0)
+        goto fail;
+
+    /* Timed waits use the monotonic clock so clock changes cannot stall them */
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wal->work, &attr);
+    pthread_condattr_destroy(&attr);
+    pthread_cond_init(&wal->space, NULL);
+    pthread_cond_init(&wal->done, NULL);
+    pthread_mutex_init(&wal->mutex, NULL);
+
+    if (pthread_create(&wal->committer, NULL, wal_committer, wal) != 0) {
+        perror("[Server] pthread_create(wal)");
+        pthread_cond_destroy(&wal->work);
+        pthread_cond_destroy(&wal->space);
+        pthread_cond_destroy(&wal->done);
+        pthread_mutex_destroy(&wal->mutex);
+        goto fail;
+    }
+    return wal;
+
+fail:
+    free(wal->buf);
+    free(wal->spare);
+    close(wal->fd);
+    free(wal);
+    return NULL;
+}
+
+/**
+ * \brief           Copy one checksummed record into the commit buffer.
+ *
+ * \return          LSN of the record, or 0 on failure.
+ */
+uint64_t trainer_wal_append(trainer_wal_t *wal, wal_op_t op, const Trainer *rec) {
+    wal_record_t r;
+    memset(&r, 0, sizeof(r));
+    r.magic = TRAINER_WAL_MAGIC;
+    r.op = (uint8_t)op;
+    r.rec = *rec;
+
+    pthread_mutex_lock(&wal->mutex);
+    while (!wal->failed && wal->len + sizeof(r) > TRAINER_WAL_BUF_BYTES) {
+        pthread_cond_signal(&wal->work);
+        pthread_cond_wait(&wal->space, &wal->mutex);
+    }
+    if (wal->failed) {
+        pthread_mutex_unlock(&wal->mutex);
+        return 0;
+    }
+
+    r.lsn = atomic_fetch_add(wal->clock, 1);
+    wal->last_lsn = r.lsn;
+    r.crc = record_crc(&r);
+    memcpy(wal->buf + wal->len, &r, sizeof(r));
+    wal->len += sizeof(r);
+
+    /* Wake the committer for a new batch, or early once half full */
+    if (wal->len == sizeof(r) || wal->len >= TRAINER_WAL_BUF_BYTES / 2)
+        pthread_cond_signal(&wal->work);
+    pthread_mutex_unlock(&wal->mutex);
+    return r.lsn;
+}
+
+/**
+ * \brief           Hand every batch to \p fn once it is durable.
+ */
+void trainer_wal_set_tap(trainer_wal_t *wal, wal_tap_fn fn, void *ctx) {
+    pthread_mutex_lock(&wal->mutex);
+    wal->tap = fn;
+    wal->tap_ctx = ctx;
+    pthread_mutex_unlock(&wal->mutex);
+}
+
+/**
+ * \brief           Wait for the committer to sync record \p lsn.
+ *
+ * \return          0 if durable, -1 on failure.
+ */
+int trainer_wal_commit(trainer_wal_t *wal, uint64_t lsn) {
+    if (lsn == 0) return -1;
+
+    pthread_mutex_lock(&wal->mutex);
+    while (wal->durable_lsn < lsn && !wal->failed)
+        pthread_cond_wait(&wal->done, &wal->mutex);
+    int ok = wal->durable_lsn >= lsn;
+    pthread_mutex_unlock(&wal->mutex);
+    return ok ? 0 : -1;
+}
+
+/**
+ * \brief           Report whether record \p lsn has been synced.
+ *
+ * \return          1 if durable, 0 if pending, -1 on failure.
+ */
+int trainer_wal_status(trainer_wal_t *wal, uint64_t lsn) {
+    if (lsn == 0) return -1;
+
+    pthread_mutex_lock(&wal->mutex);
+    int st = (wal->durable_lsn >= lsn || wal->durable_lsn == wal->last_lsn) ? 1 :
+             (wal->failed ? -1 : 0);
+    pthread_mutex_unlock(&wal->mutex);
+    return st;
+}
+
+/**
+ * \brief           Read the LSN of the newest appended record.
+ */
+uint64_t trainer_wal_last_lsn(trainer_wal_t *wal) {
+    pthread_mutex_lock(&wal->mutex);
+    uint64_t lsn = wal->last_lsn;
+    pthread_mutex_unlock(&wal->mutex);
+    return lsn;
+}
+
+/**
+ * \brief           Check the checkpoint threshold.
+ */
+int trainer_wal_should_checkpoint(trainer_wal_t *wal) {
+    pthread_mutex_lock(&wal->mutex);
+    int due = wal->size >= TRAINER_WAL_CHECKPOINT_BYTES;
+    pthread_mutex_unlock(&wal->mutex);
+    return due;
+}
+
+/**
+ * \brief           Wait for pending commits, sync the data file, truncate.
+ *
+ * \return          0 on success, -1 on failure.
+ */
+int trainer_wal_checkpoint(trainer_wal_t *wal, int data_fd) {
+    int rc = -1;
+
+    pthread_mutex_lock(&wal->mutex);
+    while (!wal->failed && wal->durable_lsn < wal->last_lsn) {
+        pthread_cond_signal(&wal->work);
+        pthread_cond_wait(&wal->done, &wal->mutex);
+    }
+
+    /* Only once the data file is durable may the log forget its records */
+    if (!wal->failed && fdatasync(data_fd) == 0 && ftruncate(wal->fd, 0) == 0 &&
+        fdatasync(wal->fd) == 0) {
+        wal->size = 0;
+        rc = 0;
+    } else if (!wal->failed) {
+        perror("[Server] trainer WAL checkpoint");
+    }
+    pthread_mutex_unlock(&wal->mutex);
+    return rc;
+}
+
+/**
+ * \brief           Drain the buffer, join the committer, release everything.
+ */
+void trainer_wal_close(trainer_wal_t *wal) {
+    if (!wal) return;
+
+    pthread_mutex_lock(&wal->mutex);
+    wal->stop = 1;
+    pthread_cond_signal(&wal->work);
+    pthread_mutex_unlock(&wal->mutex);
+    pthread_join(wal->committer, NULL);
+
+    close(wal->fd);
+    pthread_cond_destroy(&wal->work);
+    pthread_cond_destroy(&wal->space);
+    pthread_cond_destroy(&wal->done);
+    pthread_mutex_destroy(&wal->mutex);
+    free(wal->buf);
+    free(wal->spare);
+    free(wal);
+}
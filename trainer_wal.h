@@ -0,0 +1,218 @@
+/*
+#############################################################
+# Author: Arek Gebka                                        #
+# Major: Computer Science                                   #
+# Creation Date: December 8, 2025                           #
+# Last Updated: December 8, 2025                            #
+# Due Date: December 10, 2025                               #
+# Course: CPSC 552 — Advanced Unix Programming              #
+# Professor Name: Dr. Dylan Schwesinger                     #
+# Assignment: Project 6 — Threaded Server                   #
+# Filename: trainer_wal.h                                   #
+# Purpose:                                                   #
+#     Declares the trainer write-ahead log. Every mutation  #
+#     is appended as a checksummed record; one committer    #
+#     thread writes whatever has accumulated and makes it   #
+#     durable with a single fdatasync(), so many clients    #
+#     share each sync. The log is replayed into the trainer #
+#     file at startup and truncated at checkpoints.         #
+#############################################################
+# Citations:                                                #
+# [1] Linux Man Pages: write(2), fdatasync(2), ftruncate(2) #
+#     https://man7.org/linux/man-pages/                     #
+# [2] ISO/IEC 9899:2018 (C11 Standard)                      #
+# [3] MaJerle C Code Style Guide                            #
+#     https://github.com/MaJerle/c-code-style               #
+#############################################################
+*/
+
+#ifndef TRAINER_WAL_H
+#define TRAINER_WAL_H
+
+#include <stdint.h>     /* uint8_t, uint32_t, uint64_t */
+#include <stddef.h>     /* size_t */
+#include <sys/types.h>  /* off_t */
+#include <pthread.h>    /* pthread_t, pthread_mutex_t, pthread_cond_t */
+#include <stdatomic.h>  /* _Atomic */
+
+#include "trainer.h"
+
+/* ========================================================================== */
+/* ============================== Configuration ============================= */
+/* ========================================================================== */
+
+/*!< Default group-commit window in milliseconds. */
+#define TRAINER_WAL_COMMIT_MS_DEFAULT   2
+
+/*!< Bytes of records that can wait for the committer at once. */
+#define TRAINER_WAL_BUF_BYTES           (256 * 1024)
+
+/*!< Log size at which the next mutation checkpoints and truncates it. */
+#define TRAINER_WAL_CHECKPOINT_BYTES    (8 * 1024 * 1024)
+
+/*!< Record magic ("TWAL", little-endian). */
+#define TRAINER_WAL_MAGIC               0x4C415754u
+
+/* ========================================================================== */
+/* =============================== Data Types =============================== */
+/* ========================================================================== */
+
+/*!< Logged mutation kinds. */
+typedef enum {
+    WAL_OP_PUT = 1,                 /*!< Insert or overwrite the whole record */
+    WAL_OP_DELETE = 2               /*!< Remove the trainer with rec.id */
+} wal_op_t;
+
+#pragma pack(push, 1)
+/*!< On-disk log record. */
+typedef struct {
+    uint32_t    magic;              /*!< TRAINER_WAL_MAGIC */
+    uint8_t     op;                 /*!< wal_op_t */
+    uint8_t     reserved[3];        /*!< Zero */
+    uint64_t    lsn;                /*!< Sequence number, increasing through the log */
+    Trainer     rec;                /*!< New record (only id for deletes) */
+    uint32_t    crc;                /*!< CRC-32 of every preceding byte */
+} wal_record_t;
+#pragma pack(pop)
+
+/*!< Observer of committed records (replication); runs on the committer. */
+typedef void (*wal_tap_fn)(const wal_record_t *recs, size_t n, void *ctx);
+
+/**
+ * \brief           Write-ahead log state.
+ *
+ * \note            Appenders copy records into \ref buf under \ref mutex.
+ *                  The committer swaps \ref buf with \ref spare, writes and
+ *                  syncs the spare without the mutex, then advances
+ *                  \ref durable_lsn, so appends proceed during the sync.
+ */
+typedef struct {
+    int             fd;             /*!< Log file, opened for append */
+    int             commit_ms;      /*!< Group-commit window */
+    char           *buf;            /*!< Records waiting to be written */
+    char           *spare;          /*!< Buffer being written by the committer */
+    size_t          len;            /*!< Valid bytes in \ref buf */
+    off_t           size;           /*!< Bytes in the log file */
+    _Atomic uint64_t own_clock;     /*!< LSN source when none is shared */
+    _Atomic uint64_t *clock;        /*!< Hands out LSNs (own or shared) */
+    uint64_t        last_lsn;       /*!< LSN of the newest append */
+    uint64_t        durable_lsn;    /*!< Every LSN up to this one is synced */
+    int             failed;         /*!< Sticky write/sync failure */
+    int             stop;           /*!< Set by trainer_wal_close() */
+    wal_tap_fn      tap;            /*!< Sees each batch once durable, or NULL */
+    void           *tap_ctx;        /*!< Argument of \ref tap */
+    pthread_mutex_t mutex;          /*!< Guards every field above */
+    pthread_cond_t  work;           /*!< Signalled when \ref buf fills */
+    pthread_cond_t  space;          /*!< Signalled when \ref buf drains */
+    pthread_cond_t  done;           /*!< Signalled after every commit */
+    pthread_t       committer;      /*!< Committer thread */
+} trainer_wal_t;
+
+/*!< Callback for trainer_wal_replay(); return 0 to continue, -1 to abort. */
+typedef int (*wal_apply_fn)(wal_op_t op, const Trainer *rec, void *ctx);
+
+/* ========================================================================== */
+/* ============================ Public Interface ============================ */
+/* ========================================================================== */
+
+/**
+ * \brief           Feed every intact record of the log at \p path to \p fn.
+ *
+ * \return          Records replayed (0 if the log is missing), -1 on read
+ *                  error or if \p fn aborted.
+ *
+ * \note            Replay stops at the first torn or corrupt record: only a
+ *                  crash during an append can leave one, and nothing after
+ *                  it was ever acknowledged.
+ */
+long trainer_wal_replay(const char *path, wal_apply_fn fn, void *ctx);
+
+/**
+ * \brief           Check a record's magic, operation and checksum.
+ *
+ * \return          1 if \p r is an intact mutation record, 0 otherwise.
+ */
+int trainer_wal_record_valid(const wal_record_t *r);
+
+/**
+ * \brief           Create an empty log at \p path and start the committer.
+ *
+ * \param[in]       commit_ms   Group-commit window (< 0 → default).
+ * \param[in]       clock       LSN source shared with other logs (starting
+ *                              at 1), or NULL for a private one.
+ *
+ * \return          Running log, or NULL on failure.
+ *
+ * \note            Truncates \p path: replay it and sync the trainer file
+ *                  first. Logs sharing a clock draw from one LSN space, so
+ *                  an LSN orders records across them and LSNs within one
+ *                  log increase with gaps.
+ */
+trainer_wal_t *trainer_wal_open(const char *path, int commit_ms, _Atomic uint64_t *clock);
+
+/**
+ * \brief           Hand every batch to \p fn once it is durable.
+ *
+ * \note            \p fn runs on the committer thread, in log order, after
+ *                  the sync and before waiting writers are released, so it
+ *                  must not block for long. Pass NULL to detach.
+ */
+void trainer_wal_set_tap(trainer_wal_t *wal, wal_tap_fn fn, void *ctx);
+
+/**
+ * \brief           Append a mutation record.
+ *
+ * \return          Its LSN, or 0 if the log has failed.
+ *
+ * \note            Call while holding the lock that orders the mutation, so
+ *                  the log order matches the order the changes were applied.
+ *                  Waits only when the buffer is full.
+ */
+uint64_t trainer_wal_append(trainer_wal_t *wal, wal_op_t op, const Trainer *rec);
+
+/**
+ * \brief           Block until record \p lsn is durable.
+ *
+ * \return          0 once synced, -1 if \p lsn is 0 or the log has failed.
+ */
+int trainer_wal_commit(trainer_wal_t *wal, uint64_t lsn);
+
+/**
+ * \brief           Poll whether every record up to \p lsn is durable.
+ *
+ * \return          1 if durable, 0 if still pending, -1 if \p lsn is 0 or
+ *                  the log has failed.
+ *
+ * \note            A log with nothing pending reports 1 for any \p lsn, so
+ *                  an LSN from a log sharing the clock can be checked too.
+ */
+int trainer_wal_status(trainer_wal_t *wal, uint64_t lsn);
+
+/**
+ * \brief           LSN of the newest appended record (0 if none yet).
+ *
+ * \note            Call while blocking mutations to get an exact boundary.
+ */
+uint64_t trainer_wal_last_lsn(trainer_wal_t *wal);
+
+/**
+ * \brief           Has the log grown past TRAINER_WAL_CHECKPOINT_BYTES?
+ */
+int trainer_wal_should_checkpoint(trainer_wal_t *wal);
+
+/**
+ * \brief           Sync \p data_fd and truncate the log.
+ *
+ * \return          0 on success, -1 on failure (the log is kept).
+ *
+ * \note            The caller must block all mutations, so every logged
+ *                  change is already in the file behind \p data_fd.
+ */
+int trainer_wal_checkpoint(trainer_wal_t *wal, int data_fd);
+
+/**
+ * \brief           Commit outstanding records, stop the committer and free.
+ */
+void trainer_wal_close(trainer_wal_t *wal);
+
+#endif /* TRAINER_WAL_H */